@@ -0,0 +1,80 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#include "index_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace lsdj
+{
+    uint64_t readLittleEndian(const uint8_t* data, size_t byteCount)
+    {
+        uint64_t value = 0;
+        for (size_t i = 0; i < byteCount; ++i)
+            value |= static_cast<uint64_t>(data[i]) << (i * 8);
+        return value;
+    }
+
+    void appendLittleEndian(std::vector<uint8_t>& data, uint64_t value, size_t byteCount)
+    {
+        for (size_t i = 0; i < byteCount; ++i)
+            data.emplace_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+
+    bool hasIndexHeader(const MappedFile& file, const IndexMagic& magic, uint32_t formatVersion, size_t headerSize)
+    {
+        return file.size() >= std::max<size_t>(headerSize, magic.size() + 4) &&
+               memcmp(file.data(), magic.data(), magic.size()) == 0 &&
+               readLittleEndian(file.data() + magic.size(), 4) == formatVersion;
+    }
+
+    bool writeIndex(const ghc::filesystem::path& path, const std::vector<uint8_t>& data)
+    {
+        const auto temporaryPath = path.string() + ".tmp";
+        {
+            std::ofstream stream(temporaryPath, std::ios_base::binary | std::ios_base::trunc);
+            stream.write(reinterpret_cast<const char*>(data.data()), data.size());
+            if (!stream.flush())
+                return false;
+        }
+        
+        std::error_code error;
+        ghc::filesystem::rename(temporaryPath, path, error);
+        return !error;
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#ifndef LSDJ_INDEX_FILE_HPP
+#define LSDJ_INDEX_FILE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ghc/filesystem.hpp>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+/* Helpers for the on-disk indices of the library tools (catalogs, search indices and
+   fingerprint indices). Every index starts with an 8-byte magic followed by a 32-bit
+   format version, and all numbers in them are little endian. */
+
+namespace lsdj
+{
+    //! The magic every index starts with
+    using IndexMagic = std::array<char, 8>;
+    
+    //! Read a little endian number of up to 8 bytes
+    uint64_t readLittleEndian(const uint8_t* data, size_t byteCount);
+    
+    //! Append a number as little endian bytes
+    void appendLittleEndian(std::vector<uint8_t>& data, uint64_t value, size_t byteCount);
+    
+    //! Whether a mapped file is at least as large as a header, and starts with a magic and format version
+    bool hasIndexHeader(const MappedFile& file, const IndexMagic& magic, uint32_t formatVersion, size_t headerSize);
+    
+    //! Write an index next to the old one and swap them, so readers never see half an index
+    bool writeIndex(const ghc::filesystem::path& path, const std::vector<uint8_t>& data);
+}
+
+#endif
@@ -0,0 +1,158 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lsdj
+{
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+#ifdef _WIN32
+    bool MappedFile::open(const ghc::filesystem::path& path)
+    {
+        close();
+        
+        file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            file = nullptr;
+            return false;
+        }
+        
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+        {
+            close();
+            return false;
+        }
+        
+        // Empty files can't be mapped, but there's nothing to read from them anyway
+        length = static_cast<size_t>(size.QuadPart);
+        if (length == 0)
+            return true;
+        
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr)
+        {
+            close();
+            return false;
+        }
+        
+        bytes = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (bytes == nullptr)
+        {
+            close();
+            return false;
+        }
+        
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (bytes)
+            UnmapViewOfFile(bytes);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file)
+            CloseHandle(file);
+        
+        bytes = nullptr;
+        length = 0;
+        mapping = nullptr;
+        file = nullptr;
+    }
+#else
+    bool MappedFile::open(const ghc::filesystem::path& path)
+    {
+        close();
+        
+        const int descriptor = ::open(path.string().c_str(), O_RDONLY | O_CLOEXEC);
+        if (descriptor == -1)
+            return false;
+        
+        struct stat status;
+        if (fstat(descriptor, &status) != 0)
+        {
+            ::close(descriptor);
+            return false;
+        }
+        
+        // Empty files can't be mapped, but there's nothing to read from them anyway
+        length = static_cast<size_t>(status.st_size);
+        if (length == 0)
+        {
+            ::close(descriptor);
+            return true;
+        }
+        
+        // The mapping stays valid after closing the descriptor
+        void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        ::close(descriptor);
+        
+        if (address == MAP_FAILED)
+        {
+            length = 0;
+            return false;
+        }
+        
+        bytes = static_cast<const uint8_t*>(address);
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (bytes)
+            munmap(const_cast<uint8_t*>(bytes), length);
+        
+        bytes = nullptr;
+        length = 0;
+    }
+#endif
+}
@@ -0,0 +1,186 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#include "server.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#include "thread_pool.hpp"
+
+namespace lsdj
+{
+    Server::Server(unsigned int jobs) :
+        jobs(std::max(jobs, 1u))
+    {
+    }
+
+    void Server::addCommand(const std::string& name, const std::string& usage, Command command)
+    {
+        commands[name] = { usage, std::move(command) };
+    }
+
+    int Server::serve(std::istream& input, std::ostream& output)
+    {
+        // The response of a job, which is held back until those of earlier jobs are written
+        struct Response
+        {
+            std::ostringstream output;
+            bool done = false;
+            bool succeeded = false;
+        };
+        
+        std::deque<std::unique_ptr<Response>> responses;
+        std::mutex responseMutex;
+        std::atomic<bool> failed{false};
+        
+        // Write the responses that are done, but never before those of earlier jobs
+        auto finish = [&](Response& response, bool succeeded)
+        {
+            std::lock_guard<std::mutex> lock(responseMutex);
+            response.done = true;
+            response.succeeded = succeeded;
+            if (!succeeded)
+                failed = true;
+            
+            for (; !responses.empty() && responses.front()->done; responses.pop_front())
+                output << responses.front()->output.str() << (responses.front()->succeeded ? "OK" : "ERROR") << std::endl;
+        };
+        
+        // The thread reading the input is blocked most of the time, so it doesn't count as one of the jobs
+        ThreadPool pool(jobs);
+        ThreadPool::Group group;
+        
+        std::string line;
+        while (std::getline(input, line))
+        {
+            std::vector<std::string> arguments;
+            const bool valid = split(line, arguments);
+            
+            if (valid && (arguments.empty() || arguments.front().find('#') == 0))
+                continue;
+            
+            if (valid && arguments.front() == "quit")
+                break;
+            
+            Response* response = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(responseMutex);
+                responses.emplace_back(std::make_unique<Response>());
+                response = responses.back().get();
+            }
+            
+            if (!valid)
+            {
+                response->output << "A quote isn't closed" << std::endl;
+                finish(*response, false);
+                continue;
+            }
+            
+            if (arguments.front() == "help")
+            {
+                for (const auto& command : commands)
+                    response->output << command.first << ' ' << command.second.usage << std::endl;
+                response->output << "quit" << std::endl;
+                finish(*response, true);
+                continue;
+            }
+            
+            const auto command = commands.find(arguments.front());
+            if (command == commands.end())
+            {
+                response->output << "Unknown command '" << arguments.front() << "', send help for a list" << std::endl;
+                finish(*response, false);
+                continue;
+            }
+            
+            // Keep a bounded amount of jobs in flight, so a client can't flood the memory
+            pool.waitUntilBelow(group, jobs * 2);
+            
+            arguments.erase(arguments.begin());
+            pool.submit(group, [&, response, arguments, function = command->second.command]()
+            {
+                bool succeeded = false;
+                try
+                {
+                    succeeded = function(arguments, response->output);
+                } catch (std::exception& e) {
+                    response->output << e.what() << std::endl;
+                }
+                
+                finish(*response, succeeded);
+            });
+        }
+        
+        pool.wait(group);
+        
+        return failed ? 1 : 0;
+    }
+
+    bool Server::split(const std::string& line, std::vector<std::string>& arguments)
+    {
+        std::string argument;
+        bool inArgument = false;
+        bool quoted = false;
+        
+        for (const char c : line)
+        {
+            if (c == '"')
+            {
+                quoted = !quoted;
+                inArgument = true;
+            } else if (!quoted && std::isspace(static_cast<unsigned char>(c))) {
+                if (inArgument)
+                    arguments.emplace_back(std::move(argument));
+                argument.clear();
+                inArgument = false;
+            } else {
+                argument += c;
+                inArgument = true;
+            }
+        }
+        
+        if (inArgument)
+            arguments.emplace_back(std::move(argument));
+        
+        return !quoted;
+    }
+}
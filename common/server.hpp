@@ -0,0 +1,92 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#ifndef LSDJ_SERVER_HPP
+#define LSDJ_SERVER_HPP
+
+#include <functional>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lsdj
+{
+    //! Handles jobs sent as lines of text, for tools that keep running between jobs
+    /*! Every line holds a command and its arguments, separated by whitespace. Arguments
+        containing whitespace can be put between double quotes. Jobs run on a pool of
+        threads that lives as long as the server, but their responses are written in the
+        order the jobs came in: whatever the job printed, followed by a line saying either
+        "OK" or "ERROR". Empty lines and lines starting with # are ignored, and "help"
+        lists the commands. The server stops at the end of the input, or at "quit". */
+    class Server
+    {
+    public:
+        //! Run a single job, writing its response to output
+        /*! @return Whether the job succeeded */
+        using Command = std::function<bool(const std::vector<std::string>& arguments, std::ostream& output)>;
+        
+    public:
+        //! Create a server that runs a given amount of jobs simultaneously
+        explicit Server(unsigned int jobs);
+        
+        //! Add a command clients can send
+        /*! @param usage The arguments of the command, shown by "help" */
+        void addCommand(const std::string& name, const std::string& usage, Command command);
+        
+        //! Handle jobs until the input ends or a client sends "quit"
+        /*! @return Zero if every job succeeded */
+        int serve(std::istream& input, std::ostream& output);
+        
+        //! Split a line into whitespace separated arguments, honoring double quotes
+        /*! @return False if a quote isn't closed */
+        static bool split(const std::string& line, std::vector<std::string>& arguments);
+        
+    private:
+        struct Entry
+        {
+            std::string usage;
+            Command command;
+        };
+        
+    private:
+        unsigned int jobs = 1;
+        std::map<std::string, Entry> commands;
+    };
+}
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#include "song_library.hpp"
+
+#include <algorithm>
+
+#include <lsdj/project.h>
+#include <lsdj/sav.h>
+
+#include "common.hpp"
+
+namespace lsdj
+{
+    ghc::filesystem::path absoluteInputPath(const std::string& input)
+    {
+        // Folders given with a trailing separator ("A/") have no file name, which reads as hidden
+        auto path = ghc::filesystem::absolute(input).lexically_normal();
+        if (!path.has_filename())
+            path = path.parent_path();
+        
+        return path;
+    }
+
+    void walkSongFiles(const ghc::filesystem::path& path, const std::function<void(const ghc::filesystem::path&)>& onFile, const std::function<void(const ghc::filesystem::path&)>& onFolder)
+    {
+        if (isHiddenFile(path.filename().string()))
+            return;
+        
+        if (!ghc::filesystem::is_directory(path))
+        {
+            if (path.extension() == ".sav" || path.extension() == ".lsdsng")
+                onFile(path);
+            return;
+        }
+        
+        if (onFolder)
+            onFolder(path);
+        
+        // Directory iteration order differs per platform, sort it to keep the output stable
+        std::vector<ghc::filesystem::path> children;
+        for (auto it = ghc::filesystem::directory_iterator(path); it != ghc::filesystem::directory_iterator(); ++it)
+        {
+            // is_directory() follows symlinks, so a link to an ancestor would recurse forever
+            if (!(it->is_symlink() && it->is_directory()))
+                children.emplace_back(it->path());
+        }
+        std::sort(children.begin(), children.end());
+        
+        for (const auto& child : children)
+            walkSongFiles(child, onFile, onFolder);
+    }
+
+    std::vector<ghc::filesystem::path> collectSongFiles(const std::vector<std::string>& inputs)
+    {
+        std::vector<ghc::filesystem::path> paths;
+        for (const auto& input : inputs)
+            walkSongFiles(absoluteInputPath(input), [&](const ghc::filesystem::path& path){ paths.emplace_back(path); });
+        
+        // Sorted, so that indices built twice from the same files come out the same
+        std::sort(paths.begin(), paths.end());
+        paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+        
+        return paths;
+    }
+
+    bool readSongs(const ghc::filesystem::path& path, const SongVisitor& visitor)
+    {
+        if (path.extension() == ".sav")
+        {
+            lsdj_sav_t* sav = nullptr;
+            if (lsdj_sav_read_from_file(path.string().c_str(), &sav, nullptr) != LSDJ_SUCCESS)
+                return false;
+            
+            // The working memory song goes by the name of the project it was loaded from
+            const uint8_t active = lsdj_sav_get_active_project_index(sav);
+            const lsdj_project_t* activeProject = active == LSDJ_SAV_NO_ACTIVE_PROJECT_INDEX ? nullptr : lsdj_sav_get_project_const(sav, active);
+            visitor(lsdj_sav_get_working_memory_song_const(sav), WORKING_MEMORY_SLOT, activeProject ? lsdj_project_get_name(activeProject) : nullptr, 0);
+            
+            for (uint8_t i = 0; i < LSDJ_SAV_PROJECT_COUNT; ++i)
+            {
+                const lsdj_project_t* project = lsdj_sav_get_project_const(sav, i);
+                if (project)
+                    visitor(lsdj_project_get_song_const(project), i, lsdj_project_get_name(project), lsdj_project_get_version(project));
+            }
+            
+            lsdj_sav_free(sav);
+        } else {
+            lsdj_project_t* project = nullptr;
+            if (lsdj_project_read_lsdsng_from_file(path.string().c_str(), &project, nullptr) != LSDJ_SUCCESS)
+                return false;
+            
+            visitor(lsdj_project_get_song_const(project), LSDSNG_SLOT, lsdj_project_get_name(project), lsdj_project_get_version(project));
+            
+            lsdj_project_free(project);
+        }
+        
+        return true;
+    }
+
+    std::string formatSlot(uint8_t slot)
+    {
+        if (slot == WORKING_MEMORY_SLOT)
+            return "WM";
+        else if (slot == LSDSNG_SLOT)
+            return "-";
+        else
+            return std::to_string(slot);
+    }
+}
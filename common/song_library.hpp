@@ -0,0 +1,84 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#ifndef LSDJ_SONG_LIBRARY_HPP
+#define LSDJ_SONG_LIBRARY_HPP
+
+#include <cstdint>
+#include <functional>
+#include <ghc/filesystem.hpp>
+#include <string>
+#include <vector>
+
+#include <lsdj/song.h>
+
+/* Finding and reading the songs in a library of .sav's and .lsdsng's, for the tools that
+   index whole libraries (catalogs, search indices, fingerprints and packs). */
+
+namespace lsdj
+{
+    //! The slot of a working memory song
+    constexpr uint8_t WORKING_MEMORY_SLOT = 0xFF;
+    
+    //! The slot of the song in an .lsdsng
+    constexpr uint8_t LSDSNG_SLOT = 0xFE;
+    
+    //! Called for every song in a file, with its slot and the name and version of its project
+    /*! The working memory song goes by the name of the project it was loaded from (if any),
+        and has version 0 */
+    using SongVisitor = std::function<void(const lsdj_song_t* song, uint8_t slot, const char* name, uint8_t version)>;
+    
+    //! Turn a path given on the command line into the absolute path files are found under
+    ghc::filesystem::path absoluteInputPath(const std::string& input);
+    
+    //! Walk the .sav's and .lsdsng's in a path, recursing into folders in sorted order
+    /*! Hidden files are skipped, and so are symlinked folders inside the path, since they could
+        point back at one of their ancestors. onFolder (if any) is called before a folder is walked */
+    void walkSongFiles(const ghc::filesystem::path& path, const std::function<void(const ghc::filesystem::path&)>& onFile, const std::function<void(const ghc::filesystem::path&)>& onFolder = nullptr);
+    
+    //! Find the .sav's and .lsdsng's in the inputs, recursing into folders
+    /*! @return The absolute paths, sorted and without duplicates */
+    std::vector<ghc::filesystem::path> collectSongFiles(const std::vector<std::string>& inputs);
+    
+    //! Read every song in a .sav (including its working memory song) or .lsdsng
+    /*! @return False if the file couldn't be read */
+    bool readSongs(const ghc::filesystem::path& path, const SongVisitor& visitor);
+    
+    //! A slot as it's printed: WM for the working memory song, - for an .lsdsng, or the project index
+    std::string formatSlot(uint8_t slot);
+}
+
+#endif
@@ -0,0 +1,63 @@
+#include "song_passes.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include <lsdj/clean.h>
+#include <lsdj/mono.h>
+#include <lsdj/wave.h>
+
+namespace lsdj
+{
+    bool MonoPass::apply(lsdj_song_t* song, std::ostream&) const
+    {
+        assert(song != nullptr);
+        
+        unsigned int flags = 0;
+        if (processInstruments)
+            flags |= LSDJ_MONO_INSTRUMENTS;
+        if (processTables)
+            flags |= LSDJ_MONO_TABLES;
+        if (processPhrases)
+            flags |= LSDJ_MONO_PHRASES;
+        
+        lsdj_song_make_mono(song, flags);
+        
+        return true;
+    }
+
+    bool CleanPass::apply(lsdj_song_t* song, std::ostream&) const
+    {
+        assert(song != nullptr);
+        
+        lsdj_song_clean(song);
+        
+        if (deduplicate)
+        {
+            // Phrases first, merging those can turn chains into duplicates
+            lsdj_song_deduplicate_phrases(song);
+            lsdj_song_deduplicate_chains(song);
+        }
+        
+        return true;
+    }
+
+    WavetablePass::WavetablePass(std::vector<WaveFrame> frames, uint8_t index) :
+        frames(std::move(frames)),
+        index(index)
+    {
+        // Frames beyond the last wave don't fit
+        this->frames.resize(std::min<size_t>(this->frames.size(), 0x100 - index));
+    }
+
+    bool WavetablePass::apply(lsdj_song_t* song, std::ostream&) const
+    {
+        assert(song != nullptr);
+        
+        for (size_t i = 0; i < frames.size(); ++i)
+            lsdj_wave_set_bytes(song, static_cast<uint8_t>(index + i), frames[i].data());
+        
+        return true;
+    }
+}
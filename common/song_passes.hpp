@@ -0,0 +1,71 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <lsdj/song.h>
+
+#include "wavetable.hpp"
+
+namespace lsdj
+{
+    //! A single transformation of a song, which can be chained with others in a pipeline
+    class SongPass
+    {
+    public:
+        virtual ~SongPass() = default;
+        
+        //! A short description of what the pass does, for logging
+        [[nodiscard]] virtual std::string getName() const = 0;
+        
+        //! Transform a song in place
+        /*! Passes are applied to several songs simultaneously, so they shouldn't change themselves */
+        virtual bool apply(lsdj_song_t* song, std::ostream& log) const = 0;
+    };
+    
+    //! Changes all panning to play on both the left and the right
+    class MonoPass :
+        public SongPass
+    {
+    public:
+        bool processInstruments = true;
+        bool processTables = true;
+        bool processPhrases = true;
+        
+    public:
+        [[nodiscard]] std::string getName() const final { return "mono"; }
+        bool apply(lsdj_song_t* song, std::ostream& log) const final;
+    };
+    
+    //! Resets everything that can't be reached from the song screen
+    class CleanPass :
+        public SongPass
+    {
+    public:
+        //! Merge duplicate phrases and chains after cleaning
+        bool deduplicate = false;
+        
+    public:
+        [[nodiscard]] std::string getName() const final { return deduplicate ? "clean and deduplicate" : "clean"; }
+        bool apply(lsdj_song_t* song, std::ostream& log) const final;
+    };
+    
+    //! Writes a wavetable into the waves of a song, overwriting whatever was there
+    class WavetablePass :
+        public SongPass
+    {
+    public:
+        WavetablePass(std::vector<WaveFrame> frames, uint8_t index);
+        
+    public:
+        [[nodiscard]] std::string getName() const final { return "wavetable"; }
+        bool apply(lsdj_song_t* song, std::ostream& log) const final;
+        
+    private:
+        std::vector<WaveFrame> frames;
+        
+        //! The index of the wave the first frame is written to
+        uint8_t index = 0;
+    };
+}
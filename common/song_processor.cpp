@@ -2,49 +2,129 @@
 
 #include <cassert>
 #include <ghc/filesystem.hpp>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
+#include <sstream>
 
 #include <lsdj/error.h>
+#include <lsdj/hash.h>
 #include <lsdj/sav.h>
 
 #include "common.hpp"
+#include "song_library.hpp"
+#include "stream.hpp"
+#include "thread_pool.hpp"
 
 namespace lsdj
 {
+    namespace
+    {
+        //! The buffered output of a single file
+        struct FileLog
+        {
+            std::ostringstream output;
+            std::ostringstream errors;
+            bool done = false;
+            bool succeeded = false;
+        };
+        
+        //! The log of the file being processed on this thread, if any
+        thread_local FileLog* currentLog = nullptr;
+    }
+
     bool SongProcessor::process(const ghc::filesystem::path& path)
-    {        
-        if (isHiddenFile(path.filename().string()))
-            return true;
+    {
+        // Folders passed with a trailing separator have an empty file name
+        if (path.filename().empty() && path.has_parent_path() && path.parent_path() != path)
+            return process(path.parent_path());
         
-        if (ghc::filesystem::is_directory(path))
-        {
-            if (processDirectory(path) != 0)
-                return false;
-        }
-        else if (path.extension() == ".sav")
-        {
-            if (processSav(path) != 0)
-                return false;
-        }
-        else if (path.extension() == ".lsdsng")
+        const size_t modified = modifiedCount;
+        const size_t unmodified = unmodifiedCount;
+        
+        bool success = false;
+        if (isStandardStream(path))
         {
-            if (processLsdsng(path) != 0)
-                return false;
+            success = processStream();
+        } else {
+            std::vector<ghc::filesystem::path> files;
+            walkSongFiles(path, [&](const ghc::filesystem::path& file){ files.emplace_back(file); }, [&](const ghc::filesystem::path& folder)
+            {
+                if (verbose)
+                    log() << "Processing folder '" << folder.string() << "'" << std::endl;
+            });
+            
+            success = processFiles(files);
         }
         
-        return true;
+        if (modifiedCount != modified || unmodifiedCount != unmodified)
+            log() << "Modified " << (modifiedCount - modified) << " file(s), " << (unmodifiedCount - unmodified) << " unchanged" << std::endl;
+        
+        return success;
     }
 
-    bool SongProcessor::processDirectory(const ghc::filesystem::path& path)
+    std::ostream& SongProcessor::log()
     {
-        if (verbose)
-            std::cout << "Processing folder '" << path.string() << "'" << std::endl;
+        if (currentLog)
+            return currentLog->output;
         
-        for (auto it = ghc::filesystem::directory_iterator(path); it != ghc::filesystem::directory_iterator(); ++it)
+        // stdout carries the songs when streaming
+        return streaming ? std::cerr : std::cout;
+    }
+
+    void SongProcessor::logError(lsdj_error_t error)
+    {
+        logError(lsdj_error_get_description(error));
+    }
+
+    void SongProcessor::logError(const std::string& message)
+    {
+        std::ostream& stream = currentLog ? currentLog->errors : std::cerr;
+        stream << "ERROR: " << message << std::endl;
+    }
+
+    bool SongProcessor::processFiles(const std::vector<ghc::filesystem::path>& paths)
+    {
+        std::vector<FileLog> logs(paths.size());
+        std::mutex logMutex;
+        size_t nextLog = 0;
+        bool success = true;
+        
+        auto run = [&](size_t index)
         {
-            if (process(it->path()) != 0)
-                return false;
-        }
+            currentLog = &logs[index];
+            const bool succeeded = processFile(paths[index]);
+            currentLog = nullptr;
+            
+            std::lock_guard<std::mutex> lock(logMutex);
+            logs[index].done = true;
+            logs[index].succeeded = succeeded;
+            
+            // Print the logs of the files that are done, but never before those of earlier files
+            for (; nextLog < logs.size() && logs[nextLog].done; ++nextLog)
+            {
+                const auto& log = logs[nextLog];
+                std::cout << log.output.str() << std::flush;
+                
+                if (!log.succeeded)
+                {
+                    std::cerr << "Failed to process '" << paths[nextLog].string() << "'\n" << log.errors.str() << std::flush;
+                    success = false;
+                }
+            }
+        };
+        
+        ThreadPool::forEach(jobs, paths.size(), run);
+        
+        return success;
+    }
+
+    bool SongProcessor::processFile(const ghc::filesystem::path& path)
+    {
+        if (path.extension() == ".sav")
+            return processSav(path);
+        else if (path.extension() == ".lsdsng")
+            return processLsdsng(path);
         
         return true;
     }
@@ -58,23 +138,61 @@ namespace lsdj
         lsdj_error_t error = lsdj_sav_read_from_file(path.string().c_str(), &sav, nullptr);
         if (error != LSDJ_SUCCESS)
         {
-            handle_error(error);
+            logError(error);
             lsdj_sav_free(sav);
             return false;
         }
         
         if (verbose)
-            std::cout << "Processing sav '" + path.string() + "'" << std::endl;
+            log() << "Processing sav '" + path.string() + "'" << std::endl;
         
-        auto song = lsdj_sav_get_working_memory_song(sav);
-        assert(song != nullptr);
-
-        if (!processSong(song))
+        // Remember what the songs looked like, so untouched files don't need to be written
+        bool changed = false;
+        if (!processSavSongs(sav, path, changed))
         {
             lsdj_sav_free(sav);
             return false;
         }
         
+        if (!shouldWriteSongs())
+        {
+            lsdj_sav_free(sav);
+            return true;
+        }
+        
+        const auto destination = constructSavDestinationPath(path);
+        if (!changed)
+        {
+            lsdj_sav_free(sav);
+            return skipUnchanged(path, destination);
+        }
+        
+        ++modifiedCount;
+        error = lsdj_sav_write_to_file(sav, destination.string().c_str(), nullptr);
+        if (error != LSDJ_SUCCESS)
+        {
+            logError(error);
+            lsdj_sav_free(sav);
+            return false;
+        }
+        
+        lsdj_sav_free(sav);
+        
+        return true;
+    }
+
+    bool SongProcessor::processSavSongs(lsdj_sav_t* sav, const ghc::filesystem::path& path, bool& changed)
+    {
+        const auto stem = path.stem().string();
+        
+        auto song = lsdj_sav_get_working_memory_song(sav);
+        assert(song != nullptr);
+        
+        auto hash = lsdj_song_hash(song);
+        if (!processSong(song, path, stem + "_WM"))
+            return false;
+        changed |= lsdj_song_hash(song) != hash;
+        
         for (int i = 0; i < LSDJ_SAV_PROJECT_COUNT; ++i)
         {
             lsdj_project_t* project = lsdj_sav_get_project(sav, i);
@@ -83,23 +201,16 @@ namespace lsdj
             
             auto song = lsdj_project_get_song(project);
             assert(song != nullptr);
+            
+            std::ostringstream name;
+            name << stem << '_' << std::setfill('0') << std::setw(2) << i << '_' << constructProjectName(project, true);
 
-            if (!processSong(song))
-            {
-                lsdj_sav_free(sav);
+            hash = lsdj_song_hash(song);
+            if (!processSong(song, path, name.str()))
                 return false;
-            }
+            changed |= lsdj_song_hash(song) != hash;
         }
         
-        lsdj_sav_write_to_file(sav, constructSavDestinationPath(path).string().c_str(), nullptr);
-        if (error != LSDJ_SUCCESS)
-        {
-            lsdj_sav_free(sav);
-            return false;
-        }
-        
-        lsdj_sav_free(sav);
-        
         return true;
     }
 
@@ -112,27 +223,40 @@ namespace lsdj
         lsdj_error_t error = lsdj_project_read_lsdsng_from_file(path.string().c_str(), &project, nullptr);
         if (error != LSDJ_SUCCESS)
         {
-            handle_error(error);
+            logError(error);
             lsdj_project_free(project);
             return false;
         }
         
         if (verbose)
-            std::cout << "Processing lsdsng '" + path.string() + "'" << std::endl;
-        
-        auto song = lsdj_project_get_song(project);
-        assert(song != nullptr);
+            log() << "Processing lsdsng '" + path.string() + "'" << std::endl;
         
-        if (!processSong(song))
+        bool changed = false;
+        if (!processLsdsngSong(project, path, changed))
         {
             lsdj_project_free(project);
             return false;
         }
         
-        error = lsdj_project_write_lsdsng_to_file(project, constructLsdsngDestinationPath(path).string().c_str(), nullptr);
+        if (!shouldWriteSongs())
+        {
+            lsdj_project_free(project);
+            return true;
+        }
+        
+        const auto destination = constructLsdsngDestinationPath(path);
+        if (!changed)
+        {
+            lsdj_project_free(project);
+            return skipUnchanged(path, destination);
+        }
+        
+        ++modifiedCount;
+        
+        error = lsdj_project_write_lsdsng_to_file(project, destination.string().c_str(), nullptr);
         if (error != LSDJ_SUCCESS)
         {
-            handle_error(error);
+            logError(error);
             lsdj_project_free(project);
             return false;
         }
@@ -141,4 +265,166 @@ namespace lsdj
         
         return true;
     }
+
+    bool SongProcessor::processLsdsngSong(lsdj_project_t* project, const ghc::filesystem::path& path, bool& changed)
+    {
+        auto song = lsdj_project_get_song(project);
+        assert(song != nullptr);
+        
+        const auto hash = lsdj_song_hash(song);
+        if (!processSong(song, path, path.stem().string()))
+            return false;
+        changed |= lsdj_song_hash(song) != hash;
+        
+        return true;
+    }
+
+    bool SongProcessor::processStream()
+    {
+        streaming = true;
+        
+        // Frames go out the same way they came in, a single file stays a single file
+        std::vector<StreamFrame> frames;
+        bool framed = false;
+        if (!readStandardInputFrames("stdin", frames, framed))
+        {
+            std::cerr << "ERROR: The stream on stdin is cut off" << std::endl;
+            return false;
+        }
+        
+        bool success = true;
+        for (auto& frame : frames)
+        {
+            const ghc::filesystem::path path = frame.name;
+            
+            if (!processFrame(frame))
+            {
+                std::cerr << "Failed to process '" << frame.name << "'" << std::endl;
+                success = false;
+                continue;
+            }
+            
+            if (!shouldWriteSongs())
+                continue;
+            
+            const auto destination = path.extension() == ".sav" ? constructSavDestinationPath(path) : constructLsdsngDestinationPath(path);
+            const bool written = framed ?
+                writeFrame((path.parent_path() / destination.filename()).generic_string(), frame.data) :
+                writeStandardOutput(frame.data.data(), frame.data.size());
+            
+            if (!written)
+            {
+                handle_error(LSDJ_WRITE_FAILED);
+                return false;
+            }
+        }
+        
+        return success;
+    }
+
+    bool SongProcessor::processFrame(StreamFrame& frame)
+    {
+        const ghc::filesystem::path path = frame.name;
+        lsdj_error_t error = LSDJ_SUCCESS;
+        bool changed = false;
+        
+        if (path.extension() == ".sav")
+        {
+            // Frames that aren't processed pass through untouched
+            if (!shouldProcessSav(path))
+                return true;
+            
+            lsdj_sav_t* sav = nullptr;
+            error = lsdj_sav_read_from_memory(frame.data.data(), frame.data.size(), &sav, nullptr);
+            if (error != LSDJ_SUCCESS)
+            {
+                logError(error);
+                return false;
+            }
+            
+            if (verbose)
+                log() << "Processing sav '" + frame.name + "'" << std::endl;
+            
+            if (!processSavSongs(sav, path, changed))
+            {
+                lsdj_sav_free(sav);
+                return false;
+            }
+            
+            if (changed && shouldWriteSongs())
+                error = writeSav(sav, frame.data);
+            
+            lsdj_sav_free(sav);
+        } else if (path.extension() == ".lsdsng") {
+            if (!shouldProcessLsdsng(path))
+                return true;
+            
+            lsdj_project_t* project = nullptr;
+            error = lsdj_project_read_lsdsng_from_memory(frame.data.data(), frame.data.size(), &project, nullptr);
+            if (error != LSDJ_SUCCESS)
+            {
+                logError(error);
+                return false;
+            }
+            
+            if (verbose)
+                log() << "Processing lsdsng '" + frame.name + "'" << std::endl;
+            
+            if (!processLsdsngSong(project, path, changed))
+            {
+                lsdj_project_free(project);
+                return false;
+            }
+            
+            if (changed && shouldWriteSongs())
+                error = writeLsdsng(project, frame.data);
+            
+            lsdj_project_free(project);
+        } else {
+            return true;
+        }
+        
+        if (error != LSDJ_SUCCESS)
+        {
+            logError(error);
+            return false;
+        }
+        
+        // Unchanged songs don't need recompressing, the original bytes go back out
+        if (!shouldWriteSongs())
+            return true;
+        else if (changed)
+            ++modifiedCount;
+        else
+            ++unmodifiedCount;
+        
+        return true;
+    }
+
+    bool SongProcessor::skipUnchanged(const ghc::filesystem::path& source, const ghc::filesystem::path& destination)
+    {
+        ++unmodifiedCount;
+        
+        if (destination == source)
+        {
+            if (verbose)
+                log() << "Nothing changed, leaving '" << source.string() << "' untouched" << std::endl;
+            
+            return true;
+        }
+        
+        // The result still has to end up at the destination, but copying saves recompressing
+        std::error_code error;
+        ghc::filesystem::copy_file(source, destination, ghc::filesystem::copy_options::overwrite_existing, error);
+        if (error)
+        {
+            logError(error.message());
+            return false;
+        }
+        
+        if (verbose)
+            log() << "Nothing changed, copied '" << source.string() << "' to '" << destination.string() << "'" << std::endl;
+        
+        return true;
+    }
 }
@@ -1,24 +1,65 @@
 #pragma once
 
+#include <atomic>
 #include <ghc/filesystem.hpp>
+#include <ostream>
+#include <string>
 #include <vector>
 
+#include <lsdj/error.h>
+#include <lsdj/project.h>
+#include <lsdj/sav.h>
 #include <lsdj/song.h>
 
 namespace lsdj
 {
+    struct StreamFrame;
+    
     class SongProcessor
     {
     public:
+        //! Process a sav, an lsdsng, or all of them in a folder and its sub-folders
+        /*! A file that fails doesn't stop the others from being processed. The output of
+            every file is printed in the same order, however many jobs are used.
+         
+            A path of "-" reads a sav, an lsdsng or a stream of frames from stdin, and writes
+            the results to stdout in the same form.
+            @return Whether all of the files were processed successfully */
         bool process(const ghc::filesystem::path& path);
         
     public:
         bool verbose = false;
         
+        //! The amount of files that may be processed simultaneously
+        unsigned int jobs = 1;
+        
+        //! The amount of files that were written, because at least one of their songs changed
+        [[nodiscard]] size_t getModifiedCount() const { return modifiedCount; }
+        
+        //! The amount of files that weren't rewritten, because none of their songs changed
+        [[nodiscard]] size_t getUnmodifiedCount() const { return unmodifiedCount; }
+        
+    protected:
+        //! The output stream for the file being processed on this thread
+        /*! Write to this instead of std::cout, so that files processed in parallel don't interleave */
+        std::ostream& log();
+        
+        //! Report an error for the file being processed on this thread
+        void logError(lsdj_error_t error);
+        
+        //! Report an error for the file being processed on this thread
+        void logError(const std::string& message);
+        
     private:
-        bool processDirectory(const ghc::filesystem::path& path);
+        bool processFiles(const std::vector<ghc::filesystem::path>& paths);
+        bool processFile(const ghc::filesystem::path& path);
         bool processSav(const ghc::filesystem::path& path);
         bool processLsdsng(const ghc::filesystem::path& path);
+        bool processSavSongs(lsdj_sav_t* sav, const ghc::filesystem::path& path, bool& changed);
+        bool processLsdsngSong(lsdj_project_t* project, const ghc::filesystem::path& path, bool& changed);
+        bool processStream();
+        bool processFrame(StreamFrame& frame);
+        bool skipUnchanged(const ghc::filesystem::path& source, const ghc::filesystem::path& destination);
         
         [[nodiscard]] virtual bool shouldProcessSav(const ghc::filesystem::path& path) const { return true; }
         [[nodiscard]] virtual bool shouldProcessLsdsng(const ghc::filesystem::path& path) const { return true; }
@@ -26,6 +67,20 @@ namespace lsdj
         [[nodiscard]] virtual ghc::filesystem::path constructSavDestinationPath(const ghc::filesystem::path& path) { return path; }
         [[nodiscard]] virtual ghc::filesystem::path constructLsdsngDestinationPath(const ghc::filesystem::path& path) { return path; }
         
-        virtual bool processSong(lsdj_song_t* song) = 0;
+        //! Whether the processed songs should be written back to disk
+        [[nodiscard]] virtual bool shouldWriteSongs() const { return true; }
+        
+        //! Process a song, knowing the file it came from and a name that identifies it within that file
+        /*! The name is the file stem for lsdsng's, and "<stem>_WM" or "<stem>_<index>_<project>" for sav's */
+        virtual bool processSong(lsdj_song_t* song, const ghc::filesystem::path& source, const std::string& name) { return processSong(song); }
+        
+        virtual bool processSong(lsdj_song_t* song) { return true; }
+        
+    private:
+        std::atomic<size_t> modifiedCount{0};
+        std::atomic<size_t> unmodifiedCount{0};
+        
+        //! Whether songs are being written to stdout, so output should go to stderr
+        bool streaming = false;
     };
 }
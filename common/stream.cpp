@@ -0,0 +1,247 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "stream.hpp"
+
+namespace lsdj
+{
+    namespace
+    {
+        constexpr std::array<uint8_t, 4> FRAME_MAGIC = { 0x89, 'L', 'S', 'J' };
+        
+        //! stdin and stdout are opened in text mode on Windows, which mangles line endings
+        void setBinaryMode(FILE* file)
+        {
+#ifdef _WIN32
+            _setmode(_fileno(file), _O_BINARY);
+#else
+            (void)file;
+#endif
+        }
+        
+        void appendLittleEndian(std::vector<uint8_t>& data, uint32_t value, size_t byteCount)
+        {
+            for (size_t i = 0; i < byteCount; ++i)
+                data.emplace_back(static_cast<uint8_t>(value >> (i * 8)));
+        }
+        
+        uint32_t readLittleEndian(const uint8_t* data, size_t byteCount)
+        {
+            uint32_t value = 0;
+            for (size_t i = 0; i < byteCount; ++i)
+                value |= static_cast<uint32_t>(data[i]) << (i * 8);
+            return value;
+        }
+    }
+
+    bool isStandardStream(const ghc::filesystem::path& path)
+    {
+        return path.string() == "-";
+    }
+
+    ghc::filesystem::path absoluteUnlessStandardStream(const std::string& path)
+    {
+        return isStandardStream(path) ? ghc::filesystem::path(path) : ghc::filesystem::absolute(path);
+    }
+
+    std::vector<uint8_t> readStandardInput()
+    {
+        setBinaryMode(stdin);
+        
+        std::vector<uint8_t> data;
+        std::array<uint8_t, 0x10000> buffer;
+        
+        size_t count = 0;
+        while ((count = fread(buffer.data(), 1, buffer.size(), stdin)) > 0)
+            data.insert(data.end(), buffer.begin(), buffer.begin() + count);
+        
+        return data;
+    }
+
+    bool writeStandardOutput(const uint8_t* data, size_t size)
+    {
+        setBinaryMode(stdout);
+        
+        return fwrite(data, 1, size, stdout) == size && fflush(stdout) == 0;
+    }
+
+    bool isFrameStream(const std::vector<uint8_t>& data)
+    {
+        return data.size() >= FRAME_MAGIC.size() && std::equal(FRAME_MAGIC.begin(), FRAME_MAGIC.end(), data.begin());
+    }
+
+    bool isSav(const std::vector<uint8_t>& data)
+    {
+        return data.size() == LSDJ_SAV_SIZE && lsdj_sav_is_likely_valid_memory(data.data(), data.size());
+    }
+
+    bool readFrames(const std::vector<uint8_t>& data, std::vector<StreamFrame>& frames)
+    {
+        size_t position = 0;
+        while (position < data.size())
+        {
+            if (data.size() - position < FRAME_MAGIC.size() + 2 ||
+                !std::equal(FRAME_MAGIC.begin(), FRAME_MAGIC.end(), data.begin() + position))
+                return false;
+            position += FRAME_MAGIC.size();
+            
+            const size_t nameLength = readLittleEndian(&data[position], 2);
+            position += 2;
+            if (data.size() - position < nameLength + 4)
+                return false;
+            
+            StreamFrame frame;
+            frame.name.assign(data.begin() + position, data.begin() + position + nameLength);
+            position += nameLength;
+            
+            const size_t dataLength = readLittleEndian(&data[position], 4);
+            position += 4;
+            if (data.size() - position < dataLength)
+                return false;
+            
+            frame.data.assign(data.begin() + position, data.begin() + position + dataLength);
+            position += dataLength;
+            
+            frames.emplace_back(std::move(frame));
+        }
+        
+        return true;
+    }
+
+    bool writeFrame(const std::string& name, const std::vector<uint8_t>& data)
+    {
+        std::vector<uint8_t> frame(FRAME_MAGIC.begin(), FRAME_MAGIC.end());
+        frame.reserve(FRAME_MAGIC.size() + 2 + name.size() + 4 + data.size());
+        
+        appendLittleEndian(frame, static_cast<uint32_t>(name.size()), 2);
+        frame.insert(frame.end(), name.begin(), name.end());
+        appendLittleEndian(frame, static_cast<uint32_t>(data.size()), 4);
+        frame.insert(frame.end(), data.begin(), data.end());
+        
+        return writeStandardOutput(frame.data(), frame.size());
+    }
+
+    bool readStandardInputFrames(const std::string& name, std::vector<StreamFrame>& frames, bool& framed)
+    {
+        auto data = readStandardInput();
+        
+        framed = isFrameStream(data);
+        if (framed)
+            return readFrames(data, frames);
+        
+        StreamFrame frame;
+        frame.name = name + (isSav(data) ? ".sav" : ".lsdsng");
+        frame.data = std::move(data);
+        frames.emplace_back(std::move(frame));
+        
+        return true;
+    }
+
+    lsdj_error_t readSav(const ghc::filesystem::path& path, lsdj_sav_t** sav)
+    {
+        if (!isStandardStream(path))
+            return lsdj_sav_read_from_file(path.string().c_str(), sav, nullptr);
+        
+        const auto data = readStandardInput();
+        return lsdj_sav_read_from_memory(data.data(), data.size(), sav, nullptr);
+    }
+
+    lsdj_error_t writeSav(const lsdj_sav_t* sav, const ghc::filesystem::path& path)
+    {
+        if (!isStandardStream(path))
+            return lsdj_sav_write_to_file(sav, path.string().c_str(), nullptr);
+        
+        std::vector<uint8_t> data;
+        const lsdj_error_t error = writeSav(sav, data);
+        if (error != LSDJ_SUCCESS)
+            return error;
+        
+        return writeStandardOutput(data.data(), data.size()) ? LSDJ_SUCCESS : LSDJ_WRITE_FAILED;
+    }
+
+    lsdj_error_t readLsdsng(const ghc::filesystem::path& path, lsdj_project_t** project)
+    {
+        if (!isStandardStream(path))
+            return lsdj_project_read_lsdsng_from_file(path.string().c_str(), project, nullptr);
+        
+        const auto data = readStandardInput();
+        return lsdj_project_read_lsdsng_from_memory(data.data(), data.size(), project, nullptr);
+    }
+
+    lsdj_error_t writeLsdsng(const lsdj_project_t* project, const ghc::filesystem::path& path)
+    {
+        if (!isStandardStream(path))
+            return lsdj_project_write_lsdsng_to_file(project, path.string().c_str(), nullptr);
+        
+        std::vector<uint8_t> data;
+        const lsdj_error_t error = writeLsdsng(project, data);
+        if (error != LSDJ_SUCCESS)
+            return error;
+        
+        return writeStandardOutput(data.data(), data.size()) ? LSDJ_SUCCESS : LSDJ_WRITE_FAILED;
+    }
+
+    lsdj_error_t writeSav(const lsdj_sav_t* sav, std::vector<uint8_t>& data)
+    {
+        data.resize(LSDJ_SAV_SIZE);
+        
+        size_t size = 0;
+        const lsdj_error_t error = lsdj_sav_write_to_memory(sav, data.data(), data.size(), &size);
+        data.resize(size);
+        
+        return error;
+    }
+
+    lsdj_error_t writeLsdsng(const lsdj_project_t* project, std::vector<uint8_t>& data)
+    {
+        data.resize(LSDSNG_MAX_SIZE);
+        
+        size_t size = 0;
+        const lsdj_error_t error = lsdj_project_write_lsdsng_to_memory(project, data.data(), &size);
+        data.resize(size);
+        
+        return error;
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#ifndef LSDJ_STREAM_HPP
+#define LSDJ_STREAM_HPP
+
+#include <cstdint>
+#include <ghc/filesystem.hpp>
+#include <string>
+#include <vector>
+
+#include <lsdj/error.h>
+#include <lsdj/project.h>
+#include <lsdj/sav.h>
+
+/* Every tool accepts "-" as a path, meaning stdin for input or stdout for output.
+ 
+   To pipe several files between tools, they are wrapped in frames: a 4-byte magic
+   (0x89 'L' 'S' 'J'), the length of the file name as 16-bit little endian, the file
+   name, the length of the data as 32-bit little endian and then the data itself.
+   A stream is any amount of frames back to back, so streams can be concatenated. */
+
+namespace lsdj
+{
+    //! A named file within a stream of several
+    struct StreamFrame
+    {
+        std::string name;
+        std::vector<uint8_t> data;
+    };
+    
+    //! Whether a path on the command line means stdin or stdout
+    bool isStandardStream(const ghc::filesystem::path& path);
+    
+    //! Make a path from the command line absolute, unless it means stdin or stdout
+    ghc::filesystem::path absoluteUnlessStandardStream(const std::string& path);
+    
+    //! Read everything there is on stdin
+    std::vector<uint8_t> readStandardInput();
+    
+    //! Write bytes to stdout
+    bool writeStandardOutput(const uint8_t* data, size_t size);
+    
+    //! Whether bytes are a stream of frames, rather than a single file
+    bool isFrameStream(const std::vector<uint8_t>& data);
+    
+    //! Whether bytes are a sav, rather than an lsdsng
+    bool isSav(const std::vector<uint8_t>& data);
+    
+    //! Split a stream into its frames
+    /*! @return False if the stream is cut off or malformed */
+    bool readFrames(const std::vector<uint8_t>& data, std::vector<StreamFrame>& frames);
+    
+    //! Write a single frame to stdout
+    bool writeFrame(const std::string& name, const std::vector<uint8_t>& data);
+    
+    //! Read the bytes of stdin as frames, wrapping a single sav or lsdsng in a frame of its own
+    /*! @param name The name given to a single file, without extension
+        @param framed Whether stdin held a stream of frames, rather than a single file */
+    bool readStandardInputFrames(const std::string& name, std::vector<StreamFrame>& frames, bool& framed);
+    
+    // Read or write a sav or lsdsng from a path, or from stdin/stdout if the path is "-"
+    lsdj_error_t readSav(const ghc::filesystem::path& path, lsdj_sav_t** sav);
+    lsdj_error_t writeSav(const lsdj_sav_t* sav, const ghc::filesystem::path& path);
+    lsdj_error_t readLsdsng(const ghc::filesystem::path& path, lsdj_project_t** project);
+    lsdj_error_t writeLsdsng(const lsdj_project_t* project, const ghc::filesystem::path& path);
+    
+    // Compress a sav or lsdsng into memory, for writing it as a frame
+    lsdj_error_t writeSav(const lsdj_sav_t* sav, std::vector<uint8_t>& data);
+    lsdj_error_t writeLsdsng(const lsdj_project_t* project, std::vector<uint8_t>& data);
+}
+
+#endif
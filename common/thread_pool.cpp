@@ -0,0 +1,213 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace lsdj
+{
+    namespace
+    {
+        //! The pool the current thread is a worker of, if any
+        thread_local const ThreadPool* currentPool = nullptr;
+        
+        //! The index of the current worker within its pool
+        thread_local size_t currentIndex = 0;
+    }
+
+    ThreadPool::ThreadPool(unsigned int threadCount)
+    {
+        threadCount = std::max(threadCount, 1u);
+        
+        for (unsigned int i = 0; i < threadCount; ++i)
+            queues.emplace_back(std::make_unique<Queue>());
+        
+        for (unsigned int i = 0; i < threadCount; ++i)
+            workers.emplace_back([this, i]() { work(i); });
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        sleeper.notify_all();
+        
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    void ThreadPool::submit(Task task)
+    {
+        // Workers push onto their own queue, outsiders spread their tasks round-robin
+        const size_t index = currentPool == this ? currentIndex : nextQueue++ % queues.size();
+        
+        // The count goes up before the task becomes visible, so it never drops below zero.
+        // Taking the sleep lock makes sure no worker is in between checking the count and
+        // going to sleep, which would lose this wake-up.
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            ++queued;
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.emplace_back(std::move(task));
+        }
+        
+        sleeper.notify_one();
+        waiters.notify_all();
+    }
+
+    void ThreadPool::submit(Group& group, Task task)
+    {
+        ++group.pending;
+        submit([this, &group, task = std::move(task)]()
+        {
+            task();
+            
+            // Under the sleep lock, so a waiter can't miss this between checking and blocking
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                --group.pending;
+            }
+            waiters.notify_all();
+        });
+    }
+
+    void ThreadPool::wait(Group& group)
+    {
+        waitUntilBelow(group, 1);
+    }
+
+    void ThreadPool::waitUntilBelow(Group& group, size_t count)
+    {
+        const size_t index = currentPool == this ? currentIndex : 0;
+        
+        while (group.pending >= count)
+        {
+            // Help out while waiting, and only block once there is nothing left to do
+            if (runOne(index))
+                continue;
+            
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            waiters.wait(lock, [&]() { return group.pending < count || queued > 0; });
+        }
+    }
+
+    void ThreadPool::forEach(unsigned int jobs, size_t count, const std::function<void(size_t)>& function)
+    {
+        const auto threadCount = std::min<size_t>(std::max(jobs, 1u), count);
+        if (threadCount <= 1)
+        {
+            for (size_t i = 0; i < count; ++i)
+                function(i);
+            return;
+        }
+        
+        ThreadPool pool(static_cast<unsigned int>(threadCount - 1));
+        Group group;
+        
+        for (size_t i = 0; i < count; ++i)
+            pool.submit(group, [&function, i]() { function(i); });
+        
+        pool.wait(group);
+    }
+
+    void ThreadPool::work(size_t index)
+    {
+        currentPool = this;
+        currentIndex = index;
+        
+        while (true)
+        {
+            if (runOne(index))
+                continue;
+            
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleeper.wait(lock, [this]() { return stopping || queued > 0; });
+            
+            if (stopping && queued == 0)
+                return;
+        }
+    }
+
+    bool ThreadPool::runOne(size_t index)
+    {
+        Task task;
+        if (!pop(index, task) && !steal(index, task))
+            return false;
+        
+        --queued;
+        task();
+        
+        return true;
+    }
+
+    bool ThreadPool::pop(size_t index, Task& task)
+    {
+        auto& queue = *queues[index];
+        
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            return false;
+        
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        
+        return true;
+    }
+
+    bool ThreadPool::steal(size_t index, Task& task)
+    {
+        for (size_t i = 1; i < queues.size(); ++i)
+        {
+            auto& queue = *queues[(index + i) % queues.size()];
+            
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty())
+                continue;
+            
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            
+            return true;
+        }
+        
+        return false;
+    }
+}
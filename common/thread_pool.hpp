@@ -0,0 +1,131 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#ifndef LSDJ_THREAD_POOL_HPP
+#define LSDJ_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lsdj
+{
+    //! A fixed set of worker threads that share work by stealing tasks from each other
+    /*! Every worker owns a queue. Tasks submitted from a worker go onto its own queue,
+        which it drains newest-first, while idle workers steal the oldest tasks from
+        the others. Tasks may submit and wait on sub-tasks; waiting threads keep
+        running queued tasks, so nested waits cannot deadlock the pool. */
+    class ThreadPool
+    {
+    public:
+        using Task = std::function<void()>;
+        
+        //! Counts the unfinished tasks of a group, so they can be waited on together
+        class Group
+        {
+            friend class ThreadPool;
+            
+        public:
+            [[nodiscard]] bool isDone() const { return pending == 0; }
+            
+        private:
+            std::atomic<size_t> pending{0};
+        };
+        
+    public:
+        //! Create a pool with a given amount of worker threads (at least one)
+        explicit ThreadPool(unsigned int threadCount);
+        ~ThreadPool();
+        
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        
+        //! Queue a task for execution
+        void submit(Task task);
+        
+        //! Queue a task that is part of a group
+        void submit(Group& group, Task task);
+        
+        //! Block until all tasks of a group have finished, running queued tasks meanwhile
+        void wait(Group& group);
+        
+        //! Block until the amount of unfinished tasks in a group drops to a maximum
+        void waitUntilBelow(Group& group, size_t count);
+        
+        [[nodiscard]] unsigned int getThreadCount() const { return static_cast<unsigned int>(workers.size()); }
+        
+        //! Run a function for 0 to count on as many threads as there are jobs, and wait for all of them
+        /*! The calling thread helps out while waiting, so it counts as one of the jobs */
+        static void forEach(unsigned int jobs, size_t count, const std::function<void(size_t)>& function);
+        
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+        
+    private:
+        void work(size_t index);
+        bool runOne(size_t index);
+        bool pop(size_t index, Task& task);
+        bool steal(size_t index, Task& task);
+        
+    private:
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+        
+        //! The amount of tasks sitting in any of the queues
+        std::atomic<size_t> queued{0};
+        
+        //! The queue tasks from outside of the pool are pushed to next
+        std::atomic<size_t> nextQueue{0};
+        
+        std::mutex sleepMutex;
+        std::condition_variable sleeper;
+        
+        //! Wakes threads waiting on a group, whenever a grouped task finishes or new work comes in
+        std::condition_variable waiters;
+        bool stopping = false;
+    };
+}
+
+#endif
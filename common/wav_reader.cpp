@@ -0,0 +1,155 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include "wav_reader.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace lsdj
+{
+    namespace
+    {
+        constexpr uint16_t FORMAT_PCM = 0x0001;
+        constexpr uint16_t FORMAT_FLOAT = 0x0003;
+        constexpr uint16_t FORMAT_EXTENSIBLE = 0xFFFE;
+        
+        uint32_t readLittleEndian(const uint8_t* bytes, size_t size)
+        {
+            uint32_t value = 0;
+            for (size_t i = 0; i < size; ++i)
+                value |= static_cast<uint32_t>(bytes[i]) << (i * 8);
+            
+            return value;
+        }
+        
+        //! Convert a single sample to [-1, 1]
+        float decodeSample(const uint8_t* bytes, uint16_t format, uint16_t bitsPerSample)
+        {
+            if (format == FORMAT_FLOAT)
+            {
+                const uint32_t bits = readLittleEndian(bytes, 4);
+                float value;
+                memcpy(&value, &bits, sizeof(value));
+                return value;
+            }
+            
+            // 8-bit samples are unsigned, all others signed
+            if (bitsPerSample == 8)
+                return (static_cast<float>(bytes[0]) - 128.0f) / 128.0f;
+            
+            const auto size = bitsPerSample / 8;
+            const auto shift = 32 - bitsPerSample;
+            const auto value = static_cast<int32_t>(readLittleEndian(bytes, size) << shift);
+            
+            return static_cast<float>(value) / 2147483648.0f;
+        }
+    }
+
+    bool readWav(const ghc::filesystem::path& path, std::vector<float>& samples)
+    {
+        std::ifstream stream(path.string(), std::ios_base::binary);
+        if (!stream.is_open())
+        {
+            std::cerr << "Could not open " << path.filename().string() << std::endl;
+            return false;
+        }
+        
+        const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+        if (bytes.size() < 12 || memcmp(bytes.data(), "RIFF", 4) != 0 || memcmp(bytes.data() + 8, "WAVE", 4) != 0)
+        {
+            std::cerr << path.filename().string() << " is not a WAV file" << std::endl;
+            return false;
+        }
+        
+        // Walk the chunks, looking for the format and the data
+        uint16_t format = 0;
+        uint16_t channelCount = 0;
+        uint16_t bitsPerSample = 0;
+        const uint8_t* data = nullptr;
+        size_t dataSize = 0;
+        
+        for (size_t offset = 12; offset + 8 <= bytes.size();)
+        {
+            const uint8_t* chunk = bytes.data() + offset;
+            const size_t size = std::min<size_t>(readLittleEndian(chunk + 4, 4), bytes.size() - offset - 8);
+            
+            if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16)
+            {
+                format = static_cast<uint16_t>(readLittleEndian(chunk + 8, 2));
+                channelCount = static_cast<uint16_t>(readLittleEndian(chunk + 10, 2));
+                bitsPerSample = static_cast<uint16_t>(readLittleEndian(chunk + 22, 2));
+                
+                // Extensible formats keep the actual format in the first bytes of the sub-format
+                if (format == FORMAT_EXTENSIBLE && size >= 26)
+                    format = static_cast<uint16_t>(readLittleEndian(chunk + 32, 2));
+            } else if (memcmp(chunk, "data", 4) == 0) {
+                data = chunk + 8;
+                dataSize = size;
+            }
+            
+            // Chunks are padded to an even size
+            offset += 8 + size + (size & 1);
+        }
+        
+        const bool supported = (format == FORMAT_PCM && (bitsPerSample == 8 || bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32)) ||
+                               (format == FORMAT_FLOAT && bitsPerSample == 32);
+        if (!supported || channelCount == 0 || data == nullptr)
+        {
+            std::cerr << path.filename().string() << " is not an 8, 16, 24 or 32-bit PCM or 32-bit float WAV file" << std::endl;
+            return false;
+        }
+        
+        const size_t sampleSize = bitsPerSample / 8;
+        const size_t frameSize = sampleSize * channelCount;
+        const size_t frameCount = dataSize / frameSize;
+        
+        samples.resize(frameCount);
+        for (size_t frame = 0; frame < frameCount; ++frame)
+        {
+            float sum = 0.0f;
+            for (size_t channel = 0; channel < channelCount; ++channel)
+                sum += decodeSample(data + frame * frameSize + channel * sampleSize, format, bitsPerSample);
+            
+            samples[frame] = sum / channelCount;
+        }
+        
+        return true;
+    }
+}
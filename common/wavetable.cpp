@@ -0,0 +1,88 @@
+#include "wavetable.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include <lsdj/wave_converter.h>
+
+#include "common.hpp"
+#include "wav_reader.hpp"
+
+namespace lsdj
+{
+    namespace
+    {
+        bool loadSnt(const ghc::filesystem::path& path, std::vector<WaveFrame>& frames)
+        {
+            // Make sure the wavetable is the correct size
+            const auto size = ghc::filesystem::file_size(path);
+            if (size % LSDJ_WAVE_BYTE_COUNT != 0)
+            {
+                std::cerr << "The wavetable file size is not a multiple of 16 bytes" << std::endl;
+                return false;
+            }
+            
+            std::ifstream stream(path.string(), std::ios_base::binary);
+            if (!stream.is_open())
+            {
+                std::cerr << "Could not open " << path.filename().string() << std::endl;
+                return false;
+            }
+            
+            frames.resize(size / LSDJ_WAVE_BYTE_COUNT);
+            for (auto& frame : frames)
+                stream.read(reinterpret_cast<char*>(frame.data()), frame.size());
+            
+            return true;
+        }
+        
+        bool loadWav(const ghc::filesystem::path& path, const WavetableSettings& settings, std::vector<WaveFrame>& frames, bool verbose, std::ostream& log)
+        {
+            std::vector<float> samples;
+            if (!readWav(path, samples))
+                return false;
+            
+            // Slice the audio into single cycles, ignoring a trailing partial one
+            const auto cycleCount = std::min<size_t>(samples.size() / settings.cycleLength, 0x100);
+            if (cycleCount == 0)
+            {
+                std::cerr << path.filename().string() << " is shorter than a single cycle of " << std::dec << settings.cycleLength << " samples" << std::endl;
+                return false;
+            }
+            
+            lsdj_wave_converter_t* converter = nullptr;
+            const lsdj_error_t error = lsdj_wave_converter_new(settings.cycleLength, &converter, nullptr);
+            if (error != LSDJ_SUCCESS)
+                return handle_error(error) == 0;
+            
+            lsdj_wave_converter_set_normalize(converter, settings.normalize);
+            lsdj_wave_converter_set_dither(converter, settings.dither);
+            
+            frames.resize(cycleCount);
+            for (size_t i = 0; i < cycleCount; ++i)
+                lsdj_wave_converter_convert(converter, samples.data() + i * settings.cycleLength, frames[i].data());
+            
+            lsdj_wave_converter_free(converter);
+            
+            if (verbose)
+                log << "Converted " << std::dec << cycleCount << " cycles of " << settings.cycleLength << " samples from " << path.filename().string() << std::endl;
+            
+            return true;
+        }
+    }
+
+    bool loadWavetable(const ghc::filesystem::path& path, const WavetableSettings& settings, std::vector<WaveFrame>& frames, bool verbose, std::ostream& log)
+    {
+        if (!ghc::filesystem::exists(path))
+        {
+            std::cerr << path.filename().string() << " does not exist" << std::endl;
+            return false;
+        }
+        
+        if (compareCaseInsensitive(path.extension().string(), ".wav"))
+            return loadWav(path, settings, frames, verbose, log);
+        else
+            return loadSnt(path, frames);
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+#include <ghc/filesystem.hpp>
+#include <ostream>
+#include <vector>
+
+#include <lsdj/wave.h>
+
+namespace lsdj
+{
+    //! A single wave, packed the way LSDJ stores it
+    using WaveFrame = std::array<uint8_t, LSDJ_WAVE_BYTE_COUNT>;
+    
+    //! How .wav wavetables are turned into frames
+    struct WavetableSettings
+    {
+        //! The amount of samples in every single-cycle frame
+        size_t cycleLength = 2048;
+        
+        //! Scale the frames to use the full range
+        bool normalize = true;
+        
+        //! Dither the frames when quantizing them
+        bool dither = false;
+    };
+    
+    //! Load the frames of a wavetable, either straight from a .snt or converted from a .wav
+    /*! Problems are reported to std::cerr, verbose output to log
+        @return Whether the wavetable could be loaded */
+    bool loadWavetable(const ghc::filesystem::path& path, const WavetableSettings& settings, std::vector<WaveFrame>& frames, bool verbose, std::ostream& log);
+}
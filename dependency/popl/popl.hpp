@@ -966,7 +966,9 @@ inline void OptionParser::parse(int argc, const char * const argv[])
 			else
 				unknown_options_.push_back(arg);
 		}
-		else if (arg.find('-') == 0)
+		/// Local change in liblsdj (see LOCAL_CHANGES.md): a lone "-" is a regular argument
+		/// meaning stdin/stdout, instead of an empty group of short options that gets dropped
+		else if ((arg.find('-') == 0) && (arg.size() > 1))
 		{
 			/// short option arg
 			std::string opt = arg.substr(1);
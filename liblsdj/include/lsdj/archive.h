@@ -0,0 +1,108 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#ifndef LSDJ_ARCHIVE_H
+#define LSDJ_ARCHIVE_H
+
+/* Archives are a compact storage encoding for songs, meant for backups and
+   libraries rather than for loading into LSDj. Most of a song's memory is
+   identical to that of a new song (unused phrases, chains, tables, default
+   instruments and waves), so the song is XOR'ed against LSDJ_SONG_NEW_BYTES
+   first, which turns all of that into zeroes.
+
+   The result is stored as a sequence of runs, each starting with a varint
+   holding the run type and length:
+
+   - Zero runs: bytes identical to those of a new song, nothing else is stored
+   - Repeat runs: followed by a single byte that repeats for the whole run
+   - Literal runs: followed by the bytes themselves
+
+   Runs follow each other until all LSDJ_SONG_BYTE_COUNT bytes are covered.
+   When it makes the archive smaller, the run bytes are Huffman coded, with
+   the code lengths stored up front. The header contains a hash of the song,
+   so corrupt archives are detected.
+
+   Archives are usually a fraction of the size of the block compression used
+   by LSDj, and decoding writes straight into an lsdj_song_t. To get back an
+   .lsdsng, decode into a project's song and use lsdj_project_write_lsdsng(). */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "error.h"
+#include "song.h"
+#include "vio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! The size of the header every archive starts with
+#define LSDJ_ARCHIVE_HEADER_SIZE (16)
+
+//! The largest size an archived song can take up
+/*! This is reached when no byte of the song matches a new song, and nothing repeats */
+#define LSDJ_ARCHIVE_MAX_SIZE (LSDJ_ARCHIVE_HEADER_SIZE + 3 + LSDJ_SONG_BYTE_COUNT)
+
+//! Write a song in the archive encoding
+/*! @param song The song to archive
+	@param wvio The virtual I/O to write the archive to
+	@param writeCounter The amount of bytes written is _added_ to this value, if provided
+	@return An error code representing success or failure */
+lsdj_error_t lsdj_song_write_archive(const lsdj_song_t* song, lsdj_vio_t* wvio, size_t* writeCounter);
+
+//! Read a song written by lsdj_song_write_archive()
+/*! @param rvio The virtual I/O to read the archive from
+	@param readCounter The amount of bytes read is _added_ to this value, if provided
+	@param song The song to decode into
+	@return An error code representing success or failure */
+lsdj_error_t lsdj_song_read_archive(lsdj_vio_t* rvio, size_t* readCounter, lsdj_song_t* song);
+
+//! Read a song written by lsdj_song_write_archive() from memory
+/*! This decodes straight from the buffer, without going through virtual I/O,
+	which makes it the fastest way to unpack a large amount of songs.
+
+	@param data The memory containing the archive
+	@param size The size of the memory
+	@param readCounter The amount of bytes read is _added_ to this value, if provided
+	@param song The song to decode into
+	@return An error code representing success or failure */
+lsdj_error_t lsdj_song_read_archive_from_memory(const uint8_t* data, size_t size, size_t* readCounter, lsdj_song_t* song);
+    
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#ifndef LSDJ_CLEAN_H
+#define LSDJ_CLEAN_H
+
+/* Cleaning functions remove data from a song that LSDJ will never play.
+   Besides tidier songs, cleaned songs compress into fewer blocks, because
+   unused slots are reset to the same default bytes a new song starts out
+   with, which the sav compression collapses. */
+
+#include "song.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Clear everything in a song that can't be reached from the song rows
+/*! Marks every chain placed in the song rows, the phrases in those chains,
+	the instruments, tables and grooves those phrases refer to (following
+	A-commands through other tables), and the synths and waves of the wave
+	instruments. All chains, phrases, instruments, tables, grooves, synths
+	and waves that weren't marked are reset to their defaults, and their
+	allocation flags are cleared.
+
+	Groove 0 is always kept, as it is the groove every channel starts with.
+
+	@param song The song to clean */
+void lsdj_song_clean(lsdj_song_t* song);
+
+//! Merge byte-identical phrases and compact the phrase bank
+/*! Every allocated phrase (notes, instruments, commands and command values)
+	is hashed, and phrases that are identical to an earlier one are merged
+	into it. Afterwards, the remaining phrases are moved down to fill up the
+	freed slots, keeping their order. All chain references are rewritten.
+
+	@param song The song to deduplicate the phrases of
+	@return The amount of phrases that were merged away */
+unsigned int lsdj_song_deduplicate_phrases(lsdj_song_t* song);
+
+//! Merge byte-identical chains and compact the chain bank
+/*! Every allocated chain (phrases and transpositions) is hashed, and chains
+	that are identical to an earlier one are merged into it. Afterwards, the
+	remaining chains are moved down to fill up the freed slots, keeping their
+	order. All song row references are rewritten.
+
+	@note Run this after lsdj_song_deduplicate_phrases(), as merging phrases
+	may turn chains into duplicates of each other
+
+	@param song The song to deduplicate the chains of
+	@return The amount of chains that were merged away */
+unsigned int lsdj_song_deduplicate_chains(lsdj_song_t* song);
+    
+#ifdef __cplusplus
+}
+#endif
+
+#endif
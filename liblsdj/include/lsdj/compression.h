@@ -134,6 +134,17 @@ lsdj_error_t lsdj_decompress_step(lsdj_vio_t* rvio, size_t* readCounter,
 
     @todo Should the first argument be an lsdj_vio_t* rvio? */
 lsdj_error_t lsdj_compress(const uint8_t* data, lsdj_vio_t* wvio, unsigned int blockOffset, size_t* writeCounter);
+
+//! Calculate how many blocks a song compresses into
+/*! The song is compressed without storing the result, so this is a cheap way of finding
+    out whether songs fit together in the LSDJ_BLOCK_COUNT blocks of a sav. The amount
+    of blocks doesn't depend on where in the sav the song ends up.
+
+    @param data The data that would be compressed into blocks
+    @param blockCount The amount of blocks the data compresses into
+
+    @return An error code representing success or failure */
+lsdj_error_t lsdj_compress_count_blocks(const uint8_t* data, unsigned int* blockCount);
     
 #ifdef __cplusplus
 }
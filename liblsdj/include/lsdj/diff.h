@@ -0,0 +1,87 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#ifndef LSDJ_DIFF_H
+#define LSDJ_DIFF_H
+
+/* Song diffs are compact descriptions of the bytes that changed between two
+   versions of a song. They consist of a small header followed by runs of
+   changed bytes, each of which is copied straight into place when patching.
+
+   Runs never cross the boundaries between regions of the song memory
+   (phrase notes, chain transpositions, waves, etc.) and changes close to
+   each other within a region are merged into a single run, so that typical
+   edits produce only a handful of runs.
+
+   The header contains the hash of the song the diff was made against, and
+   the hash of the resulting song, so patches are never applied to the wrong
+   song, and corrupt patches are detected. */
+
+#include <stddef.h>
+
+#include "error.h"
+#include "song.h"
+#include "vio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! The size of a diff between two identical songs
+#define LSDJ_DIFF_HEADER_SIZE (23)
+
+//! Write the difference between two songs
+/*! @param from The song the diff should be applied to later on
+	@param to The song the diff should result in
+	@param wvio The virtual I/O to write the diff to
+	@param writeCounter The amount of bytes written is _added_ to this value, if provided
+	@return An error code representing success or failure */
+lsdj_error_t lsdj_song_diff(const lsdj_song_t* from, const lsdj_song_t* to, lsdj_vio_t* wvio, size_t* writeCounter);
+
+//! Apply a diff written by lsdj_song_diff() to a song
+/*! @param base The song the diff was made against
+	@param rvio The virtual I/O to read the diff from
+	@param readCounter The amount of bytes read is _added_ to this value, if provided
+	@param out The song to write the result to (may be the same as base)
+	@return An error code representing success or failure. If the diff was made
+			against another song, LSDJ_PATCH_BASE_MISMATCH is returned. out is only
+			written to on success, and left untouched on any failure */
+lsdj_error_t lsdj_song_patch(const lsdj_song_t* base, lsdj_vio_t* rvio, size_t* readCounter, lsdj_song_t* out);
+    
+#ifdef __cplusplus
+}
+#endif
+
+#endif
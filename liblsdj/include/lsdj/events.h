@@ -0,0 +1,223 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#ifndef LSDJ_EVENTS_H
+#define LSDJ_EVENTS_H
+
+/* Song playback walks a tree: every song row points to a chain per channel,
+   every chain step to a phrase (with a transposition), and every phrase
+   step holds the note, instrument and command that play. This module
+   offers two views of that walk.
+
+   A cursor steps through a single channel in playback order, one phrase
+   step at a time, following empty rows and H-commands the way LSDJ does.
+   It keeps no memory besides itself.
+
+   An event stream flattens an entire song into one compact array of events
+   per channel, so tools that need to look at the notes over and over (MIDI
+   export, timing, similarity) don't have to walk the tree each time. The
+   stream remembers hashes of the song sections it was built from, and only
+   flattens again when one of those sections has changed. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "allocator.h"
+#include "channel.h"
+#include "command.h"
+#include "error.h"
+#include "song.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! The maximum number of steps a channel plays before it loops (256 rows of 16 phrases of 16 steps)
+#define LSDJ_EVENTS_MAX_STEP_COUNT (256 * 16 * 16)
+
+
+// --- Cursors --- //
+
+//! The result of moving a cursor
+typedef enum
+{
+	//! The cursor moved on to the next step
+	LSDJ_CURSOR_NEXT,
+
+	//! The cursor ran into an empty row and jumped back to the top of its block of rows
+	LSDJ_CURSOR_LOOPED,
+
+	//! The channel stopped playing, either through an HFF command or because nothing is left to play
+	LSDJ_CURSOR_STOPPED
+} lsdj_cursor_move_t;
+
+//! A position in the playback of a single channel
+typedef struct
+{
+	//! The channel this cursor walks through
+	lsdj_channel_t channel;
+
+	//! The song row that is playing
+	uint8_t row;
+
+	//! The chain in that row
+	uint8_t chain;
+
+	//! The step within the chain
+	uint8_t chainStep;
+
+	//! The phrase at that chain step
+	uint8_t phrase;
+
+	//! The step within the phrase
+	uint8_t phraseStep;
+
+	//! The transposition of the chain step
+	uint8_t transposition;
+
+	//! The first row of the block of rows that is playing, which is where the channel loops back to
+	uint8_t loopRow;
+
+	//! The number of steps played since the cursor started
+	uint32_t step;
+} lsdj_song_cursor_t;
+
+//! Place a cursor on the first step that plays from a song row onwards
+/*! @param song The song to walk through
+	@param channel The channel to walk through
+	@param row The song row to start playing from
+	@param cursor The cursor to initialize
+	@return False if there is nothing to play from this row */
+bool lsdj_song_cursor_start(const lsdj_song_t* song, lsdj_channel_t channel, uint8_t row, lsdj_song_cursor_t* cursor);
+
+//! Move a cursor to the step that plays next
+/*! An H-command on the current step is followed: H00 through H0F hop to that
+	step of the next phrase, HFF stops the channel. Chains end at their first
+	empty step, and an empty song row makes the channel jump back to the
+	first row of its block (the row after the previous empty one).
+
+	@param song The song to walk through
+	@param cursor The cursor to move
+	@return How the cursor moved. A stopped cursor stays where it was. */
+lsdj_cursor_move_t lsdj_song_cursor_advance(const lsdj_song_t* song, lsdj_song_cursor_t* cursor);
+
+
+// --- Event streams --- //
+
+//! A single step that does something, in playback order
+typedef struct
+{
+	//! The index of the step, counted from the start of the song
+	/*! Steps without a note, instrument or command don't become events, so
+		these can skip. How long a step takes depends on the groove. */
+	uint32_t step;
+
+	//! The song row that played this step
+	uint8_t row;
+
+	//! The chain that played this step
+	uint8_t chain;
+
+	//! The phrase that contains this step
+	uint8_t phrase;
+
+	//! The step within the phrase
+	uint8_t phraseStep;
+
+	//! The note, after chain transposition, or LSDJ_PHRASE_NO_NOTE
+	uint8_t note;
+
+	//! The instrument, or LSDJ_PHRASE_NO_INSTRUMENT
+	uint8_t instrument;
+
+	//! The command (an lsdj_command_t)
+	uint8_t command;
+
+	//! The command value
+	uint8_t value;
+} lsdj_event_t;
+
+//! How a channel ends in an event stream
+typedef enum
+{
+	//! The channel loops back to row 0, the first step of the stream
+	LSDJ_EVENTS_END_LOOP,
+
+	//! The channel stops playing (HFF), or doesn't play at all
+	LSDJ_EVENTS_END_STOP
+} lsdj_events_end_t;
+
+//! A flattened song, with an array of events per channel
+typedef struct lsdj_song_events_t lsdj_song_events_t;
+
+//! Create a new, empty event stream
+/*! @param events Pointer to the place where the stream will be created
+	@param allocator The allocator (or NULL) used for memory (de)allocation
+	@return Whether the stream could be created
+
+	@note Every call must be paired with an lsdj_song_events_free() */
+lsdj_error_t lsdj_song_events_new(lsdj_song_events_t** events, const lsdj_allocator_t* allocator);
+
+//! Frees an event stream from memory
+void lsdj_song_events_free(lsdj_song_events_t* events);
+
+//! Make an event stream match a song, playing from row 0
+/*! The song rows, chains and phrases are hashed, and the song is only
+	flattened again if any of them differ from the last update.
+
+	@param events The event stream to update
+	@param song The song to flatten
+	@param flattened Set to whether the song was flattened again (may be NULL)
+	@return Whether the stream could be updated. On failure the stream is empty. */
+lsdj_error_t lsdj_song_events_update(lsdj_song_events_t* events, const lsdj_song_t* song, bool* flattened);
+
+//! Retrieve the events of a channel, in playback order
+const lsdj_event_t* lsdj_song_events_get(const lsdj_song_events_t* events, lsdj_channel_t channel);
+
+//! Retrieve the number of events of a channel
+size_t lsdj_song_events_get_count(const lsdj_song_events_t* events, lsdj_channel_t channel);
+
+//! Retrieve the number of steps a channel plays before it loops or stops
+uint32_t lsdj_song_events_get_step_count(const lsdj_song_events_t* events, lsdj_channel_t channel);
+
+//! Retrieve how a channel ends
+lsdj_events_end_t lsdj_song_events_get_end(const lsdj_song_events_t* events, lsdj_channel_t channel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#ifndef LSDJ_FINGERPRINT_H
+#define LSDJ_FINGERPRINT_H
+
+/* Melodic fingerprints tell how alike the melodies of two songs are, even
+   when one of them was transposed, rearranged or partly rewritten.
+
+   The notes of the pulse and wave channels are followed in the order they
+   are played (song rows, then chain steps, then phrase steps), with the
+   chain transpositions applied. Every run of LSDJ_FINGERPRINT_NGRAM_LENGTH
+   consecutive intervals between these notes forms an n-gram. Intervals
+   don't change when a melody is transposed, so neither do the n-grams.
+
+   A fingerprint is a MinHash signature over the set of n-grams: for each
+   of LSDJ_FINGERPRINT_LENGTH hash functions it keeps the smallest hash of
+   any n-gram. The fraction of positions two signatures agree on estimates
+   the fraction of n-grams the songs share (their Jaccard similarity).
+
+   For finding similar songs among many, split the signature into bands and
+   put the songs in buckets by the hash of each band (locality sensitive
+   hashing). Songs that share a bucket in any band are likely to be similar,
+   so only those need comparing. With the bands below, songs sharing half of
+   their n-grams end up in a common bucket about 2 out of 3 times, and songs
+   sharing 80% practically always. */
+
+#include <stdint.h>
+
+#include "song.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! The amount of minimum hashes in a fingerprint
+#define LSDJ_FINGERPRINT_LENGTH (64)
+
+//! The amount of intervals in an n-gram
+#define LSDJ_FINGERPRINT_NGRAM_LENGTH (4)
+
+//! The amount of bands a fingerprint is split into for locality sensitive hashing
+#define LSDJ_FINGERPRINT_BAND_COUNT (16)
+
+//! The amount of minimum hashes in a band
+#define LSDJ_FINGERPRINT_BAND_LENGTH (LSDJ_FINGERPRINT_LENGTH / LSDJ_FINGERPRINT_BAND_COUNT)
+
+//! A melodic fingerprint of a song
+typedef struct
+{
+	//! The smallest hash of any n-gram, per hash function
+	uint32_t minimums[LSDJ_FINGERPRINT_LENGTH];
+
+	//! The amount of n-grams in the song (0 means it has no melody to speak of)
+	uint32_t ngramCount;
+} lsdj_fingerprint_t;
+
+//! Compute the melodic fingerprint of a song
+/*! Only the chains placed on the song screen are followed, so unused chains
+	and phrases don't count towards the fingerprint.
+
+	@param song The song to fingerprint
+	@param fingerprint The fingerprint to fill in */
+void lsdj_song_fingerprint(const lsdj_song_t* song, lsdj_fingerprint_t* fingerprint);
+
+//! Estimate how similar the melodies of two songs are
+/*! @return The estimated fraction of n-grams the songs share, between 0 and 1.
+			Songs without any n-grams aren't similar to anything. */
+double lsdj_fingerprint_similarity(const lsdj_fingerprint_t* lhs, const lsdj_fingerprint_t* rhs);
+
+//! Hash one band of a fingerprint, for putting it in a bucket
+/*! The hash is stable across platforms, so it can be stored on disk
+
+	@param fingerprint The fingerprint to hash
+	@param band The band to hash (< LSDJ_FINGERPRINT_BAND_COUNT) */
+uint64_t lsdj_fingerprint_hash_band(const lsdj_fingerprint_t* fingerprint, uint8_t band);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
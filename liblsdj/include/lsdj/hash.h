@@ -0,0 +1,127 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#ifndef LSDJ_HASH_H
+#define LSDJ_HASH_H
+
+/* Hashing functions for quickly telling whether two songs, or parts of
+   songs, are identical. The hashes are 64-bit xxHash (XXH64) digests;
+   they are fast and well distributed, but NOT cryptographically secure.
+   They are stable across platforms, so they can be stored on disk. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "song.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! The distinct regions of data in a song that can be hashed separately
+typedef enum
+{
+	//! Phrase notes, instruments, commands, command values and allocations
+	LSDJ_SONG_SECTION_PHRASES,
+
+	//! Chain phrases, transpositions and allocations
+	LSDJ_SONG_SECTION_CHAINS,
+
+	//! The chains placed on the song screen
+	LSDJ_SONG_SECTION_ROWS,
+
+	//! Instrument parameters, names and allocations
+	LSDJ_SONG_SECTION_INSTRUMENTS,
+
+	//! Table envelopes, transpositions, commands, command values and allocations
+	LSDJ_SONG_SECTION_TABLES,
+
+	//! The wave data
+	LSDJ_SONG_SECTION_WAVES,
+
+	//! Synth parameters and wave overwrite flags
+	LSDJ_SONG_SECTION_SYNTHS,
+
+	//! The grooves
+	LSDJ_SONG_SECTION_GROOVES,
+
+	//! Speech synth words and their names
+	LSDJ_SONG_SECTION_WORDS,
+
+	//! Song and editor settings, the clock and the format version
+	LSDJ_SONG_SECTION_SETTINGS,
+
+	//! The amount of sections
+	LSDJ_SONG_SECTION_COUNT
+} lsdj_song_section_t;
+
+//! Hash a full song
+/*! Every byte of the song is taken into account, including editor settings and unused memory */
+uint64_t lsdj_song_hash(const lsdj_song_t* song);
+
+//! Hash one section of a song
+/*! @param song The song to hash
+	@param section The section of the song that should be hashed */
+uint64_t lsdj_song_hash_section(const lsdj_song_t* song, lsdj_song_section_t section);
+
+//! Hash a phrase (its notes, instruments, commands and command values)
+/*! @param song The song that contains the phrase
+	@param phrase The phrase to hash (< LSDJ_PHRASE_COUNT) */
+uint64_t lsdj_phrase_hash(const lsdj_song_t* song, uint8_t phrase);
+
+//! Hash a chain (its phrases and transpositions)
+/*! @param song The song that contains the chain
+	@param chain The chain to hash */
+uint64_t lsdj_chain_hash(const lsdj_song_t* song, uint8_t chain);
+
+//! Hash an instrument (its parameters, not its name)
+/*! @param song The song that contains the instrument
+	@param instrument The instrument to hash (< LSDJ_INSTRUMENT_COUNT) */
+uint64_t lsdj_instrument_hash(const lsdj_song_t* song, uint8_t instrument);
+
+//! Hash an arbitrary block of memory
+/*! Songs and projects have their own hash functions, but this can be used
+	for related data, like the names of projects in a sav.
+
+	@param data The memory to hash
+	@param size The amount of bytes to hash
+	@param seed A seed that changes the outcome of the hash (use 0 if you don't care) */
+uint64_t lsdj_hash_bytes(const void* data, size_t size, uint64_t seed);
+    
+#ifdef __cplusplus
+}
+#endif
+
+#endif
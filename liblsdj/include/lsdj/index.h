@@ -0,0 +1,203 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#ifndef LSDJ_INDEX_H
+#define LSDJ_INDEX_H
+
+/* A song index is a precomputed reference graph of a song. LSDJ songs are
+   a tree of references (rows point to chains, chains to phrases, phrases to
+   instruments and tables, instruments to tables...), and answering questions
+   like "which chains use this phrase?" means scanning the entire song. The
+   index builds both directions of every reference in a single pass, after
+   which each of these queries only touches its own answer.
+
+   The index doesn't track changes on its own. Whenever you change a song
+   through any of the regular setters, call the matching update function
+   (lsdj_song_index_update_phrase() after changing a phrase, etc.) to keep
+   the index in sync. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "allocator.h"
+#include "channel.h"
+#include "error.h"
+#include "song.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! The number of chain slots tracked by the index (chains 0x00 through 0x7F)
+#define LSDJ_INDEX_CHAIN_SLOT_COUNT (0x80)
+
+//! The number of song rows tracked by the index, per channel
+#define LSDJ_INDEX_ROW_COUNT (256)
+
+//! A reference graph of a song, used for fast usage lookups
+typedef struct lsdj_song_index_t lsdj_song_index_t;
+
+
+// --- Allocation --- //
+
+//! Create a new index for a song
+/*! Builds the full reference graph of a song in a single pass.
+
+	@param song The song to index
+	@param index Pointer to the place where the index will be created
+	@param allocator The allocator (or NULL) used for memory (de)allocation
+	@return Whether the index could be created
+
+	@note Every call must be paired with an lsdj_song_index_free() */
+lsdj_error_t lsdj_song_index_new(const lsdj_song_t* song, lsdj_song_index_t** index, const lsdj_allocator_t* allocator);
+
+//! Frees an index from memory
+void lsdj_song_index_free(lsdj_song_index_t* index);
+
+//! Rebuild an entire index from scratch
+/*! Use this after large changes to a song, where calling the individual update functions would be more work */
+void lsdj_song_index_rebuild(lsdj_song_index_t* index, const lsdj_song_t* song);
+
+
+// --- Updating --- //
+
+//! Update the index after a row of the song has changed
+/*! @param index The index to update
+	@param song The song, which already contains the new row
+	@param row The row that was changed */
+void lsdj_song_index_update_row(lsdj_song_index_t* index, const lsdj_song_t* song, uint8_t row);
+
+//! Update the index after a chain has changed
+/*! @param index The index to update
+	@param song The song, which already contains the new chain contents
+	@param chain The chain that was changed (< LSDJ_INDEX_CHAIN_SLOT_COUNT) */
+void lsdj_song_index_update_chain(lsdj_song_index_t* index, const lsdj_song_t* song, uint8_t chain);
+
+//! Update the index after a phrase has changed
+/*! @param index The index to update
+	@param song The song, which already contains the new phrase contents
+	@param phrase The phrase that was changed (< LSDJ_PHRASE_COUNT) */
+void lsdj_song_index_update_phrase(lsdj_song_index_t* index, const lsdj_song_t* song, uint8_t phrase);
+
+//! Update the index after an instrument has changed
+/*! @param index The index to update
+	@param song The song, which already contains the new instrument parameters
+	@param instrument The instrument that was changed (< LSDJ_INSTRUMENT_COUNT) */
+void lsdj_song_index_update_instrument(lsdj_song_index_t* index, const lsdj_song_t* song, uint8_t instrument);
+
+//! Update the index after a table has changed
+/*! @param index The index to update
+	@param song The song, which already contains the new table contents
+	@param table The table that was changed (< LSDJ_TABLE_COUNT) */
+void lsdj_song_index_update_table(lsdj_song_index_t* index, const lsdj_song_t* song, uint8_t table);
+
+
+// --- Chains --- //
+
+//! Is a chain referenced from anywhere in the song rows?
+bool lsdj_song_index_is_chain_used(const lsdj_song_index_t* index, uint8_t chain);
+
+//! Retrieve the rows in which a chain is placed for a given channel
+/*! @param index The index to query
+	@param chain The chain to look for
+	@param channel The channel to look in
+	@param rows Array receiving the row numbers in ascending order (should hold LSDJ_INDEX_ROW_COUNT)
+	@return The amount of rows written */
+size_t lsdj_song_index_get_chain_rows(const lsdj_song_index_t* index, uint8_t chain, lsdj_channel_t channel, uint8_t* rows);
+
+//! Retrieve the unique phrases used by a chain
+/*! @param phrases Array receiving the phrase indices in ascending order (should hold LSDJ_CHAIN_LENGTH)
+	@return The amount of phrases written */
+size_t lsdj_song_index_get_chain_phrases(const lsdj_song_index_t* index, uint8_t chain, uint8_t* phrases);
+
+
+// --- Phrases --- //
+
+//! Is a phrase referenced from any chain?
+bool lsdj_song_index_is_phrase_used(const lsdj_song_index_t* index, uint8_t phrase);
+
+//! Retrieve the chains that use a phrase
+/*! @param chains Array receiving the chain indices in ascending order (should hold LSDJ_INDEX_CHAIN_SLOT_COUNT)
+	@return The amount of chains written */
+size_t lsdj_song_index_get_phrase_chains(const lsdj_song_index_t* index, uint8_t phrase, uint8_t* chains);
+
+//! Retrieve the unique instruments used by a phrase
+/*! @param instruments Array receiving the instrument indices in ascending order (should hold LSDJ_PHRASE_LENGTH)
+	@return The amount of instruments written */
+size_t lsdj_song_index_get_phrase_instruments(const lsdj_song_index_t* index, uint8_t phrase, uint8_t* instruments);
+
+//! Retrieve the unique tables a phrase refers to through A-commands
+/*! @param tables Array receiving the table indices in ascending order (should hold LSDJ_PHRASE_LENGTH)
+	@return The amount of tables written */
+size_t lsdj_song_index_get_phrase_tables(const lsdj_song_index_t* index, uint8_t phrase, uint8_t* tables);
+
+
+// --- Instruments --- //
+
+//! Is an instrument referenced from any phrase?
+bool lsdj_song_index_is_instrument_used(const lsdj_song_index_t* index, uint8_t instrument);
+
+//! Retrieve the phrases that use an instrument
+/*! @param phrases Array receiving the phrase indices in ascending order (should hold LSDJ_PHRASE_COUNT)
+	@return The amount of phrases written */
+size_t lsdj_song_index_get_instrument_phrases(const lsdj_song_index_t* index, uint8_t instrument, uint8_t* phrases);
+
+
+// --- Tables --- //
+
+//! Is a table referenced from any instrument, phrase or other table?
+bool lsdj_song_index_is_table_used(const lsdj_song_index_t* index, uint8_t table);
+
+//! Retrieve the instruments that have a table enabled and set
+/*! @param instruments Array receiving the instrument indices in ascending order (should hold LSDJ_INSTRUMENT_COUNT)
+	@return The amount of instruments written */
+size_t lsdj_song_index_get_table_instruments(const lsdj_song_index_t* index, uint8_t table, uint8_t* instruments);
+
+//! Retrieve the phrases that refer to a table through A-commands
+/*! @param phrases Array receiving the phrase indices in ascending order (should hold LSDJ_PHRASE_COUNT)
+	@return The amount of phrases written */
+size_t lsdj_song_index_get_table_phrases(const lsdj_song_index_t* index, uint8_t table, uint8_t* phrases);
+
+//! Retrieve the (other) tables that refer to a table through A-commands
+/*! @param tables Array receiving the table indices in ascending order (should hold LSDJ_TABLE_COUNT)
+	@return The amount of tables written */
+size_t lsdj_song_index_get_table_tables(const lsdj_song_index_t* index, uint8_t table, uint8_t* tables);
+    
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#ifndef LSDJ_MONO_H
+#define LSDJ_MONO_H
+
+/* Mono conversion turns every panned sound in a song into one that plays on
+   both speakers, for playback on systems where hard panning sounds off. */
+
+#include "song.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! The parts of a song lsdj_song_make_mono() converts
+typedef enum
+{
+	LSDJ_MONO_INSTRUMENTS = 1 << 0,
+	LSDJ_MONO_TABLES = 1 << 1,
+	LSDJ_MONO_PHRASES = 1 << 2,
+	LSDJ_MONO_ALL = LSDJ_MONO_INSTRUMENTS | LSDJ_MONO_TABLES | LSDJ_MONO_PHRASES
+} lsdj_mono_flags_t;
+
+//! Change all panning in a song to play on both the left and the right
+/*! Instruments panned left or right are set to LR, and so are the values of all
+	O-commands that pan left or right in the tables and phrases. Anything set to
+	play on neither speaker (O__ or an instrument without panning) is left alone.
+
+	This converts whole command banks at once instead of going step by step,
+	which is the same as looping over lsdj_phrase_set_command_value() and
+	friends, only a lot faster.
+
+	@param song The song to convert
+	@param flags Which parts of the song to convert, see lsdj_mono_flags_t */
+void lsdj_song_make_mono(lsdj_song_t* song, unsigned int flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
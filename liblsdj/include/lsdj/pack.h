@@ -0,0 +1,141 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#ifndef LSDJ_PACK_H
+#define LSDJ_PACK_H
+
+/* A pack is an archive of many songs that stores every piece of data only
+   once. Songs are cut into chunks along the lines of what they contain:
+   a chunk per phrase, chain, instrument, table, synth (its parameters and
+   waves), groove and speech word, one for the song rows and one for all
+   remaining settings. Each chunk is addressed by its hash, so the default
+   instruments, empty phrases and cloned chains that make up most of a
+   library are stored once, no matter how many songs use them.
+
+   A pack is a log of records that is only ever appended to:
+
+   - An 8-byte header, the magic "LSDJPAK" followed by the format version
+   - Chunk records: the byte 'C', the kind of chunk, its 64-bit hash and
+     its contents (the size of which follows from the kind)
+   - Song records: the byte 'S', the size of its manifest (16-bit), a
+     32-bit checksum, the project name (8 bytes) and version, and the
+     manifest: the number of every chunk of the song as a variable length
+     integer, in a fixed order. A song's chunks always come before it.
+
+   Opening a pack reads the record headers and skips over the contents, to
+   index where every chunk and song is. Retrieving a song then reads only
+   its own manifest and chunks, and checks every chunk against its hash. A
+   song record that was cut off, for instance by a crash while appending,
+   fails its checks and is ignored, along with everything after it, and is
+   overwritten by the next append. The chunks after the last whole song are
+   the only ones such a crash can tear, so opening reads those in full, and
+   ignores everything from the first one that doesn't match its hash.
+
+   Chunk hashes are 64-bit xxHash digests, so chunks with different contents
+   are only ever mistaken for each other by astronomically bad luck. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "allocator.h"
+#include "error.h"
+#include "project.h"
+#include "song.h"
+#include "vio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! The amount of chunks every song is cut into
+#define LSDJ_PACK_SONG_CHUNK_COUNT (571)
+
+//! A pack of songs, see above
+typedef struct lsdj_pack_t lsdj_pack_t;
+
+//! Open a pack, or create one in an empty stream
+/*! @param vio The virtual I/O the pack lives in, which needs to support reading, seeking and telling,
+		   and writing if anything is going to be appended. It needs to stay valid as long as the pack.
+	@param pack Pointer to the place where the pack will be created
+	@param allocator The allocator (or NULL) used for memory (de)allocation
+	@return An error code representing success or failure
+	@note Every successful call must be paired with an lsdj_pack_free() */
+lsdj_error_t lsdj_pack_open(lsdj_vio_t* vio, lsdj_pack_t** pack, const lsdj_allocator_t* allocator);
+
+//! Frees a pack from memory (this doesn't close its virtual I/O)
+void lsdj_pack_free(lsdj_pack_t* pack);
+
+//! Retrieve the amount of songs in a pack
+size_t lsdj_pack_get_song_count(const lsdj_pack_t* pack);
+
+//! Retrieve the amount of distinct chunks in a pack
+size_t lsdj_pack_get_chunk_count(const lsdj_pack_t* pack);
+
+//! Retrieve the project name of a song in a pack
+/*! @return The name, at maximum LSDJ_PROJECT_NAME_LENGTH (may not be null-terminated) */
+const char* lsdj_pack_get_name(const lsdj_pack_t* pack, size_t index);
+
+//! Retrieve the project version of a song in a pack
+uint8_t lsdj_pack_get_version(const lsdj_pack_t* pack, size_t index);
+
+//! Append a project to the end of a pack
+/*! Only the chunks the pack doesn't contain yet are written, followed by the song's manifest
+	@param pack The pack to append to
+	@param project The project to append
+	@param newChunkCount The amount of chunks that were new to the pack is _added_ to this value, if provided
+	@return An error code representing success or failure */
+lsdj_error_t lsdj_pack_append_project(lsdj_pack_t* pack, const lsdj_project_t* project, size_t* newChunkCount);
+
+//! Read a song from a pack
+/*! @param pack The pack to read from
+	@param index The index of the song (< lsdj_pack_get_song_count())
+	@param song The song to write the result to, which is left untouched on failure
+	@return An error code representing success or failure, LSDJ_PACK_INVALID if a chunk is corrupt */
+lsdj_error_t lsdj_pack_read_song(lsdj_pack_t* pack, size_t index, lsdj_song_t* song);
+
+//! Read a song from a pack as a project, along with its name and version
+/*! @param pack The pack to read from
+	@param index The index of the song (< lsdj_pack_get_song_count())
+	@param project Pointer to the place where the project will be created
+	@param allocator The allocator (or NULL) used for memory (de)allocation
+	@return An error code representing success or failure */
+lsdj_error_t lsdj_pack_read_project(lsdj_pack_t* pack, size_t index, lsdj_project_t** project, const lsdj_allocator_t* allocator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#ifndef LSDJ_RENDER_H
+#define LSDJ_RENDER_H
+
+/* The renderer plays a song through a model of the Game Boy's sound chip
+   (the APU) and produces 16-bit stereo PCM. Each channel is modelled after
+   its hardware counterpart: two pulse channels with duty cycles, volume
+   envelopes and length counters, a wave channel playing 32 4-bit samples,
+   and a noise channel driven by a linear feedback shift register.
+
+   The renderer follows song playback through a timer (see timing.h), and
+   applies notes, instruments, tables and a handful of commands on every
+   tick. It doesn't try to be a complete LSDJ implementation: kit samples
+   live in the LSDJ ROM and render as silence, and most effect commands are
+   ignored. Rendering only uses integer arithmetic, so the same song always
+   renders to the exact same samples. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "allocator.h"
+#include "error.h"
+#include "song.h"
+#include "vio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! The number of interleaved samples in a rendered frame (left and right)
+#define LSDJ_RENDER_FRAME_SAMPLE_COUNT (2)
+
+//! The channel mask that renders every channel
+#define LSDJ_RENDER_ALL_CHANNELS (0x0F)
+
+//! Renders a song to PCM audio
+typedef struct lsdj_renderer_t lsdj_renderer_t;
+
+//! Create a new renderer for a song
+/*! The renderer starts at the beginning of the song, and renders until
+	every channel has looped or stopped.
+
+	@param song The song to render, which is copied into the renderer
+	@param sampleRate The number of frames per second to render
+	@param renderer Pointer to the place where the renderer will be created
+	@param allocator The allocator (or NULL) used for memory (de)allocation
+	@return Whether the renderer could be created
+
+	@note Every call must be paired with an lsdj_renderer_free() */
+lsdj_error_t lsdj_renderer_new(const lsdj_song_t* song, unsigned int sampleRate, lsdj_renderer_t** renderer, const lsdj_allocator_t* allocator);
+
+//! Frees a renderer from memory
+void lsdj_renderer_free(lsdj_renderer_t* renderer);
+
+//! Choose which channels are audible
+/*! Muted channels are still played (their T-commands still change the
+	tempo), they just don't end up in the mix. Rendering each channel on its
+	own and adding the results together gives the same mix as rendering all
+	channels at once.
+
+	@param renderer The renderer
+	@param mask A bit per channel (1 << LSDJ_CHANNEL_PULSE1, etc.), or LSDJ_RENDER_ALL_CHANNELS */
+void lsdj_renderer_set_channel_mask(lsdj_renderer_t* renderer, unsigned int mask);
+
+//! Render the next frames of a song
+/*! @param renderer The renderer
+	@param frames The buffer to render into, interleaved left/right, LSDJ_RENDER_FRAME_SAMPLE_COUNT * frameCount samples long
+	@param frameCount The number of frames to render
+	@return The number of frames rendered, which is lower than frameCount once the song has ended */
+size_t lsdj_renderer_render(lsdj_renderer_t* renderer, int16_t* frames, size_t frameCount);
+
+//! Compute the number of frames a renderer will produce for a song
+/*! @param song The song to render
+	@param sampleRate The number of frames per second to render */
+size_t lsdj_render_get_frame_count(const lsdj_song_t* song, unsigned int sampleRate);
+
+//! Write the header of a 16-bit stereo WAV file
+/*! Use this when writing rendered frames yourself. The frames that follow
+	the header should be interleaved little-endian 16-bit samples.
+
+	@param sampleRate The number of frames per second
+	@param frameCount The number of frames that will follow the header
+	@param wvio The virtual I/O the header is written to
+	@param writeCounter The amount of bytes written is _added_ to this value, if not NULL
+	@return Whether the header could be written */
+lsdj_error_t lsdj_render_write_wav_header(unsigned int sampleRate, size_t frameCount, lsdj_vio_t* wvio, size_t* writeCounter);
+
+//! Render a song into a 16-bit stereo WAV file
+/*! @param song The song to render
+	@param sampleRate The number of frames per second to render
+	@param channelMask The channels to render (see lsdj_renderer_set_channel_mask())
+	@param wvio The virtual I/O the WAV file is written to
+	@param writeCounter The amount of bytes written is _added_ to this value, if not NULL
+	@param allocator The allocator (or NULL) used for memory (de)allocation
+	@return Whether the song could be rendered and written */
+lsdj_error_t lsdj_render_wav(const lsdj_song_t* song, unsigned int sampleRate, unsigned int channelMask, lsdj_vio_t* wvio, size_t* writeCounter, const lsdj_allocator_t* allocator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
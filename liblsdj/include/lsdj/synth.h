@@ -39,6 +39,7 @@
 #include <stdbool.h>
 
 #include "song.h"
+#include "wave.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -50,6 +51,9 @@ extern "C" {
 //! The amount of bytes a synth takes
 #define LSDJ_SYNTH_BYTE_COUNT (16)
 
+//! The amount of waves a synth generates, sweeping from its start to its end values
+#define LSDJ_SYNTH_WAVE_COUNT (16)
+
 //! The waveform shapes the synth can use
 typedef enum
 {
@@ -271,6 +275,26 @@ void lsdj_synth_set_phase_end(lsdj_song_t* song, uint8_t synth, uint8_t phase);
 /*! @param song The song containing the synth
 	@param synth The index of the synth (< LSDJ_SYNTH_COUNT) */
 uint8_t lsdj_synth_get_phase_end(const lsdj_song_t* song, uint8_t synth);
+
+//! Generate the waves a synth produces from its parameters
+/*! LSDJ generates these waves itself whenever a synth is edited. This is an offline
+	model of that soft synth, matched against waves LSDJ generated: every wave is a sum
+	of the waveform's harmonics, filtered per harmonic with a resonance peak at the
+	cutoff and squeezed by phase compression. It's scaled by the volume, shifted,
+	distorted at the limit and quantized to 4 bits. The default synth comes out
+	identical, other synths can still be a level or two off on some samples.
+
+	@param song The song containing the synth
+	@param synth The index of the synth (< LSDJ_SYNTH_COUNT)
+	@param waves The generated waves, in the packed format of lsdj_wave_get_bytes() */
+void lsdj_synth_render_waves(const lsdj_song_t* song, uint8_t synth, uint8_t waves[LSDJ_SYNTH_WAVE_COUNT][LSDJ_WAVE_BYTE_COUNT]);
+
+//! Generate the waves of a synth and store them in the song's wave memory
+/*! The synth's waves are flagged as overwritten, so LSDJ keeps them as they are.
+
+	@param song The song containing the synth
+	@param synth The index of the synth (< LSDJ_SYNTH_COUNT) */
+void lsdj_synth_write_waves(lsdj_song_t* song, uint8_t synth);
     
 #ifdef __cplusplus
 }
@@ -0,0 +1,180 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#ifndef LSDJ_TIMING_H
+#define LSDJ_TIMING_H
+
+/* Timing turns song playback into time. Every channel steps through its
+   phrases with its own groove, where every groove step says how many ticks
+   a phrase step lasts. Ticks are a fixed fraction of a beat (24 per beat),
+   so their length in seconds depends on the tempo, which is shared by all
+   channels and can be changed on the fly with the T-command.
+
+   A timer walks all four channels at once, in order of time, and reports
+   every step that is played. It only keeps a cursor per channel, so its
+   memory use doesn't depend on the song. lsdj_song_time() uses a timer to
+   compute the duration of a song in one pass. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "channel.h"
+#include "events.h"
+#include "song.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! The number of ticks in a beat
+#define LSDJ_TICKS_PER_BEAT (24)
+
+//! The number of ticks a step lasts when its groove is empty
+#define LSDJ_DEFAULT_STEP_TICKS (6)
+
+//! The number of song rows for which timing keeps track of the start time
+#define LSDJ_TIMING_ROW_COUNT (256)
+
+//! The start time given to rows that aren't played
+#define LSDJ_TIMING_NOT_PLAYED (-1.0)
+
+//! A step played by a timer
+typedef struct
+{
+	//! The channel that plays the step
+	lsdj_channel_t channel;
+
+	//! The song row, chain, phrase and phrase step that are played
+	uint8_t row;
+	uint8_t chain;
+	uint8_t phrase;
+	uint8_t phraseStep;
+
+	//! The transposition of the chain step
+	uint8_t transposition;
+
+	//! The number of ticks the step lasts
+	uint8_t tickCount;
+
+	//! The tick at which the step starts, counted from the start of the song
+	uint32_t tick;
+
+	//! The time in seconds at which the step starts
+	double time;
+} lsdj_timed_step_t;
+
+//! Walks through all channels of a song, in order of time
+/*! Treat the contents as private, except for tick, time and tempo, which can be read */
+typedef struct
+{
+	//! The playback position of every channel
+	lsdj_song_cursor_t cursors[LSDJ_CHANNEL_COUNT];
+
+	//! Whether each channel still has to play its current step
+	bool playing[LSDJ_CHANNEL_COUNT];
+
+	//! Whether each channel has looped (instead of stopped)
+	bool looped[LSDJ_CHANNEL_COUNT];
+
+	//! The groove each channel is playing, and the position within it
+	uint8_t grooves[LSDJ_CHANNEL_COUNT];
+	uint8_t grooveSteps[LSDJ_CHANNEL_COUNT];
+
+	//! The tick at which the current step of each channel starts
+	uint32_t stepTicks[LSDJ_CHANNEL_COUNT];
+
+	//! The tick at which the last channel ended
+	uint32_t endTick;
+
+	//! The current tempo, in beats per minute
+	unsigned short tempo;
+
+	//! The tick of the last step played, or the end of the song once the timer is done
+	uint32_t tick;
+
+	//! The time in seconds at that tick
+	double time;
+} lsdj_song_timer_t;
+
+//! The timing of an entire song
+typedef struct
+{
+	//! The number of seconds until every channel has looped or stopped
+	double duration;
+
+	//! The number of ticks until every channel has looped or stopped
+	uint32_t tickCount;
+
+	//! Whether the song loops (at least one channel loops back instead of stopping)
+	bool loops;
+} lsdj_song_timing_t;
+
+//! Start a timer at the beginning of a song (row 0 of every channel)
+/*! @param song The song to time
+	@param timer The timer to initialize
+	@return False if none of the channels play anything */
+bool lsdj_song_timer_start(const lsdj_song_t* song, lsdj_song_timer_t* timer);
+
+//! Play the next step of a song
+/*! Steps are reported in order of time. Steps that start at the same tick
+	are reported in channel order. Every channel plays up to the point where
+	it loops or stops, like the cursors in events.h. G-commands change the
+	groove of their channel, starting with their own step, and T-commands
+	change the tempo for all channels.
+
+	@param song The song being timed
+	@param timer The timer to move forward
+	@param step Filled with the step that plays
+	@return False once every channel has looped or stopped, in which case step is left untouched */
+bool lsdj_song_timer_next(const lsdj_song_t* song, lsdj_song_timer_t* timer, lsdj_timed_step_t* step);
+
+//! Compute the duration of a song, and optionally the time each row starts playing
+/*! @param song The song to time
+	@param timing Filled with the timing of the song
+	@param rowTimes If not NULL, filled with the start time of every row per channel, or LSDJ_TIMING_NOT_PLAYED */
+void lsdj_song_time(const lsdj_song_t* song, lsdj_song_timing_t* timing, double (*rowTimes)[LSDJ_TIMING_ROW_COUNT]);
+
+//! Compute the duration of a batch of songs
+/*! @param songs Pointers to the songs to time
+	@param count The number of songs
+	@param timings An array of count elements that will be filled with the timing of each song */
+void lsdj_song_time_batch(const lsdj_song_t* const* songs, size_t count, lsdj_song_timing_t* timings);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
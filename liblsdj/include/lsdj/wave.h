@@ -56,7 +56,7 @@ extern "C" {
 
 //! The number of steps in a wave
 /*! Do note that each step is represented by 4 bits, so the byte count is half this */
-#define LSDJ_WAVE_STEP_COUNT (LSDJ_WAVE_BYTE_LENGTH * 2)
+#define LSDJ_WAVE_STEP_COUNT (LSDJ_WAVE_BYTE_COUNT * 2)
 
 //! Change the bytes that represent a wave
 /*! @param song The song that contains the wave
@@ -0,0 +1,90 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#ifndef LSDJ_WAVE_CONVERTER_H
+#define LSDJ_WAVE_CONVERTER_H
+
+/* A wave converter turns single cycles of audio into LSDJ waves. Every cycle is
+   band-limited and resampled to the 32 steps of a wave (only harmonics the wave
+   can hold are kept, so nothing aliases), optionally normalized, and quantized
+   to 4 bits with optional dithering.
+
+   The converter is created for one cycle length and precomputes its tables for
+   it, so converting a whole wavetable of equally long cycles is cheap. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "allocator.h"
+#include "error.h"
+#include "wave.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct lsdj_wave_converter_t lsdj_wave_converter_t;
+
+//! Create a wave converter for cycles of a given length
+/*! Normalization is on and dithering is off by default.
+
+	@param cycleLength The amount of samples in every cycle (> 0)
+	@param converter A pointer to the converter that will be created
+	@param allocator The allocator (or null) used for memory management
+	@return Whether the converter could be allocated */
+lsdj_error_t lsdj_wave_converter_new(size_t cycleLength, lsdj_wave_converter_t** converter, const lsdj_allocator_t* allocator);
+
+//! Free a wave converter
+void lsdj_wave_converter_free(lsdj_wave_converter_t* converter);
+
+//! Remove the DC offset of every cycle and scale it to use all 16 levels
+void lsdj_wave_converter_set_normalize(lsdj_wave_converter_t* converter, bool normalize);
+
+//! Add triangular noise of one level before quantizing, to trade distortion for noise
+/*! The noise is pseudo-random but deterministic, so conversions can be reproduced */
+void lsdj_wave_converter_set_dither(lsdj_wave_converter_t* converter, bool dither);
+
+//! Convert a single cycle of audio to a wave
+/*! @param converter The converter, which knows the length of the cycle
+	@param cycle The samples of the cycle, in the range [-1, 1]
+	@param wave The resulting wave, in the packed format of lsdj_wave_set_bytes() */
+void lsdj_wave_converter_convert(lsdj_wave_converter_t* converter, const float* cycle, uint8_t wave[LSDJ_WAVE_BYTE_COUNT]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,656 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include "archive.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "hash.h"
+
+//! The bytes each archive starts with
+static const uint8_t MAGIC[4] = { 'L', 'S', 'D', 'A' };
+
+//! The version of the archive format
+#define ARCHIVE_FORMAT_VERSION (1)
+
+//! How the run bytes following the header are stored
+#define ENCODING_RAW (0)
+#define ENCODING_HUFFMAN (1)
+
+//! The run types, stored in the lowest bits of each run's varint
+#define RUN_ZERO (0)
+#define RUN_REPEAT (1)
+#define RUN_LITERAL (2)
+#define RUN_TYPE_BITS (2)
+#define RUN_TYPE_MASK ((1 << RUN_TYPE_BITS) - 1)
+
+//! The shortest run of zeroes or repeats that is worth breaking up a literal run for
+/*! Ending a literal run and starting a new one costs two varints, which shorter runs don't make up for */
+#define MIN_RUN_LENGTH (3)
+
+//! The longest Huffman code, chosen so the decoding table fits comfortably on the stack
+#define MAX_CODE_LENGTH (12)
+
+//! The size of the code length table, two lengths per byte
+#define CODE_LENGTHS_SIZE (128)
+
+//! The size of the buffers used for reading and writing the payload
+#define BUFFER_SIZE (256)
+
+
+// --- Huffman codes --- //
+
+//! Compute the Huffman code lengths for a set of symbol frequencies
+/*! @return The longest code length */
+static uint8_t compute_code_lengths(const size_t* frequencies, uint8_t* lengths)
+{
+	size_t weights[511];
+	unsigned short parents[511];
+	bool active[511];
+	unsigned short leaves[256];
+	size_t leafCount = 0;
+
+	for (unsigned short i = 0; i < 256; i++)
+	{
+		lengths[i] = 0;
+		if (frequencies[i] == 0)
+			continue;
+
+		weights[leafCount] = frequencies[i];
+		active[leafCount] = true;
+		leaves[leafCount++] = i;
+	}
+
+	if (leafCount == 1)
+		lengths[leaves[0]] = 1;
+	if (leafCount <= 1)
+		return 1;
+
+	// Repeatedly merge the two lightest nodes, there are few enough symbols for this to be quick
+	size_t nodeCount = leafCount;
+	for (size_t remaining = leafCount; remaining > 1; remaining--)
+	{
+		size_t lightest[2] = { SIZE_MAX, SIZE_MAX };
+		for (size_t i = 0; i < nodeCount; i++)
+		{
+			if (!active[i])
+				continue;
+
+			if (lightest[0] == SIZE_MAX || weights[i] < weights[lightest[0]])
+			{
+				lightest[1] = lightest[0];
+				lightest[0] = i;
+			} else if (lightest[1] == SIZE_MAX || weights[i] < weights[lightest[1]]) {
+				lightest[1] = i;
+			}
+		}
+
+		weights[nodeCount] = weights[lightest[0]] + weights[lightest[1]];
+		active[nodeCount] = true;
+		active[lightest[0]] = active[lightest[1]] = false;
+		parents[lightest[0]] = parents[lightest[1]] = (unsigned short)nodeCount;
+		nodeCount++;
+	}
+
+	uint8_t longest = 0;
+	for (size_t i = 0; i < leafCount; i++)
+	{
+		uint8_t length = 0;
+		for (size_t node = i; node != nodeCount - 1; node = parents[node])
+			length++;
+
+		lengths[leaves[i]] = length;
+		if (length > longest)
+			longest = length;
+	}
+
+	return longest;
+}
+
+//! Compute Huffman code lengths no longer than MAX_CODE_LENGTH
+static void limit_code_lengths(const size_t* frequencies, uint8_t* lengths)
+{
+	size_t weights[256];
+	memcpy(weights, frequencies, sizeof(weights));
+
+	// Flatten the distribution until the codes fit, which only happens for very skewed frequencies
+	while (compute_code_lengths(weights, lengths) > MAX_CODE_LENGTH)
+	{
+		for (size_t i = 0; i < 256; i++)
+			weights[i] = (weights[i] + 1) / 2;
+	}
+}
+
+//! Assign canonical codes to a set of code lengths
+/*! The codes are bit-reversed, because the bit stream is written least significant bit first
+	@return false if the lengths don't form a valid prefix code */
+static bool assign_codes(const uint8_t* lengths, uint16_t* codes)
+{
+	size_t counts[MAX_CODE_LENGTH + 1] = { 0 };
+	for (size_t i = 0; i < 256; i++)
+	{
+		if (lengths[i] > MAX_CODE_LENGTH)
+			return false;
+		counts[lengths[i]]++;
+	}
+
+	// Codes using more of the code space than there is don't form a prefix code
+	counts[0] = 0;
+	long left = 1;
+	for (size_t length = 1; length <= MAX_CODE_LENGTH; length++)
+	{
+		left = (left << 1) - (long)counts[length];
+		if (left < 0)
+			return false;
+	}
+
+	uint16_t next[MAX_CODE_LENGTH + 1] = { 0 };
+	uint16_t code = 0;
+	for (size_t length = 1; length <= MAX_CODE_LENGTH; length++)
+	{
+		code = (uint16_t)((code + counts[length - 1]) << 1);
+		next[length] = code;
+	}
+
+	for (size_t i = 0; i < 256; i++)
+	{
+		const uint8_t length = lengths[i];
+		if (length == 0)
+			continue;
+
+		const uint16_t value = next[length]++;
+		uint16_t reversed = 0;
+		for (uint8_t bit = 0; bit < length; bit++)
+			reversed |= (uint16_t)(((value >> bit) & 1) << (length - 1 - bit));
+
+		codes[i] = reversed;
+	}
+
+	return true;
+}
+
+
+// --- Encoding --- //
+
+//! Receives the run bytes, to either count their frequencies or write them out
+typedef struct
+{
+	//! The virtual I/O to write to, or NULL when only counting frequencies
+	lsdj_vio_t* wvio;
+	size_t* writeCounter;
+
+	//! The Huffman code of every byte, or NULL when writing bytes as-is
+	const uint16_t* codes;
+	const uint8_t* lengths;
+
+	size_t frequencies[256];
+
+	uint64_t bits;
+	size_t bitCount;
+
+	uint8_t buffer[BUFFER_SIZE];
+	size_t bufferSize;
+
+	bool failed;
+} encoder_t;
+
+static void flush_buffer(encoder_t* encoder)
+{
+	if (!lsdj_vio_write(encoder->wvio, encoder->buffer, encoder->bufferSize, encoder->writeCounter))
+		encoder->failed = true;
+
+	encoder->bufferSize = 0;
+}
+
+static void put_byte(encoder_t* encoder, uint8_t byte)
+{
+	encoder->buffer[encoder->bufferSize++] = byte;
+	if (encoder->bufferSize == BUFFER_SIZE)
+		flush_buffer(encoder);
+}
+
+static void emit(encoder_t* encoder, uint8_t byte)
+{
+	if (encoder->wvio == NULL)
+	{
+		encoder->frequencies[byte]++;
+	} else if (encoder->codes == NULL) {
+		put_byte(encoder, byte);
+	} else {
+		encoder->bits |= (uint64_t)encoder->codes[byte] << encoder->bitCount;
+		encoder->bitCount += encoder->lengths[byte];
+
+		while (encoder->bitCount >= 8)
+		{
+			put_byte(encoder, (uint8_t)(encoder->bits & 0xFF));
+			encoder->bits >>= 8;
+			encoder->bitCount -= 8;
+		}
+	}
+}
+
+static void emit_run(encoder_t* encoder, size_t type, size_t length)
+{
+	size_t value = (length << RUN_TYPE_BITS) | type;
+	for (; value >= 0x80; value >>= 7)
+		emit(encoder, (uint8_t)((value & 0x7F) | 0x80));
+
+	emit(encoder, (uint8_t)value);
+}
+
+//! Count the bytes from an offset onwards that XOR to the same value
+static size_t count_repeats(const uint8_t* bytes, size_t offset)
+{
+	const uint8_t value = bytes[offset] ^ LSDJ_SONG_NEW_BYTES[offset];
+
+	size_t end = offset + 1;
+	while (end < LSDJ_SONG_BYTE_COUNT && (bytes[end] ^ LSDJ_SONG_NEW_BYTES[end]) == value)
+		end++;
+
+	return end - offset;
+}
+
+//! Find the end of a literal run starting at an offset
+/*! The run ends where a run of zeroes or repeats long enough to be stored on its own begins */
+static size_t find_literal_end(const uint8_t* bytes, size_t offset)
+{
+	size_t end = offset + 1;
+	while (end < LSDJ_SONG_BYTE_COUNT && count_repeats(bytes, end) < MIN_RUN_LENGTH)
+		end++;
+
+	return end;
+}
+
+//! Split the song, XOR'ed against a new song, into runs
+static void encode_runs(const uint8_t* bytes, encoder_t* encoder)
+{
+	size_t offset = 0;
+	while (offset < LSDJ_SONG_BYTE_COUNT)
+	{
+		const size_t repeats = count_repeats(bytes, offset);
+		const uint8_t value = bytes[offset] ^ LSDJ_SONG_NEW_BYTES[offset];
+
+		if (value == 0)
+		{
+			// Zero runs are always worth it, their bytes don't have to be stored at all
+			emit_run(encoder, RUN_ZERO, repeats);
+			offset += repeats;
+		} else if (repeats >= MIN_RUN_LENGTH) {
+			emit_run(encoder, RUN_REPEAT, repeats);
+			emit(encoder, value);
+			offset += repeats;
+		} else {
+			const size_t end = find_literal_end(bytes, offset);
+			emit_run(encoder, RUN_LITERAL, end - offset);
+			for (; offset < end; offset++)
+				emit(encoder, bytes[offset] ^ LSDJ_SONG_NEW_BYTES[offset]);
+		}
+	}
+}
+
+static bool write_uint64(lsdj_vio_t* wvio, uint64_t value, size_t* writeCounter)
+{
+	uint8_t bytes[8];
+	for (size_t i = 0; i < 8; i++)
+		bytes[i] = (uint8_t)((value >> (i * 8)) & 0xFF);
+
+	return lsdj_vio_write(wvio, bytes, sizeof(bytes), writeCounter);
+}
+
+lsdj_error_t lsdj_song_write_archive(const lsdj_song_t* song, lsdj_vio_t* wvio, size_t* writeCounter)
+{
+	assert(song != NULL);
+
+	// The first pass counts the run bytes, to decide on the encoding and build the Huffman codes
+	encoder_t encoder;
+	memset(&encoder, 0, sizeof(encoder));
+	encode_runs(song->bytes, &encoder);
+
+	uint8_t lengths[256];
+	uint16_t codes[256];
+	limit_code_lengths(encoder.frequencies, lengths);
+	assign_codes(lengths, codes);
+
+	size_t rawSize = 0;
+	size_t codedBits = 0;
+	for (size_t i = 0; i < 256; i++)
+	{
+		rawSize += encoder.frequencies[i];
+		codedBits += encoder.frequencies[i] * lengths[i];
+	}
+
+	const size_t huffmanSize = CODE_LENGTHS_SIZE + (codedBits + 7) / 8;
+	const uint8_t encoding = huffmanSize < rawSize ? ENCODING_HUFFMAN : ENCODING_RAW;
+	const size_t payloadSize = encoding == ENCODING_HUFFMAN ? huffmanSize : rawSize;
+	assert(payloadSize <= 0xFFFF);
+
+	if (!lsdj_vio_write(wvio, MAGIC, sizeof(MAGIC), writeCounter) ||
+		!lsdj_vio_write_byte(wvio, ARCHIVE_FORMAT_VERSION, writeCounter) ||
+		!write_uint64(wvio, lsdj_song_hash(song), writeCounter) ||
+		!lsdj_vio_write_byte(wvio, encoding, writeCounter) ||
+		!lsdj_vio_write_byte(wvio, (uint8_t)(payloadSize & 0xFF), writeCounter) ||
+		!lsdj_vio_write_byte(wvio, (uint8_t)(payloadSize >> 8), writeCounter))
+	{
+		return LSDJ_WRITE_FAILED;
+	}
+
+	// The second pass writes the run bytes out
+	encoder.wvio = wvio;
+	encoder.writeCounter = writeCounter;
+
+	if (encoding == ENCODING_HUFFMAN)
+	{
+		for (size_t i = 0; i < 256; i += 2)
+			put_byte(&encoder, (uint8_t)(lengths[i] | (lengths[i + 1] << 4)));
+
+		encoder.codes = codes;
+		encoder.lengths = lengths;
+	}
+
+	encode_runs(song->bytes, &encoder);
+
+	if (encoder.bitCount > 0)
+		put_byte(&encoder, (uint8_t)encoder.bits);
+	if (encoder.bufferSize > 0)
+		flush_buffer(&encoder);
+
+	return encoder.failed ? LSDJ_WRITE_FAILED : LSDJ_SUCCESS;
+}
+
+
+// --- Decoding --- //
+
+//! Reads the run bytes, either straight from memory or buffered from virtual I/O
+typedef struct
+{
+	//! The virtual I/O to read from, or NULL when the whole payload is in memory
+	lsdj_vio_t* rvio;
+	size_t* readCounter;
+
+	//! The payload bytes that haven't been read from rvio yet
+	size_t remaining;
+
+	const uint8_t* cur;
+	const uint8_t* end;
+	uint8_t buffer[BUFFER_SIZE];
+
+	//! The Huffman decoding table, indexed by the next MAX_CODE_LENGTH bits
+	/*! Each entry holds the symbol in the upper bits and the code length in the lower four */
+	uint16_t table[1 << MAX_CODE_LENGTH];
+	bool huffman;
+
+	uint64_t bits;
+	size_t bitCount;
+
+	lsdj_error_t error;
+} decoder_t;
+
+static bool next_byte(decoder_t* decoder, uint8_t* byte)
+{
+	if (decoder->cur == decoder->end)
+	{
+		if (decoder->rvio == NULL || decoder->remaining == 0)
+			return false;
+
+		const size_t size = decoder->remaining < BUFFER_SIZE ? decoder->remaining : BUFFER_SIZE;
+		if (!lsdj_vio_read(decoder->rvio, decoder->buffer, size, decoder->readCounter))
+			return false;
+
+		decoder->remaining -= size;
+		decoder->cur = decoder->buffer;
+		decoder->end = decoder->buffer + size;
+	}
+
+	*byte = *decoder->cur++;
+	return true;
+}
+
+static bool read_code_lengths(decoder_t* decoder)
+{
+	uint8_t lengths[256];
+	for (size_t i = 0; i < 256; i += 2)
+	{
+		uint8_t byte = 0;
+		if (!next_byte(decoder, &byte))
+		{
+			decoder->error = LSDJ_READ_FAILED;
+			return false;
+		}
+
+		lengths[i] = byte & 0x0F;
+		lengths[i + 1] = byte >> 4;
+	}
+
+	uint16_t codes[256];
+	if (!assign_codes(lengths, codes))
+	{
+		decoder->error = LSDJ_ARCHIVE_INVALID;
+		return false;
+	}
+
+	// Entries not covered by any code keep a length of zero, and are rejected when decoding
+	memset(decoder->table, 0, sizeof(decoder->table));
+	for (size_t i = 0; i < 256; i++)
+	{
+		for (size_t index = codes[i]; lengths[i] > 0 && index < (1 << MAX_CODE_LENGTH); index += (size_t)1 << lengths[i])
+			decoder->table[index] = (uint16_t)((i << 4) | lengths[i]);
+	}
+
+	decoder->huffman = true;
+	return true;
+}
+
+static bool decode_byte(decoder_t* decoder, uint8_t* byte)
+{
+	if (!decoder->huffman)
+	{
+		if (next_byte(decoder, byte))
+			return true;
+
+		decoder->error = LSDJ_READ_FAILED;
+		return false;
+	}
+
+	uint8_t next = 0;
+	while (decoder->bitCount < MAX_CODE_LENGTH && next_byte(decoder, &next))
+	{
+		decoder->bits |= (uint64_t)next << decoder->bitCount;
+		decoder->bitCount += 8;
+	}
+
+	const uint16_t entry = decoder->table[decoder->bits & ((1 << MAX_CODE_LENGTH) - 1)];
+	const size_t length = entry & 0x0F;
+	if (length == 0 || length > decoder->bitCount)
+	{
+		decoder->error = length == 0 ? LSDJ_ARCHIVE_INVALID : LSDJ_READ_FAILED;
+		return false;
+	}
+
+	decoder->bits >>= length;
+	decoder->bitCount -= length;
+	*byte = (uint8_t)(entry >> 4);
+	return true;
+}
+
+static bool decode_run(decoder_t* decoder, size_t* run)
+{
+	*run = 0;
+	for (size_t shift = 0; shift < 35; shift += 7)
+	{
+		uint8_t byte = 0;
+		if (!decode_byte(decoder, &byte))
+			return false;
+
+		*run |= (size_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+
+	decoder->error = LSDJ_ARCHIVE_INVALID;
+	return false;
+}
+
+//! Decode the payload following the header straight into a song
+static lsdj_error_t decode(decoder_t* decoder, const uint8_t* header, lsdj_song_t* song)
+{
+	if (memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || header[4] != ARCHIVE_FORMAT_VERSION)
+		return LSDJ_ARCHIVE_INVALID;
+
+	uint64_t hash = 0;
+	for (size_t i = 0; i < 8; i++)
+		hash |= (uint64_t)header[5 + i] << (i * 8);
+
+	const uint8_t encoding = header[13];
+	if (encoding == ENCODING_HUFFMAN)
+	{
+		if (!read_code_lengths(decoder))
+			return decoder->error;
+	} else if (encoding != ENCODING_RAW) {
+		return LSDJ_ARCHIVE_INVALID;
+	}
+
+	// Start out from a new song, so zero runs can simply be skipped over
+	uint8_t* bytes = song->bytes;
+	memcpy(bytes, LSDJ_SONG_NEW_BYTES, LSDJ_SONG_BYTE_COUNT);
+
+	size_t offset = 0;
+	while (offset < LSDJ_SONG_BYTE_COUNT)
+	{
+		size_t run = 0;
+		if (!decode_run(decoder, &run))
+			return decoder->error;
+
+		const size_t length = run >> RUN_TYPE_BITS;
+		if (length == 0 || length > LSDJ_SONG_BYTE_COUNT - offset)
+			return LSDJ_ARCHIVE_INVALID;
+
+		switch (run & RUN_TYPE_MASK)
+		{
+			case RUN_ZERO:
+				break;
+
+			case RUN_REPEAT:
+			{
+				uint8_t value = 0;
+				if (!decode_byte(decoder, &value))
+					return decoder->error;
+
+				for (size_t i = offset; i < offset + length; i++)
+					bytes[i] ^= value;
+				break;
+			}
+
+			case RUN_LITERAL:
+			{
+				for (size_t i = offset; i < offset + length; i++)
+				{
+					uint8_t value = 0;
+					if (!decode_byte(decoder, &value))
+						return decoder->error;
+
+					bytes[i] ^= value;
+				}
+				break;
+			}
+
+			default:
+				return LSDJ_ARCHIVE_INVALID;
+		}
+
+		offset += length;
+	}
+
+	if (lsdj_song_hash(song) != hash)
+		return LSDJ_ARCHIVE_INVALID;
+
+	return LSDJ_SUCCESS;
+}
+
+static size_t read_payload_size(const uint8_t* header)
+{
+	return (size_t)header[14] | ((size_t)header[15] << 8);
+}
+
+lsdj_error_t lsdj_song_read_archive(lsdj_vio_t* rvio, size_t* readCounter, lsdj_song_t* song)
+{
+	assert(song != NULL);
+
+	uint8_t header[LSDJ_ARCHIVE_HEADER_SIZE];
+	if (!lsdj_vio_read(rvio, header, sizeof(header), readCounter))
+		return LSDJ_READ_FAILED;
+
+	decoder_t decoder;
+	memset(&decoder, 0, sizeof(decoder));
+	decoder.rvio = rvio;
+	decoder.readCounter = readCounter;
+	decoder.remaining = read_payload_size(header);
+
+	const lsdj_error_t result = decode(&decoder, header, song);
+	if (result != LSDJ_SUCCESS)
+		return result;
+
+	// Leave the stream right after the archive, even if the last few bytes were never needed
+	while (decoder.remaining > 0)
+	{
+		const size_t size = decoder.remaining < BUFFER_SIZE ? decoder.remaining : BUFFER_SIZE;
+		if (!lsdj_vio_read(rvio, decoder.buffer, size, readCounter))
+			return LSDJ_READ_FAILED;
+
+		decoder.remaining -= size;
+	}
+
+	return LSDJ_SUCCESS;
+}
+
+lsdj_error_t lsdj_song_read_archive_from_memory(const uint8_t* data, size_t size, size_t* readCounter, lsdj_song_t* song)
+{
+	assert(data != NULL);
+	assert(song != NULL);
+
+	if (size < LSDJ_ARCHIVE_HEADER_SIZE || size - LSDJ_ARCHIVE_HEADER_SIZE < read_payload_size(data))
+		return LSDJ_READ_FAILED;
+
+	decoder_t decoder;
+	memset(&decoder, 0, sizeof(decoder));
+	decoder.cur = data + LSDJ_ARCHIVE_HEADER_SIZE;
+	decoder.end = decoder.cur + read_payload_size(data);
+
+	const lsdj_error_t result = decode(&decoder, data, song);
+	if (result == LSDJ_SUCCESS && readCounter)
+		*readCounter += LSDJ_ARCHIVE_HEADER_SIZE + read_payload_size(data);
+
+	return result;
+}
@@ -0,0 +1,495 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include "clean.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "chain.h"
+#include "channel.h"
+#include "groove.h"
+#include "hash_state.h"
+#include "instrument.h"
+#include "phrase.h"
+#include "song_offsets.h"
+#include "synth.h"
+#include "table.h"
+#include "wave.h"
+
+//! The amount of chain slots in a song (0x00 through 0x7F)
+#define CHAIN_SLOT_COUNT (0x80)
+
+//! The amount of groove slots in a song (0x00 through 0x1F)
+#define GROOVE_SLOT_COUNT (0x20)
+
+//! The amount of wave slots in a song (0x00 through 0xFF)
+#define WAVE_SLOT_COUNT (0x100)
+
+//! The amount of waves generated by each synth
+#define WAVES_PER_SYNTH (WAVE_SLOT_COUNT / LSDJ_SYNTH_COUNT)
+
+//! The amount of song rows
+#define ROW_COUNT (256)
+
+typedef struct
+{
+	bool chains[CHAIN_SLOT_COUNT];
+	bool phrases[LSDJ_PHRASE_COUNT];
+	bool instruments[LSDJ_INSTRUMENT_COUNT];
+	bool tables[LSDJ_TABLE_COUNT];
+	bool grooves[GROOVE_SLOT_COUNT];
+	bool synths[LSDJ_SYNTH_COUNT];
+	bool waves[WAVE_SLOT_COUNT];
+} reachable_t;
+
+
+// --- Marking --- //
+
+static void mark_command(reachable_t* reachable, lsdj_command_t command, uint8_t value)
+{
+	if (command == LSDJ_COMMAND_A && value < LSDJ_TABLE_COUNT)
+		reachable->tables[value] = true;
+	else if (command == LSDJ_COMMAND_G && value < GROOVE_SLOT_COUNT)
+		reachable->grooves[value] = true;
+}
+
+static void mark_rows(const lsdj_song_t* song, reachable_t* reachable)
+{
+	for (size_t row = 0; row < ROW_COUNT; row++)
+	{
+		for (uint8_t channel = 0; channel < LSDJ_CHANNEL_COUNT; channel++)
+		{
+			const uint8_t chain = lsdj_row_get_chain(song, (uint8_t)row, channel);
+			if (chain < CHAIN_SLOT_COUNT)
+				reachable->chains[chain] = true;
+		}
+	}
+}
+
+static void mark_chains(const lsdj_song_t* song, reachable_t* reachable)
+{
+	for (size_t chain = 0; chain < CHAIN_SLOT_COUNT; chain++)
+	{
+		if (!reachable->chains[chain])
+			continue;
+
+		for (uint8_t step = 0; step < LSDJ_CHAIN_LENGTH; step++)
+		{
+			const uint8_t phrase = lsdj_chain_get_phrase(song, (uint8_t)chain, step);
+			if (phrase < LSDJ_PHRASE_COUNT)
+				reachable->phrases[phrase] = true;
+		}
+	}
+}
+
+static void mark_phrases(const lsdj_song_t* song, reachable_t* reachable)
+{
+	for (uint8_t phrase = 0; phrase < LSDJ_PHRASE_COUNT; phrase++)
+	{
+		if (!reachable->phrases[phrase])
+			continue;
+
+		for (uint8_t step = 0; step < LSDJ_PHRASE_LENGTH; step++)
+		{
+			const uint8_t instrument = lsdj_phrase_get_instrument(song, phrase, step);
+			if (instrument < LSDJ_INSTRUMENT_COUNT)
+				reachable->instruments[instrument] = true;
+
+			mark_command(reachable, lsdj_phrase_get_command(song, phrase, step), lsdj_phrase_get_command_value(song, phrase, step));
+		}
+	}
+}
+
+static void mark_instruments(const lsdj_song_t* song, reachable_t* reachable)
+{
+	for (uint8_t instrument = 0; instrument < LSDJ_INSTRUMENT_COUNT; instrument++)
+	{
+		if (!reachable->instruments[instrument])
+			continue;
+
+		if (lsdj_instrument_is_table_enabled(song, instrument))
+		{
+			const uint8_t table = lsdj_instrument_get_table(song, instrument);
+			if (table < LSDJ_TABLE_COUNT)
+				reachable->tables[table] = true;
+		}
+
+		if (lsdj_instrument_get_type(song, instrument) == LSDJ_INSTRUMENT_TYPE_WAVE)
+		{
+			const uint8_t synth = lsdj_instrument_wave_get_synth(song, instrument);
+			if (synth < LSDJ_SYNTH_COUNT)
+			{
+				reachable->synths[synth] = true;
+				for (size_t wave = 0; wave < WAVES_PER_SYNTH; wave++)
+					reachable->waves[synth * WAVES_PER_SYNTH + wave] = true;
+			}
+
+			reachable->waves[lsdj_instrument_wave_get_wave(song, instrument)] = true;
+		}
+	}
+}
+
+static void mark_tables(const lsdj_song_t* song, reachable_t* reachable)
+{
+	// Tables can refer to other tables with A-commands, so keep a
+	// worklist of tables whose commands still need to be followed
+	uint8_t worklist[LSDJ_TABLE_COUNT];
+	size_t count = 0;
+
+	bool visited[LSDJ_TABLE_COUNT];
+	for (uint8_t table = 0; table < LSDJ_TABLE_COUNT; table++)
+	{
+		visited[table] = reachable->tables[table];
+		if (visited[table])
+			worklist[count++] = table;
+	}
+
+	while (count > 0)
+	{
+		const uint8_t table = worklist[--count];
+
+		for (uint8_t step = 0; step < LSDJ_TABLE_LENGTH; step++)
+		{
+			mark_command(reachable, lsdj_table_get_command1(song, table, step), lsdj_table_get_command1_value(song, table, step));
+			mark_command(reachable, lsdj_table_get_command2(song, table, step), lsdj_table_get_command2_value(song, table, step));
+		}
+
+		for (uint8_t other = 0; other < LSDJ_TABLE_COUNT; other++)
+		{
+			if (reachable->tables[other] && !visited[other])
+			{
+				visited[other] = true;
+				worklist[count++] = other;
+			}
+		}
+	}
+}
+
+
+// --- Clearing --- //
+
+//! Reset a range of bytes in a song to what a new song contains
+static void reset_bytes(lsdj_song_t* song, size_t offset, size_t count)
+{
+	memcpy(&song->bytes[offset], &LSDJ_SONG_NEW_BYTES[offset], count);
+}
+
+static void clear_allocation_bit(lsdj_song_t* song, size_t offset, size_t index)
+{
+	song->bytes[offset + index / 8] &= (uint8_t)~(1 << (index % 8));
+}
+
+static void clear_chain(lsdj_song_t* song, size_t chain)
+{
+	reset_bytes(song, CHAIN_PHRASES_OFFSET + chain * LSDJ_CHAIN_LENGTH, LSDJ_CHAIN_LENGTH);
+	reset_bytes(song, CHAIN_TRANSPOSITIONS_OFFSET + chain * LSDJ_CHAIN_LENGTH, LSDJ_CHAIN_LENGTH);
+	clear_allocation_bit(song, CHAIN_ALLOCATIONS_OFFSET, chain);
+}
+
+static void clear_phrase(lsdj_song_t* song, size_t phrase)
+{
+	reset_bytes(song, PHRASE_NOTES_OFFSET + phrase * LSDJ_PHRASE_LENGTH, LSDJ_PHRASE_LENGTH);
+	reset_bytes(song, PHRASE_INSTRUMENTS_OFFSET + phrase * LSDJ_PHRASE_LENGTH, LSDJ_PHRASE_LENGTH);
+	reset_bytes(song, PHRASE_COMMANDS_OFFSET + phrase * LSDJ_PHRASE_LENGTH, LSDJ_PHRASE_LENGTH);
+	reset_bytes(song, PHRASE_COMMAND_VALUES_OFFSET + phrase * LSDJ_PHRASE_LENGTH, LSDJ_PHRASE_LENGTH);
+	clear_allocation_bit(song, PHRASE_ALLOCATIONS_OFFSET, phrase);
+}
+
+static void clear_instrument(lsdj_song_t* song, size_t instrument)
+{
+	reset_bytes(song, INSTRUMENT_PARAMS_OFFSET + instrument * LSDJ_INSTRUMENT_BYTE_COUNT, LSDJ_INSTRUMENT_BYTE_COUNT);
+	reset_bytes(song, INSTRUMENT_NAMES_OFFSET + instrument * LSDJ_INSTRUMENT_NAME_LENGTH, LSDJ_INSTRUMENT_NAME_LENGTH);
+	song->bytes[INSTRUMENT_ALLOCATION_TABLE_OFFSET + instrument] = 0;
+}
+
+static void clear_table(lsdj_song_t* song, size_t table)
+{
+	reset_bytes(song, TABLE_ENVELOPES_OFFSET + table * LSDJ_TABLE_LENGTH, LSDJ_TABLE_LENGTH);
+	reset_bytes(song, TABLE_TRANSPOSITION_OFFSET + table * LSDJ_TABLE_LENGTH, LSDJ_TABLE_LENGTH);
+	reset_bytes(song, TABLE_COMMAND1_OFFSET + table * LSDJ_TABLE_LENGTH, LSDJ_TABLE_LENGTH);
+	reset_bytes(song, TABLE_COMMAND1_VALUE_OFFSET + table * LSDJ_TABLE_LENGTH, LSDJ_TABLE_LENGTH);
+	reset_bytes(song, TABLE_COMMAND2_OFFSET + table * LSDJ_TABLE_LENGTH, LSDJ_TABLE_LENGTH);
+	reset_bytes(song, TABLE_COMMAND2_VALUE_OFFSET + table * LSDJ_TABLE_LENGTH, LSDJ_TABLE_LENGTH);
+	song->bytes[TABLE_ALLOCATION_TABLE_OFFSET + table] = 0;
+}
+
+static void clear_synth(lsdj_song_t* song, uint8_t synth)
+{
+	reset_bytes(song, SYNTH_PARAMS_OFFSET + (size_t)synth * LSDJ_SYNTH_BYTE_COUNT, LSDJ_SYNTH_BYTE_COUNT);
+	lsdj_synth_set_wave_overwritten(song, synth, false);
+}
+
+void lsdj_song_clean(lsdj_song_t* song)
+{
+	reachable_t reachable;
+	memset(&reachable, 0, sizeof(reachable));
+
+	// Every channel starts playing with groove 0
+	reachable.grooves[0] = true;
+
+	mark_rows(song, &reachable);
+	mark_chains(song, &reachable);
+	mark_phrases(song, &reachable);
+	mark_instruments(song, &reachable);
+	mark_tables(song, &reachable);
+
+	for (size_t chain = 0; chain < CHAIN_SLOT_COUNT; chain++)
+	{
+		if (!reachable.chains[chain])
+			clear_chain(song, chain);
+	}
+
+	for (size_t phrase = 0; phrase < LSDJ_PHRASE_COUNT; phrase++)
+	{
+		if (!reachable.phrases[phrase])
+			clear_phrase(song, phrase);
+	}
+
+	for (size_t instrument = 0; instrument < LSDJ_INSTRUMENT_COUNT; instrument++)
+	{
+		if (!reachable.instruments[instrument])
+			clear_instrument(song, instrument);
+	}
+
+	for (size_t table = 0; table < LSDJ_TABLE_COUNT; table++)
+	{
+		if (!reachable.tables[table])
+			clear_table(song, table);
+	}
+
+	for (size_t groove = 0; groove < GROOVE_SLOT_COUNT; groove++)
+	{
+		if (!reachable.grooves[groove])
+			reset_bytes(song, GROOVES_OFFSET + groove * LSDJ_GROOVE_LENGTH, LSDJ_GROOVE_LENGTH);
+	}
+
+	for (uint8_t synth = 0; synth < LSDJ_SYNTH_COUNT; synth++)
+	{
+		if (!reachable.synths[synth])
+			clear_synth(song, synth);
+	}
+
+	for (size_t wave = 0; wave < WAVE_SLOT_COUNT; wave++)
+	{
+		if (!reachable.waves[wave])
+			reset_bytes(song, WAVES_OFFSET + wave * LSDJ_WAVE_BYTE_COUNT, LSDJ_WAVE_BYTE_COUNT);
+	}
+}
+
+
+// --- Deduplication --- //
+
+//! The maximum amount of separate byte ranges an entity is stored in
+#define BANK_MAX_RANGE_COUNT (4)
+
+//! The value used for an empty slot in a deduplication hash table
+#define NO_ENTRY (0xFFFF)
+
+//! Description of a bank of entities (phrases, chains) and where they are referenced from
+typedef struct
+{
+	//! The offsets of each byte range an entity is stored in
+	size_t offsets[BANK_MAX_RANGE_COUNT];
+
+	//! The amount of byte ranges each entity is stored in
+	size_t rangeCount;
+
+	//! The length of an entity within each byte range
+	size_t length;
+
+	//! The amount of entities in the bank
+	size_t count;
+
+	//! The offset of the allocation bit field
+	size_t allocationsOffset;
+
+	//! The offset of the references to entities in this bank
+	size_t referencesOffset;
+
+	//! The amount of references to entities in this bank
+	size_t referenceCount;
+} bank_t;
+
+static const bank_t PHRASE_BANK = {
+	{ PHRASE_NOTES_OFFSET, PHRASE_INSTRUMENTS_OFFSET, PHRASE_COMMANDS_OFFSET, PHRASE_COMMAND_VALUES_OFFSET }, 4,
+	LSDJ_PHRASE_LENGTH, LSDJ_PHRASE_COUNT, PHRASE_ALLOCATIONS_OFFSET,
+	CHAIN_PHRASES_OFFSET, CHAIN_SLOT_COUNT * LSDJ_CHAIN_LENGTH
+};
+
+static const bank_t CHAIN_BANK = {
+	{ CHAIN_PHRASES_OFFSET, CHAIN_TRANSPOSITIONS_OFFSET, 0, 0 }, 2,
+	LSDJ_CHAIN_LENGTH, CHAIN_SLOT_COUNT, CHAIN_ALLOCATIONS_OFFSET,
+	CHAIN_ASSIGNMENTS_OFFSET, ROW_COUNT * LSDJ_CHANNEL_COUNT
+};
+
+static bool is_entity_allocated(const lsdj_song_t* song, const bank_t* bank, size_t entity)
+{
+	return (song->bytes[bank->allocationsOffset + entity / 8] & (1 << (entity % 8))) != 0;
+}
+
+static uint64_t hash_entity(const lsdj_song_t* song, const bank_t* bank, size_t entity)
+{
+	lsdj_hash_state_t state;
+	lsdj_hash_state_init(&state, 0);
+
+	for (size_t range = 0; range < bank->rangeCount; range++)
+		lsdj_hash_state_update(&state, &song->bytes[bank->offsets[range] + entity * bank->length], bank->length);
+
+	return lsdj_hash_state_digest(&state);
+}
+
+static bool are_entities_equal(const lsdj_song_t* song, const bank_t* bank, size_t lhs, size_t rhs)
+{
+	for (size_t range = 0; range < bank->rangeCount; range++)
+	{
+		const uint8_t* bytes = &song->bytes[bank->offsets[range]];
+		if (memcmp(bytes + lhs * bank->length, bytes + rhs * bank->length, bank->length) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+static void move_entity(lsdj_song_t* song, const bank_t* bank, size_t from, size_t to)
+{
+	for (size_t range = 0; range < bank->rangeCount; range++)
+	{
+		uint8_t* bytes = &song->bytes[bank->offsets[range]];
+		memcpy(bytes + to * bank->length, bytes + from * bank->length, bank->length);
+	}
+
+	song->bytes[bank->allocationsOffset + to / 8] |= (uint8_t)(1 << (to % 8));
+}
+
+static void reset_entity(lsdj_song_t* song, const bank_t* bank, size_t entity)
+{
+	for (size_t range = 0; range < bank->rangeCount; range++)
+		reset_bytes(song, bank->offsets[range] + entity * bank->length, bank->length);
+
+	clear_allocation_bit(song, bank->allocationsOffset, entity);
+}
+
+static unsigned int deduplicate_bank(lsdj_song_t* song, const bank_t* bank)
+{
+	// Maps every entity index to the index it should be referred to by afterwards
+	uint8_t remap[256];
+
+	// Open-addressing hash table of the first occurrence of every unique entity.
+	// It has at least twice the amount of slots as there are entities, so it
+	// never fills up and probe sequences stay short.
+	uint16_t table[512];
+	const size_t tableMask = sizeof(table) / sizeof(table[0]) - 1;
+	for (size_t i = 0; i <= tableMask; i++)
+		table[i] = NO_ENTRY;
+
+	// Entities that are referenced, but not allocated, are pinned in place
+	bool pinned[256];
+	memset(pinned, 0, sizeof(pinned));
+	for (size_t i = 0; i < bank->referenceCount; i++)
+	{
+		const uint8_t entity = song->bytes[bank->referencesOffset + i];
+		if (entity < bank->count && !is_entity_allocated(song, bank, entity))
+			pinned[entity] = true;
+	}
+
+	// Merge duplicates into their first occurrence
+	unsigned int merged = 0;
+	for (size_t entity = 0; entity < bank->count; entity++)
+	{
+		remap[entity] = (uint8_t)entity;
+		if (!is_entity_allocated(song, bank, entity))
+			continue;
+
+		size_t slot = (size_t)(hash_entity(song, bank, entity) & tableMask);
+		while (table[slot] != NO_ENTRY && !are_entities_equal(song, bank, table[slot], entity))
+			slot = (slot + 1) & tableMask;
+
+		if (table[slot] == NO_ENTRY)
+		{
+			table[slot] = (uint16_t)entity;
+		} else {
+			remap[entity] = (uint8_t)table[slot];
+			reset_entity(song, bank, entity);
+			merged++;
+		}
+	}
+
+	// Compact the remaining entities towards the start of the bank. Entities only
+	// ever move down, so moving them in ascending order never overwrites live data.
+	uint8_t compacted[256];
+	size_t next = 0;
+	for (size_t entity = 0; entity < bank->count; entity++)
+	{
+		compacted[entity] = (uint8_t)entity;
+		if (remap[entity] != entity)
+			continue;
+
+		if (!is_entity_allocated(song, bank, entity))
+			continue;
+
+		while (next < entity && pinned[next])
+			next++;
+
+		if (next < entity)
+		{
+			move_entity(song, bank, entity, next);
+			reset_entity(song, bank, entity);
+			compacted[entity] = (uint8_t)next;
+		}
+
+		next++;
+	}
+
+	// Rewrite every reference to its new location
+	for (size_t i = 0; i < bank->referenceCount; i++)
+	{
+		uint8_t* reference = &song->bytes[bank->referencesOffset + i];
+		if (*reference < bank->count)
+			*reference = compacted[remap[*reference]];
+	}
+
+	return merged;
+}
+
+unsigned int lsdj_song_deduplicate_phrases(lsdj_song_t* song)
+{
+	return deduplicate_bank(song, &PHRASE_BANK);
+}
+
+unsigned int lsdj_song_deduplicate_chains(lsdj_song_t* song)
+{
+	return deduplicate_bank(song, &CHAIN_BANK);
+}
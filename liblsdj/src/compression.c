@@ -473,3 +473,59 @@ lsdj_error_t lsdj_compress(const uint8_t* data, lsdj_vio_t* wvio, unsigned int b
     
     return LSDJ_SUCCESS;
 }
+
+//! Virtual I/O write function that only keeps track of the position
+static size_t count_write(const void* ptr, size_t size, void* userData)
+{
+    (void)ptr;
+    
+    long* position = (long*)userData;
+    *position += (long)size;
+    
+    return size;
+}
+
+//! Virtual I/O tell function that returns the counted position
+static long count_tell(void* userData)
+{
+    return *(const long*)userData;
+}
+
+//! Virtual I/O seek function that moves the counted position
+static long count_seek(long offset, int whence, void* userData)
+{
+    long* position = (long*)userData;
+    
+    switch (whence)
+    {
+        case SEEK_SET: *position = offset; break;
+        case SEEK_CUR: *position += offset; break;
+        default: return 1;
+    }
+    
+    return 0;
+}
+
+lsdj_error_t lsdj_compress_count_blocks(const uint8_t* data, unsigned int* blockCount)
+{
+    assert(data != NULL);
+    assert(blockCount != NULL);
+    
+    long position = 0;
+    
+    lsdj_vio_t vio;
+    vio.read = NULL;
+    vio.write = count_write;
+    vio.tell = count_tell;
+    vio.seek = count_seek;
+    vio.userData = &position;
+    
+    size_t size = 0;
+    const lsdj_error_t result = lsdj_compress(data, &vio, 1, &size);
+    if (result != LSDJ_SUCCESS)
+        return result;
+    
+    *blockCount = (unsigned int)(size / LSDJ_BLOCK_SIZE);
+    
+    return LSDJ_SUCCESS;
+}
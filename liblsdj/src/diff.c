@@ -0,0 +1,226 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include "diff.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "hash.h"
+#include "song_offsets.h"
+
+//! The bytes each diff starts with
+static const uint8_t MAGIC[4] = { 'L', 'S', 'D', 'D' };
+
+//! The version of the diff format
+#define DIFF_FORMAT_VERSION (1)
+
+//! The size of the offset and length prefixed to each run
+#define RUN_HEADER_SIZE (4)
+
+//! Unchanged bytes between two changes that are included in the run, instead of starting a new one
+/*! Starting a new run costs RUN_HEADER_SIZE bytes, so copying over up to that many unchanged bytes is cheaper */
+#define MAX_RUN_GAP (RUN_HEADER_SIZE)
+
+//! The start of every region in song memory, see song_offsets.h
+static const size_t REGION_STARTS[] =
+{
+	PHRASE_NOTES_OFFSET, BOOKMARKS_OFFSET, EMPTY1_OFFSET, GROOVES_OFFSET, CHAIN_ASSIGNMENTS_OFFSET,
+	TABLE_ENVELOPES_OFFSET, WORDS_OFFSET, WORD_NAMES_OFFSET, RB1_OFFSET, INSTRUMENT_NAMES_OFFSET, EMPTY2_OFFSET,
+	EMPTY3_OFFSET, TABLE_ALLOCATION_TABLE_OFFSET, INSTRUMENT_ALLOCATION_TABLE_OFFSET, CHAIN_PHRASES_OFFSET,
+	CHAIN_TRANSPOSITIONS_OFFSET, INSTRUMENT_PARAMS_OFFSET, TABLE_TRANSPOSITION_OFFSET, TABLE_COMMAND1_OFFSET,
+	TABLE_COMMAND1_VALUE_OFFSET, TABLE_COMMAND2_OFFSET, TABLE_COMMAND2_VALUE_OFFSET, RB2_OFFSET,
+	PHRASE_ALLOCATIONS_OFFSET, CHAIN_ALLOCATIONS_OFFSET, SYNTH_PARAMS_OFFSET, WORK_HOURS_OFFSET,
+	PHRASE_COMMANDS_OFFSET, PHRASE_COMMAND_VALUES_OFFSET, EMPTY7_OFFSET,
+	WAVES_OFFSET, PHRASE_INSTRUMENTS_OFFSET, RB3_OFFSET, EMPTY8_OFFSET, FORMAT_VERSION_OFFSET,
+	LSDJ_SONG_BYTE_COUNT
+};
+
+//! Find the end of the region an offset lies in
+static size_t region_end(size_t offset)
+{
+	size_t i = 0;
+	while (REGION_STARTS[i] <= offset)
+		i++;
+
+	return REGION_STARTS[i];
+}
+
+//! Find the next run of changed bytes, starting at a given offset
+/*! @return false if there are no more changes */
+static bool find_run(const uint8_t* from, const uint8_t* to, size_t* offset, size_t* length)
+{
+	size_t begin = *offset;
+
+	// Skip over unchanged memory a word at a time
+	while (begin + 8 <= LSDJ_SONG_BYTE_COUNT && memcmp(from + begin, to + begin, 8) == 0)
+		begin += 8;
+
+	while (begin < LSDJ_SONG_BYTE_COUNT && from[begin] == to[begin])
+		begin++;
+
+	if (begin == LSDJ_SONG_BYTE_COUNT)
+		return false;
+
+	const size_t end = region_end(begin);
+	size_t last = begin;
+	for (size_t i = begin + 1; i < end && i - last <= MAX_RUN_GAP; i++)
+	{
+		if (from[i] != to[i])
+			last = i;
+	}
+
+	*offset = begin;
+	*length = last + 1 - begin;
+	return true;
+}
+
+static bool write_uint16(lsdj_vio_t* wvio, size_t value, size_t* writeCounter)
+{
+	const uint8_t bytes[2] = { (uint8_t)(value & 0xFF), (uint8_t)((value >> 8) & 0xFF) };
+	return lsdj_vio_write(wvio, bytes, sizeof(bytes), writeCounter);
+}
+
+static bool write_uint64(lsdj_vio_t* wvio, uint64_t value, size_t* writeCounter)
+{
+	uint8_t bytes[8];
+	for (size_t i = 0; i < 8; i++)
+		bytes[i] = (uint8_t)((value >> (i * 8)) & 0xFF);
+
+	return lsdj_vio_write(wvio, bytes, sizeof(bytes), writeCounter);
+}
+
+static bool read_uint16(lsdj_vio_t* rvio, size_t* value, size_t* readCounter)
+{
+	uint8_t bytes[2];
+	if (!lsdj_vio_read(rvio, bytes, sizeof(bytes), readCounter))
+		return false;
+
+	*value = (size_t)bytes[0] | ((size_t)bytes[1] << 8);
+	return true;
+}
+
+static bool read_uint64(lsdj_vio_t* rvio, uint64_t* value, size_t* readCounter)
+{
+	uint8_t bytes[8];
+	if (!lsdj_vio_read(rvio, bytes, sizeof(bytes), readCounter))
+		return false;
+
+	*value = 0;
+	for (size_t i = 0; i < 8; i++)
+		*value |= (uint64_t)bytes[i] << (i * 8);
+
+	return true;
+}
+
+lsdj_error_t lsdj_song_diff(const lsdj_song_t* from, const lsdj_song_t* to, lsdj_vio_t* wvio, size_t* writeCounter)
+{
+	// Count the runs up front, so the reader knows how many to expect
+	size_t runCount = 0;
+	size_t offset = 0;
+	size_t length = 0;
+	for (; find_run(from->bytes, to->bytes, &offset, &length); offset += length)
+		runCount++;
+
+	if (!lsdj_vio_write(wvio, MAGIC, sizeof(MAGIC), writeCounter) ||
+		!lsdj_vio_write_byte(wvio, DIFF_FORMAT_VERSION, writeCounter) ||
+		!write_uint64(wvio, lsdj_song_hash(from), writeCounter) ||
+		!write_uint64(wvio, lsdj_song_hash(to), writeCounter) ||
+		!write_uint16(wvio, runCount, writeCounter))
+	{
+		return LSDJ_WRITE_FAILED;
+	}
+
+	for (offset = 0; find_run(from->bytes, to->bytes, &offset, &length); offset += length)
+	{
+		if (!write_uint16(wvio, offset, writeCounter) ||
+			!write_uint16(wvio, length, writeCounter) ||
+			!lsdj_vio_write(wvio, to->bytes + offset, length, writeCounter))
+		{
+			return LSDJ_WRITE_FAILED;
+		}
+	}
+
+	return LSDJ_SUCCESS;
+}
+
+lsdj_error_t lsdj_song_patch(const lsdj_song_t* base, lsdj_vio_t* rvio, size_t* readCounter, lsdj_song_t* out)
+{
+	uint8_t magic[sizeof(MAGIC)];
+	uint8_t version = 0;
+	uint64_t fromHash = 0;
+	uint64_t toHash = 0;
+	size_t runCount = 0;
+
+	if (!lsdj_vio_read(rvio, magic, sizeof(magic), readCounter) ||
+		!lsdj_vio_read_byte(rvio, &version, readCounter) ||
+		!read_uint64(rvio, &fromHash, readCounter) ||
+		!read_uint64(rvio, &toHash, readCounter) ||
+		!read_uint16(rvio, &runCount, readCounter))
+	{
+		return LSDJ_READ_FAILED;
+	}
+
+	if (memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version != DIFF_FORMAT_VERSION)
+		return LSDJ_PATCH_INVALID;
+
+	if (lsdj_song_hash(base) != fromHash)
+		return LSDJ_PATCH_BASE_MISMATCH;
+
+	// Patch into a copy, so a truncated or corrupt diff never leaves out half-patched
+	lsdj_song_t song;
+	memcpy(song.bytes, base->bytes, LSDJ_SONG_BYTE_COUNT);
+
+	for (size_t i = 0; i < runCount; i++)
+	{
+		size_t offset = 0;
+		size_t length = 0;
+		if (!read_uint16(rvio, &offset, readCounter) || !read_uint16(rvio, &length, readCounter))
+			return LSDJ_READ_FAILED;
+
+		if (offset + length > LSDJ_SONG_BYTE_COUNT)
+			return LSDJ_PATCH_INVALID;
+
+		if (!lsdj_vio_read(rvio, song.bytes + offset, length, readCounter))
+			return LSDJ_READ_FAILED;
+	}
+
+	if (lsdj_song_hash(&song) != toHash)
+		return LSDJ_PATCH_INVALID;
+
+	memcpy(out->bytes, song.bytes, LSDJ_SONG_BYTE_COUNT);
+
+	return LSDJ_SUCCESS;
+}
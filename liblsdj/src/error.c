@@ -51,6 +51,10 @@ const char* lsdj_error_get_description(lsdj_error_t error)
         case LSDJ_DECOMPRESSION_INCORRECT_SIZE: return "the size of a song is not 0x8000 bytes after decompression";
         case LSDJ_SRAM_INITIALIZATION_CHECK_FAILED: return "the SRAM initialization bytes aren't set to 'jk'";
         case LSDJ_FILE_OPEN_FAILED: return "couldn't open a file";
+        case LSDJ_PATCH_INVALID: return "the song diff is invalid or corrupt";
+        case LSDJ_PATCH_BASE_MISMATCH: return "the song diff was made against a different song";
+        case LSDJ_PACK_INVALID: return "the pack is invalid or corrupt";
+        case LSDJ_ARCHIVE_INVALID: return "the archived song is invalid or corrupt";
         default: return NULL;
     }
 }
@@ -0,0 +1,370 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include "events.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "chain.h"
+#include "hash.h"
+#include "phrase.h"
+
+//! The amount of chain slots in a song (0x00 through 0x7F)
+#define CHAIN_SLOT_COUNT (0x80)
+
+//! The amount of song rows
+#define ROW_COUNT (256)
+
+typedef struct
+{
+	//! The events of this channel, in playback order
+	lsdj_event_t* events;
+
+	//! The number of events in use
+	size_t count;
+
+	//! The number of events allocated
+	size_t capacity;
+
+	//! The number of steps played before the channel loops or stops
+	uint32_t stepCount;
+
+	//! How the channel ends
+	lsdj_events_end_t end;
+} channel_events_t;
+
+struct lsdj_song_events_t
+{
+	//! The events of every channel
+	channel_events_t channels[LSDJ_CHANNEL_COUNT];
+
+	//! Whether the hashes below describe the current events
+	bool flattened;
+
+	//! The hashes of the song sections the events were flattened from
+	uint64_t rowsHash;
+	uint64_t chainsHash;
+	uint64_t phrasesHash;
+
+	//! The format version of the song the events were flattened from (it changes how commands are stored)
+	uint8_t formatVersion;
+
+	//! The allocator used to create this stream
+	const lsdj_allocator_t* allocator;
+};
+
+
+// --- Cursors --- //
+
+static uint8_t get_row_chain(const lsdj_song_t* song, unsigned int row, lsdj_channel_t channel)
+{
+	if (row >= ROW_COUNT)
+		return LSDJ_SONG_NO_CHAIN;
+
+	const uint8_t chain = lsdj_row_get_chain(song, (uint8_t)row, channel);
+	return chain < CHAIN_SLOT_COUNT ? chain : LSDJ_SONG_NO_CHAIN;
+}
+
+//! Find the first step that plays from a position onwards, and move the cursor there
+static lsdj_cursor_move_t seek(const lsdj_song_t* song, lsdj_song_cursor_t* cursor, unsigned int row, unsigned int chainStep, uint8_t phraseStep)
+{
+	lsdj_cursor_move_t move = LSDJ_CURSOR_NEXT;
+
+	while (true)
+	{
+		const uint8_t chain = get_row_chain(song, row, cursor->channel);
+		if (chain == LSDJ_SONG_NO_CHAIN)
+		{
+			// Running into a second empty row means nothing in the block plays
+			if (move == LSDJ_CURSOR_LOOPED)
+				return LSDJ_CURSOR_STOPPED;
+
+			move = LSDJ_CURSOR_LOOPED;
+			row = cursor->loopRow;
+			chainStep = 0;
+			continue;
+		}
+
+		// Chains end at their first empty step
+		if (chainStep < LSDJ_CHAIN_LENGTH)
+		{
+			const uint8_t phrase = lsdj_chain_get_phrase(song, chain, (uint8_t)chainStep);
+			if (phrase != LSDJ_CHAIN_NO_PHRASE)
+			{
+				cursor->row = (uint8_t)row;
+				cursor->chain = chain;
+				cursor->chainStep = (uint8_t)chainStep;
+				cursor->phrase = phrase;
+				cursor->phraseStep = phraseStep;
+				cursor->transposition = lsdj_chain_get_transposition(song, chain, (uint8_t)chainStep);
+				return move;
+			}
+		}
+
+		row++;
+		chainStep = 0;
+	}
+}
+
+bool lsdj_song_cursor_start(const lsdj_song_t* song, lsdj_channel_t channel, uint8_t row, lsdj_song_cursor_t* cursor)
+{
+	memset(cursor, 0, sizeof(lsdj_song_cursor_t));
+	cursor->channel = channel;
+
+	if (get_row_chain(song, row, channel) == LSDJ_SONG_NO_CHAIN)
+		return false;
+
+	// Find the top of the block of rows we're starting in
+	unsigned int loopRow = row;
+	while (loopRow > 0 && get_row_chain(song, loopRow - 1, channel) != LSDJ_SONG_NO_CHAIN)
+		loopRow--;
+	cursor->loopRow = (uint8_t)loopRow;
+
+	return seek(song, cursor, row, 0, 0) != LSDJ_CURSOR_STOPPED;
+}
+
+lsdj_cursor_move_t lsdj_song_cursor_advance(const lsdj_song_t* song, lsdj_song_cursor_t* cursor)
+{
+	lsdj_cursor_move_t move;
+
+	if (lsdj_phrase_get_command(song, cursor->phrase, cursor->phraseStep) == LSDJ_COMMAND_H)
+	{
+		const uint8_t value = lsdj_phrase_get_command_value(song, cursor->phrase, cursor->phraseStep);
+		if (value == 0xFF)
+			return LSDJ_CURSOR_STOPPED;
+
+		move = seek(song, cursor, cursor->row, cursor->chainStep + 1u, value & 0x0F);
+	}
+	else if (cursor->phraseStep + 1 < LSDJ_PHRASE_LENGTH)
+	{
+		cursor->phraseStep++;
+		move = LSDJ_CURSOR_NEXT;
+	} else {
+		move = seek(song, cursor, cursor->row, cursor->chainStep + 1u, 0);
+	}
+
+	if (move != LSDJ_CURSOR_STOPPED)
+		cursor->step++;
+
+	return move;
+}
+
+
+// --- Event streams --- //
+
+static bool is_event(const lsdj_event_t* event)
+{
+	return event->note != LSDJ_PHRASE_NO_NOTE ||
+		   event->instrument != LSDJ_PHRASE_NO_INSTRUMENT ||
+		   event->command != LSDJ_COMMAND_NONE;
+}
+
+static void read_event(const lsdj_song_t* song, const lsdj_song_cursor_t* cursor, lsdj_event_t* event)
+{
+	event->step = cursor->step;
+	event->row = cursor->row;
+	event->chain = cursor->chain;
+	event->phrase = cursor->phrase;
+	event->phraseStep = cursor->phraseStep;
+
+	event->note = lsdj_phrase_get_note(song, cursor->phrase, cursor->phraseStep);
+	if (event->note != LSDJ_PHRASE_NO_NOTE)
+		event->note = (uint8_t)(event->note + cursor->transposition);
+
+	event->instrument = lsdj_phrase_get_instrument(song, cursor->phrase, cursor->phraseStep);
+	event->command = (uint8_t)lsdj_phrase_get_command(song, cursor->phrase, cursor->phraseStep);
+	event->value = lsdj_phrase_get_command_value(song, cursor->phrase, cursor->phraseStep);
+}
+
+//! Walk through a channel once, writing its events (if events isn't NULL)
+/*! @return The number of events in the channel */
+static size_t walk_channel(const lsdj_song_t* song, lsdj_channel_t channel, lsdj_event_t* events, channel_events_t* result)
+{
+	result->stepCount = 0;
+	result->end = LSDJ_EVENTS_END_STOP;
+
+	lsdj_song_cursor_t cursor;
+	if (!lsdj_song_cursor_start(song, channel, 0, &cursor))
+		return 0;
+
+	size_t count = 0;
+	while (true)
+	{
+		lsdj_event_t event;
+		read_event(song, &cursor, &event);
+		if (is_event(&event))
+		{
+			if (events)
+				events[count] = event;
+			count++;
+		}
+
+		switch (lsdj_song_cursor_advance(song, &cursor))
+		{
+			case LSDJ_CURSOR_NEXT:
+				break;
+			case LSDJ_CURSOR_LOOPED:
+				result->stepCount = cursor.step;
+				result->end = LSDJ_EVENTS_END_LOOP;
+				return count;
+			case LSDJ_CURSOR_STOPPED:
+				result->stepCount = cursor.step + 1;
+				result->end = LSDJ_EVENTS_END_STOP;
+				return count;
+		}
+	}
+}
+
+static void clear_channels(lsdj_song_events_t* events)
+{
+	for (size_t channel = 0; channel < LSDJ_CHANNEL_COUNT; channel++)
+	{
+		events->channels[channel].count = 0;
+		events->channels[channel].stepCount = 0;
+		events->channels[channel].end = LSDJ_EVENTS_END_STOP;
+	}
+}
+
+static lsdj_error_t flatten(lsdj_song_events_t* events, const lsdj_song_t* song)
+{
+	for (size_t i = 0; i < LSDJ_CHANNEL_COUNT; i++)
+	{
+		channel_events_t* channel = &events->channels[i];
+
+		// Count the events first, so we only need to allocate once
+		const size_t count = walk_channel(song, (lsdj_channel_t)i, NULL, channel);
+		if (count > channel->capacity)
+		{
+			lsdj_deallocate_or_free(events->allocator, channel->events);
+			channel->capacity = 0;
+
+			channel->events = lsdj_allocate_or_malloc(events->allocator, count * sizeof(lsdj_event_t));
+			if (channel->events == NULL)
+				return LSDJ_ALLOCATION_FAILED;
+
+			channel->capacity = count;
+		}
+
+		channel->count = walk_channel(song, (lsdj_channel_t)i, channel->events, channel);
+		assert(channel->count == count);
+	}
+
+	return LSDJ_SUCCESS;
+}
+
+lsdj_error_t lsdj_song_events_new(lsdj_song_events_t** pevents, const lsdj_allocator_t* allocator)
+{
+	lsdj_song_events_t* events = lsdj_allocate_or_malloc(allocator, sizeof(lsdj_song_events_t));
+	if (events == NULL)
+		return LSDJ_ALLOCATION_FAILED;
+
+	memset(events, 0, sizeof(lsdj_song_events_t));
+	events->allocator = allocator;
+	clear_channels(events);
+
+	*pevents = events;
+	return LSDJ_SUCCESS;
+}
+
+void lsdj_song_events_free(lsdj_song_events_t* events)
+{
+	if (events == NULL)
+		return;
+
+	for (size_t channel = 0; channel < LSDJ_CHANNEL_COUNT; channel++)
+		lsdj_deallocate_or_free(events->allocator, events->channels[channel].events);
+
+	lsdj_deallocate_or_free(events->allocator, events);
+}
+
+lsdj_error_t lsdj_song_events_update(lsdj_song_events_t* events, const lsdj_song_t* song, bool* flattened)
+{
+	const uint64_t rowsHash = lsdj_song_hash_section(song, LSDJ_SONG_SECTION_ROWS);
+	const uint64_t chainsHash = lsdj_song_hash_section(song, LSDJ_SONG_SECTION_CHAINS);
+	const uint64_t phrasesHash = lsdj_song_hash_section(song, LSDJ_SONG_SECTION_PHRASES);
+	const uint8_t formatVersion = lsdj_song_get_format_version(song);
+
+	if (flattened)
+		*flattened = false;
+
+	if (events->flattened &&
+		events->rowsHash == rowsHash &&
+		events->chainsHash == chainsHash &&
+		events->phrasesHash == phrasesHash &&
+		events->formatVersion == formatVersion)
+	{
+		return LSDJ_SUCCESS;
+	}
+
+	const lsdj_error_t result = flatten(events, song);
+	if (result != LSDJ_SUCCESS)
+	{
+		events->flattened = false;
+		clear_channels(events);
+		return result;
+	}
+
+	events->flattened = true;
+	events->rowsHash = rowsHash;
+	events->chainsHash = chainsHash;
+	events->phrasesHash = phrasesHash;
+	events->formatVersion = formatVersion;
+
+	if (flattened)
+		*flattened = true;
+
+	return LSDJ_SUCCESS;
+}
+
+const lsdj_event_t* lsdj_song_events_get(const lsdj_song_events_t* events, lsdj_channel_t channel)
+{
+	return events->channels[channel].events;
+}
+
+size_t lsdj_song_events_get_count(const lsdj_song_events_t* events, lsdj_channel_t channel)
+{
+	return events->channels[channel].count;
+}
+
+uint32_t lsdj_song_events_get_step_count(const lsdj_song_events_t* events, lsdj_channel_t channel)
+{
+	return events->channels[channel].stepCount;
+}
+
+lsdj_events_end_t lsdj_song_events_get_end(const lsdj_song_events_t* events, lsdj_channel_t channel)
+{
+	return events->channels[channel].end;
+}
@@ -0,0 +1,185 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#include "fingerprint.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "chain.h"
+#include "channel.h"
+#include "hash.h"
+#include "phrase.h"
+
+//! The amount of rows on the song screen
+#define ROW_COUNT (256)
+
+//! Spreads the permutations of an n-gram hash apart (the 64-bit golden ratio)
+#define PERMUTATION_STEP (0x9E3779B97F4A7C15ULL)
+
+//! Follows the notes of a channel and turns them into n-grams
+typedef struct
+{
+	int8_t intervals[LSDJ_FINGERPRINT_NGRAM_LENGTH];
+	unsigned int intervalCount;
+
+	int previousPitch;
+	bool hasPreviousPitch;
+} melody_t;
+
+//! Finalizer of SplitMix64, which turns consecutive inputs into unrelated outputs
+static uint64_t mix(uint64_t value)
+{
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+	return value ^ (value >> 31);
+}
+
+static void reset_melody(melody_t* melody)
+{
+	melody->intervalCount = 0;
+	melody->hasPreviousPitch = false;
+}
+
+static void add_ngram(lsdj_fingerprint_t* fingerprint, const melody_t* melody)
+{
+	// The intervals live in a ring buffer, so unroll them oldest first
+	uint8_t ngram[LSDJ_FINGERPRINT_NGRAM_LENGTH];
+	for (unsigned int i = 0; i < LSDJ_FINGERPRINT_NGRAM_LENGTH; i++)
+		ngram[i] = (uint8_t)melody->intervals[(melody->intervalCount + i) % LSDJ_FINGERPRINT_NGRAM_LENGTH];
+
+	// One real hash per n-gram, from which every hash function is derived with a cheap mix
+	const uint64_t hash = lsdj_hash_bytes(ngram, sizeof(ngram), 0);
+	for (unsigned int i = 0; i < LSDJ_FINGERPRINT_LENGTH; i++)
+	{
+		const uint32_t permuted = (uint32_t)(mix(hash + (i + 1) * PERMUTATION_STEP) >> 32);
+		if (permuted < fingerprint->minimums[i])
+			fingerprint->minimums[i] = permuted;
+	}
+
+	fingerprint->ngramCount++;
+}
+
+static void add_note(lsdj_fingerprint_t* fingerprint, melody_t* melody, int pitch)
+{
+	if (melody->hasPreviousPitch)
+	{
+		melody->intervals[melody->intervalCount % LSDJ_FINGERPRINT_NGRAM_LENGTH] = (int8_t)(pitch - melody->previousPitch);
+		melody->intervalCount++;
+
+		if (melody->intervalCount >= LSDJ_FINGERPRINT_NGRAM_LENGTH)
+			add_ngram(fingerprint, melody);
+	}
+
+	melody->previousPitch = pitch;
+	melody->hasPreviousPitch = true;
+}
+
+void lsdj_song_fingerprint(const lsdj_song_t* song, lsdj_fingerprint_t* fingerprint)
+{
+	memset(fingerprint->minimums, 0xFF, sizeof(fingerprint->minimums));
+	fingerprint->ngramCount = 0;
+
+	// The noise channel plays noise shapes instead of pitches, so it has no melody
+	static const lsdj_channel_t CHANNELS[] = { LSDJ_CHANNEL_PULSE1, LSDJ_CHANNEL_PULSE2, LSDJ_CHANNEL_WAVE };
+
+	for (size_t c = 0; c < sizeof(CHANNELS) / sizeof(CHANNELS[0]); c++)
+	{
+		melody_t melody;
+		reset_melody(&melody);
+
+		for (size_t row = 0; row < ROW_COUNT; row++)
+		{
+			const uint8_t chain = lsdj_row_get_chain(song, (uint8_t)row, CHANNELS[c]);
+
+			// An empty row ends a part of the song, and the melody doesn't carry over into the next
+			if (chain == LSDJ_SONG_NO_CHAIN)
+			{
+				reset_melody(&melody);
+				continue;
+			}
+
+			for (uint8_t step = 0; step < LSDJ_CHAIN_LENGTH; step++)
+			{
+				const uint8_t phrase = lsdj_chain_get_phrase(song, chain, step);
+				if (phrase == LSDJ_CHAIN_NO_PHRASE)
+					continue;
+
+				const int transposition = (int8_t)lsdj_chain_get_transposition(song, chain, step);
+				for (uint8_t phraseStep = 0; phraseStep < LSDJ_PHRASE_LENGTH; phraseStep++)
+				{
+					const uint8_t note = lsdj_phrase_get_note(song, phrase, phraseStep);
+					if (note != LSDJ_PHRASE_NO_NOTE)
+						add_note(fingerprint, &melody, note + transposition);
+				}
+			}
+		}
+	}
+}
+
+double lsdj_fingerprint_similarity(const lsdj_fingerprint_t* lhs, const lsdj_fingerprint_t* rhs)
+{
+	if (lhs->ngramCount == 0 || rhs->ngramCount == 0)
+		return 0.0;
+
+	unsigned int equal = 0;
+	for (unsigned int i = 0; i < LSDJ_FINGERPRINT_LENGTH; i++)
+	{
+		if (lhs->minimums[i] == rhs->minimums[i])
+			equal++;
+	}
+
+	return (double)equal / LSDJ_FINGERPRINT_LENGTH;
+}
+
+uint64_t lsdj_fingerprint_hash_band(const lsdj_fingerprint_t* fingerprint, uint8_t band)
+{
+	assert(band < LSDJ_FINGERPRINT_BAND_COUNT);
+
+	// Hash little endian bytes, so the hash is the same on every platform
+	uint8_t bytes[LSDJ_FINGERPRINT_BAND_LENGTH * 4];
+	for (unsigned int i = 0; i < LSDJ_FINGERPRINT_BAND_LENGTH; i++)
+	{
+		const uint32_t minimum = fingerprint->minimums[band * LSDJ_FINGERPRINT_BAND_LENGTH + i];
+		bytes[i * 4 + 0] = (uint8_t)(minimum);
+		bytes[i * 4 + 1] = (uint8_t)(minimum >> 8);
+		bytes[i * 4 + 2] = (uint8_t)(minimum >> 16);
+		bytes[i * 4 + 3] = (uint8_t)(minimum >> 24);
+	}
+
+	return lsdj_hash_bytes(bytes, sizeof(bytes), band);
+}
@@ -0,0 +1,347 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include "hash.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "chain.h"
+#include "hash_state.h"
+#include "instrument.h"
+#include "phrase.h"
+#include "song_offsets.h"
+
+#define PRIME1 (0x9E3779B185EBCA87ULL)
+#define PRIME2 (0xC2B2AE3D27D4EB4FULL)
+#define PRIME3 (0x165667B19E3779F9ULL)
+#define PRIME4 (0x85EBCA77C2B2AE63ULL)
+#define PRIME5 (0x27D4EB2F165667C5ULL)
+
+//! The maximum amount of separate byte ranges a song section consists of
+#define SECTION_MAX_RANGE_COUNT (7)
+
+typedef struct
+{
+	size_t offset;
+	size_t length;
+} range_t;
+
+typedef struct
+{
+	range_t ranges[SECTION_MAX_RANGE_COUNT];
+	size_t count;
+} section_t;
+
+static const section_t SECTIONS[LSDJ_SONG_SECTION_COUNT] =
+{
+	// Phrases
+	{ {
+		{ PHRASE_NOTES_OFFSET, 0x0FF0 },
+		{ PHRASE_INSTRUMENTS_OFFSET, 0x0FF0 },
+		{ PHRASE_COMMANDS_OFFSET, 0x0FF0 },
+		{ PHRASE_COMMAND_VALUES_OFFSET, 0x0FF0 },
+		{ PHRASE_ALLOCATIONS_OFFSET, 0x20 }
+	}, 5 },
+
+	// Chains
+	{ {
+		{ CHAIN_PHRASES_OFFSET, 0x800 },
+		{ CHAIN_TRANSPOSITIONS_OFFSET, 0x800 },
+		{ CHAIN_ALLOCATIONS_OFFSET, 0x10 }
+	}, 3 },
+
+	// Rows
+	{ {
+		{ CHAIN_ASSIGNMENTS_OFFSET, 0x400 }
+	}, 1 },
+
+	// Instruments
+	{ {
+		{ INSTRUMENT_PARAMS_OFFSET, 0x400 },
+		{ INSTRUMENT_NAMES_OFFSET, 0x140 },
+		{ INSTRUMENT_ALLOCATION_TABLE_OFFSET, 0x40 }
+	}, 3 },
+
+	// Tables
+	{ {
+		{ TABLE_ENVELOPES_OFFSET, 0x200 },
+		{ TABLE_TRANSPOSITION_OFFSET, 0x200 },
+		{ TABLE_COMMAND1_OFFSET, 0x200 },
+		{ TABLE_COMMAND1_VALUE_OFFSET, 0x200 },
+		{ TABLE_COMMAND2_OFFSET, 0x200 },
+		{ TABLE_COMMAND2_VALUE_OFFSET, 0x200 },
+		{ TABLE_ALLOCATION_TABLE_OFFSET, 0x20 }
+	}, 7 },
+
+	// Waves
+	{ {
+		{ WAVES_OFFSET, 0x1000 }
+	}, 1 },
+
+	// Synths
+	{ {
+		{ SYNTH_PARAMS_OFFSET, 0x100 },
+		{ SYNTH_OVERWRITES_OFFSET, 0x2 }
+	}, 2 },
+
+	// Grooves
+	{ {
+		{ GROOVES_OFFSET, 0x200 }
+	}, 1 },
+
+	// Words
+	{ {
+		{ WORDS_OFFSET, 0x540 },
+		{ WORD_NAMES_OFFSET, 0xA8 }
+	}, 2 },
+
+	// Settings
+	{ {
+		{ WORK_HOURS_OFFSET, SYNTH_OVERWRITES_OFFSET - WORK_HOURS_OFFSET },
+		{ DRUM_MAX_OFFSET, 1 },
+		{ FORMAT_VERSION_OFFSET, 1 }
+	}, 3 }
+};
+
+
+// --- XXH64 --- //
+
+static uint64_t rotate_left(uint64_t value, unsigned int count)
+{
+	return (value << count) | (value >> (64 - count));
+}
+
+static uint64_t read64(const uint8_t* data)
+{
+	return (uint64_t)data[0] | ((uint64_t)data[1] << 8) | ((uint64_t)data[2] << 16) | ((uint64_t)data[3] << 24) |
+		   ((uint64_t)data[4] << 32) | ((uint64_t)data[5] << 40) | ((uint64_t)data[6] << 48) | ((uint64_t)data[7] << 56);
+}
+
+static uint32_t read32(const uint8_t* data)
+{
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static uint64_t round64(uint64_t accumulator, uint64_t input)
+{
+	accumulator += input * PRIME2;
+	accumulator = rotate_left(accumulator, 31);
+	return accumulator * PRIME1;
+}
+
+static uint64_t merge_round(uint64_t accumulator, uint64_t value)
+{
+	accumulator ^= round64(0, value);
+	return accumulator * PRIME1 + PRIME4;
+}
+
+//! Consume 32-byte stripes, one 8-byte word per lane
+/*! The four lanes are independent, which lets the compiler and CPU process them in parallel */
+static const uint8_t* consume_stripes(uint64_t* lanes, const uint8_t* data, const uint8_t* end)
+{
+	uint64_t v1 = lanes[0];
+	uint64_t v2 = lanes[1];
+	uint64_t v3 = lanes[2];
+	uint64_t v4 = lanes[3];
+
+	for (; data + 32 <= end; data += 32)
+	{
+		v1 = round64(v1, read64(data));
+		v2 = round64(v2, read64(data + 8));
+		v3 = round64(v3, read64(data + 16));
+		v4 = round64(v4, read64(data + 24));
+	}
+
+	lanes[0] = v1;
+	lanes[1] = v2;
+	lanes[2] = v3;
+	lanes[3] = v4;
+
+	return data;
+}
+
+void lsdj_hash_state_init(lsdj_hash_state_t* state, uint64_t seed)
+{
+	state->lanes[0] = seed + PRIME1 + PRIME2;
+	state->lanes[1] = seed + PRIME2;
+	state->lanes[2] = seed;
+	state->lanes[3] = seed - PRIME1;
+	state->totalLength = 0;
+	state->bufferSize = 0;
+	state->seed = seed;
+}
+
+void lsdj_hash_state_update(lsdj_hash_state_t* state, const uint8_t* data, size_t size)
+{
+	const uint8_t* end = data + size;
+	state->totalLength += size;
+
+	// Not enough for a full stripe yet, keep it for later
+	if (state->bufferSize + size < 32)
+	{
+		memcpy(state->buffer + state->bufferSize, data, size);
+		state->bufferSize += size;
+		return;
+	}
+
+	// Complete the stripe that was started by an earlier update
+	if (state->bufferSize > 0)
+	{
+		const size_t fill = 32 - state->bufferSize;
+		memcpy(state->buffer + state->bufferSize, data, fill);
+		consume_stripes(state->lanes, state->buffer, state->buffer + 32);
+		data += fill;
+		state->bufferSize = 0;
+	}
+
+	data = consume_stripes(state->lanes, data, end);
+
+	state->bufferSize = (size_t)(end - data);
+	memcpy(state->buffer, data, state->bufferSize);
+}
+
+uint64_t lsdj_hash_state_digest(const lsdj_hash_state_t* state)
+{
+	uint64_t hash = 0;
+	if (state->totalLength >= 32)
+	{
+		hash = rotate_left(state->lanes[0], 1) + rotate_left(state->lanes[1], 7) +
+			   rotate_left(state->lanes[2], 12) + rotate_left(state->lanes[3], 18);
+		hash = merge_round(hash, state->lanes[0]);
+		hash = merge_round(hash, state->lanes[1]);
+		hash = merge_round(hash, state->lanes[2]);
+		hash = merge_round(hash, state->lanes[3]);
+	} else {
+		hash = state->seed + PRIME5;
+	}
+
+	hash += state->totalLength;
+
+	const uint8_t* data = state->buffer;
+	const uint8_t* end = state->buffer + state->bufferSize;
+
+	for (; data + 8 <= end; data += 8)
+	{
+		hash ^= round64(0, read64(data));
+		hash = rotate_left(hash, 27) * PRIME1 + PRIME4;
+	}
+
+	if (data + 4 <= end)
+	{
+		hash ^= (uint64_t)read32(data) * PRIME1;
+		hash = rotate_left(hash, 23) * PRIME2 + PRIME3;
+		data += 4;
+	}
+
+	for (; data < end; data++)
+	{
+		hash ^= (*data) * PRIME5;
+		hash = rotate_left(hash, 11) * PRIME1;
+	}
+
+	// Avalanche
+	hash ^= hash >> 33;
+	hash *= PRIME2;
+	hash ^= hash >> 29;
+	hash *= PRIME3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+uint64_t lsdj_hash_bytes(const void* data, size_t size, uint64_t seed)
+{
+	lsdj_hash_state_t state;
+	lsdj_hash_state_init(&state, seed);
+	lsdj_hash_state_update(&state, (const uint8_t*)data, size);
+	return lsdj_hash_state_digest(&state);
+}
+
+
+// --- Songs --- //
+
+uint64_t lsdj_song_hash(const lsdj_song_t* song)
+{
+	return lsdj_hash_bytes(song->bytes, LSDJ_SONG_BYTE_COUNT, 0);
+}
+
+uint64_t lsdj_song_hash_section(const lsdj_song_t* song, lsdj_song_section_t section)
+{
+	assert(section < LSDJ_SONG_SECTION_COUNT);
+
+	lsdj_hash_state_t state;
+	lsdj_hash_state_init(&state, 0);
+
+	for (size_t i = 0; i < SECTIONS[section].count; i++)
+	{
+		const range_t* range = &SECTIONS[section].ranges[i];
+		lsdj_hash_state_update(&state, &song->bytes[range->offset], range->length);
+	}
+
+	return lsdj_hash_state_digest(&state);
+}
+
+uint64_t lsdj_phrase_hash(const lsdj_song_t* song, uint8_t phrase)
+{
+	assert(phrase < LSDJ_PHRASE_COUNT);
+	const size_t offset = (size_t)phrase * LSDJ_PHRASE_LENGTH;
+
+	lsdj_hash_state_t state;
+	lsdj_hash_state_init(&state, 0);
+	lsdj_hash_state_update(&state, &song->bytes[PHRASE_NOTES_OFFSET + offset], LSDJ_PHRASE_LENGTH);
+	lsdj_hash_state_update(&state, &song->bytes[PHRASE_INSTRUMENTS_OFFSET + offset], LSDJ_PHRASE_LENGTH);
+	lsdj_hash_state_update(&state, &song->bytes[PHRASE_COMMANDS_OFFSET + offset], LSDJ_PHRASE_LENGTH);
+	lsdj_hash_state_update(&state, &song->bytes[PHRASE_COMMAND_VALUES_OFFSET + offset], LSDJ_PHRASE_LENGTH);
+	return lsdj_hash_state_digest(&state);
+}
+
+uint64_t lsdj_chain_hash(const lsdj_song_t* song, uint8_t chain)
+{
+	const size_t offset = (size_t)chain * LSDJ_CHAIN_LENGTH;
+	assert(offset < 0x800);
+
+	lsdj_hash_state_t state;
+	lsdj_hash_state_init(&state, 0);
+	lsdj_hash_state_update(&state, &song->bytes[CHAIN_PHRASES_OFFSET + offset], LSDJ_CHAIN_LENGTH);
+	lsdj_hash_state_update(&state, &song->bytes[CHAIN_TRANSPOSITIONS_OFFSET + offset], LSDJ_CHAIN_LENGTH);
+	return lsdj_hash_state_digest(&state);
+}
+
+uint64_t lsdj_instrument_hash(const lsdj_song_t* song, uint8_t instrument)
+{
+	assert(instrument < LSDJ_INSTRUMENT_COUNT);
+	return lsdj_hash_bytes(&song->bytes[INSTRUMENT_PARAMS_OFFSET + (size_t)instrument * LSDJ_INSTRUMENT_BYTE_COUNT], LSDJ_INSTRUMENT_BYTE_COUNT, 0);
+}
@@ -0,0 +1,61 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#ifndef LSDJ_HASH_STATE_H
+#define LSDJ_HASH_STATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//! Running state of an XXH64 hash, for hashing data spread out over memory
+typedef struct
+{
+	uint64_t lanes[4];
+	uint64_t totalLength;
+	uint8_t buffer[32];
+	size_t bufferSize;
+	uint64_t seed;
+} lsdj_hash_state_t;
+
+//! Start a new hash
+void lsdj_hash_state_init(lsdj_hash_state_t* state, uint64_t seed);
+
+//! Feed more data into a running hash
+void lsdj_hash_state_update(lsdj_hash_state_t* state, const uint8_t* data, size_t size);
+
+//! Compute the hash of all data fed into the state so far
+uint64_t lsdj_hash_state_digest(const lsdj_hash_state_t* state);
+
+#endif
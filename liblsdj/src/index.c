@@ -0,0 +1,412 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include "index.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "chain.h"
+#include "instrument.h"
+#include "phrase.h"
+#include "table.h"
+
+//! The amount of bytes needed to store a set of bits
+#define BITSET_BYTE_COUNT(bits) (((bits) + 7) / 8)
+
+struct lsdj_song_index_t
+{
+	//! For every chain, for every channel, the rows it has been placed in
+	uint8_t chainRows[LSDJ_INDEX_CHAIN_SLOT_COUNT][LSDJ_CHANNEL_COUNT][BITSET_BYTE_COUNT(LSDJ_INDEX_ROW_COUNT)];
+
+	//! For every chain, the phrases it uses
+	uint8_t chainPhrases[LSDJ_INDEX_CHAIN_SLOT_COUNT][BITSET_BYTE_COUNT(LSDJ_PHRASE_COUNT)];
+
+	//! For every phrase, the chains that use it
+	uint8_t phraseChains[LSDJ_PHRASE_COUNT][BITSET_BYTE_COUNT(LSDJ_INDEX_CHAIN_SLOT_COUNT)];
+
+	//! For every phrase, the instruments it uses
+	uint8_t phraseInstruments[LSDJ_PHRASE_COUNT][BITSET_BYTE_COUNT(LSDJ_INSTRUMENT_COUNT)];
+
+	//! For every instrument, the phrases that use it
+	uint8_t instrumentPhrases[LSDJ_INSTRUMENT_COUNT][BITSET_BYTE_COUNT(LSDJ_PHRASE_COUNT)];
+
+	//! For every phrase, the tables it refers to through A-commands
+	uint8_t phraseTables[LSDJ_PHRASE_COUNT][BITSET_BYTE_COUNT(LSDJ_TABLE_COUNT)];
+
+	//! For every table, the phrases that refer to it through A-commands
+	uint8_t tablePhrases[LSDJ_TABLE_COUNT][BITSET_BYTE_COUNT(LSDJ_PHRASE_COUNT)];
+
+	//! For every table, the instruments that use it
+	uint8_t tableInstruments[LSDJ_TABLE_COUNT][BITSET_BYTE_COUNT(LSDJ_INSTRUMENT_COUNT)];
+
+	//! For every table, the tables it refers to through A-commands
+	uint8_t tableTargets[LSDJ_TABLE_COUNT][BITSET_BYTE_COUNT(LSDJ_TABLE_COUNT)];
+
+	//! For every table, the tables that refer to it through A-commands
+	uint8_t tableSources[LSDJ_TABLE_COUNT][BITSET_BYTE_COUNT(LSDJ_TABLE_COUNT)];
+
+	//! The allocator used to create this index
+	const lsdj_allocator_t* allocator;
+};
+
+
+// --- Bit sets --- //
+
+static void set_bit(uint8_t* bits, size_t index)
+{
+	bits[index / 8] |= (uint8_t)(1 << (index % 8));
+}
+
+static void clear_bit(uint8_t* bits, size_t index)
+{
+	bits[index / 8] &= (uint8_t)~(1 << (index % 8));
+}
+
+static bool any_bit(const uint8_t* bits, size_t byteCount)
+{
+	for (size_t i = 0; i < byteCount; i++)
+	{
+		if (bits[i] != 0)
+			return true;
+	}
+
+	return false;
+}
+
+//! Write the indices of all set bits to an array, in ascending order
+static size_t collect_bits(const uint8_t* bits, size_t bitCount, uint8_t* indices)
+{
+	size_t count = 0;
+	for (size_t byte = 0; byte < BITSET_BYTE_COUNT(bitCount); byte++)
+	{
+		// Skip over empty bytes quickly, most sets are sparse
+		if (bits[byte] == 0)
+			continue;
+
+		for (size_t bit = 0; bit < 8; bit++)
+		{
+			const size_t index = byte * 8 + bit;
+			if (index < bitCount && (bits[byte] & (1 << bit)))
+				indices[count++] = (uint8_t)index;
+		}
+	}
+
+	return count;
+}
+
+//! Remove all forward edges of a source, and the matching reverse edges
+static void clear_edges(uint8_t* forward, size_t targetCount, uint8_t* reverse, size_t reverseStride, size_t source)
+{
+	for (size_t byte = 0; byte < BITSET_BYTE_COUNT(targetCount); byte++)
+	{
+		if (forward[byte] == 0)
+			continue;
+
+		for (size_t bit = 0; bit < 8; bit++)
+		{
+			if (forward[byte] & (1 << bit))
+				clear_bit(reverse + (byte * 8 + bit) * reverseStride, source);
+		}
+
+		forward[byte] = 0;
+	}
+}
+
+
+// --- Indexing individual entities --- //
+
+static bool is_table_reference(lsdj_command_t command, uint8_t value)
+{
+	return command == LSDJ_COMMAND_A && value < LSDJ_TABLE_COUNT;
+}
+
+static void index_row(lsdj_song_index_t* index, const lsdj_song_t* song, uint8_t row)
+{
+	for (uint8_t channel = 0; channel < LSDJ_CHANNEL_COUNT; channel++)
+	{
+		const uint8_t chain = lsdj_row_get_chain(song, row, channel);
+		if (chain < LSDJ_INDEX_CHAIN_SLOT_COUNT)
+			set_bit(index->chainRows[chain][channel], row);
+	}
+}
+
+static void index_chain(lsdj_song_index_t* index, const lsdj_song_t* song, uint8_t chain)
+{
+	for (uint8_t step = 0; step < LSDJ_CHAIN_LENGTH; step++)
+	{
+		const uint8_t phrase = lsdj_chain_get_phrase(song, chain, step);
+		if (phrase >= LSDJ_PHRASE_COUNT)
+			continue;
+
+		set_bit(index->chainPhrases[chain], phrase);
+		set_bit(index->phraseChains[phrase], chain);
+	}
+}
+
+static void index_phrase(lsdj_song_index_t* index, const lsdj_song_t* song, uint8_t phrase)
+{
+	for (uint8_t step = 0; step < LSDJ_PHRASE_LENGTH; step++)
+	{
+		const uint8_t instrument = lsdj_phrase_get_instrument(song, phrase, step);
+		if (instrument < LSDJ_INSTRUMENT_COUNT)
+		{
+			set_bit(index->phraseInstruments[phrase], instrument);
+			set_bit(index->instrumentPhrases[instrument], phrase);
+		}
+
+		const uint8_t value = lsdj_phrase_get_command_value(song, phrase, step);
+		if (is_table_reference(lsdj_phrase_get_command(song, phrase, step), value))
+		{
+			set_bit(index->phraseTables[phrase], value);
+			set_bit(index->tablePhrases[value], phrase);
+		}
+	}
+}
+
+static void index_instrument(lsdj_song_index_t* index, const lsdj_song_t* song, uint8_t instrument)
+{
+	if (!lsdj_instrument_is_table_enabled(song, instrument))
+		return;
+
+	const uint8_t table = lsdj_instrument_get_table(song, instrument);
+	if (table < LSDJ_TABLE_COUNT)
+		set_bit(index->tableInstruments[table], instrument);
+}
+
+static void index_table_reference(lsdj_song_index_t* index, uint8_t table, lsdj_command_t command, uint8_t value)
+{
+	if (!is_table_reference(command, value))
+		return;
+
+	set_bit(index->tableTargets[table], value);
+	set_bit(index->tableSources[value], table);
+}
+
+static void index_table(lsdj_song_index_t* index, const lsdj_song_t* song, uint8_t table)
+{
+	for (uint8_t step = 0; step < LSDJ_TABLE_LENGTH; step++)
+	{
+		index_table_reference(index, table, lsdj_table_get_command1(song, table, step), lsdj_table_get_command1_value(song, table, step));
+		index_table_reference(index, table, lsdj_table_get_command2(song, table, step), lsdj_table_get_command2_value(song, table, step));
+	}
+}
+
+
+// --- Allocation --- //
+
+lsdj_error_t lsdj_song_index_new(const lsdj_song_t* song, lsdj_song_index_t** pindex, const lsdj_allocator_t* allocator)
+{
+	lsdj_song_index_t* index = lsdj_allocate_or_malloc(allocator, sizeof(lsdj_song_index_t));
+	if (index == NULL)
+		return LSDJ_ALLOCATION_FAILED;
+
+	index->allocator = allocator;
+	lsdj_song_index_rebuild(index, song);
+
+	*pindex = index;
+	return LSDJ_SUCCESS;
+}
+
+void lsdj_song_index_free(lsdj_song_index_t* index)
+{
+	if (index)
+		lsdj_deallocate_or_free(index->allocator, index);
+}
+
+void lsdj_song_index_rebuild(lsdj_song_index_t* index, const lsdj_song_t* song)
+{
+	const lsdj_allocator_t* allocator = index->allocator;
+	memset(index, 0, sizeof(lsdj_song_index_t));
+	index->allocator = allocator;
+
+	for (size_t row = 0; row < LSDJ_INDEX_ROW_COUNT; row++)
+		index_row(index, song, (uint8_t)row);
+
+	for (size_t chain = 0; chain < LSDJ_INDEX_CHAIN_SLOT_COUNT; chain++)
+		index_chain(index, song, (uint8_t)chain);
+
+	for (uint8_t phrase = 0; phrase < LSDJ_PHRASE_COUNT; phrase++)
+		index_phrase(index, song, phrase);
+
+	for (uint8_t instrument = 0; instrument < LSDJ_INSTRUMENT_COUNT; instrument++)
+		index_instrument(index, song, instrument);
+
+	for (uint8_t table = 0; table < LSDJ_TABLE_COUNT; table++)
+		index_table(index, song, table);
+}
+
+
+// --- Updating --- //
+
+void lsdj_song_index_update_row(lsdj_song_index_t* index, const lsdj_song_t* song, uint8_t row)
+{
+	// Rows don't keep forward edges (the song itself is the forward lookup),
+	// so clear this row from every chain before re-indexing
+	for (size_t chain = 0; chain < LSDJ_INDEX_CHAIN_SLOT_COUNT; chain++)
+	{
+		for (size_t channel = 0; channel < LSDJ_CHANNEL_COUNT; channel++)
+			clear_bit(index->chainRows[chain][channel], row);
+	}
+
+	index_row(index, song, row);
+}
+
+void lsdj_song_index_update_chain(lsdj_song_index_t* index, const lsdj_song_t* song, uint8_t chain)
+{
+	assert(chain < LSDJ_INDEX_CHAIN_SLOT_COUNT);
+
+	clear_edges(index->chainPhrases[chain], LSDJ_PHRASE_COUNT, index->phraseChains[0], sizeof(index->phraseChains[0]), chain);
+	index_chain(index, song, chain);
+}
+
+void lsdj_song_index_update_phrase(lsdj_song_index_t* index, const lsdj_song_t* song, uint8_t phrase)
+{
+	assert(phrase < LSDJ_PHRASE_COUNT);
+
+	clear_edges(index->phraseInstruments[phrase], LSDJ_INSTRUMENT_COUNT, index->instrumentPhrases[0], sizeof(index->instrumentPhrases[0]), phrase);
+	clear_edges(index->phraseTables[phrase], LSDJ_TABLE_COUNT, index->tablePhrases[0], sizeof(index->tablePhrases[0]), phrase);
+	index_phrase(index, song, phrase);
+}
+
+void lsdj_song_index_update_instrument(lsdj_song_index_t* index, const lsdj_song_t* song, uint8_t instrument)
+{
+	assert(instrument < LSDJ_INSTRUMENT_COUNT);
+
+	for (size_t table = 0; table < LSDJ_TABLE_COUNT; table++)
+		clear_bit(index->tableInstruments[table], instrument);
+
+	index_instrument(index, song, instrument);
+}
+
+void lsdj_song_index_update_table(lsdj_song_index_t* index, const lsdj_song_t* song, uint8_t table)
+{
+	assert(table < LSDJ_TABLE_COUNT);
+
+	clear_edges(index->tableTargets[table], LSDJ_TABLE_COUNT, index->tableSources[0], sizeof(index->tableSources[0]), table);
+	index_table(index, song, table);
+}
+
+
+// --- Chains --- //
+
+bool lsdj_song_index_is_chain_used(const lsdj_song_index_t* index, uint8_t chain)
+{
+	assert(chain < LSDJ_INDEX_CHAIN_SLOT_COUNT);
+	return any_bit(index->chainRows[chain][0], sizeof(index->chainRows[chain]));
+}
+
+size_t lsdj_song_index_get_chain_rows(const lsdj_song_index_t* index, uint8_t chain, lsdj_channel_t channel, uint8_t* rows)
+{
+	assert(chain < LSDJ_INDEX_CHAIN_SLOT_COUNT);
+	return collect_bits(index->chainRows[chain][channel], LSDJ_INDEX_ROW_COUNT, rows);
+}
+
+size_t lsdj_song_index_get_chain_phrases(const lsdj_song_index_t* index, uint8_t chain, uint8_t* phrases)
+{
+	assert(chain < LSDJ_INDEX_CHAIN_SLOT_COUNT);
+	return collect_bits(index->chainPhrases[chain], LSDJ_PHRASE_COUNT, phrases);
+}
+
+
+// --- Phrases --- //
+
+bool lsdj_song_index_is_phrase_used(const lsdj_song_index_t* index, uint8_t phrase)
+{
+	assert(phrase < LSDJ_PHRASE_COUNT);
+	return any_bit(index->phraseChains[phrase], sizeof(index->phraseChains[phrase]));
+}
+
+size_t lsdj_song_index_get_phrase_chains(const lsdj_song_index_t* index, uint8_t phrase, uint8_t* chains)
+{
+	assert(phrase < LSDJ_PHRASE_COUNT);
+	return collect_bits(index->phraseChains[phrase], LSDJ_INDEX_CHAIN_SLOT_COUNT, chains);
+}
+
+size_t lsdj_song_index_get_phrase_instruments(const lsdj_song_index_t* index, uint8_t phrase, uint8_t* instruments)
+{
+	assert(phrase < LSDJ_PHRASE_COUNT);
+	return collect_bits(index->phraseInstruments[phrase], LSDJ_INSTRUMENT_COUNT, instruments);
+}
+
+size_t lsdj_song_index_get_phrase_tables(const lsdj_song_index_t* index, uint8_t phrase, uint8_t* tables)
+{
+	assert(phrase < LSDJ_PHRASE_COUNT);
+	return collect_bits(index->phraseTables[phrase], LSDJ_TABLE_COUNT, tables);
+}
+
+
+// --- Instruments --- //
+
+bool lsdj_song_index_is_instrument_used(const lsdj_song_index_t* index, uint8_t instrument)
+{
+	assert(instrument < LSDJ_INSTRUMENT_COUNT);
+	return any_bit(index->instrumentPhrases[instrument], sizeof(index->instrumentPhrases[instrument]));
+}
+
+size_t lsdj_song_index_get_instrument_phrases(const lsdj_song_index_t* index, uint8_t instrument, uint8_t* phrases)
+{
+	assert(instrument < LSDJ_INSTRUMENT_COUNT);
+	return collect_bits(index->instrumentPhrases[instrument], LSDJ_PHRASE_COUNT, phrases);
+}
+
+
+// --- Tables --- //
+
+bool lsdj_song_index_is_table_used(const lsdj_song_index_t* index, uint8_t table)
+{
+	assert(table < LSDJ_TABLE_COUNT);
+	return any_bit(index->tableInstruments[table], sizeof(index->tableInstruments[table])) ||
+		   any_bit(index->tablePhrases[table], sizeof(index->tablePhrases[table])) ||
+		   any_bit(index->tableSources[table], sizeof(index->tableSources[table]));
+}
+
+size_t lsdj_song_index_get_table_instruments(const lsdj_song_index_t* index, uint8_t table, uint8_t* instruments)
+{
+	assert(table < LSDJ_TABLE_COUNT);
+	return collect_bits(index->tableInstruments[table], LSDJ_INSTRUMENT_COUNT, instruments);
+}
+
+size_t lsdj_song_index_get_table_phrases(const lsdj_song_index_t* index, uint8_t table, uint8_t* phrases)
+{
+	assert(table < LSDJ_TABLE_COUNT);
+	return collect_bits(index->tablePhrases[table], LSDJ_PHRASE_COUNT, phrases);
+}
+
+size_t lsdj_song_index_get_table_tables(const lsdj_song_index_t* index, uint8_t table, uint8_t* tables)
+{
+	assert(table < LSDJ_TABLE_COUNT);
+	return collect_bits(index->tableSources[table], LSDJ_TABLE_COUNT, tables);
+}
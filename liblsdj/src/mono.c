@@ -0,0 +1,124 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include "mono.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LSDJ_MONO_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "command.h"
+#include "instrument.h"
+#include "panning.h"
+#include "phrase.h"
+#include "song_offsets.h"
+#include "table.h"
+
+#define PHRASE_COMMAND_COUNT (LSDJ_PHRASE_COUNT * LSDJ_PHRASE_LENGTH)
+#define TABLE_COMMAND_COUNT (LSDJ_TABLE_COUNT * LSDJ_TABLE_LENGTH)
+
+//! The byte LSDJ stores an O-command as, which moved up one when B was added in format 8
+static uint8_t get_o_command_byte(const lsdj_song_t* song)
+{
+	return (uint8_t)(lsdj_song_get_format_version(song) >= 8 ? LSDJ_COMMAND_O + 1 : LSDJ_COMMAND_O);
+}
+
+//! Set the value of every O-command in a bank that pans somewhere to LR
+/*! Branchless, so the compare-and-blend runs 16 steps at a time where SSE2 is available */
+static void make_commands_mono(const uint8_t* commands, uint8_t* values, size_t count, uint8_t command)
+{
+	size_t i = 0;
+
+#ifdef LSDJ_MONO_SSE2
+	const __m128i o = _mm_set1_epi8((char)command);
+	const __m128i none = _mm_setzero_si128();
+	const __m128i leftRight = _mm_set1_epi8((char)LSDJ_PAN_LEFT_RIGHT);
+
+	for (; i + 16 <= count; i += 16)
+	{
+		const __m128i c = _mm_loadu_si128((const __m128i*)(commands + i));
+		const __m128i v = _mm_loadu_si128((const __m128i*)(values + i));
+
+		// Only O-commands whose value isn't O__
+		const __m128i mask = _mm_andnot_si128(_mm_cmpeq_epi8(v, none), _mm_cmpeq_epi8(c, o));
+
+		const __m128i result = _mm_or_si128(_mm_andnot_si128(mask, v), _mm_and_si128(mask, leftRight));
+		_mm_storeu_si128((__m128i*)(values + i), result);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		const uint8_t mask = (uint8_t)-(commands[i] == command && values[i] != LSDJ_PAN_NONE);
+		values[i] = (uint8_t)((values[i] & ~mask) | (LSDJ_PAN_LEFT_RIGHT & mask));
+	}
+}
+
+//! Set the panning of every instrument that pans somewhere to LR
+static void make_instruments_mono(lsdj_song_t* song)
+{
+	// The panning lives in the lowest two bits of the eighth byte of every instrument
+	uint8_t* panning = &song->bytes[INSTRUMENT_PARAMS_OFFSET + 7];
+
+	for (size_t i = 0; i < LSDJ_INSTRUMENT_COUNT; ++i)
+	{
+		uint8_t* byte = panning + i * LSDJ_INSTRUMENT_BYTE_COUNT;
+		const uint8_t pans = (uint8_t)((*byte | (*byte >> 1)) & 1);
+		*byte = (uint8_t)(*byte | (pans * LSDJ_PAN_LEFT_RIGHT));
+	}
+}
+
+void lsdj_song_make_mono(lsdj_song_t* song, unsigned int flags)
+{
+	assert(song != NULL);
+
+	const uint8_t command = get_o_command_byte(song);
+
+	if (flags & LSDJ_MONO_INSTRUMENTS)
+		make_instruments_mono(song);
+
+	if (flags & LSDJ_MONO_TABLES)
+	{
+		make_commands_mono(&song->bytes[TABLE_COMMAND1_OFFSET], &song->bytes[TABLE_COMMAND1_VALUE_OFFSET], TABLE_COMMAND_COUNT, command);
+		make_commands_mono(&song->bytes[TABLE_COMMAND2_OFFSET], &song->bytes[TABLE_COMMAND2_VALUE_OFFSET], TABLE_COMMAND_COUNT, command);
+	}
+
+	if (flags & LSDJ_MONO_PHRASES)
+		make_commands_mono(&song->bytes[PHRASE_COMMANDS_OFFSET], &song->bytes[PHRASE_COMMAND_VALUES_OFFSET], PHRASE_COMMAND_COUNT, command);
+}
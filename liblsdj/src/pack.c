@@ -0,0 +1,723 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#include "pack.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash.h"
+#include "song_offsets.h"
+
+//! The bytes each pack starts with
+static const uint8_t MAGIC[7] = { 'L', 'S', 'D', 'J', 'P', 'A', 'K' };
+
+//! The version of the pack format
+#define PACK_FORMAT_VERSION (1)
+
+//! The size of the magic and format version
+#define PACK_HEADER_SIZE (8)
+
+//! The record type, kind and hash before the contents of a chunk
+#define CHUNK_RECORD_HEADER_SIZE (10)
+
+//! The record type, manifest size and checksum at the start of a song record
+#define SONG_RECORD_HEADER_SIZE (7)
+
+//! The name and version that precede a song's manifest
+#define SONG_RECORD_INFO_SIZE (LSDJ_PROJECT_NAME_LENGTH + 1)
+
+//! A manifest holds a variable length integer of at most 5 bytes per chunk
+#define MAX_MANIFEST_SIZE (LSDJ_PACK_SONG_CHUNK_COUNT * 5)
+
+//! The largest amount of separate byte ranges a chunk is gathered from
+#define MAX_FIELD_COUNT (7)
+
+//! The size of the largest kind of chunk (the rows)
+#define MAX_CHUNK_SIZE (0x400)
+
+typedef enum
+{
+	CHUNK_PHRASE,
+	CHUNK_CHAIN,
+	CHUNK_INSTRUMENT,
+	CHUNK_TABLE,
+	CHUNK_SYNTH,
+	CHUNK_GROOVE,
+	CHUNK_WORD,
+	CHUNK_ROWS,
+	CHUNK_SETTINGS,
+	CHUNK_KIND_COUNT
+} chunk_kind_t;
+
+//! A range of bytes in song memory, repeated every stride bytes for consecutive chunks of a kind
+typedef struct
+{
+	size_t offset;
+	size_t stride;
+	size_t length;
+} field_t;
+
+typedef struct
+{
+	//! The amount of chunks of this kind in a song
+	size_t count;
+
+	//! The size of a chunk of this kind, the sum of the lengths of its fields
+	size_t size;
+
+	field_t fields[MAX_FIELD_COUNT];
+	size_t fieldCount;
+} chunk_layout_t;
+
+//! How songs are cut into chunks, which together cover every byte of song memory, see song_offsets.h
+/*! The counts are the amount of slots in memory, which is sometimes one more than LSDJ lets you use */
+static const chunk_layout_t LAYOUTS[CHUNK_KIND_COUNT] =
+{
+	// Phrases
+	{ 255, 64, {
+		{ PHRASE_NOTES_OFFSET, 16, 16 },
+		{ PHRASE_INSTRUMENTS_OFFSET, 16, 16 },
+		{ PHRASE_COMMANDS_OFFSET, 16, 16 },
+		{ PHRASE_COMMAND_VALUES_OFFSET, 16, 16 }
+	}, 4 },
+
+	// Chains
+	{ 128, 32, {
+		{ CHAIN_PHRASES_OFFSET, 16, 16 },
+		{ CHAIN_TRANSPOSITIONS_OFFSET, 16, 16 }
+	}, 2 },
+
+	// Instruments
+	{ 64, 21, {
+		{ INSTRUMENT_PARAMS_OFFSET, 16, 16 },
+		{ INSTRUMENT_NAMES_OFFSET, 5, 5 }
+	}, 2 },
+
+	// Tables
+	{ 32, 96, {
+		{ TABLE_ENVELOPES_OFFSET, 16, 16 },
+		{ TABLE_TRANSPOSITION_OFFSET, 16, 16 },
+		{ TABLE_COMMAND1_OFFSET, 16, 16 },
+		{ TABLE_COMMAND1_VALUE_OFFSET, 16, 16 },
+		{ TABLE_COMMAND2_OFFSET, 16, 16 },
+		{ TABLE_COMMAND2_VALUE_OFFSET, 16, 16 }
+	}, 6 },
+
+	// Synths, with the 16 waves each of them owns
+	{ 16, 272, {
+		{ SYNTH_PARAMS_OFFSET, 16, 16 },
+		{ WAVES_OFFSET, 256, 256 }
+	}, 2 },
+
+	// Grooves
+	{ 32, 16, {
+		{ GROOVES_OFFSET, 16, 16 }
+	}, 1 },
+
+	// Speech words and their names
+	{ 42, 36, {
+		{ WORDS_OFFSET, 32, 32 },
+		{ WORD_NAMES_OFFSET, 4, 4 }
+	}, 2 },
+
+	// Rows
+	{ 1, 0x400, {
+		{ CHAIN_ASSIGNMENTS_OFFSET, 0, 0x400 }
+	}, 1 },
+
+	// Settings, allocation tables, bookmarks, memory check bytes and empty space
+	{ 1, 536, {
+		{ BOOKMARKS_OFFSET, 0, GROOVES_OFFSET - BOOKMARKS_OFFSET },
+		{ RB1_OFFSET, 0, 2 },
+		{ EMPTY2_OFFSET, 0, CHAIN_PHRASES_OFFSET - EMPTY2_OFFSET },
+		{ RB2_OFFSET, 0, SYNTH_PARAMS_OFFSET - RB2_OFFSET },
+		{ WORK_HOURS_OFFSET, 0, PHRASE_COMMANDS_OFFSET - WORK_HOURS_OFFSET },
+		{ EMPTY7_OFFSET, 0, WAVES_OFFSET - EMPTY7_OFFSET },
+		{ RB3_OFFSET, 0, LSDJ_SONG_BYTE_COUNT - RB3_OFFSET }
+	}, 7 }
+};
+
+struct lsdj_pack_t
+{
+	//! The virtual I/O the pack lives in
+	lsdj_vio_t* vio;
+
+	//! The allocator used to create this pack
+	const lsdj_allocator_t* allocator;
+
+	//! The position right after the last valid record, where new records are appended
+	long end;
+
+	//! Where the contents of every chunk start
+	long* chunkOffsets;
+	uint64_t* chunkHashes;
+	uint8_t* chunkKinds;
+	size_t chunkCount;
+	size_t chunkCapacity;
+
+	//! Hash table from chunk hashes to chunks (plus one, zero is an empty bucket), for finding duplicates
+	uint32_t* buckets;
+	size_t bucketCount;
+
+	//! Where the manifest of every song starts, and how large it is
+	long* songOffsets;
+	uint16_t* manifestSizes;
+	char* names;
+	uint8_t* versions;
+	size_t songCount;
+	size_t songCapacity;
+};
+
+
+// --- Helpers --- //
+
+static void write_le(uint8_t* data, uint64_t value, size_t byteCount)
+{
+	for (size_t i = 0; i < byteCount; i++)
+		data[i] = (uint8_t)(value >> (i * 8));
+}
+
+static uint64_t read_le(const uint8_t* data, size_t byteCount)
+{
+	uint64_t value = 0;
+	for (size_t i = 0; i < byteCount; i++)
+		value |= (uint64_t)data[i] << (i * 8);
+	return value;
+}
+
+static void gather(const lsdj_song_t* song, const chunk_layout_t* layout, size_t index, uint8_t* chunk)
+{
+	assert(layout->size <= MAX_CHUNK_SIZE);
+
+	for (size_t i = 0; i < layout->fieldCount; i++)
+	{
+		const field_t* field = &layout->fields[i];
+		memcpy(chunk, &song->bytes[field->offset + index * field->stride], field->length);
+		chunk += field->length;
+	}
+}
+
+static void scatter(lsdj_song_t* song, const chunk_layout_t* layout, size_t index, const uint8_t* chunk)
+{
+	assert(layout->size <= MAX_CHUNK_SIZE);
+
+	for (size_t i = 0; i < layout->fieldCount; i++)
+	{
+		const field_t* field = &layout->fields[i];
+		memcpy(&song->bytes[field->offset + index * field->stride], chunk, field->length);
+		chunk += field->length;
+	}
+}
+
+//! Replace an array with a larger copy of itself
+static bool grow(const lsdj_allocator_t* allocator, void** data, size_t oldSize, size_t newSize)
+{
+	void* grown = lsdj_allocate_or_malloc(allocator, newSize);
+	if (grown == NULL)
+		return false;
+
+	if (*data)
+	{
+		memcpy(grown, *data, oldSize);
+		lsdj_deallocate_or_free(allocator, *data);
+	}
+
+	*data = grown;
+	return true;
+}
+
+//! The chunk kind every position in a manifest refers to
+static chunk_kind_t manifest_kind(size_t position)
+{
+	for (int kind = 0; kind < CHUNK_KIND_COUNT; kind++)
+	{
+		if (position < LAYOUTS[kind].count)
+			return (chunk_kind_t)kind;
+		position -= LAYOUTS[kind].count;
+	}
+
+	assert(false);
+	return CHUNK_KIND_COUNT;
+}
+
+
+// --- Chunks --- //
+
+static size_t find_chunk(const lsdj_pack_t* pack, uint8_t kind, uint64_t hash)
+{
+	if (pack->bucketCount == 0)
+		return pack->chunkCount;
+
+	for (size_t bucket = hash & (pack->bucketCount - 1); pack->buckets[bucket] != 0; bucket = (bucket + 1) & (pack->bucketCount - 1))
+	{
+		const size_t chunk = pack->buckets[bucket] - 1;
+		if (pack->chunkHashes[chunk] == hash && pack->chunkKinds[chunk] == kind)
+			return chunk;
+	}
+
+	return pack->chunkCount;
+}
+
+static void insert_bucket(lsdj_pack_t* pack, size_t chunk)
+{
+	size_t bucket = pack->chunkHashes[chunk] & (pack->bucketCount - 1);
+	while (pack->buckets[bucket] != 0)
+		bucket = (bucket + 1) & (pack->bucketCount - 1);
+
+	pack->buckets[bucket] = (uint32_t)(chunk + 1);
+}
+
+//! Whether the contents of a chunk still match its hash
+static bool is_chunk_intact(const lsdj_pack_t* pack, size_t chunk, const uint8_t* contents)
+{
+	const uint8_t kind = pack->chunkKinds[chunk];
+	return lsdj_hash_bytes(contents, LAYOUTS[kind].size, (uint64_t)kind) == pack->chunkHashes[chunk];
+}
+
+//! Read the contents of a chunk back from the virtual I/O, and check them against its hash
+static bool verify_chunk(const lsdj_pack_t* pack, size_t chunk)
+{
+	uint8_t contents[MAX_CHUNK_SIZE];
+	return lsdj_vio_seek(pack->vio, pack->chunkOffsets[chunk], SEEK_SET) &&
+		   lsdj_vio_read(pack->vio, contents, LAYOUTS[pack->chunkKinds[chunk]].size, NULL) &&
+		   is_chunk_intact(pack, chunk, contents);
+}
+
+static lsdj_error_t add_chunk(lsdj_pack_t* pack, uint8_t kind, uint64_t hash, long offset)
+{
+	if (pack->chunkCount == pack->chunkCapacity)
+	{
+		const size_t capacity = pack->chunkCapacity == 0 ? 1024 : pack->chunkCapacity * 2;
+		if (!grow(pack->allocator, (void**)&pack->chunkOffsets, pack->chunkCount * sizeof(long), capacity * sizeof(long)) ||
+			!grow(pack->allocator, (void**)&pack->chunkHashes, pack->chunkCount * sizeof(uint64_t), capacity * sizeof(uint64_t)) ||
+			!grow(pack->allocator, (void**)&pack->chunkKinds, pack->chunkCount, capacity))
+			return LSDJ_ALLOCATION_FAILED;
+
+		pack->chunkCapacity = capacity;
+	}
+
+	// Keep the hash table at most half full, so lookups stay short
+	if ((pack->chunkCount + 1) * 2 > pack->bucketCount)
+	{
+		const size_t bucketCount = pack->bucketCount == 0 ? 2048 : pack->bucketCount * 2;
+		uint32_t* buckets = lsdj_allocate_or_malloc(pack->allocator, bucketCount * sizeof(uint32_t));
+		if (buckets == NULL)
+			return LSDJ_ALLOCATION_FAILED;
+
+		memset(buckets, 0, bucketCount * sizeof(uint32_t));
+		lsdj_deallocate_or_free(pack->allocator, pack->buckets);
+		pack->buckets = buckets;
+		pack->bucketCount = bucketCount;
+
+		for (size_t i = 0; i < pack->chunkCount; i++)
+			insert_bucket(pack, i);
+	}
+
+	pack->chunkOffsets[pack->chunkCount] = offset;
+	pack->chunkHashes[pack->chunkCount] = hash;
+	pack->chunkKinds[pack->chunkCount] = kind;
+	insert_bucket(pack, pack->chunkCount);
+	pack->chunkCount++;
+
+	return LSDJ_SUCCESS;
+}
+
+
+// --- Songs --- //
+
+static lsdj_error_t add_song(lsdj_pack_t* pack, long offset, uint16_t manifestSize, const uint8_t* info)
+{
+	if (pack->songCount == pack->songCapacity)
+	{
+		const size_t capacity = pack->songCapacity == 0 ? 64 : pack->songCapacity * 2;
+		if (!grow(pack->allocator, (void**)&pack->songOffsets, pack->songCount * sizeof(long), capacity * sizeof(long)) ||
+			!grow(pack->allocator, (void**)&pack->manifestSizes, pack->songCount * sizeof(uint16_t), capacity * sizeof(uint16_t)) ||
+			!grow(pack->allocator, (void**)&pack->names, pack->songCount * LSDJ_PROJECT_NAME_LENGTH, capacity * LSDJ_PROJECT_NAME_LENGTH) ||
+			!grow(pack->allocator, (void**)&pack->versions, pack->songCount, capacity))
+			return LSDJ_ALLOCATION_FAILED;
+
+		pack->songCapacity = capacity;
+	}
+
+	pack->songOffsets[pack->songCount] = offset;
+	pack->manifestSizes[pack->songCount] = manifestSize;
+	memcpy(&pack->names[pack->songCount * LSDJ_PROJECT_NAME_LENGTH], info, LSDJ_PROJECT_NAME_LENGTH);
+	pack->versions[pack->songCount] = info[LSDJ_PROJECT_NAME_LENGTH];
+	pack->songCount++;
+
+	return LSDJ_SUCCESS;
+}
+
+//! Decode a manifest into chunk numbers
+/*! @return False if the manifest is malformed or refers to chunks that don't exist (yet) */
+static bool decode_manifest(const lsdj_pack_t* pack, const uint8_t* manifest, size_t size, uint32_t* chunks)
+{
+	const uint8_t* end = manifest + size;
+	for (size_t i = 0; i < LSDJ_PACK_SONG_CHUNK_COUNT; i++)
+	{
+		uint32_t chunk = 0;
+		for (unsigned int shift = 0; ; shift += 7)
+		{
+			if (manifest == end || shift > 28)
+				return false;
+
+			const uint8_t byte = *manifest++;
+			chunk |= (uint32_t)(byte & 0x7F) << shift;
+			if (!(byte & 0x80))
+				break;
+		}
+
+		if (chunk >= pack->chunkCount || pack->chunkKinds[chunk] != manifest_kind(i))
+			return false;
+
+		chunks[i] = chunk;
+	}
+
+	return manifest == end;
+}
+
+//! Read the record at the current position of the virtual I/O, and add it to the index
+/*! @return False if there is no valid record here, which ends the pack */
+static bool index_record(lsdj_pack_t* pack, long position, long size, long* next)
+{
+	uint8_t header[CHUNK_RECORD_HEADER_SIZE > SONG_RECORD_HEADER_SIZE ? CHUNK_RECORD_HEADER_SIZE : SONG_RECORD_HEADER_SIZE];
+	if (!lsdj_vio_read_byte(pack->vio, &header[0], NULL))
+		return false;
+
+	if (header[0] == 'C')
+	{
+		if (!lsdj_vio_read(pack->vio, &header[1], CHUNK_RECORD_HEADER_SIZE - 1, NULL) || header[1] >= CHUNK_KIND_COUNT)
+			return false;
+
+		// Skip the contents, only to check that they're all there
+		*next = position + CHUNK_RECORD_HEADER_SIZE + (long)LAYOUTS[header[1]].size;
+		if (*next > size || !lsdj_vio_seek(pack->vio, *next, SEEK_SET))
+			return false;
+
+		return add_chunk(pack, header[1], read_le(&header[2], 8), position + CHUNK_RECORD_HEADER_SIZE) == LSDJ_SUCCESS;
+	} else if (header[0] == 'S') {
+		if (!lsdj_vio_read(pack->vio, &header[1], SONG_RECORD_HEADER_SIZE - 1, NULL))
+			return false;
+
+		const uint16_t manifestSize = (uint16_t)read_le(&header[1], 2);
+		if (manifestSize > MAX_MANIFEST_SIZE)
+			return false;
+
+		uint8_t body[SONG_RECORD_INFO_SIZE + MAX_MANIFEST_SIZE];
+		if (!lsdj_vio_read(pack->vio, body, SONG_RECORD_INFO_SIZE + manifestSize, NULL) ||
+			(uint32_t)lsdj_hash_bytes(body, SONG_RECORD_INFO_SIZE + manifestSize, 0) != (uint32_t)read_le(&header[3], 4))
+			return false;
+
+		uint32_t chunks[LSDJ_PACK_SONG_CHUNK_COUNT];
+		if (!decode_manifest(pack, &body[SONG_RECORD_INFO_SIZE], manifestSize, chunks))
+			return false;
+
+		*next = position + SONG_RECORD_HEADER_SIZE + SONG_RECORD_INFO_SIZE + manifestSize;
+		return add_song(pack, position + SONG_RECORD_HEADER_SIZE + SONG_RECORD_INFO_SIZE, manifestSize, body) == LSDJ_SUCCESS;
+	} else {
+		return false;
+	}
+}
+
+
+// --- Allocation --- //
+
+lsdj_error_t lsdj_pack_open(lsdj_vio_t* vio, lsdj_pack_t** ppack, const lsdj_allocator_t* allocator)
+{
+	if (!lsdj_vio_seek(vio, 0, SEEK_END))
+		return LSDJ_SEEK_FAILED;
+
+	const long size = lsdj_vio_tell(vio);
+	if (size < 0)
+		return LSDJ_TELL_FAILED;
+
+	if (!lsdj_vio_seek(vio, 0, SEEK_SET))
+		return LSDJ_SEEK_FAILED;
+
+	uint8_t header[PACK_HEADER_SIZE];
+	if (size == 0)
+	{
+		memcpy(header, MAGIC, sizeof(MAGIC));
+		header[7] = PACK_FORMAT_VERSION;
+		if (!lsdj_vio_write(vio, header, sizeof(header), NULL))
+			return LSDJ_WRITE_FAILED;
+	} else {
+		if (!lsdj_vio_read(vio, header, sizeof(header), NULL))
+			return LSDJ_READ_FAILED;
+
+		if (memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || header[7] != PACK_FORMAT_VERSION)
+			return LSDJ_PACK_INVALID;
+	}
+
+	lsdj_pack_t* pack = lsdj_allocate_or_malloc(allocator, sizeof(lsdj_pack_t));
+	if (pack == NULL)
+		return LSDJ_ALLOCATION_FAILED;
+
+	memset(pack, 0, sizeof(lsdj_pack_t));
+	pack->vio = vio;
+	pack->allocator = allocator;
+	pack->end = PACK_HEADER_SIZE;
+
+	// Index records until the first one that isn't whole, which is where the pack ends
+	long next = pack->end;
+	long songEnd = pack->end;
+	size_t songCount = 0;
+	while (pack->end < size && index_record(pack, pack->end, size, &next))
+	{
+		pack->end = next;
+		if (pack->songCount != songCount)
+		{
+			songCount = pack->songCount;
+			songEnd = next;
+		}
+	}
+
+	// Only the chunks of a song are appended before the song itself, so a crash can only tear (or leave
+	// zeroes in) the chunks after the last song. Those are checked, so that no append ever refers to a
+	// torn chunk. The first one that doesn't match its hash ends the pack, and is overwritten next time.
+	size_t chunk = pack->chunkCount;
+	while (chunk > 0 && pack->chunkOffsets[chunk - 1] > songEnd)
+		chunk--;
+
+	for (; chunk < pack->chunkCount; chunk++)
+	{
+		if (!verify_chunk(pack, chunk))
+		{
+			pack->end = pack->chunkOffsets[chunk] - CHUNK_RECORD_HEADER_SIZE;
+			pack->chunkCount = chunk;
+
+			memset(pack->buckets, 0, pack->bucketCount * sizeof(uint32_t));
+			for (size_t i = 0; i < pack->chunkCount; i++)
+				insert_bucket(pack, i);
+
+			break;
+		}
+	}
+
+	*ppack = pack;
+	return LSDJ_SUCCESS;
+}
+
+void lsdj_pack_free(lsdj_pack_t* pack)
+{
+	if (pack == NULL)
+		return;
+
+	lsdj_deallocate_or_free(pack->allocator, pack->chunkOffsets);
+	lsdj_deallocate_or_free(pack->allocator, pack->chunkHashes);
+	lsdj_deallocate_or_free(pack->allocator, pack->chunkKinds);
+	lsdj_deallocate_or_free(pack->allocator, pack->buckets);
+	lsdj_deallocate_or_free(pack->allocator, pack->songOffsets);
+	lsdj_deallocate_or_free(pack->allocator, pack->manifestSizes);
+	lsdj_deallocate_or_free(pack->allocator, pack->names);
+	lsdj_deallocate_or_free(pack->allocator, pack->versions);
+	lsdj_deallocate_or_free(pack->allocator, pack);
+}
+
+
+// --- Contents --- //
+
+size_t lsdj_pack_get_song_count(const lsdj_pack_t* pack)
+{
+	return pack->songCount;
+}
+
+size_t lsdj_pack_get_chunk_count(const lsdj_pack_t* pack)
+{
+	return pack->chunkCount;
+}
+
+const char* lsdj_pack_get_name(const lsdj_pack_t* pack, size_t index)
+{
+	assert(index < pack->songCount);
+	return &pack->names[index * LSDJ_PROJECT_NAME_LENGTH];
+}
+
+uint8_t lsdj_pack_get_version(const lsdj_pack_t* pack, size_t index)
+{
+	assert(index < pack->songCount);
+	return pack->versions[index];
+}
+
+lsdj_error_t lsdj_pack_append_project(lsdj_pack_t* pack, const lsdj_project_t* project, size_t* newChunkCount)
+{
+	const lsdj_song_t* song = lsdj_project_get_song_const(project);
+
+	if (!lsdj_vio_seek(pack->vio, pack->end, SEEK_SET))
+		return LSDJ_SEEK_FAILED;
+
+	uint8_t body[SONG_RECORD_INFO_SIZE + MAX_MANIFEST_SIZE];
+	size_t manifestSize = 0;
+	uint8_t* manifest = &body[SONG_RECORD_INFO_SIZE];
+
+	uint8_t record[CHUNK_RECORD_HEADER_SIZE + MAX_CHUNK_SIZE];
+	for (int kind = 0; kind < CHUNK_KIND_COUNT; kind++)
+	{
+		const chunk_layout_t* layout = &LAYOUTS[kind];
+		for (size_t i = 0; i < layout->count; i++)
+		{
+			gather(song, layout, i, &record[CHUNK_RECORD_HEADER_SIZE]);
+			const uint64_t hash = lsdj_hash_bytes(&record[CHUNK_RECORD_HEADER_SIZE], layout->size, (uint64_t)kind);
+
+			size_t chunk = find_chunk(pack, (uint8_t)kind, hash);
+			if (chunk == pack->chunkCount)
+			{
+				record[0] = 'C';
+				record[1] = (uint8_t)kind;
+				write_le(&record[2], hash, 8);
+
+				const size_t recordSize = CHUNK_RECORD_HEADER_SIZE + layout->size;
+				if (!lsdj_vio_write(pack->vio, record, recordSize, NULL))
+					return LSDJ_WRITE_FAILED;
+
+				// Only whole chunks are known to the pack, so a failed write leaves it consistent
+				const lsdj_error_t result = add_chunk(pack, (uint8_t)kind, hash, pack->end + CHUNK_RECORD_HEADER_SIZE);
+				if (result != LSDJ_SUCCESS)
+					return result;
+
+				pack->end += (long)recordSize;
+				if (newChunkCount)
+					*newChunkCount += 1;
+			}
+
+			for (; chunk >= 0x80; chunk >>= 7)
+				manifest[manifestSize++] = (uint8_t)(chunk | 0x80);
+			manifest[manifestSize++] = (uint8_t)chunk;
+		}
+	}
+
+	memset(body, 0, LSDJ_PROJECT_NAME_LENGTH);
+	const char* name = lsdj_project_get_name(project);
+	memcpy(body, name, strnlen(name, LSDJ_PROJECT_NAME_LENGTH));
+	body[LSDJ_PROJECT_NAME_LENGTH] = lsdj_project_get_version(project);
+
+	uint8_t header[SONG_RECORD_HEADER_SIZE];
+	header[0] = 'S';
+	write_le(&header[1], manifestSize, 2);
+	write_le(&header[3], (uint32_t)lsdj_hash_bytes(body, SONG_RECORD_INFO_SIZE + manifestSize, 0), 4);
+
+	if (!lsdj_vio_write(pack->vio, header, sizeof(header), NULL) ||
+		!lsdj_vio_write(pack->vio, body, SONG_RECORD_INFO_SIZE + manifestSize, NULL))
+		return LSDJ_WRITE_FAILED;
+
+	const lsdj_error_t result = add_song(pack, pack->end + SONG_RECORD_HEADER_SIZE + SONG_RECORD_INFO_SIZE, (uint16_t)manifestSize, body);
+	if (result != LSDJ_SUCCESS)
+		return result;
+
+	pack->end += (long)(SONG_RECORD_HEADER_SIZE + SONG_RECORD_INFO_SIZE + manifestSize);
+	return LSDJ_SUCCESS;
+}
+
+lsdj_error_t lsdj_pack_read_song(lsdj_pack_t* pack, size_t index, lsdj_song_t* song)
+{
+	if (index >= pack->songCount)
+		return LSDJ_NO_PROJECT_AT_INDEX;
+
+	uint8_t manifest[MAX_MANIFEST_SIZE];
+	const size_t manifestSize = pack->manifestSizes[index];
+	if (!lsdj_vio_seek(pack->vio, pack->songOffsets[index], SEEK_SET))
+		return LSDJ_SEEK_FAILED;
+	if (!lsdj_vio_read(pack->vio, manifest, manifestSize, NULL))
+		return LSDJ_READ_FAILED;
+
+	// The manifest was checked when the pack was opened, but not its contents
+	uint32_t chunks[LSDJ_PACK_SONG_CHUNK_COUNT];
+	if (!decode_manifest(pack, manifest, manifestSize, chunks))
+		return LSDJ_PACK_INVALID;
+
+	// Chunks written together sit next to each other, and reading on through their record headers saves a seek.
+	// The song is put together in a copy, so a chunk that doesn't match its hash leaves the output untouched.
+	lsdj_song_t result;
+	long position = pack->songOffsets[index] + (long)manifestSize;
+	size_t chunkIndex = 0;
+	uint8_t record[CHUNK_RECORD_HEADER_SIZE + MAX_CHUNK_SIZE];
+	for (int kind = 0; kind < CHUNK_KIND_COUNT; kind++)
+	{
+		const chunk_layout_t* layout = &LAYOUTS[kind];
+		for (size_t i = 0; i < layout->count; i++)
+		{
+			const size_t chunk = chunks[chunkIndex++];
+			const long offset = pack->chunkOffsets[chunk];
+			if (offset == position + CHUNK_RECORD_HEADER_SIZE)
+			{
+				if (!lsdj_vio_read(pack->vio, record, CHUNK_RECORD_HEADER_SIZE + layout->size, NULL))
+					return LSDJ_READ_FAILED;
+			} else {
+				if (!lsdj_vio_seek(pack->vio, offset, SEEK_SET))
+					return LSDJ_SEEK_FAILED;
+				if (!lsdj_vio_read(pack->vio, &record[CHUNK_RECORD_HEADER_SIZE], layout->size, NULL))
+					return LSDJ_READ_FAILED;
+			}
+
+			if (!is_chunk_intact(pack, chunk, &record[CHUNK_RECORD_HEADER_SIZE]))
+				return LSDJ_PACK_INVALID;
+
+			position = offset + (long)layout->size;
+			scatter(&result, layout, i, &record[CHUNK_RECORD_HEADER_SIZE]);
+		}
+	}
+
+	memcpy(song->bytes, result.bytes, LSDJ_SONG_BYTE_COUNT);
+	return LSDJ_SUCCESS;
+}
+
+lsdj_error_t lsdj_pack_read_project(lsdj_pack_t* pack, size_t index, lsdj_project_t** pproject, const lsdj_allocator_t* allocator)
+{
+	if (index >= pack->songCount)
+		return LSDJ_NO_PROJECT_AT_INDEX;
+
+	lsdj_project_t* project = NULL;
+	lsdj_error_t result = lsdj_project_new(&project, allocator);
+	if (result != LSDJ_SUCCESS)
+		return result;
+
+	result = lsdj_pack_read_song(pack, index, lsdj_project_get_song(project));
+	if (result != LSDJ_SUCCESS)
+	{
+		lsdj_project_free(project);
+		return result;
+	}
+
+	char name[LSDJ_PROJECT_NAME_LENGTH + 1] = { 0 };
+	memcpy(name, lsdj_pack_get_name(pack, index), LSDJ_PROJECT_NAME_LENGTH);
+	lsdj_project_set_name(project, name);
+	lsdj_project_set_version(project, lsdj_pack_get_version(pack, index));
+
+	*pproject = project;
+	return LSDJ_SUCCESS;
+}
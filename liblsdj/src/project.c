@@ -170,12 +170,14 @@ lsdj_error_t lsdj_project_read_lsdsng(lsdj_vio_t* rvio, lsdj_project_t** pprojec
     if (!lsdj_vio_read(rvio, project->name, LSDJ_PROJECT_NAME_LENGTH, NULL))
     {
         lsdj_project_free(project);
+        *pproject = NULL;
         return LSDJ_READ_FAILED;
     }
     
     if (!lsdj_vio_read_byte(rvio, &project->version, NULL))
     {
         lsdj_project_free(project);
+        *pproject = NULL;
         return LSDJ_READ_FAILED;
     }
 
@@ -193,6 +195,7 @@ lsdj_error_t lsdj_project_read_lsdsng(lsdj_vio_t* rvio, lsdj_project_t** pprojec
     if (result != LSDJ_SUCCESS)
     {
         lsdj_project_free(project);
+        *pproject = NULL;
         return result;
     }
     
@@ -0,0 +1,863 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include "render.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "channel.h"
+#include "command.h"
+#include "instrument.h"
+#include "phrase.h"
+#include "table.h"
+#include "tempo.h"
+#include "timing.h"
+#include "wave.h"
+
+//! The number of frames rendered per block
+#define BLOCK_FRAME_COUNT (256)
+
+//! The number of frames written to a WAV file at once
+#define WAV_CHUNK_FRAME_COUNT (1024)
+
+//! The size of a WAV header (RIFF, fmt and data chunk headers)
+#define WAV_HEADER_SIZE (44)
+
+//! The gain of a channel (which outputs -15 to 15) in the mix, so four channels never clip
+#define CHANNEL_GAIN (512)
+
+//! The number of 4-bit samples in a wave
+#define WAVE_SAMPLE_COUNT (32)
+
+//! The number of waves a synth plays through
+#define WAVES_PER_SYNTH (16)
+
+//! The format version from which instruments use ADSR instead of hardware envelopes
+#define ADSR_FORMAT_VERSION (11)
+
+//! The last format version in which noise instruments have a length
+#define NOISE_LENGTH_LAST_FORMAT_VERSION (13)
+
+//! The frequency of the lowest note (C-3 in LSDJ terms), in 16.16 fixed point Hz
+#define LOWEST_NOTE_FREQUENCY (4286473)
+
+//! The clock that divides into pulse channel frequencies (one duty cycle per 2048 - x ticks)
+#define PULSE_CLOCK (131072)
+
+//! The clock that divides into wave channel frequencies (one wave per 2048 - x ticks)
+#define WAVE_CLOCK (65536)
+
+//! The clock that divides into noise channel frequencies (before the divisor and shift)
+#define NOISE_CLOCK (1048576)
+
+//! The number of noise frequency settings notes map to (four divisors for each of the 14 shifts)
+#define NOISE_SETTING_COUNT (56)
+
+//! The multipliers of the 12 semitones in an octave, in 16.16 fixed point
+static const uint32_t SEMITONES[12] = { 65536, 69433, 73562, 77936, 82570, 87480, 92682, 98193, 104032, 110218, 116772, 123715 };
+
+//! The 8-step waveforms of the four pulse widths, one bit per step
+static const uint8_t DUTY_PATTERNS[4] = { 0x01, 0x81, 0x87, 0x7E };
+
+typedef enum
+{
+	ADSR_ATTACK,
+	ADSR_DECAY,
+	ADSR_SUSTAIN
+} adsr_stage_t;
+
+typedef struct
+{
+	//! Whether the voice is making sound
+	bool playing;
+
+	//! The instrument last used on this channel, or LSDJ_PHRASE_NO_INSTRUMENT
+	uint8_t instrument;
+
+	//! The note being played, with the chain and song transposition applied
+	uint8_t note;
+
+	//! The output panning
+	lsdj_panning_t panning;
+
+	//! The table running alongside the note
+	bool tableEnabled;
+	uint8_t table;
+	uint8_t tableStep;
+	uint8_t tableTransposition;
+
+	//! The current volume (0 - F)
+	uint8_t volume;
+
+	//! The hardware volume envelope, used before ADSR was introduced
+	bool envelopeIncreasing;
+	uint8_t envelopePeriod;
+	uint32_t envelopeCounter;
+
+	//! The ADSR stage and its tick counter
+	adsr_stage_t adsrStage;
+	uint8_t adsrCounter;
+
+	//! The frames left before the length counter silences the voice, if enabled
+	bool lengthEnabled;
+	uint32_t lengthRemaining;
+
+	//! The ticks left before a K-command kills the note, or 0
+	uint8_t killTicks;
+
+	//! The oscillator phase and its increment per frame, in 32.32 fixed point cycles (or noise clocks)
+	uint64_t phase;
+	uint64_t phaseIncrement;
+
+	//! The pulse width (an lsdj_instrument_pulse_width_t)
+	uint8_t pulseWidth;
+
+	//! The wave samples, the NR32 output level (0 = mute, 1 = 100%, 2 = 50%, 3 = 25%) and synth playback
+	uint8_t waveSamples[WAVE_SAMPLE_COUNT];
+	uint8_t waveLevel;
+	uint8_t wave;
+	uint8_t waveOffset;
+	uint8_t waveSpeed;
+	uint8_t waveTicks;
+	bool waveDescending;
+	lsdj_wave_play_mode_t wavePlayMode;
+
+	//! The noise shift register
+	uint16_t lfsr;
+} voice_t;
+
+struct lsdj_renderer_t
+{
+	//! A copy of the song being rendered
+	lsdj_song_t song;
+
+	//! The number of frames per second
+	unsigned int sampleRate;
+
+	//! The channels that end up in the mix
+	unsigned int channelMask;
+
+	//! The voice of every channel
+	voice_t voices[LSDJ_CHANNEL_COUNT];
+
+	//! The timer driving playback, and the first step it returned that hasn't been played yet
+	lsdj_song_timer_t timer;
+	lsdj_timed_step_t pendingStep;
+	bool hasPendingStep;
+	bool timerDone;
+
+	//! The tick at which the song ends (known once the timer is done)
+	uint32_t endTick;
+
+	//! The next tick to start
+	uint32_t tick;
+
+	//! The current tempo
+	unsigned short tempo;
+
+	//! The frame at which the current tick ends, in 32.32 fixed point
+	uint64_t tickEnd;
+
+	//! The number of frames rendered
+	uint64_t frame;
+
+	//! Whether the end of the song has been reached
+	bool finished;
+
+	//! The output of every channel for the block being rendered
+	int16_t buffers[LSDJ_CHANNEL_COUNT][BLOCK_FRAME_COUNT];
+
+	//! The allocator used to create this renderer
+	const lsdj_allocator_t* allocator;
+};
+
+
+// --- Timing --- //
+
+//! The length of a tick in frames, in 32.32 fixed point
+static uint64_t tick_length(unsigned int sampleRate, unsigned short tempo)
+{
+	return ((uint64_t)sampleRate * 60 << 32) / ((uint64_t)tempo * LSDJ_TICKS_PER_BEAT);
+}
+
+size_t lsdj_render_get_frame_count(const lsdj_song_t* song, unsigned int sampleRate)
+{
+	lsdj_song_timer_t timer;
+	if (!lsdj_song_timer_start(song, &timer))
+		return 0;
+
+	unsigned short tempo = lsdj_song_get_tempo(song);
+	uint64_t position = 0;
+	uint32_t tick = 0;
+
+	lsdj_timed_step_t step;
+	while (lsdj_song_timer_next(song, &timer, &step))
+	{
+		for (; tick < step.tick; tick++)
+			position += tick_length(sampleRate, tempo);
+
+		if (lsdj_phrase_get_command(song, step.phrase, step.phraseStep) == LSDJ_COMMAND_T)
+			tempo = decode_tempo(lsdj_phrase_get_command_value(song, step.phrase, step.phraseStep));
+	}
+
+	for (; tick < timer.tick; tick++)
+		position += tick_length(sampleRate, tempo);
+
+	return (size_t)(position >> 32);
+}
+
+
+// --- Pitch --- //
+
+//! Compute the frequency divider (2048 - x in hardware terms) for a note on a given clock
+static uint32_t note_divider(uint8_t note, uint32_t clock)
+{
+	const unsigned int index = note == LSDJ_PHRASE_NO_NOTE ? 0 : note - 1u;
+	const uint64_t frequency = (((uint64_t)LOWEST_NOTE_FREQUENCY * SEMITONES[index % 12]) >> 16) << (index / 12);
+
+	const uint64_t divider = (((uint64_t)clock << 16) + frequency / 2) / frequency;
+	if (divider < 1)
+		return 1;
+	else if (divider > 2048)
+		return 2048;
+	else
+		return (uint32_t)divider;
+}
+
+static void update_pitch(voice_t* voice, lsdj_channel_t channel, unsigned int sampleRate)
+{
+	const uint8_t note = (uint8_t)(voice->note + voice->tableTransposition);
+
+	switch (channel)
+	{
+		case LSDJ_CHANNEL_PULSE1:
+		case LSDJ_CHANNEL_PULSE2:
+			voice->phaseIncrement = ((uint64_t)PULSE_CLOCK << 32) / ((uint64_t)note_divider(note, PULSE_CLOCK) * sampleRate);
+			break;
+		case LSDJ_CHANNEL_WAVE:
+			voice->phaseIncrement = ((uint64_t)WAVE_CLOCK << 32) / ((uint64_t)note_divider(note, WAVE_CLOCK) * sampleRate);
+			break;
+		case LSDJ_CHANNEL_NOISE:
+		{
+			// Notes pick one of the noise clock settings, from low to high
+			unsigned int setting = (note == LSDJ_PHRASE_NO_NOTE ? 0 : note - 1u) / 2;
+			if (setting >= NOISE_SETTING_COUNT)
+				setting = NOISE_SETTING_COUNT - 1;
+
+			const unsigned int shift = 13 - setting / 4;
+			const unsigned int divisor = 14 - 2 * (setting % 4);
+			voice->phaseIncrement = ((uint64_t)NOISE_CLOCK << 32) / (((uint64_t)divisor << (shift + 1)) * sampleRate);
+			break;
+		}
+	}
+}
+
+
+// --- Voices --- //
+
+static void load_wave(voice_t* voice, const lsdj_song_t* song)
+{
+	const uint8_t* bytes = lsdj_wave_get_bytes_const(song, voice->wave);
+	for (size_t i = 0; i < LSDJ_WAVE_BYTE_COUNT; i++)
+	{
+		voice->waveSamples[i * 2] = (uint8_t)(bytes[i] >> 4);
+		voice->waveSamples[i * 2 + 1] = (uint8_t)(bytes[i] & 0x0F);
+	}
+}
+
+static void set_envelope(voice_t* voice, uint8_t envelope)
+{
+	voice->volume = (uint8_t)(envelope >> 4);
+	voice->envelopeIncreasing = (envelope & 0x08) != 0;
+	voice->envelopePeriod = envelope & 0x07;
+	voice->envelopeCounter = 0;
+	voice->adsrStage = ADSR_SUSTAIN;
+}
+
+static void set_length(voice_t* voice, uint8_t length, unsigned int sampleRate)
+{
+	// The hardware length counter runs at 256Hz, counting up to 64
+	voice->lengthEnabled = length < LSDJ_INSTRUMENT_PULSE_LENGTH_INFINITE;
+	voice->lengthRemaining = voice->lengthEnabled ? (uint32_t)(((uint64_t)(64 - length) * sampleRate) / 256) : 0;
+}
+
+static void trigger_note(lsdj_renderer_t* renderer, lsdj_channel_t channel, uint8_t note, uint8_t transposition)
+{
+	const lsdj_song_t* song = &renderer->song;
+	voice_t* voice = &renderer->voices[channel];
+
+	voice->playing = false;
+	if (voice->instrument >= LSDJ_INSTRUMENT_COUNT)
+		return;
+
+	const uint8_t instrument = voice->instrument;
+	const lsdj_instrument_type_t type = lsdj_instrument_get_type(song, instrument);
+
+	// Channels only play the instrument types their hardware supports
+	switch (channel)
+	{
+		case LSDJ_CHANNEL_PULSE1:
+		case LSDJ_CHANNEL_PULSE2:
+			if (type != LSDJ_INSTRUMENT_TYPE_PULSE)
+				return;
+			break;
+		case LSDJ_CHANNEL_WAVE:
+			// Kit samples live in the LSDJ ROM, so they can't be played
+			if (type != LSDJ_INSTRUMENT_TYPE_WAVE)
+				return;
+			break;
+		case LSDJ_CHANNEL_NOISE:
+			if (type != LSDJ_INSTRUMENT_TYPE_NOISE)
+				return;
+			break;
+	}
+
+	if (lsdj_instrument_get_transpose(song, instrument))
+	{
+		note = (uint8_t)(note + transposition);
+		if (channel != LSDJ_CHANNEL_NOISE)
+			note = (uint8_t)(note + lsdj_song_get_transposition(song));
+	}
+
+	voice->playing = true;
+	voice->note = note;
+	voice->killTicks = 0;
+	voice->panning = lsdj_instrument_get_panning(song, instrument);
+
+	voice->tableEnabled = lsdj_instrument_is_table_enabled(song, instrument);
+	voice->table = lsdj_instrument_get_table(song, instrument);
+	voice->tableStep = 0;
+	voice->tableTransposition = 0;
+
+	const uint8_t formatVersion = lsdj_song_get_format_version(song);
+
+	if (channel == LSDJ_CHANNEL_WAVE)
+	{
+		voice->waveLevel = (lsdj_instrument_wave_get_volume(song, instrument) >> 5) & 0x03;
+		voice->wavePlayMode = lsdj_instrument_wave_get_play_mode(song, instrument);
+		voice->waveSpeed = lsdj_instrument_wave_get_speed(song, instrument);
+		if (voice->waveSpeed == 0)
+			voice->waveSpeed = 1;
+
+		if (voice->wavePlayMode == LSDJ_INSTRUMENT_WAVE_PLAY_MANUAL)
+			voice->wave = lsdj_instrument_wave_get_wave(song, instrument);
+		else
+			voice->wave = (uint8_t)(lsdj_instrument_wave_get_synth(song, instrument) * WAVES_PER_SYNTH);
+
+		voice->waveOffset = 0;
+		voice->waveTicks = 0;
+		voice->waveDescending = false;
+		voice->lengthEnabled = false;
+		voice->phase = 0;
+		load_wave(voice, song);
+	} else {
+		if (formatVersion >= ADSR_FORMAT_VERSION)
+		{
+			voice->volume = lsdj_instrument_adsr_get_initial_level(song, instrument);
+			voice->envelopePeriod = 0;
+			voice->adsrStage = ADSR_ATTACK;
+			voice->adsrCounter = 0;
+		} else {
+			set_envelope(voice, lsdj_instrument_get_envelope(song, instrument));
+		}
+
+		if (channel == LSDJ_CHANNEL_NOISE)
+		{
+			if (formatVersion <= NOISE_LENGTH_LAST_FORMAT_VERSION)
+				set_length(voice, lsdj_instrument_noise_get_length(song, instrument), renderer->sampleRate);
+			else
+				voice->lengthEnabled = false;
+
+			// Stable noise restarts its shift register with every note, so every hit sounds the same
+			if (lsdj_instrument_noise_get_stability(song, instrument) == LSDJ_INSTRUMENT_NOISE_STABLE || voice->lfsr == 0)
+				voice->lfsr = 0x7FFF;
+		} else {
+			voice->pulseWidth = (uint8_t)lsdj_instrument_pulse_get_pulse_width(song, instrument);
+			set_length(voice, lsdj_instrument_pulse_get_length(song, instrument), renderer->sampleRate);
+		}
+	}
+
+	update_pitch(voice, channel, renderer->sampleRate);
+}
+
+static void apply_step(lsdj_renderer_t* renderer, const lsdj_timed_step_t* step)
+{
+	const lsdj_song_t* song = &renderer->song;
+	voice_t* voice = &renderer->voices[step->channel];
+
+	const uint8_t note = lsdj_phrase_get_note(song, step->phrase, step->phraseStep);
+	const uint8_t instrument = lsdj_phrase_get_instrument(song, step->phrase, step->phraseStep);
+	const lsdj_command_t command = lsdj_phrase_get_command(song, step->phrase, step->phraseStep);
+	const uint8_t value = lsdj_phrase_get_command_value(song, step->phrase, step->phraseStep);
+
+	if (instrument != LSDJ_PHRASE_NO_INSTRUMENT)
+		voice->instrument = instrument;
+
+	if (note != LSDJ_PHRASE_NO_NOTE)
+		trigger_note(renderer, step->channel, note, step->transposition);
+
+	switch (command)
+	{
+		case LSDJ_COMMAND_A:
+			voice->tableEnabled = value < LSDJ_TABLE_COUNT;
+			voice->table = value;
+			voice->tableStep = 0;
+			voice->tableTransposition = 0;
+			break;
+		case LSDJ_COMMAND_E:
+			if (step->channel != LSDJ_CHANNEL_WAVE)
+				set_envelope(voice, value);
+			break;
+		case LSDJ_COMMAND_K:
+			if (value == 0)
+				voice->playing = false;
+			else
+				voice->killTicks = value;
+			break;
+		case LSDJ_COMMAND_O:
+			voice->panning = (lsdj_panning_t)(value & LSDJ_PAN_LEFT_RIGHT);
+			break;
+		case LSDJ_COMMAND_T:
+			renderer->tempo = decode_tempo(value);
+			break;
+		case LSDJ_COMMAND_W:
+			if (step->channel == LSDJ_CHANNEL_PULSE1 || step->channel == LSDJ_CHANNEL_PULSE2)
+				voice->pulseWidth = value & 0x03;
+			break;
+		default:
+			break;
+	}
+}
+
+//! Move an ADSR level one step towards a target every speed ticks, returning whether the target was reached
+static bool step_adsr(voice_t* voice, uint8_t target, uint8_t speed)
+{
+	if (speed == 0)
+		voice->volume = target;
+	else if (++voice->adsrCounter >= speed)
+	{
+		voice->adsrCounter = 0;
+		if (voice->volume < target)
+			voice->volume++;
+		else if (voice->volume > target)
+			voice->volume--;
+	}
+
+	return voice->volume == target;
+}
+
+static void update_voice_tick(lsdj_renderer_t* renderer, lsdj_channel_t channel)
+{
+	const lsdj_song_t* song = &renderer->song;
+	voice_t* voice = &renderer->voices[channel];
+
+	if (!voice->playing)
+		return;
+
+	if (voice->killTicks > 0 && --voice->killTicks == 0)
+	{
+		voice->playing = false;
+		return;
+	}
+
+	if (voice->tableEnabled)
+	{
+		voice->tableTransposition = lsdj_table_get_transposition(song, voice->table, voice->tableStep);
+		voice->tableStep = (uint8_t)((voice->tableStep + 1) % LSDJ_TABLE_LENGTH);
+		update_pitch(voice, channel, renderer->sampleRate);
+	}
+
+	if (channel == LSDJ_CHANNEL_WAVE)
+	{
+		if (voice->wavePlayMode == LSDJ_INSTRUMENT_WAVE_PLAY_MANUAL || ++voice->waveTicks < voice->waveSpeed)
+			return;
+
+		voice->waveTicks = 0;
+
+		const uint8_t offset = voice->waveOffset;
+		switch (voice->wavePlayMode)
+		{
+			case LSDJ_INSTRUMENT_WAVE_PLAY_ONCE:
+				if (voice->waveOffset + 1 < WAVES_PER_SYNTH)
+					voice->waveOffset++;
+				break;
+			case LSDJ_INSTRUMENT_WAVE_PLAY_LOOP:
+				voice->waveOffset = (uint8_t)((voice->waveOffset + 1) % WAVES_PER_SYNTH);
+				break;
+			case LSDJ_INSTRUMENT_WAVE_PLAY_PING_PONG:
+				if (voice->waveDescending ? voice->waveOffset == 0 : voice->waveOffset + 1 == WAVES_PER_SYNTH)
+					voice->waveDescending = !voice->waveDescending;
+				voice->waveOffset = (uint8_t)(voice->waveDescending ? voice->waveOffset - 1 : voice->waveOffset + 1);
+				break;
+			default:
+				break;
+		}
+
+		if (voice->waveOffset != offset)
+		{
+			voice->wave = (uint8_t)((voice->wave - offset) + voice->waveOffset);
+			load_wave(voice, song);
+		}
+	}
+	else if (lsdj_song_get_format_version(song) >= ADSR_FORMAT_VERSION && voice->instrument < LSDJ_INSTRUMENT_COUNT)
+	{
+		switch (voice->adsrStage)
+		{
+			case ADSR_ATTACK:
+				if (step_adsr(voice, lsdj_instrument_adsr_get_attack_level(song, voice->instrument), lsdj_instrument_adsr_get_attack_speed(song, voice->instrument)))
+				{
+					voice->adsrStage = ADSR_DECAY;
+					voice->adsrCounter = 0;
+				}
+				break;
+			case ADSR_DECAY:
+				if (step_adsr(voice, lsdj_instrument_adsr_get_sustain_level(song, voice->instrument), lsdj_instrument_adsr_get_decay_speed(song, voice->instrument)))
+					voice->adsrStage = ADSR_SUSTAIN;
+				break;
+			case ADSR_SUSTAIN:
+				break;
+		}
+	}
+}
+
+
+// --- Rendering --- //
+
+//! Count down the length counter, returning false once it silences the voice
+static bool update_length(voice_t* voice)
+{
+	if (!voice->lengthEnabled)
+		return true;
+
+	if (voice->lengthRemaining == 0)
+	{
+		voice->playing = false;
+		return false;
+	}
+
+	voice->lengthRemaining--;
+	return true;
+}
+
+//! Run the hardware volume envelope, which steps every period/64th of a second
+static void update_envelope(voice_t* voice, unsigned int sampleRate)
+{
+	if (voice->envelopePeriod == 0)
+		return;
+
+	voice->envelopeCounter += 64;
+	if (voice->envelopeCounter < voice->envelopePeriod * sampleRate)
+		return;
+
+	voice->envelopeCounter -= voice->envelopePeriod * sampleRate;
+	if (voice->envelopeIncreasing && voice->volume < 0x0F)
+		voice->volume++;
+	else if (!voice->envelopeIncreasing && voice->volume > 0)
+		voice->volume--;
+}
+
+static void render_pulse(voice_t* voice, unsigned int sampleRate, int16_t* output, size_t frameCount)
+{
+	const uint8_t pattern = DUTY_PATTERNS[voice->pulseWidth & 0x03];
+
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		if (!voice->playing || !update_length(voice))
+		{
+			memset(output + i, 0, (frameCount - i) * sizeof(int16_t));
+			return;
+		}
+
+		update_envelope(voice, sampleRate);
+
+		voice->phase = (voice->phase + voice->phaseIncrement) & 0xFFFFFFFF;
+		const bool high = (pattern >> (voice->phase >> 29)) & 1;
+		output[i] = (int16_t)(high ? voice->volume : -voice->volume);
+	}
+}
+
+static void render_wave(voice_t* voice, int16_t* output, size_t frameCount)
+{
+	if (!voice->playing || voice->waveLevel == 0)
+	{
+		memset(output, 0, frameCount * sizeof(int16_t));
+		return;
+	}
+
+	const int divisor = 1 << (voice->waveLevel - 1);
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		voice->phase = (voice->phase + voice->phaseIncrement) & 0xFFFFFFFF;
+		const int sample = voice->waveSamples[voice->phase >> 27];
+		output[i] = (int16_t)((2 * sample - 15) / divisor);
+	}
+}
+
+static void render_noise(voice_t* voice, unsigned int sampleRate, int16_t* output, size_t frameCount)
+{
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		if (!voice->playing || !update_length(voice))
+		{
+			memset(output + i, 0, (frameCount - i) * sizeof(int16_t));
+			return;
+		}
+
+		update_envelope(voice, sampleRate);
+
+		// Clock the shift register as many times as the noise clock ticked during this frame
+		voice->phase += voice->phaseIncrement;
+		for (uint64_t clocks = voice->phase >> 32; clocks > 0; clocks--)
+		{
+			const uint16_t bit = (voice->lfsr ^ (voice->lfsr >> 1)) & 1;
+			voice->lfsr = (uint16_t)((voice->lfsr >> 1) | (bit << 14));
+		}
+		voice->phase &= 0xFFFFFFFF;
+
+		output[i] = (int16_t)((voice->lfsr & 1) ? -voice->volume : voice->volume);
+	}
+}
+
+static void render_block(lsdj_renderer_t* renderer, int16_t* frames, size_t frameCount)
+{
+	int32_t leftGains[LSDJ_CHANNEL_COUNT];
+	int32_t rightGains[LSDJ_CHANNEL_COUNT];
+
+	for (size_t channel = 0; channel < LSDJ_CHANNEL_COUNT; channel++)
+	{
+		voice_t* voice = &renderer->voices[channel];
+		int16_t* buffer = renderer->buffers[channel];
+
+		switch (channel)
+		{
+			case LSDJ_CHANNEL_PULSE1:
+			case LSDJ_CHANNEL_PULSE2:
+				render_pulse(voice, renderer->sampleRate, buffer, frameCount);
+				break;
+			case LSDJ_CHANNEL_WAVE:
+				render_wave(voice, buffer, frameCount);
+				break;
+			case LSDJ_CHANNEL_NOISE:
+				render_noise(voice, renderer->sampleRate, buffer, frameCount);
+				break;
+		}
+
+		const bool audible = (renderer->channelMask & (1u << channel)) != 0;
+		leftGains[channel] = (audible && (voice->panning & LSDJ_PAN_LEFT)) ? CHANNEL_GAIN : 0;
+		rightGains[channel] = (audible && (voice->panning & LSDJ_PAN_RIGHT)) ? CHANNEL_GAIN : 0;
+	}
+
+	// Panning only changes between ticks, so the gains are constant throughout a block
+	const int16_t* pulse1 = renderer->buffers[LSDJ_CHANNEL_PULSE1];
+	const int16_t* pulse2 = renderer->buffers[LSDJ_CHANNEL_PULSE2];
+	const int16_t* wave = renderer->buffers[LSDJ_CHANNEL_WAVE];
+	const int16_t* noise = renderer->buffers[LSDJ_CHANNEL_NOISE];
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		frames[i * 2] = (int16_t)(pulse1[i] * leftGains[0] + pulse2[i] * leftGains[1] + wave[i] * leftGains[2] + noise[i] * leftGains[3]);
+		frames[i * 2 + 1] = (int16_t)(pulse1[i] * rightGains[0] + pulse2[i] * rightGains[1] + wave[i] * rightGains[2] + noise[i] * rightGains[3]);
+	}
+}
+
+//! Make sure the first step that hasn't been played yet is known, returning false if there is none
+static bool fetch_step(lsdj_renderer_t* renderer)
+{
+	if (!renderer->hasPendingStep && !renderer->timerDone)
+	{
+		if (lsdj_song_timer_next(&renderer->song, &renderer->timer, &renderer->pendingStep))
+		{
+			renderer->hasPendingStep = true;
+		} else {
+			renderer->timerDone = true;
+			renderer->endTick = renderer->timer.tick;
+		}
+	}
+
+	return renderer->hasPendingStep;
+}
+
+static void start_tick(lsdj_renderer_t* renderer)
+{
+	if (!fetch_step(renderer) && renderer->tick >= renderer->endTick)
+	{
+		renderer->finished = true;
+		return;
+	}
+
+	while (fetch_step(renderer) && renderer->pendingStep.tick == renderer->tick)
+	{
+		apply_step(renderer, &renderer->pendingStep);
+		renderer->hasPendingStep = false;
+	}
+
+	for (size_t channel = 0; channel < LSDJ_CHANNEL_COUNT; channel++)
+		update_voice_tick(renderer, (lsdj_channel_t)channel);
+
+	renderer->tickEnd += tick_length(renderer->sampleRate, renderer->tempo);
+	renderer->tick++;
+}
+
+lsdj_error_t lsdj_renderer_new(const lsdj_song_t* song, unsigned int sampleRate, lsdj_renderer_t** prenderer, const lsdj_allocator_t* allocator)
+{
+	lsdj_renderer_t* renderer = lsdj_allocate_or_malloc(allocator, sizeof(lsdj_renderer_t));
+	if (renderer == NULL)
+		return LSDJ_ALLOCATION_FAILED;
+
+	memset(renderer, 0, sizeof(lsdj_renderer_t));
+	memcpy(&renderer->song, song, sizeof(lsdj_song_t));
+	renderer->sampleRate = sampleRate;
+	renderer->channelMask = LSDJ_RENDER_ALL_CHANNELS;
+	renderer->tempo = lsdj_song_get_tempo(song);
+	renderer->allocator = allocator;
+
+	for (size_t channel = 0; channel < LSDJ_CHANNEL_COUNT; channel++)
+	{
+		renderer->voices[channel].instrument = LSDJ_PHRASE_NO_INSTRUMENT;
+		renderer->voices[channel].panning = LSDJ_PAN_LEFT_RIGHT;
+	}
+
+	if (!lsdj_song_timer_start(&renderer->song, &renderer->timer))
+		renderer->timerDone = true;
+
+	*prenderer = renderer;
+	return LSDJ_SUCCESS;
+}
+
+void lsdj_renderer_free(lsdj_renderer_t* renderer)
+{
+	if (renderer)
+		lsdj_deallocate_or_free(renderer->allocator, renderer);
+}
+
+void lsdj_renderer_set_channel_mask(lsdj_renderer_t* renderer, unsigned int mask)
+{
+	renderer->channelMask = mask;
+}
+
+size_t lsdj_renderer_render(lsdj_renderer_t* renderer, int16_t* frames, size_t frameCount)
+{
+	size_t written = 0;
+	while (written < frameCount)
+	{
+		const uint64_t tickEndFrame = renderer->tickEnd >> 32;
+		if (renderer->frame >= tickEndFrame)
+		{
+			if (renderer->finished)
+				break;
+
+			start_tick(renderer);
+			continue;
+		}
+
+		size_t count = frameCount - written;
+		if (count > tickEndFrame - renderer->frame)
+			count = (size_t)(tickEndFrame - renderer->frame);
+		if (count > BLOCK_FRAME_COUNT)
+			count = BLOCK_FRAME_COUNT;
+
+		render_block(renderer, frames + written * LSDJ_RENDER_FRAME_SAMPLE_COUNT, count);
+		written += count;
+		renderer->frame += count;
+	}
+
+	return written;
+}
+
+
+// --- WAV --- //
+
+static void write_le(uint8_t* bytes, uint32_t value, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+		bytes[i] = (uint8_t)((value >> (i * 8)) & 0xFF);
+}
+
+lsdj_error_t lsdj_render_write_wav_header(unsigned int sampleRate, size_t frameCount, lsdj_vio_t* wvio, size_t* writeCounter)
+{
+	const uint64_t dataSize = (uint64_t)frameCount * LSDJ_RENDER_FRAME_SAMPLE_COUNT * sizeof(int16_t);
+	if (dataSize > 0xFFFFFFFF - (WAV_HEADER_SIZE - 8))
+		return LSDJ_WRITE_FAILED;
+
+	uint8_t header[WAV_HEADER_SIZE];
+	memcpy(header, "RIFF", 4);
+	write_le(header + 4, (uint32_t)(dataSize + WAV_HEADER_SIZE - 8), 4);
+	memcpy(header + 8, "WAVEfmt ", 8);
+	write_le(header + 16, 16, 4); // fmt chunk size
+	write_le(header + 20, 1, 2); // PCM
+	write_le(header + 22, LSDJ_RENDER_FRAME_SAMPLE_COUNT, 2);
+	write_le(header + 24, sampleRate, 4);
+	write_le(header + 28, sampleRate * LSDJ_RENDER_FRAME_SAMPLE_COUNT * (uint32_t)sizeof(int16_t), 4);
+	write_le(header + 32, LSDJ_RENDER_FRAME_SAMPLE_COUNT * (uint32_t)sizeof(int16_t), 2);
+	write_le(header + 34, 16, 2); // bits per sample
+	memcpy(header + 36, "data", 4);
+	write_le(header + 40, (uint32_t)dataSize, 4);
+
+	return lsdj_vio_write(wvio, header, sizeof(header), writeCounter) ? LSDJ_SUCCESS : LSDJ_WRITE_FAILED;
+}
+
+lsdj_error_t lsdj_render_wav(const lsdj_song_t* song, unsigned int sampleRate, unsigned int channelMask, lsdj_vio_t* wvio, size_t* writeCounter, const lsdj_allocator_t* allocator)
+{
+	lsdj_error_t result = lsdj_render_write_wav_header(sampleRate, lsdj_render_get_frame_count(song, sampleRate), wvio, writeCounter);
+	if (result != LSDJ_SUCCESS)
+		return result;
+
+	lsdj_renderer_t* renderer = NULL;
+	result = lsdj_renderer_new(song, sampleRate, &renderer, allocator);
+	if (result != LSDJ_SUCCESS)
+		return result;
+
+	lsdj_renderer_set_channel_mask(renderer, channelMask);
+
+	int16_t frames[WAV_CHUNK_FRAME_COUNT * LSDJ_RENDER_FRAME_SAMPLE_COUNT];
+	uint8_t bytes[sizeof(frames)];
+
+	size_t count;
+	while ((count = lsdj_renderer_render(renderer, frames, WAV_CHUNK_FRAME_COUNT)) > 0)
+	{
+		const size_t sampleCount = count * LSDJ_RENDER_FRAME_SAMPLE_COUNT;
+		for (size_t i = 0; i < sampleCount; i++)
+			write_le(bytes + i * 2, (uint16_t)frames[i], 2);
+
+		if (!lsdj_vio_write(wvio, bytes, sampleCount * sizeof(int16_t), writeCounter))
+		{
+			lsdj_renderer_free(renderer);
+			return LSDJ_WRITE_FAILED;
+		}
+	}
+
+	lsdj_renderer_free(renderer);
+	return LSDJ_SUCCESS;
+}
@@ -379,6 +379,7 @@ lsdj_error_t lsdj_sav_read(lsdj_vio_t* rvio, lsdj_sav_t** psav, const lsdj_alloc
     if (!lsdj_vio_read(rvio, sav->workingMemorysong.bytes, LSDJ_SONG_BYTE_COUNT, NULL))
     {
         lsdj_sav_free(sav);
+        *psav = NULL;
         return LSDJ_READ_FAILED;
     }
     
@@ -388,6 +389,7 @@ lsdj_error_t lsdj_sav_read(lsdj_vio_t* rvio, lsdj_sav_t** psav, const lsdj_alloc
     if (!lsdj_vio_read(rvio, &header, sizeof(header), NULL))
 	{
         lsdj_sav_free(sav);
+        *psav = NULL;
         return LSDJ_READ_FAILED;
     }
     
@@ -396,6 +398,7 @@ lsdj_error_t lsdj_sav_read(lsdj_vio_t* rvio, lsdj_sav_t** psav, const lsdj_alloc
     if (header.init[0] != 'j' || header.init[1] != 'k')
     {
         lsdj_sav_free(sav);
+        *psav = NULL;
         return LSDJ_SRAM_INITIALIZATION_CHECK_FAILED;
     }
 
@@ -411,6 +414,7 @@ lsdj_error_t lsdj_sav_read(lsdj_vio_t* rvio, lsdj_sav_t** psav, const lsdj_alloc
     if (result != LSDJ_SUCCESS)
     {
         lsdj_sav_free(sav);
+        *psav = NULL;
         return result;
     }
     
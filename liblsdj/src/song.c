@@ -39,6 +39,7 @@
 #include <stddef.h>
 
 #include "song_offsets.h"
+#include "tempo.h"
 
 // --- Other macros --- //
 
@@ -78,22 +79,13 @@ bool lsdj_song_set_tempo(lsdj_song_t* song, unsigned short bpm)
     if (bpm < 40 || bpm > 295)
         return false;
     
-    if (bpm > 255)
-        song->bytes[TEMPO_OFFSET] = (uint8_t)(bpm - 256);
-    else
-        song->bytes[TEMPO_OFFSET] = (uint8_t)bpm;
-    
+    song->bytes[TEMPO_OFFSET] = encode_tempo(bpm);
     return true;
 }
 
 unsigned short lsdj_song_get_tempo(const lsdj_song_t* song)
 {
-	const uint8_t byte = song->bytes[TEMPO_OFFSET];
-    
-    if (byte < 40)
-        return byte + 256;
-    else
-        return byte;
+	return decode_tempo(song->bytes[TEMPO_OFFSET]);
 }
 
 void lsdj_song_set_transposition(lsdj_song_t* song, uint8_t semitones)
@@ -40,7 +40,7 @@
 
 #define PHRASE_NOTES_OFFSET					(0x0000)
 #define BOOKMARKS_OFFSET					(0x0FF0)
-// Empty									(0x1030)
+#define EMPTY1_OFFSET						(0x1030)
 #define GROOVES_OFFSET						(0x1090)
 #define CHAIN_ASSIGNMENTS_OFFSET			(0x1290)
 #define TABLE_ENVELOPES_OFFSET				(0x1690)
@@ -48,12 +48,12 @@
 #define WORD_NAMES_OFFSET					(0x1DD0)
 #define RB1_OFFSET							(0x1E78)
 #define INSTRUMENT_NAMES_OFFSET				(0x1E7A)
-// Empty									(0x1FBA)
+#define EMPTY2_OFFSET						(0x1FBA)
 
 
 // --- Bank 1 --- //
 
-// Empty									(0x2000)
+#define EMPTY3_OFFSET						(0x2000)
 #define TABLE_ALLOCATION_TABLE_OFFSET		(0x2020)
 #define INSTRUMENT_ALLOCATION_TABLE_OFFSET	(0x2040)
 #define CHAIN_PHRASES_OFFSET				(0x2080)
@@ -81,22 +81,22 @@
 #define FONT_OFFSET							(0x3FBC)
 #define SYNC_MODE_OFFSET					(0x3FBD)
 #define COLOR_PALETTE_OFFSET				(0x3FBE)
-// Empty									(0x3FBF)
+#define EMPTY4_OFFSET						(0x3FBF)
 #define CLONE_MODE_OFFSET					(0x3FC0)
 #define FILE_CHANGED_OFFSET					(0x3FC1)
 #define POWER_SAVE_OFFSET					(0x3FC2)
 #define PRELISTEN_OFFSET					(0x3FC3)
 #define SYNTH_OVERWRITES_OFFSET				(0x3FC4)
-// Empty									(0x3FC6)
+#define EMPTY5_OFFSET						(0x3FC6)
 #define DRUM_MAX_OFFSET						(0x3FD0)
-// Empty									(0x3FD1)
+#define EMPTY6_OFFSET						(0x3FD1)
 
 
 // --- Bank 2 --- //
 
 #define PHRASE_COMMANDS_OFFSET				(0x4000)
 #define PHRASE_COMMAND_VALUES_OFFSET		(0x4FF0)
-// Empty									(0x5FE0)
+#define EMPTY7_OFFSET						(0x5FE0)
 
 
 // --- Bank 3 --- //
@@ -104,7 +104,7 @@
 #define WAVES_OFFSET						(0x6000)
 #define PHRASE_INSTRUMENTS_OFFSET			(0x7000)
 #define RB3_OFFSET							(0x7FF0)
-// Empty 									(0x7FF2)
+#define EMPTY8_OFFSET						(0x7FF2)
 #define FORMAT_VERSION_OFFSET				(0x7FFF)
 
 
@@ -0,0 +1,279 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include "synth.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include "song_offsets.h"
+
+//! The amount of samples in a wave (every byte holds two)
+#define SAMPLE_COUNT (LSDJ_WAVE_BYTE_COUNT * 2)
+
+//! The amount of harmonics a wave can hold below its Nyquist frequency
+#define HARMONIC_COUNT (SAMPLE_COUNT / 2 - 1)
+
+//! The amplitude in levels of the fundamental, per step of volume
+#define VOLUME_GAIN (0.2367f)
+
+//! The height of the resonance peak without any resonance
+#define RESONANCE_BASE (0.947f)
+
+//! How much every step of resonance adds to the height of its peak
+#define RESONANCE_GAIN (0.7925f)
+
+//! The resonance peaks a little above the cutoff, in harmonics
+#define RESONANCE_OFFSET (0.033f)
+
+/* Every step of the pipeline processes all 16 waves of a synth at once, one lane
+   per wave. The loops over these lanes have no dependencies between iterations,
+   so the compiler can turn them into vector instructions. */
+typedef float lanes_t[LSDJ_SYNTH_WAVE_COUNT];
+
+//! Interpolate a parameter from its start towards its end value across the lanes
+/*! LSDJ reaches the end value one step after the last wave */
+static void interpolate(float start, float end, lanes_t lanes)
+{
+	for (int i = 0; i < LSDJ_SYNTH_WAVE_COUNT; i++)
+		lanes[i] = start + (end - start) * (float)i / LSDJ_SYNTH_WAVE_COUNT;
+}
+
+//! Step a parameter from its start to its end value across the lanes
+/*! Resonance, limit and phase don't interpolate, but are divided into runs of waves of
+	(nearly) equal length for every value in between. The last wave holds the end
+	value, and the longest runs are at the end. */
+static void step(int start, int end, lanes_t lanes)
+{
+	const int distance = start > end ? start - end : end - start;
+
+	for (int i = 0; i < LSDJ_SYNTH_WAVE_COUNT; i++)
+	{
+		int offset = (LSDJ_SYNTH_WAVE_COUNT - 1 - i) * (distance + 1) / LSDJ_SYNTH_WAVE_COUNT;
+		if (offset > distance)
+			offset = distance;
+
+		lanes[i] = (float)(start > end ? end + offset : end - offset);
+	}
+}
+
+static float clamp_float(float x, float low, float high)
+{
+	return x < low ? low : (x > high ? high : x);
+}
+
+//! The amplitude of a harmonic in the spectrum of a waveform, relative to the fundamental
+static float harmonic_amplitude(lsdj_synth_waveform_t waveform, int harmonic)
+{
+	switch (waveform)
+	{
+		case LSDJ_SYNTH_WAVEFORM_SQUARE:
+			return harmonic % 2 ? 1.0f / (float)harmonic : 0.0f;
+		case LSDJ_SYNTH_WAVEFORM_TRIANGLE:
+			if (harmonic % 2 == 0)
+				return 0.0f;
+			return ((harmonic / 2) % 2 ? -1.0f : 1.0f) / (float)(harmonic * harmonic);
+		default:
+			return 1.0f / (float)harmonic;
+	}
+}
+
+//! Compute the gain of every harmonic of every lane, with the filter applied to the waveform
+/*! The filter works directly on the harmonics: a cutoff of 0x10 lies on the fundamental,
+	every 0x10 higher lies on the next harmonic. Below and above the cutoff the filter
+	passes or blocks the harmonics, and the resonance adds a peak at the cutoff, spread
+	across the two harmonics surrounding it. */
+static void compute_gains(lsdj_synth_waveform_t waveform, lsdj_synth_filter_t type, const lanes_t cutoff, const lanes_t resonance, lanes_t gains[HARMONIC_COUNT])
+{
+	for (int h = 0; h < HARMONIC_COUNT; h++)
+	{
+		const int harmonic = h + 1;
+		const float amplitude = harmonic_amplitude(waveform, harmonic);
+
+		for (int i = 0; i < LSDJ_SYNTH_WAVE_COUNT; i++)
+		{
+			const float center = cutoff[i] / 0x10;
+
+			// How much of the harmonic lies below the cutoff
+			const float low = clamp_float(center - (float)harmonic, 0.0f, 1.0f);
+
+			float gain;
+			switch (type)
+			{
+				case LSDJ_SYNTH_FILTER_HIGH_PASS:
+					gain = 1.0f - low;
+					break;
+				case LSDJ_SYNTH_FILTER_BAND_PASS:
+					gain = 0.0f;
+					break;
+				case LSDJ_SYNTH_FILTER_ALL_PASS:
+					gain = 1.0f;
+					break;
+				default:
+					gain = low;
+					break;
+			}
+
+			// The resonance peak, linearly split between the surrounding harmonics
+			const float distance = fabsf(center + RESONANCE_OFFSET - (float)harmonic);
+			if (distance < 1.0f)
+				gain += (RESONANCE_BASE + RESONANCE_GAIN * resonance[i]) * (1.0f - distance);
+
+			gains[h][i] = amplitude * gain;
+		}
+	}
+}
+
+//! The sine of a position within a cycle of a given length in samples
+/*! This is exactly odd around the middle of the cycle, like the waves LSDJ generates */
+static float sine(int position, int length)
+{
+	if (2 * position > length)
+		return -sine(length - position, length);
+	else if (2 * position == length)
+		return 0.0f;
+	else
+		return sinf(6.28318530718f * (float)position / (float)length);
+}
+
+//! Sum the harmonics into the samples of every lane, with the phase compressed
+static void synthesize(lsdj_synth_phase_compression_t compression, const lanes_t phase, const lanes_t gains[HARMONIC_COUNT], lanes_t samples[SAMPLE_COUNT])
+{
+	for (int sample = 0; sample < SAMPLE_COUNT; sample++)
+	{
+		for (int i = 0; i < LSDJ_SYNTH_WAVE_COUNT; i++)
+		{
+			// Phase compression squeezes a cycle of the waveform into fewer samples.
+			// Normal mode stays silent afterwards, resync restarts the waveform and resync2
+			// plays it backwards every other time.
+			const int length = SAMPLE_COUNT - (int)phase[i];
+			const int cycle = sample / length;
+			const int position = sample % length;
+
+			float value = 0.0f;
+			for (int h = 0; h < HARMONIC_COUNT; h++)
+				value += gains[h][i] * sine(position * (h + 1) % length, length);
+
+			if (compression == LSDJ_SYNTH_PHASE_NORMAL && cycle >= 1)
+				value = 0.0f;
+			else if (compression == LSDJ_SYNTH_PHASE_RESYNC2 && (cycle & 1))
+				value = -value;
+
+			samples[sample][i] = value;
+		}
+	}
+}
+
+//! Keep a sample within the limit, the way the distortion type dictates
+static float distort(lsdj_synth_distortion_t distortion, float value, float limit)
+{
+	switch (distortion)
+	{
+		case LSDJ_SYNTH_DISTORTION_WRAP:
+		{
+			const float range = 2.0f * limit;
+			const float wrapped = (value + limit) / range;
+			return (wrapped - floorf(wrapped)) * range - limit;
+		}
+		case LSDJ_SYNTH_DISTORTION_FOLD:
+		{
+			// Reflect the value off of the limits, which repeats every four limits
+			const float period = 4.0f * limit;
+			const float folded = (value + limit) / period;
+			const float position = (folded - floorf(folded)) * period;
+			return (position < 2.0f * limit ? position : period - position) - limit;
+		}
+		default:
+			return clamp_float(value, -limit, limit);
+	}
+}
+
+void lsdj_synth_render_waves(const lsdj_song_t* song, uint8_t synth, uint8_t waves[LSDJ_SYNTH_WAVE_COUNT][LSDJ_WAVE_BYTE_COUNT])
+{
+	assert(synth < LSDJ_SYNTH_COUNT);
+
+	lanes_t volume, cutoff, resonance, vshift, limit, phase;
+	interpolate(lsdj_synth_get_volume_start(song, synth), lsdj_synth_get_volume_end(song, synth), volume);
+	interpolate(lsdj_synth_get_cutoff_start(song, synth), lsdj_synth_get_cutoff_end(song, synth), cutoff);
+	interpolate(lsdj_synth_get_vshift_start(song, synth), lsdj_synth_get_vshift_end(song, synth), vshift);
+	step(lsdj_synth_get_resonance_start(song, synth), lsdj_synth_get_resonance_end(song, synth), resonance);
+	step(lsdj_synth_get_limit_start(song, synth), lsdj_synth_get_limit_end(song, synth), limit);
+	step(lsdj_synth_get_phase_start(song, synth) & 0x1F, lsdj_synth_get_phase_end(song, synth) & 0x1F, phase);
+
+	lanes_t gains[HARMONIC_COUNT];
+	compute_gains(lsdj_synth_get_waveform(song, synth), lsdj_synth_get_filter(song, synth), cutoff, resonance, gains);
+
+	lanes_t samples[SAMPLE_COUNT];
+	synthesize(lsdj_synth_get_phase_compression(song, synth), phase, (const lanes_t*)gains, samples);
+
+	const lsdj_synth_distortion_t distortion = lsdj_synth_get_distortion(song, synth);
+	for (int sample = 0; sample < SAMPLE_COUNT; sample++)
+	{
+		for (int i = 0; i < LSDJ_SYNTH_WAVE_COUNT; i++)
+		{
+			// The samples are in levels around the center of the wave. The vertical shift
+			// covers the full range once, before the signal gets distorted.
+			const float shifted = samples[sample][i] * volume[i] * VOLUME_GAIN + vshift[i] / 0x10;
+			samples[sample][i] = distort(distortion, shifted, (limit[i] + 1.0f) / 2.0f);
+		}
+	}
+
+	// Quantize to 4-bit levels, two per byte with the first in the high nibble
+	for (int sample = 0; sample < SAMPLE_COUNT; sample++)
+	{
+		for (int i = 0; i < LSDJ_SYNTH_WAVE_COUNT; i++)
+		{
+			const float level = clamp_float(floorf(samples[sample][i]) + 8.0f, 0.0f, 15.0f);
+			uint8_t* byte = &waves[i][sample / 2];
+
+			if (sample % 2 == 0)
+				*byte = (uint8_t)((uint8_t)level << 4);
+			else
+				*byte = (uint8_t)(*byte | (uint8_t)level);
+		}
+	}
+}
+
+void lsdj_synth_write_waves(lsdj_song_t* song, uint8_t synth)
+{
+	assert(synth < LSDJ_SYNTH_COUNT);
+
+	uint8_t waves[LSDJ_SYNTH_WAVE_COUNT][LSDJ_WAVE_BYTE_COUNT];
+	lsdj_synth_render_waves(song, synth, waves);
+
+	memcpy(&song->bytes[WAVES_OFFSET + (size_t)synth * sizeof(waves)], waves, sizeof(waves));
+	lsdj_synth_set_wave_overwritten(song, synth, true);
+}
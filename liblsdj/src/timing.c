@@ -0,0 +1,186 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include "timing.h"
+
+#include <string.h>
+
+#include "groove.h"
+#include "phrase.h"
+#include "tempo.h"
+
+//! The amount of groove slots in a song (0x00 through 0x1F)
+#define GROOVE_SLOT_COUNT (0x20)
+
+//! The number of seconds in a tick, at a given tempo
+#define SECONDS_PER_TICK(tempo) (60.0 / ((double)(tempo) * LSDJ_TICKS_PER_BEAT))
+
+//! Move the timer forward in time, at the current tempo
+static void move_to_tick(lsdj_song_timer_t* timer, uint32_t tick)
+{
+	if (tick <= timer->tick)
+		return;
+
+	timer->time += (double)(tick - timer->tick) * SECONDS_PER_TICK(timer->tempo);
+	timer->tick = tick;
+}
+
+//! Read the length of the current groove step of a channel, and move on to the next groove step
+static uint8_t read_groove_step(const lsdj_song_t* song, lsdj_song_timer_t* timer, size_t channel)
+{
+	const uint8_t groove = timer->grooves[channel];
+
+	// Grooves loop at their first empty step
+	uint8_t ticks = lsdj_groove_get_step(song, groove, timer->grooveSteps[channel]);
+	if (ticks == LSDJ_GROOVE_NO_VALUE && timer->grooveSteps[channel] != 0)
+	{
+		timer->grooveSteps[channel] = 0;
+		ticks = lsdj_groove_get_step(song, groove, 0);
+	}
+
+	timer->grooveSteps[channel] = (uint8_t)((timer->grooveSteps[channel] + 1) % LSDJ_GROOVE_LENGTH);
+
+	return ticks == LSDJ_GROOVE_NO_VALUE ? LSDJ_DEFAULT_STEP_TICKS : ticks;
+}
+
+bool lsdj_song_timer_start(const lsdj_song_t* song, lsdj_song_timer_t* timer)
+{
+	memset(timer, 0, sizeof(lsdj_song_timer_t));
+	timer->tempo = lsdj_song_get_tempo(song);
+
+	bool playing = false;
+	for (size_t channel = 0; channel < LSDJ_CHANNEL_COUNT; channel++)
+	{
+		timer->playing[channel] = lsdj_song_cursor_start(song, (lsdj_channel_t)channel, 0, &timer->cursors[channel]);
+		playing |= timer->playing[channel];
+	}
+
+	return playing;
+}
+
+bool lsdj_song_timer_next(const lsdj_song_t* song, lsdj_song_timer_t* timer, lsdj_timed_step_t* step)
+{
+	// Find the channel whose step starts first
+	size_t channel = LSDJ_CHANNEL_COUNT;
+	for (size_t i = 0; i < LSDJ_CHANNEL_COUNT; i++)
+	{
+		if (timer->playing[i] && (channel == LSDJ_CHANNEL_COUNT || timer->stepTicks[i] < timer->stepTicks[channel]))
+			channel = i;
+	}
+
+	if (channel == LSDJ_CHANNEL_COUNT)
+	{
+		move_to_tick(timer, timer->endTick);
+		return false;
+	}
+
+	move_to_tick(timer, timer->stepTicks[channel]);
+
+	lsdj_song_cursor_t* cursor = &timer->cursors[channel];
+	const lsdj_command_t command = lsdj_phrase_get_command(song, cursor->phrase, cursor->phraseStep);
+	const uint8_t value = lsdj_phrase_get_command_value(song, cursor->phrase, cursor->phraseStep);
+
+	if (command == LSDJ_COMMAND_G && value < GROOVE_SLOT_COUNT)
+	{
+		timer->grooves[channel] = value;
+		timer->grooveSteps[channel] = 0;
+	}
+	else if (command == LSDJ_COMMAND_T)
+	{
+		timer->tempo = decode_tempo(value);
+	}
+
+	const uint8_t tickCount = read_groove_step(song, timer, channel);
+
+	step->channel = (lsdj_channel_t)channel;
+	step->row = cursor->row;
+	step->chain = cursor->chain;
+	step->phrase = cursor->phrase;
+	step->phraseStep = cursor->phraseStep;
+	step->transposition = cursor->transposition;
+	step->tickCount = tickCount;
+	step->tick = timer->tick;
+	step->time = timer->time;
+
+	const lsdj_cursor_move_t move = lsdj_song_cursor_advance(song, cursor);
+	if (move == LSDJ_CURSOR_NEXT)
+	{
+		timer->stepTicks[channel] += tickCount;
+	} else {
+		const uint32_t endTick = timer->stepTicks[channel] + tickCount;
+		if (endTick > timer->endTick)
+			timer->endTick = endTick;
+
+		timer->playing[channel] = false;
+		timer->looped[channel] = move == LSDJ_CURSOR_LOOPED;
+	}
+
+	return true;
+}
+
+void lsdj_song_time(const lsdj_song_t* song, lsdj_song_timing_t* timing, double (*rowTimes)[LSDJ_TIMING_ROW_COUNT])
+{
+	if (rowTimes)
+	{
+		for (size_t channel = 0; channel < LSDJ_CHANNEL_COUNT; channel++)
+		{
+			for (size_t row = 0; row < LSDJ_TIMING_ROW_COUNT; row++)
+				rowTimes[channel][row] = LSDJ_TIMING_NOT_PLAYED;
+		}
+	}
+
+	lsdj_song_timer_t timer;
+	if (lsdj_song_timer_start(song, &timer))
+	{
+		lsdj_timed_step_t step;
+		while (lsdj_song_timer_next(song, &timer, &step))
+		{
+			if (rowTimes && rowTimes[step.channel][step.row] < 0.0)
+				rowTimes[step.channel][step.row] = step.time;
+		}
+	}
+
+	timing->duration = timer.time;
+	timing->tickCount = timer.tick;
+	timing->loops = false;
+	for (size_t channel = 0; channel < LSDJ_CHANNEL_COUNT; channel++)
+		timing->loops |= timer.looped[channel];
+}
+
+void lsdj_song_time_batch(const lsdj_song_t* const* songs, size_t count, lsdj_song_timing_t* timings)
+{
+	for (size_t i = 0; i < count; i++)
+		lsdj_song_time(songs[i], &timings[i], NULL);
+}
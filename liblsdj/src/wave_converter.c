@@ -0,0 +1,208 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include "wave_converter.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+//! The amount of harmonics kept, including DC (a wave of 32 steps holds 15 below Nyquist)
+#define HARMONIC_COUNT (LSDJ_WAVE_STEP_COUNT / 2)
+
+//! Cycles with a lower peak are considered silent, so rounding noise isn't blown up by normalization
+#define SILENCE_THRESHOLD (1.0e-4f)
+
+struct lsdj_wave_converter_t
+{
+	//! The amount of samples in every cycle
+	size_t cycleLength;
+
+	//! The highest harmonic a cycle of this length can hold
+	size_t harmonicCount;
+
+	bool normalize;
+	bool dither;
+
+	//! State of the pseudo-random generator used for dithering
+	uint32_t noise;
+
+	//! Cosines and sines of every harmonic for every input sample, stored per sample
+	/*! Storing them this way lets the analysis loop run over all harmonics at once */
+	float* analysis;
+
+	//! Cosines and sines of every harmonic for every output sample
+	float synthesis[LSDJ_WAVE_STEP_COUNT][HARMONIC_COUNT * 2];
+
+	//! The allocator used to create this converter
+	const lsdj_allocator_t* allocator;
+};
+
+lsdj_error_t lsdj_wave_converter_new(size_t cycleLength, lsdj_wave_converter_t** pconverter, const lsdj_allocator_t* allocator)
+{
+	assert(cycleLength > 0);
+
+	lsdj_wave_converter_t* converter = lsdj_allocate_or_malloc(allocator, sizeof(lsdj_wave_converter_t));
+	if (converter == NULL)
+		return LSDJ_ALLOCATION_FAILED;
+
+	converter->analysis = lsdj_allocate_or_malloc(allocator, cycleLength * HARMONIC_COUNT * 2 * sizeof(float));
+	if (converter->analysis == NULL)
+	{
+		lsdj_deallocate_or_free(allocator, converter);
+		return LSDJ_ALLOCATION_FAILED;
+	}
+
+	converter->cycleLength = cycleLength;
+	converter->harmonicCount = (cycleLength + 1) / 2 < HARMONIC_COUNT ? (cycleLength + 1) / 2 : HARMONIC_COUNT;
+	converter->normalize = true;
+	converter->dither = false;
+	converter->noise = 0x12345678;
+	converter->allocator = allocator;
+
+	const double tau = 6.283185307179586476925;
+	for (size_t n = 0; n < cycleLength; n++)
+	{
+		float* row = &converter->analysis[n * HARMONIC_COUNT * 2];
+		for (size_t h = 0; h < HARMONIC_COUNT; h++)
+		{
+			// Reduce the phase before taking the sine, to keep precision for long cycles
+			const double phase = tau * (double)((h * n) % cycleLength) / (double)cycleLength;
+			row[h] = (float)cos(phase);
+			row[HARMONIC_COUNT + h] = (float)sin(phase);
+		}
+	}
+
+	for (size_t k = 0; k < LSDJ_WAVE_STEP_COUNT; k++)
+	{
+		for (size_t h = 0; h < HARMONIC_COUNT; h++)
+		{
+			const double phase = tau * (double)((h * k) % LSDJ_WAVE_STEP_COUNT) / LSDJ_WAVE_STEP_COUNT;
+			converter->synthesis[k][h] = (float)cos(phase);
+			converter->synthesis[k][HARMONIC_COUNT + h] = (float)sin(phase);
+		}
+	}
+
+	*pconverter = converter;
+	return LSDJ_SUCCESS;
+}
+
+void lsdj_wave_converter_free(lsdj_wave_converter_t* converter)
+{
+	if (converter == NULL)
+		return;
+
+	lsdj_deallocate_or_free(converter->allocator, converter->analysis);
+	lsdj_deallocate_or_free(converter->allocator, converter);
+}
+
+void lsdj_wave_converter_set_normalize(lsdj_wave_converter_t* converter, bool normalize)
+{
+	converter->normalize = normalize;
+}
+
+void lsdj_wave_converter_set_dither(lsdj_wave_converter_t* converter, bool dither)
+{
+	converter->dither = dither;
+}
+
+//! Return a pseudo-random number in [0, 1)
+static float next_noise(lsdj_wave_converter_t* converter)
+{
+	// Xorshift32
+	uint32_t x = converter->noise;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	converter->noise = x;
+
+	return (float)(x >> 8) / (float)(1 << 24);
+}
+
+void lsdj_wave_converter_convert(lsdj_wave_converter_t* converter, const float* cycle, uint8_t wave[LSDJ_WAVE_BYTE_COUNT])
+{
+	// Analyze the harmonics the wave can hold. The inner loop runs over all harmonics
+	// at once and has no dependencies between iterations, so the compiler vectorizes it.
+	float spectrum[HARMONIC_COUNT * 2];
+	memset(spectrum, 0, sizeof(spectrum));
+
+	for (size_t n = 0; n < converter->cycleLength; n++)
+	{
+		const float* row = &converter->analysis[n * HARMONIC_COUNT * 2];
+		for (size_t i = 0; i < HARMONIC_COUNT * 2; i++)
+			spectrum[i] += cycle[n] * row[i];
+	}
+
+	// Weigh the harmonics for resynthesis, leaving out the ones the cycle can't hold
+	const float scale = 1.0f / (float)converter->cycleLength;
+	for (size_t h = 0; h < HARMONIC_COUNT; h++)
+	{
+		const float weight = h >= converter->harmonicCount ? 0.0f : (h == 0 ? (converter->normalize ? 0.0f : scale) : 2.0f * scale);
+		spectrum[h] *= weight;
+		spectrum[HARMONIC_COUNT + h] *= weight;
+	}
+
+	// Resynthesize the 32 steps of the wave
+	float samples[LSDJ_WAVE_STEP_COUNT];
+	float peak = 0.0f;
+	for (size_t k = 0; k < LSDJ_WAVE_STEP_COUNT; k++)
+	{
+		float sample = 0.0f;
+		for (size_t i = 0; i < HARMONIC_COUNT * 2; i++)
+			sample += spectrum[i] * converter->synthesis[k][i];
+
+		samples[k] = sample;
+		peak = fabsf(sample) > peak ? fabsf(sample) : peak;
+	}
+
+	// Silent cycles become the silent wave (all 8's), instead of whatever side the rounding noise falls on
+	float gain = converter->normalize ? 1.0f / peak : 1.0f;
+	if (peak <= SILENCE_THRESHOLD)
+		gain = 0.0f;
+
+	// Quantize to 4-bit levels, two per byte with the first in the high nibble
+	for (size_t k = 0; k < LSDJ_WAVE_STEP_COUNT; k++)
+	{
+		float level = 7.5f + 7.5f * samples[k] * gain + 0.5f;
+		if (converter->dither)
+			level += next_noise(converter) - next_noise(converter);
+
+		const uint8_t quantized = level < 0.0f ? 0 : (level >= 15.0f ? 15 : (uint8_t)level);
+		if (k % 2 == 0)
+			wave[k / 2] = (uint8_t)(quantized << 4);
+		else
+			wave[k / 2] = (uint8_t)(wave[k / 2] | quantized);
+	}
+}
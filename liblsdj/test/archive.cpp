@@ -0,0 +1,153 @@
+#include <lsdj/archive.h>
+
+#include <catch2/catch.hpp>
+#include <cstring>
+#include <vector>
+
+#include <lsdj/compression.h>
+#include <lsdj/phrase.h>
+#include <lsdj/sav.h>
+
+using namespace Catch;
+
+static std::vector<uint8_t> archive(const lsdj_song_t* song)
+{
+	std::vector<uint8_t> memory(LSDJ_ARCHIVE_MAX_SIZE);
+
+	lsdj_memory_access_state_t state;
+	state.begin = state.cur = memory.data();
+	state.size = memory.size();
+	lsdj_vio_t wvio = lsdj_create_memory_vio(&state);
+
+	size_t writeCounter = 0;
+	REQUIRE( lsdj_song_write_archive(song, &wvio, &writeCounter) == LSDJ_SUCCESS );
+
+	memory.resize(writeCounter);
+	return memory;
+}
+
+static lsdj_error_t unarchive(std::vector<uint8_t> data, lsdj_song_t* song)
+{
+	lsdj_memory_access_state_t state;
+	state.begin = state.cur = data.data();
+	state.size = data.size();
+	lsdj_vio_t rvio = lsdj_create_memory_vio(&state);
+
+	size_t readCounter = 0;
+	const lsdj_error_t result = lsdj_song_read_archive(&rvio, &readCounter, song);
+	if (result == LSDJ_SUCCESS)
+		REQUIRE( readCounter == data.size() );
+
+	return result;
+}
+
+SCENARIO( "Song archives", "[archive]" )
+{
+	lsdj_song_t song;
+	lsdj_song_t result;
+	memcpy(song.bytes, LSDJ_SONG_NEW_BYTES, LSDJ_SONG_BYTE_COUNT);
+
+	GIVEN( "A new song" )
+	{
+		const auto data = archive(&song);
+
+		THEN( "The archive should contain a header and a single run" )
+		{
+			REQUIRE( data.size() == LSDJ_ARCHIVE_HEADER_SIZE + 3 );
+		}
+
+		THEN( "Reading it back should result in the same song" )
+		{
+			REQUIRE( unarchive(data, &result) == LSDJ_SUCCESS );
+			REQUIRE( memcmp(result.bytes, song.bytes, LSDJ_SONG_BYTE_COUNT) == 0 );
+		}
+	}
+
+	GIVEN( "A song with a few notes" )
+	{
+		lsdj_phrase_set_note(&song, 0x00, 0, 0x20);
+		lsdj_phrase_set_note(&song, 0x00, 1, 0x22);
+		lsdj_phrase_set_note(&song, 0x10, 4, 0x24);
+
+		const auto data = archive(&song);
+
+		THEN( "Both decoders should result in the same song" )
+		{
+			REQUIRE( unarchive(data, &result) == LSDJ_SUCCESS );
+			REQUIRE( memcmp(result.bytes, song.bytes, LSDJ_SONG_BYTE_COUNT) == 0 );
+
+			memset(result.bytes, 0, LSDJ_SONG_BYTE_COUNT);
+			size_t readCounter = 0;
+			REQUIRE( lsdj_song_read_archive_from_memory(data.data(), data.size(), &readCounter, &result) == LSDJ_SUCCESS );
+			REQUIRE( readCounter == data.size() );
+			REQUIRE( memcmp(result.bytes, song.bytes, LSDJ_SONG_BYTE_COUNT) == 0 );
+		}
+
+		THEN( "A corrupt archive should be detected" )
+		{
+			auto corrupt = data;
+			corrupt[LSDJ_ARCHIVE_HEADER_SIZE + 1] ^= 0x01;
+			REQUIRE( unarchive(corrupt, &result) == LSDJ_ARCHIVE_INVALID );
+			REQUIRE( lsdj_song_read_archive_from_memory(corrupt.data(), corrupt.size(), nullptr, &result) == LSDJ_ARCHIVE_INVALID );
+		}
+
+		THEN( "A truncated archive should fail to read" )
+		{
+			auto truncated = data;
+			truncated.pop_back();
+			REQUIRE( unarchive(truncated, &result) == LSDJ_READ_FAILED );
+			REQUIRE( lsdj_song_read_archive_from_memory(truncated.data(), truncated.size(), nullptr, &result) == LSDJ_READ_FAILED );
+		}
+	}
+
+	GIVEN( "A song that has nothing in common with a new song" )
+	{
+		for (size_t i = 0; i < LSDJ_SONG_BYTE_COUNT; i++)
+			song.bytes[i] = static_cast<uint8_t>(LSDJ_SONG_NEW_BYTES[i] ^ (1 + (i * 7) % 255));
+
+		const auto data = archive(&song);
+
+		THEN( "The archive should not exceed the maximum size" )
+		{
+			REQUIRE( data.size() <= LSDJ_ARCHIVE_MAX_SIZE );
+			REQUIRE( unarchive(data, &result) == LSDJ_SUCCESS );
+			REQUIRE( memcmp(result.bytes, song.bytes, LSDJ_SONG_BYTE_COUNT) == 0 );
+		}
+	}
+
+	GIVEN( "The songs in a sav" )
+	{
+		lsdj_sav_t* sav = nullptr;
+		REQUIRE( lsdj_sav_read_from_file(RESOURCES_FOLDER "sav/all.sav", &sav, nullptr) == LSDJ_SUCCESS );
+
+		THEN( "Each should round trip, and take up less space than the LSDj block compression" )
+		{
+			for (uint8_t i = 0; i < LSDJ_SAV_PROJECT_COUNT; i++)
+			{
+				const lsdj_project_t* project = lsdj_sav_get_project_const(sav, i);
+				if (project == nullptr)
+					continue;
+
+				const lsdj_song_t* original = lsdj_project_get_song_const(project);
+				const auto data = archive(original);
+
+				REQUIRE( unarchive(data, &result) == LSDJ_SUCCESS );
+				REQUIRE( memcmp(result.bytes, original->bytes, LSDJ_SONG_BYTE_COUNT) == 0 );
+
+				memset(result.bytes, 0, LSDJ_SONG_BYTE_COUNT);
+				REQUIRE( lsdj_song_read_archive_from_memory(data.data(), data.size(), nullptr, &result) == LSDJ_SUCCESS );
+				REQUIRE( memcmp(result.bytes, original->bytes, LSDJ_SONG_BYTE_COUNT) == 0 );
+
+				auto corrupt = data;
+				corrupt[data.size() / 2] ^= 0x10;
+				REQUIRE( lsdj_song_read_archive_from_memory(corrupt.data(), corrupt.size(), nullptr, &result) != LSDJ_SUCCESS );
+
+				unsigned int blockCount = 0;
+				REQUIRE( lsdj_compress_count_blocks(original->bytes, &blockCount) == LSDJ_SUCCESS );
+				REQUIRE( data.size() < blockCount * LSDJ_BLOCK_SIZE );
+			}
+		}
+
+		lsdj_sav_free(sav);
+	}
+}
@@ -0,0 +1,255 @@
+#include <lsdj/clean.h>
+
+#include <array>
+#include <catch2/catch.hpp>
+#include <cstring>
+#include <vector>
+
+#include <lsdj/chain.h>
+#include <lsdj/compression.h>
+#include <lsdj/instrument.h>
+#include <lsdj/phrase.h>
+#include <lsdj/sav.h>
+#include <lsdj/table.h>
+
+using namespace Catch;
+
+struct PhraseContents
+{
+	std::array<uint8_t, LSDJ_PHRASE_LENGTH> notes;
+	std::array<uint8_t, LSDJ_PHRASE_LENGTH> instruments;
+	std::array<lsdj_command_t, LSDJ_PHRASE_LENGTH> commands;
+	std::array<uint8_t, LSDJ_PHRASE_LENGTH> values;
+
+	bool operator==(const PhraseContents& rhs) const
+	{
+		return notes == rhs.notes && instruments == rhs.instruments && commands == rhs.commands && values == rhs.values;
+	}
+};
+
+static PhraseContents getPhrase(const lsdj_song_t& song, uint8_t phrase)
+{
+	PhraseContents contents;
+	for (uint8_t step = 0; step < LSDJ_PHRASE_LENGTH; step++)
+	{
+		contents.notes[step] = lsdj_phrase_get_note(&song, phrase, step);
+		contents.instruments[step] = lsdj_phrase_get_instrument(&song, phrase, step);
+		contents.commands[step] = lsdj_phrase_get_command(&song, phrase, step);
+		contents.values[step] = lsdj_phrase_get_command_value(&song, phrase, step);
+	}
+
+	return contents;
+}
+
+static void setPhrase(lsdj_song_t& song, uint8_t phrase, const PhraseContents& contents)
+{
+	for (uint8_t step = 0; step < LSDJ_PHRASE_LENGTH; step++)
+	{
+		lsdj_phrase_set_note(&song, phrase, step, contents.notes[step]);
+		lsdj_phrase_set_instrument(&song, phrase, step, contents.instruments[step]);
+		lsdj_phrase_set_command(&song, phrase, step, contents.commands[step]);
+		lsdj_phrase_set_command_value(&song, phrase, step, contents.values[step]);
+	}
+}
+
+//! Every phrase played in the song, in order of the song rows
+static std::vector<PhraseContents> getPlayedPhrases(const lsdj_song_t& song)
+{
+	std::vector<PhraseContents> phrases;
+	for (int row = 0; row < 256; row++)
+	{
+		for (uint8_t channel = 0; channel < LSDJ_CHANNEL_COUNT; channel++)
+		{
+			const auto chain = lsdj_row_get_chain(&song, static_cast<uint8_t>(row), static_cast<lsdj_channel_t>(channel));
+			for (uint8_t step = 0; chain != LSDJ_SONG_NO_CHAIN && step < LSDJ_CHAIN_LENGTH; step++)
+			{
+				const auto phrase = lsdj_chain_get_phrase(&song, chain, step);
+				if (phrase != LSDJ_CHAIN_NO_PHRASE)
+					phrases.emplace_back(getPhrase(song, phrase));
+			}
+		}
+	}
+
+	return phrases;
+}
+
+static size_t compressedBlockCount(const lsdj_song_t& song)
+{
+	std::vector<uint8_t> memory(LSDJ_BLOCK_COUNT * LSDJ_BLOCK_SIZE);
+
+	lsdj_memory_access_state_t state;
+	state.begin = state.cur = memory.data();
+	state.size = memory.size();
+	lsdj_vio_t wvio = lsdj_create_memory_vio(&state);
+
+	size_t writeCounter = 0;
+	REQUIRE( lsdj_compress(song.bytes, &wvio, 1, &writeCounter) == LSDJ_SUCCESS );
+
+	return writeCounter / LSDJ_BLOCK_SIZE;
+}
+
+SCENARIO( "Cleaning songs", "[clean]" )
+{
+	lsdj_sav_t* sav = nullptr;
+	REQUIRE( lsdj_sav_read_from_file(RESOURCES_FOLDER "sav/all.sav", &sav, nullptr) == LSDJ_SUCCESS );
+
+	lsdj_song_t song;
+	memcpy(&song, lsdj_project_get_song_const(lsdj_sav_get_project_const(sav, 0)), sizeof(song));
+
+	GIVEN( "A song with data that isn't reachable from the song rows" )
+	{
+		// Move the chain on the noise channel out of the song, orphaning it and its phrases
+		const uint8_t phrase = lsdj_chain_get_phrase(&song, 0x04, 0);
+		REQUIRE( phrase != LSDJ_CHAIN_NO_PHRASE );
+		lsdj_row_set_chain(&song, 0, LSDJ_CHANNEL_NOISE, LSDJ_SONG_NO_CHAIN);
+
+		const auto blocksBefore = compressedBlockCount(song);
+
+		WHEN( "Cleaning the song" )
+		{
+			lsdj_song_clean(&song);
+
+			THEN( "Reachable chains and phrases should be kept" )
+			{
+				REQUIRE( lsdj_chain_is_allocated(&song, 0x01) );
+				REQUIRE( lsdj_chain_get_phrase(&song, 0x01, 6) == 0x07 );
+				REQUIRE( lsdj_phrase_is_allocated(&song, 0x07) );
+				REQUIRE( lsdj_instrument_is_allocated(&song, 0x02) );
+			}
+
+			THEN( "The orphaned chain and its phrases should be reset" )
+			{
+				REQUIRE_FALSE( lsdj_chain_is_allocated(&song, 0x04) );
+				REQUIRE( lsdj_chain_get_phrase(&song, 0x04, 0) == LSDJ_CHAIN_NO_PHRASE );
+				REQUIRE_FALSE( lsdj_phrase_is_allocated(&song, phrase) );
+				REQUIRE( lsdj_phrase_get_instrument(&song, phrase, 0) == LSDJ_PHRASE_NO_INSTRUMENT );
+			}
+
+			THEN( "The song should not compress into more blocks" )
+			{
+				REQUIRE( compressedBlockCount(song) <= blocksBefore );
+			}
+
+			THEN( "Every allocated phrase should be used by a chain in the song" )
+			{
+				for (uint8_t i = 0; i < LSDJ_PHRASE_COUNT; i++)
+				{
+					if (!lsdj_phrase_is_allocated(&song, i))
+						continue;
+
+					bool used = false;
+					for (uint8_t row = 0; row < 0xFF && !used; row++)
+					{
+						for (uint8_t channel = 0; channel < LSDJ_CHANNEL_COUNT && !used; channel++)
+						{
+							const auto chain = lsdj_row_get_chain(&song, row, static_cast<lsdj_channel_t>(channel));
+							for (uint8_t step = 0; chain != LSDJ_SONG_NO_CHAIN && step < LSDJ_CHAIN_LENGTH; step++)
+								used |= lsdj_chain_get_phrase(&song, chain, step) == i;
+						}
+					}
+
+					REQUIRE( used );
+				}
+			}
+
+			AND_WHEN( "Cleaning it again" )
+			{
+				lsdj_song_t copy;
+				memcpy(&copy, &song, sizeof(song));
+				lsdj_song_clean(&song);
+
+				THEN( "Nothing should change" )
+				{
+					REQUIRE( memcmp(copy.bytes, song.bytes, sizeof(song.bytes)) == 0 );
+				}
+			}
+		}
+	}
+
+	GIVEN( "A song with duplicate phrases and chains" )
+	{
+		setPhrase(song, 0x0E, getPhrase(song, 0x07));
+		for (uint8_t step = 0; step < LSDJ_CHAIN_LENGTH; step++)
+		{
+			lsdj_chain_set_phrase(&song, 0x02, step, lsdj_chain_get_phrase(&song, 0x01, step));
+			lsdj_chain_set_transposition(&song, 0x02, step, lsdj_chain_get_transposition(&song, 0x01, step));
+		}
+
+		const auto played = getPlayedPhrases(song);
+
+		WHEN( "Deduplicating phrases and chains" )
+		{
+			REQUIRE( lsdj_song_deduplicate_phrases(&song) >= 1 );
+			REQUIRE( lsdj_song_deduplicate_chains(&song) >= 1 );
+
+			THEN( "The song should still play the same phrases" )
+			{
+				REQUIRE( getPlayedPhrases(song) == played );
+			}
+
+			THEN( "Both channels should refer to the same chain" )
+			{
+				REQUIRE( lsdj_row_get_chain(&song, 0, LSDJ_CHANNEL_PULSE1) == lsdj_row_get_chain(&song, 0, LSDJ_CHANNEL_PULSE2) );
+			}
+
+			THEN( "No two allocated phrases should be the same" )
+			{
+				for (uint8_t lhs = 0; lhs < LSDJ_PHRASE_COUNT; lhs++)
+				{
+					for (uint8_t rhs = lhs + 1; rhs < LSDJ_PHRASE_COUNT && lsdj_phrase_is_allocated(&song, lhs); rhs++)
+					{
+						if (lsdj_phrase_is_allocated(&song, rhs))
+							REQUIRE_FALSE( getPhrase(song, lhs) == getPhrase(song, rhs) );
+					}
+				}
+			}
+
+			THEN( "The allocated phrases and chains should be compacted" )
+			{
+				bool gap = false;
+				for (uint8_t phrase = 0; phrase < LSDJ_PHRASE_COUNT; phrase++)
+				{
+					if (!lsdj_phrase_is_allocated(&song, phrase))
+						gap = true;
+					else
+						REQUIRE_FALSE( gap );
+				}
+
+				gap = false;
+				for (uint8_t chain = 0; chain < LSDJ_CHAIN_COUNT; chain++)
+				{
+					if (!lsdj_chain_is_allocated(&song, chain))
+						gap = true;
+					else
+						REQUIRE_FALSE( gap );
+				}
+			}
+
+			AND_WHEN( "Deduplicating again" )
+			{
+				THEN( "Nothing should be merged" )
+				{
+					REQUIRE( lsdj_song_deduplicate_phrases(&song) == 0 );
+					REQUIRE( lsdj_song_deduplicate_chains(&song) == 0 );
+				}
+			}
+		}
+	}
+
+	GIVEN( "A new song" )
+	{
+		memcpy(song.bytes, LSDJ_SONG_NEW_BYTES, sizeof(song.bytes));
+
+		WHEN( "Cleaning the song" )
+		{
+			lsdj_song_clean(&song);
+
+			THEN( "It should still equal a new song" )
+			{
+				REQUIRE( memcmp(song.bytes, LSDJ_SONG_NEW_BYTES, sizeof(song.bytes)) == 0 );
+			}
+		}
+	}
+
+	lsdj_sav_free(sav);
+}
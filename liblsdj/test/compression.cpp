@@ -0,0 +1,72 @@
+#include <lsdj/compression.h>
+
+#include <catch2/catch.hpp>
+#include <vector>
+
+#include <lsdj/project.h>
+#include <lsdj/sav.h>
+#include <lsdj/song.h>
+
+using namespace Catch;
+
+//! Compress for real, to check the block count against
+static unsigned int compressAndCountBlocks(const uint8_t* data)
+{
+	std::vector<uint8_t> blocks(LSDJ_BLOCK_COUNT * LSDJ_BLOCK_SIZE);
+
+	lsdj_memory_access_state_t state;
+	state.begin = state.cur = blocks.data();
+	state.size = blocks.size();
+	lsdj_vio_t vio = lsdj_create_memory_vio(&state);
+
+	size_t size = 0;
+	REQUIRE( lsdj_compress(data, &vio, 1, &size) == LSDJ_SUCCESS );
+
+	return static_cast<unsigned int>(size / LSDJ_BLOCK_SIZE);
+}
+
+TEST_CASE( "Counting compressed blocks", "[compression]" )
+{
+	unsigned int count = 0;
+
+	SECTION( "New song" )
+	{
+		REQUIRE( lsdj_compress_count_blocks(LSDJ_SONG_NEW_BYTES, &count) == LSDJ_SUCCESS );
+		REQUIRE( count == compressAndCountBlocks(LSDJ_SONG_NEW_BYTES) );
+	}
+
+	SECTION( "Lsdsng" )
+	{
+		lsdj_project_t* project = nullptr;
+		REQUIRE( lsdj_project_read_lsdsng_from_file(RESOURCES_FOLDER "lsdsng/happy_birthday.lsdsng", &project, nullptr) == LSDJ_SUCCESS );
+
+		const auto song = lsdj_project_get_song_const(project);
+		REQUIRE( lsdj_compress_count_blocks(song->bytes, &count) == LSDJ_SUCCESS );
+		REQUIRE( count == compressAndCountBlocks(song->bytes) );
+
+		// Recompressed, the song makes for a 2569 byte lsdsng: a name, a version and the blocks.
+		// (the file on disk is 3081 bytes, as it was stored in one block more)
+		REQUIRE( count == (2569 - LSDJ_PROJECT_NAME_LENGTH - 1) / LSDJ_BLOCK_SIZE );
+
+		lsdj_project_free(project);
+	}
+
+	SECTION( "Every song in a sav" )
+	{
+		lsdj_sav_t* sav = nullptr;
+		REQUIRE( lsdj_sav_read_from_file(RESOURCES_FOLDER "sav/all.sav", &sav, nullptr) == LSDJ_SUCCESS );
+
+		for (uint8_t i = 0; i < LSDJ_SAV_PROJECT_COUNT; i++)
+		{
+			const auto project = lsdj_sav_get_project_const(sav, i);
+			if (project == nullptr)
+				continue;
+
+			const auto song = lsdj_project_get_song_const(project);
+			REQUIRE( lsdj_compress_count_blocks(song->bytes, &count) == LSDJ_SUCCESS );
+			REQUIRE( count == compressAndCountBlocks(song->bytes) );
+		}
+
+		lsdj_sav_free(sav);
+	}
+}
@@ -0,0 +1,137 @@
+#include <lsdj/diff.h>
+
+#include <catch2/catch.hpp>
+#include <cstring>
+#include <vector>
+
+#include <lsdj/chain.h>
+#include <lsdj/phrase.h>
+#include <lsdj/sav.h>
+#include <lsdj/wave.h>
+
+using namespace Catch;
+
+static std::vector<uint8_t> diff(const lsdj_song_t* from, const lsdj_song_t* to)
+{
+	std::vector<uint8_t> memory(2 * LSDJ_SONG_BYTE_COUNT);
+
+	lsdj_memory_access_state_t state;
+	state.begin = state.cur = memory.data();
+	state.size = memory.size();
+	lsdj_vio_t wvio = lsdj_create_memory_vio(&state);
+
+	size_t writeCounter = 0;
+	REQUIRE( lsdj_song_diff(from, to, &wvio, &writeCounter) == LSDJ_SUCCESS );
+
+	memory.resize(writeCounter);
+	return memory;
+}
+
+static lsdj_error_t patch(const lsdj_song_t* base, std::vector<uint8_t> data, lsdj_song_t* out)
+{
+	lsdj_memory_access_state_t state;
+	state.begin = state.cur = data.data();
+	state.size = data.size();
+	lsdj_vio_t rvio = lsdj_create_memory_vio(&state);
+
+	return lsdj_song_patch(base, &rvio, nullptr, out);
+}
+
+SCENARIO( "Song diffs", "[diff]" )
+{
+	lsdj_sav_t* sav = nullptr;
+	REQUIRE( lsdj_sav_read_from_file(RESOURCES_FOLDER "sav/all.sav", &sav, nullptr) == LSDJ_SUCCESS );
+
+	const auto song0 = lsdj_project_get_song_const(lsdj_sav_get_project_const(sav, 0));
+	const auto song1 = lsdj_project_get_song_const(lsdj_sav_get_project_const(sav, 1));
+
+	lsdj_song_t edited;
+	memcpy(&edited, song0, sizeof(edited));
+
+	lsdj_song_t result;
+
+	GIVEN( "Two identical songs" )
+	{
+		const auto data = diff(song0, &edited);
+
+		THEN( "The diff should only contain a header" )
+		{
+			REQUIRE( data.size() == LSDJ_DIFF_HEADER_SIZE );
+		}
+
+		THEN( "Patching should result in the same song" )
+		{
+			REQUIRE( patch(song0, data, &result) == LSDJ_SUCCESS );
+			REQUIRE( memcmp(result.bytes, song0->bytes, LSDJ_SONG_BYTE_COUNT) == 0 );
+		}
+	}
+
+	GIVEN( "A song with a few small edits" )
+	{
+		lsdj_phrase_set_note(&edited, 0x07, 3, 0x20);
+		lsdj_phrase_set_note(&edited, 0x07, 5, 0x22);
+		lsdj_chain_set_transposition(&edited, 0x02, 0, 0x0C);
+		lsdj_wave_set_silent(&edited, 0x30);
+
+		const auto data = diff(song0, &edited);
+
+		THEN( "The diff should be small, with nearby edits sharing a run" )
+		{
+			// Four runs: both notes, the transposition, the wave and its synth's overwritten flag
+			REQUIRE( data.size() == LSDJ_DIFF_HEADER_SIZE + 4 * 4 + 3 + 1 + 16 + 1 );
+		}
+
+		THEN( "Patching the original should result in the edited song" )
+		{
+			REQUIRE( patch(song0, data, &result) == LSDJ_SUCCESS );
+			REQUIRE( memcmp(result.bytes, edited.bytes, LSDJ_SONG_BYTE_COUNT) == 0 );
+		}
+
+		THEN( "Patching in place should work as well" )
+		{
+			memcpy(&result, song0, sizeof(result));
+			REQUIRE( patch(&result, data, &result) == LSDJ_SUCCESS );
+			REQUIRE( memcmp(result.bytes, edited.bytes, LSDJ_SONG_BYTE_COUNT) == 0 );
+		}
+
+		THEN( "Patching another song should fail" )
+		{
+			REQUIRE( patch(song1, data, &result) == LSDJ_PATCH_BASE_MISMATCH );
+		}
+
+		THEN( "A corrupt diff should be detected" )
+		{
+			auto corrupt = data;
+			corrupt.back() ^= 0xFF;
+			REQUIRE( patch(song0, corrupt, &result) == LSDJ_PATCH_INVALID );
+		}
+
+		THEN( "A corrupt or truncated diff should leave the base song untouched" )
+		{
+			memcpy(result.bytes, song0->bytes, LSDJ_SONG_BYTE_COUNT);
+
+			auto corrupt = data;
+			corrupt.back() ^= 0xFF;
+			REQUIRE( patch(&result, corrupt, &result) == LSDJ_PATCH_INVALID );
+			REQUIRE( memcmp(result.bytes, song0->bytes, LSDJ_SONG_BYTE_COUNT) == 0 );
+
+			auto truncated = data;
+			truncated.pop_back();
+			REQUIRE( patch(&result, truncated, &result) == LSDJ_READ_FAILED );
+			REQUIRE( memcmp(result.bytes, song0->bytes, LSDJ_SONG_BYTE_COUNT) == 0 );
+		}
+	}
+
+	GIVEN( "Two entirely different songs" )
+	{
+		const auto data = diff(song0, song1);
+
+		THEN( "Patching should result in the second song" )
+		{
+			REQUIRE( patch(song0, data, &result) == LSDJ_SUCCESS );
+			REQUIRE( memcmp(result.bytes, song1->bytes, LSDJ_SONG_BYTE_COUNT) == 0 );
+		}
+	}
+
+	lsdj_sav_free(sav);
+}
@@ -0,0 +1,174 @@
+#include <lsdj/events.h>
+
+#include <catch2/catch.hpp>
+#include <cstring>
+
+#include <lsdj/chain.h>
+#include <lsdj/phrase.h>
+#include <lsdj/sav.h>
+
+using namespace Catch;
+
+SCENARIO( "Event streams", "[events]" )
+{
+	lsdj_song_t song;
+	memcpy(song.bytes, LSDJ_SONG_NEW_BYTES, sizeof(song.bytes));
+
+	// Row 0: chain 0, playing phrase 0 (transposed up 2) and phrase 1
+	lsdj_row_set_chain(&song, 0, LSDJ_CHANNEL_PULSE1, 0);
+	lsdj_chain_set_phrase(&song, 0, 0, 0);
+	lsdj_chain_set_transposition(&song, 0, 0, 2);
+	lsdj_chain_set_phrase(&song, 0, 1, 1);
+
+	// Row 1: chain 1, playing phrase 2 (which hops) and phrase 3
+	lsdj_row_set_chain(&song, 1, LSDJ_CHANNEL_PULSE1, 1);
+	lsdj_chain_set_phrase(&song, 1, 0, 2);
+	lsdj_chain_set_phrase(&song, 1, 1, 3);
+
+	lsdj_phrase_set_note(&song, 0, 0, 0x10);
+	lsdj_phrase_set_instrument(&song, 0, 0, 0x00);
+	lsdj_phrase_set_note(&song, 0, 5, 0x20);
+	lsdj_phrase_set_note(&song, 1, 15, 0x30);
+	lsdj_phrase_set_command(&song, 2, 1, LSDJ_COMMAND_H);
+	lsdj_phrase_set_command_value(&song, 2, 1, 0x04);
+	lsdj_phrase_set_note(&song, 3, 4, 0x40);
+
+	lsdj_song_events_t* events = nullptr;
+	REQUIRE( lsdj_song_events_new(&events, nullptr) == LSDJ_SUCCESS );
+
+	bool flattened = false;
+	REQUIRE( lsdj_song_events_update(events, &song, &flattened) == LSDJ_SUCCESS );
+	REQUIRE( flattened );
+
+	GIVEN( "A song with two rows on the first channel" )
+	{
+		WHEN( "Flattening the song" )
+		{
+			THEN( "The channel plays every step until the empty row, following the hop" )
+			{
+				REQUIRE( lsdj_song_events_get_end(events, LSDJ_CHANNEL_PULSE1) == LSDJ_EVENTS_END_LOOP );
+				REQUIRE( lsdj_song_events_get_step_count(events, LSDJ_CHANNEL_PULSE1) == 16 + 16 + 2 + 12 );
+			}
+
+			THEN( "Only the steps that do something become events" )
+			{
+				REQUIRE( lsdj_song_events_get_count(events, LSDJ_CHANNEL_PULSE1) == 5 );
+
+				const lsdj_event_t* stream = lsdj_song_events_get(events, LSDJ_CHANNEL_PULSE1);
+				REQUIRE( stream[0].step == 0 );
+				REQUIRE( stream[0].note == 0x12 );
+				REQUIRE( stream[0].instrument == 0x00 );
+				REQUIRE( stream[1].step == 5 );
+				REQUIRE( stream[1].note == 0x22 );
+				REQUIRE( stream[1].instrument == LSDJ_PHRASE_NO_INSTRUMENT );
+				REQUIRE( stream[2].step == 31 );
+				REQUIRE( stream[2].note == 0x30 );
+				REQUIRE( stream[3].step == 33 );
+				REQUIRE( stream[3].command == LSDJ_COMMAND_H );
+				REQUIRE( stream[3].value == 0x04 );
+				REQUIRE( stream[4].step == 34 );
+				REQUIRE( stream[4].row == 1 );
+				REQUIRE( stream[4].chain == 1 );
+				REQUIRE( stream[4].phrase == 3 );
+				REQUIRE( stream[4].phraseStep == 4 );
+				REQUIRE( stream[4].note == 0x40 );
+			}
+
+			THEN( "Channels without chains don't play" )
+			{
+				REQUIRE( lsdj_song_events_get_count(events, LSDJ_CHANNEL_PULSE2) == 0 );
+				REQUIRE( lsdj_song_events_get_step_count(events, LSDJ_CHANNEL_PULSE2) == 0 );
+				REQUIRE( lsdj_song_events_get_end(events, LSDJ_CHANNEL_PULSE2) == LSDJ_EVENTS_END_STOP );
+			}
+		}
+
+		WHEN( "Adding an HFF command" )
+		{
+			lsdj_phrase_set_command(&song, 3, 6, LSDJ_COMMAND_H);
+			lsdj_phrase_set_command_value(&song, 3, 6, 0xFF);
+			REQUIRE( lsdj_song_events_update(events, &song, &flattened) == LSDJ_SUCCESS );
+
+			THEN( "The channel stops after that step" )
+			{
+				REQUIRE( flattened );
+				REQUIRE( lsdj_song_events_get_end(events, LSDJ_CHANNEL_PULSE1) == LSDJ_EVENTS_END_STOP );
+				REQUIRE( lsdj_song_events_get_step_count(events, LSDJ_CHANNEL_PULSE1) == 16 + 16 + 2 + 3 );
+			}
+		}
+
+		WHEN( "Updating without changes to the playback" )
+		{
+			lsdj_song_set_tempo(&song, 200);
+			REQUIRE( lsdj_song_events_update(events, &song, &flattened) == LSDJ_SUCCESS );
+
+			THEN( "The song isn't flattened again" )
+			{
+				REQUIRE_FALSE( flattened );
+				REQUIRE( lsdj_song_events_get_count(events, LSDJ_CHANNEL_PULSE1) == 5 );
+			}
+		}
+	}
+
+	GIVEN( "A cursor" )
+	{
+		lsdj_song_cursor_t cursor;
+
+		THEN( "It can start in the middle of a block, and loops to its top" )
+		{
+			REQUIRE( lsdj_song_cursor_start(&song, LSDJ_CHANNEL_PULSE1, 1, &cursor) );
+			REQUIRE( cursor.loopRow == 0 );
+			REQUIRE( cursor.phrase == 2 );
+
+			REQUIRE( lsdj_song_cursor_advance(&song, &cursor) == LSDJ_CURSOR_NEXT );
+			REQUIRE( lsdj_song_cursor_advance(&song, &cursor) == LSDJ_CURSOR_NEXT );
+			REQUIRE( cursor.phrase == 3 );
+			REQUIRE( cursor.phraseStep == 4 );
+
+			for (int i = 4; i < 15; i++)
+				REQUIRE( lsdj_song_cursor_advance(&song, &cursor) == LSDJ_CURSOR_NEXT );
+
+			REQUIRE( lsdj_song_cursor_advance(&song, &cursor) == LSDJ_CURSOR_LOOPED );
+			REQUIRE( cursor.row == 0 );
+			REQUIRE( cursor.phrase == 0 );
+			REQUIRE( cursor.transposition == 2 );
+		}
+
+		THEN( "It can't start on an empty row" )
+		{
+			REQUIRE_FALSE( lsdj_song_cursor_start(&song, LSDJ_CHANNEL_PULSE1, 2, &cursor) );
+		}
+	}
+
+	lsdj_song_events_free(events);
+}
+
+TEST_CASE( "Event streams of a real song", "[events]" )
+{
+	lsdj_sav_t* sav = nullptr;
+	REQUIRE( lsdj_sav_read_from_file(RESOURCES_FOLDER "sav/all.sav", &sav, nullptr) == LSDJ_SUCCESS );
+	const lsdj_song_t* song = lsdj_project_get_song_const(lsdj_sav_get_project_const(sav, 0));
+
+	lsdj_song_events_t* events = nullptr;
+	REQUIRE( lsdj_song_events_new(&events, nullptr) == LSDJ_SUCCESS );
+	REQUIRE( lsdj_song_events_update(events, song, nullptr) == LSDJ_SUCCESS );
+
+	// Every event lies within the steps played, in order
+	for (int channel = 0; channel < LSDJ_CHANNEL_COUNT; channel++)
+	{
+		const auto count = lsdj_song_events_get_count(events, static_cast<lsdj_channel_t>(channel));
+		const auto stepCount = lsdj_song_events_get_step_count(events, static_cast<lsdj_channel_t>(channel));
+		const lsdj_event_t* stream = lsdj_song_events_get(events, static_cast<lsdj_channel_t>(channel));
+
+		for (size_t i = 0; i < count; i++)
+		{
+			REQUIRE( stream[i].step < stepCount );
+			if (i > 0)
+				REQUIRE( stream[i].step > stream[i - 1].step );
+		}
+	}
+
+	REQUIRE( lsdj_song_events_get_count(events, LSDJ_CHANNEL_PULSE1) > 0 );
+
+	lsdj_song_events_free(events);
+	lsdj_sav_free(sav);
+}
@@ -0,0 +1,103 @@
+#include <lsdj/fingerprint.h>
+
+#include <catch2/catch.hpp>
+#include <cstring>
+
+#include <lsdj/chain.h>
+#include <lsdj/channel.h>
+#include <lsdj/phrase.h>
+#include <lsdj/sav.h>
+
+using namespace Catch;
+
+TEST_CASE( "Fingerprints", "[fingerprint]" )
+{
+	lsdj_sav_t* sav = nullptr;
+	REQUIRE( lsdj_sav_read_from_file(RESOURCES_FOLDER "sav/all.sav", &sav, nullptr) == LSDJ_SUCCESS );
+
+	lsdj_song_t song;
+	memcpy(&song, lsdj_project_get_song_const(lsdj_sav_get_project_const(sav, 0)), sizeof(song));
+
+	lsdj_fingerprint_t fingerprint;
+	lsdj_song_fingerprint(&song, &fingerprint);
+	REQUIRE( fingerprint.ngramCount > 0 );
+
+	SECTION( "Identical songs" )
+	{
+		lsdj_song_t copy;
+		memcpy(&copy, &song, sizeof(song));
+
+		lsdj_fingerprint_t other;
+		lsdj_song_fingerprint(&copy, &other);
+		REQUIRE( memcmp(&fingerprint, &other, sizeof(fingerprint)) == 0 );
+		REQUIRE( lsdj_fingerprint_similarity(&fingerprint, &other) == 1.0 );
+
+		for (uint8_t band = 0; band < LSDJ_FINGERPRINT_BAND_COUNT; band++)
+			REQUIRE( lsdj_fingerprint_hash_band(&fingerprint, band) == lsdj_fingerprint_hash_band(&other, band) );
+	}
+
+	SECTION( "Transposition doesn't matter" )
+	{
+		lsdj_song_t transposed;
+		memcpy(&transposed, &song, sizeof(song));
+
+		for (uint8_t chain = 0; chain < LSDJ_CHAIN_COUNT; chain++)
+		{
+			for (uint8_t step = 0; step < LSDJ_CHAIN_LENGTH; step++)
+				lsdj_chain_set_transposition(&transposed, chain, step, static_cast<uint8_t>(lsdj_chain_get_transposition(&song, chain, step) + 5));
+		}
+
+		lsdj_fingerprint_t other;
+		lsdj_song_fingerprint(&transposed, &other);
+		REQUIRE( memcmp(&fingerprint, &other, sizeof(fingerprint)) == 0 );
+	}
+
+	SECTION( "Small changes keep songs similar" )
+	{
+		lsdj_song_t changed;
+		memcpy(&changed, &song, sizeof(song));
+
+		// Change a note in the middle of the second phrase the song plays, which changes the intervals on either side of it
+		const auto phrase = lsdj_chain_get_phrase(&song, lsdj_row_get_chain(&song, 0, LSDJ_CHANNEL_PULSE1), 1);
+		unsigned int noteCount = 0;
+		bool found = false;
+		for (uint8_t step = 0; step < LSDJ_PHRASE_LENGTH && !found; step++)
+		{
+			const auto note = lsdj_phrase_get_note(&song, phrase, step);
+			if (note != LSDJ_PHRASE_NO_NOTE && ++noteCount == 2)
+			{
+				lsdj_phrase_set_note(&changed, phrase, step, static_cast<uint8_t>(note + 1));
+				found = true;
+			}
+		}
+		REQUIRE( found );
+
+		lsdj_fingerprint_t other;
+		lsdj_song_fingerprint(&changed, &other);
+
+		const auto similarity = lsdj_fingerprint_similarity(&fingerprint, &other);
+		REQUIRE( similarity < 1.0 );
+		REQUIRE( similarity > 0.5 );
+	}
+
+	SECTION( "Different songs" )
+	{
+		lsdj_fingerprint_t other;
+		lsdj_song_fingerprint(lsdj_project_get_song_const(lsdj_sav_get_project_const(sav, 1)), &other);
+		REQUIRE( other.ngramCount > 0 );
+		REQUIRE( lsdj_fingerprint_similarity(&fingerprint, &other) < 0.5 );
+	}
+
+	SECTION( "Songs without melody" )
+	{
+		lsdj_song_t empty;
+		memcpy(empty.bytes, LSDJ_SONG_NEW_BYTES, sizeof(empty.bytes));
+
+		lsdj_fingerprint_t other;
+		lsdj_song_fingerprint(&empty, &other);
+		REQUIRE( other.ngramCount == 0 );
+		REQUIRE( lsdj_fingerprint_similarity(&other, &other) == 0.0 );
+	}
+
+	lsdj_sav_free(sav);
+}
@@ -0,0 +1,84 @@
+#include <lsdj/hash.h>
+
+#include <catch2/catch.hpp>
+#include <cstring>
+
+#include <lsdj/chain.h>
+#include <lsdj/instrument.h>
+#include <lsdj/phrase.h>
+#include <lsdj/sav.h>
+#include <lsdj/wave.h>
+
+using namespace Catch;
+
+TEST_CASE( "Hashing", "[hash]" )
+{
+	SECTION( "Reference values" )
+	{
+		// Known XXH64 digests
+		REQUIRE( lsdj_hash_bytes("", 0, 0) == 0xEF46DB3751D8E999ULL );
+		REQUIRE( lsdj_hash_bytes("a", 1, 0) == 0xD24EC4F1A98C6E5BULL );
+		REQUIRE( lsdj_hash_bytes("abc", 3, 0) == 0x44BC2CF5AD770999ULL );
+		REQUIRE( lsdj_hash_bytes("Nobody inspects the spammish repetition", 39, 0) == 0xFBCEA83C8A378BF1ULL );
+	}
+
+	lsdj_sav_t* sav = nullptr;
+	REQUIRE( lsdj_sav_read_from_file(RESOURCES_FOLDER "sav/all.sav", &sav, nullptr) == LSDJ_SUCCESS );
+
+	lsdj_song_t song;
+	memcpy(&song, lsdj_project_get_song_const(lsdj_sav_get_project_const(sav, 0)), sizeof(song));
+
+	lsdj_song_t copy;
+	memcpy(&copy, &song, sizeof(song));
+
+	SECTION( "Identical songs hash identically" )
+	{
+		REQUIRE( lsdj_song_hash(&song) == lsdj_song_hash(&copy) );
+		for (int section = 0; section < LSDJ_SONG_SECTION_COUNT; section++)
+			REQUIRE( lsdj_song_hash_section(&song, static_cast<lsdj_song_section_t>(section)) == lsdj_song_hash_section(&copy, static_cast<lsdj_song_section_t>(section)) );
+	}
+
+	SECTION( "Different songs hash differently" )
+	{
+		auto song1 = lsdj_project_get_song_const(lsdj_sav_get_project_const(sav, 1));
+		REQUIRE( lsdj_song_hash(&song) != lsdj_song_hash(song1) );
+	}
+
+	SECTION( "Changes only affect their own section" )
+	{
+		lsdj_phrase_set_note(&copy, 0x07, 0, 0x30);
+
+		REQUIRE( lsdj_song_hash(&song) != lsdj_song_hash(&copy) );
+		REQUIRE( lsdj_song_hash_section(&song, LSDJ_SONG_SECTION_PHRASES) != lsdj_song_hash_section(&copy, LSDJ_SONG_SECTION_PHRASES) );
+		REQUIRE( lsdj_song_hash_section(&song, LSDJ_SONG_SECTION_CHAINS) == lsdj_song_hash_section(&copy, LSDJ_SONG_SECTION_CHAINS) );
+		REQUIRE( lsdj_song_hash_section(&song, LSDJ_SONG_SECTION_WAVES) == lsdj_song_hash_section(&copy, LSDJ_SONG_SECTION_WAVES) );
+
+		REQUIRE( lsdj_phrase_hash(&song, 0x07) != lsdj_phrase_hash(&copy, 0x07) );
+		REQUIRE( lsdj_phrase_hash(&song, 0x08) == lsdj_phrase_hash(&copy, 0x08) );
+	}
+
+	SECTION( "Sections" )
+	{
+		lsdj_wave_set_silent(&copy, 0x10);
+		REQUIRE( lsdj_song_hash_section(&song, LSDJ_SONG_SECTION_WAVES) != lsdj_song_hash_section(&copy, LSDJ_SONG_SECTION_WAVES) );
+
+		lsdj_song_set_tempo(&copy, 200);
+		REQUIRE( lsdj_song_hash_section(&song, LSDJ_SONG_SECTION_SETTINGS) != lsdj_song_hash_section(&copy, LSDJ_SONG_SECTION_SETTINGS) );
+
+		lsdj_row_set_chain(&copy, 10, LSDJ_CHANNEL_WAVE, 0x03);
+		REQUIRE( lsdj_song_hash_section(&song, LSDJ_SONG_SECTION_ROWS) != lsdj_song_hash_section(&copy, LSDJ_SONG_SECTION_ROWS) );
+	}
+
+	SECTION( "Chains and instruments" )
+	{
+		lsdj_chain_set_transposition(&copy, 0x01, 0, 0x0C);
+		REQUIRE( lsdj_chain_hash(&song, 0x01) != lsdj_chain_hash(&copy, 0x01) );
+		REQUIRE( lsdj_chain_hash(&song, 0x02) == lsdj_chain_hash(&copy, 0x02) );
+
+		lsdj_instrument_set_envelope(&copy, 0x02, 0x11);
+		REQUIRE( lsdj_instrument_hash(&song, 0x02) != lsdj_instrument_hash(&copy, 0x02) );
+		REQUIRE( lsdj_instrument_hash(&song, 0x03) == lsdj_instrument_hash(&copy, 0x03) );
+	}
+
+	lsdj_sav_free(sav);
+}
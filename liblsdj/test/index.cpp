@@ -0,0 +1,159 @@
+#include <lsdj/index.h>
+
+#include <algorithm>
+#include <array>
+#include <catch2/catch.hpp>
+#include <cstring>
+
+#include <lsdj/chain.h>
+#include <lsdj/instrument.h>
+#include <lsdj/phrase.h>
+#include <lsdj/sav.h>
+#include <lsdj/table.h>
+
+using namespace Catch;
+
+TEST_CASE( "Song index", "[index]" )
+{
+	lsdj_sav_t* sav = nullptr;
+	REQUIRE( lsdj_sav_read_from_file(RESOURCES_FOLDER "sav/all.sav", &sav, nullptr) == LSDJ_SUCCESS );
+
+	lsdj_song_t song;
+	memcpy(&song, lsdj_project_get_song_const(lsdj_sav_get_project_const(sav, 0)), sizeof(song));
+
+	lsdj_song_index_t* index = nullptr;
+	REQUIRE( lsdj_song_index_new(&song, &index, nullptr) == LSDJ_SUCCESS );
+	REQUIRE( index != nullptr );
+
+	SECTION( "Chains" )
+	{
+		REQUIRE( lsdj_song_index_is_chain_used(index, 0x01) );
+		REQUIRE( lsdj_song_index_is_chain_used(index, 0x04) );
+		REQUIRE_FALSE( lsdj_song_index_is_chain_used(index, 0x05) );
+
+		std::array<uint8_t, LSDJ_INDEX_ROW_COUNT> rows;
+		REQUIRE( lsdj_song_index_get_chain_rows(index, 0x01, LSDJ_CHANNEL_PULSE1, rows.data()) == 1 );
+		REQUIRE( rows[0] == 0 );
+		REQUIRE( lsdj_song_index_get_chain_rows(index, 0x01, LSDJ_CHANNEL_PULSE2, rows.data()) == 0 );
+
+		std::array<uint8_t, LSDJ_CHAIN_LENGTH> phrases;
+		const auto count = lsdj_song_index_get_chain_phrases(index, 0x01, phrases.data());
+		REQUIRE( count > 0 );
+		REQUIRE( std::find(phrases.begin(), phrases.begin() + count, 0x07) != phrases.begin() + count );
+	}
+
+	SECTION( "Phrases" )
+	{
+		REQUIRE( lsdj_song_index_is_phrase_used(index, 0x07) );
+
+		std::array<uint8_t, LSDJ_INDEX_CHAIN_SLOT_COUNT> chains;
+		const auto count = lsdj_song_index_get_phrase_chains(index, 0x07, chains.data());
+		REQUIRE( std::find(chains.begin(), chains.begin() + count, 0x01) != chains.begin() + count );
+
+		std::array<uint8_t, LSDJ_PHRASE_LENGTH> instruments;
+		const auto instrumentCount = lsdj_song_index_get_phrase_instruments(index, 0x16, instruments.data());
+		REQUIRE( instrumentCount >= 2 );
+		REQUIRE( instruments[0] == 0x03 );
+	}
+
+	SECTION( "Instruments" )
+	{
+		REQUIRE( lsdj_song_index_is_instrument_used(index, 0x02) );
+
+		std::array<uint8_t, LSDJ_PHRASE_COUNT> phrases;
+		const auto count = lsdj_song_index_get_instrument_phrases(index, 0x02, phrases.data());
+		REQUIRE( std::find(phrases.begin(), phrases.begin() + count, 0x0C) != phrases.begin() + count );
+	}
+
+	SECTION( "The index matches a full scan" )
+	{
+		for (uint8_t phrase = 0; phrase < LSDJ_PHRASE_COUNT; phrase++)
+		{
+			bool used = false;
+			for (uint8_t chain = 0; chain < LSDJ_INDEX_CHAIN_SLOT_COUNT; chain++)
+			{
+				for (uint8_t step = 0; step < LSDJ_CHAIN_LENGTH; step++)
+					used |= lsdj_chain_get_phrase(&song, chain, step) == phrase;
+			}
+
+			REQUIRE( lsdj_song_index_is_phrase_used(index, phrase) == used );
+		}
+	}
+
+	SECTION( "Updating" )
+	{
+		WHEN( "Placing a phrase in a chain" )
+		{
+			REQUIRE_FALSE( lsdj_song_index_is_phrase_used(index, 0xF0) );
+
+			lsdj_chain_set_phrase(&song, 0x01, 0, 0xF0);
+			lsdj_song_index_update_chain(index, &song, 0x01);
+
+			THEN( "The phrase should be marked as used by that chain" )
+			{
+				std::array<uint8_t, LSDJ_INDEX_CHAIN_SLOT_COUNT> chains;
+				REQUIRE( lsdj_song_index_get_phrase_chains(index, 0xF0, chains.data()) == 1 );
+				REQUIRE( chains[0] == 0x01 );
+			}
+
+			AND_WHEN( "Removing it again" )
+			{
+				lsdj_chain_set_phrase(&song, 0x01, 0, LSDJ_CHAIN_NO_PHRASE);
+				lsdj_song_index_update_chain(index, &song, 0x01);
+
+				THEN( "The phrase should no longer be used" )
+				{
+					REQUIRE_FALSE( lsdj_song_index_is_phrase_used(index, 0xF0) );
+				}
+			}
+		}
+
+		WHEN( "Moving a chain to another row" )
+		{
+			lsdj_row_set_chain(&song, 0, LSDJ_CHANNEL_PULSE1, LSDJ_SONG_NO_CHAIN);
+			lsdj_row_set_chain(&song, 5, LSDJ_CHANNEL_PULSE1, 0x01);
+			lsdj_song_index_update_row(index, &song, 0);
+			lsdj_song_index_update_row(index, &song, 5);
+
+			THEN( "The chain should only be found at the new row" )
+			{
+				std::array<uint8_t, LSDJ_INDEX_ROW_COUNT> rows;
+				REQUIRE( lsdj_song_index_get_chain_rows(index, 0x01, LSDJ_CHANNEL_PULSE1, rows.data()) == 1 );
+				REQUIRE( rows[0] == 5 );
+			}
+		}
+
+		WHEN( "Referring to a table through an A-command" )
+		{
+			REQUIRE( lsdj_phrase_set_command(&song, 0x07, 3, LSDJ_COMMAND_A) );
+			lsdj_phrase_set_command_value(&song, 0x07, 3, 0x1E);
+			lsdj_song_index_update_phrase(index, &song, 0x07);
+
+			THEN( "The table should be used by the phrase" )
+			{
+				REQUIRE( lsdj_song_index_is_table_used(index, 0x1E) );
+
+				std::array<uint8_t, LSDJ_PHRASE_COUNT> phrases;
+				REQUIRE( lsdj_song_index_get_table_phrases(index, 0x1E, phrases.data()) == 1 );
+				REQUIRE( phrases[0] == 0x07 );
+			}
+		}
+
+		WHEN( "Enabling a table on an instrument" )
+		{
+			lsdj_instrument_set_table(&song, 0x10, 0x0D);
+			lsdj_instrument_enable_table(&song, 0x10, true);
+			lsdj_song_index_update_instrument(index, &song, 0x10);
+
+			THEN( "The table should be used by the instrument" )
+			{
+				std::array<uint8_t, LSDJ_INSTRUMENT_COUNT> instruments;
+				REQUIRE( lsdj_song_index_get_table_instruments(index, 0x0D, instruments.data()) == 1 );
+				REQUIRE( instruments[0] == 0x10 );
+			}
+		}
+	}
+
+	lsdj_song_index_free(index);
+	lsdj_sav_free(sav);
+}
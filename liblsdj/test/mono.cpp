@@ -0,0 +1,109 @@
+#include <lsdj/mono.h>
+
+#include <catch2/catch.hpp>
+#include <cstring>
+#include <random>
+
+#include <lsdj/instrument.h>
+#include <lsdj/phrase.h>
+#include <lsdj/sav.h>
+#include <lsdj/table.h>
+
+using namespace Catch;
+
+//! The step-by-step conversion lsdj-mono used to do, to check the bulk kernels against
+static void makeMonoReference(lsdj_song_t& song, unsigned int flags)
+{
+	if (flags & LSDJ_MONO_INSTRUMENTS)
+	{
+		for (uint8_t instrument = 0; instrument < LSDJ_INSTRUMENT_COUNT; instrument++)
+		{
+			if (lsdj_instrument_get_panning(&song, instrument) != LSDJ_PAN_NONE)
+				lsdj_instrument_set_panning(&song, instrument, LSDJ_PAN_LEFT_RIGHT);
+		}
+	}
+
+	if (flags & LSDJ_MONO_TABLES)
+	{
+		for (uint8_t table = 0; table < LSDJ_TABLE_COUNT; table++)
+		{
+			for (uint8_t step = 0; step < LSDJ_TABLE_LENGTH; step++)
+			{
+				if (lsdj_table_get_command1(&song, table, step) == LSDJ_COMMAND_O && lsdj_table_get_command1_value(&song, table, step) != LSDJ_PAN_NONE)
+					lsdj_table_set_command1_value(&song, table, step, LSDJ_PAN_LEFT_RIGHT);
+				if (lsdj_table_get_command2(&song, table, step) == LSDJ_COMMAND_O && lsdj_table_get_command2_value(&song, table, step) != LSDJ_PAN_NONE)
+					lsdj_table_set_command2_value(&song, table, step, LSDJ_PAN_LEFT_RIGHT);
+			}
+		}
+	}
+
+	if (flags & LSDJ_MONO_PHRASES)
+	{
+		for (uint8_t phrase = 0; phrase < LSDJ_PHRASE_COUNT; phrase++)
+		{
+			for (uint8_t step = 0; step < LSDJ_PHRASE_LENGTH; step++)
+			{
+				if (lsdj_phrase_get_command(&song, phrase, step) == LSDJ_COMMAND_O && lsdj_phrase_get_command_value(&song, phrase, step) != LSDJ_PAN_NONE)
+					lsdj_phrase_set_command_value(&song, phrase, step, LSDJ_PAN_LEFT_RIGHT);
+			}
+		}
+	}
+}
+
+static void requireMatchesReference(const lsdj_song_t& song, unsigned int flags)
+{
+	lsdj_song_t expected;
+	memcpy(&expected, &song, sizeof(song));
+	makeMonoReference(expected, flags);
+
+	lsdj_song_t converted;
+	memcpy(&converted, &song, sizeof(song));
+	lsdj_song_make_mono(&converted, flags);
+
+	REQUIRE( memcmp(&converted, &expected, sizeof(song)) == 0 );
+}
+
+TEST_CASE( "Mono", "[mono]" )
+{
+	const unsigned int flags = GENERATE(as<unsigned int>(), LSDJ_MONO_INSTRUMENTS, LSDJ_MONO_TABLES, LSDJ_MONO_PHRASES, LSDJ_MONO_ALL);
+
+	SECTION( "Real songs" )
+	{
+		lsdj_sav_t* sav = nullptr;
+		REQUIRE( lsdj_sav_read_from_file(RESOURCES_FOLDER "sav/all.sav", &sav, nullptr) == LSDJ_SUCCESS );
+
+		for (uint8_t project = 0; project < 2; project++)
+			requireMatchesReference(*lsdj_project_get_song_const(lsdj_sav_get_project_const(sav, project)), flags);
+		requireMatchesReference(*lsdj_sav_get_working_memory_song_const(sav), flags);
+
+		lsdj_sav_free(sav);
+	}
+
+	SECTION( "Random songs, before and after the B-command was added" )
+	{
+		std::mt19937 random(1234);
+		std::uniform_int_distribution<int> commands(0, 23);
+		std::uniform_int_distribution<int> bytes(0, 255);
+
+		for (uint8_t formatVersion : { uint8_t(7), uint8_t(8) })
+		{
+			lsdj_song_t song;
+			for (auto& byte : song.bytes)
+				byte = static_cast<uint8_t>(bytes(random));
+
+			// Squash the values down, so plenty of them are O__ and plenty of commands are O
+			for (auto& byte : song.bytes)
+				byte = static_cast<uint8_t>(byte % 4 == 0 ? 0 : byte);
+			for (size_t i = 0; i < 0x200; i++)
+			{
+				song.bytes[0x3680 + i] = static_cast<uint8_t>(commands(random));
+				song.bytes[0x3A80 + i] = static_cast<uint8_t>(commands(random));
+			}
+			for (size_t i = 0x4000; i < 0x4FF0; i++)
+				song.bytes[i] = static_cast<uint8_t>(commands(random));
+
+			song.bytes[0x7FFF] = formatVersion;
+			requireMatchesReference(song, flags);
+		}
+	}
+}
@@ -0,0 +1,194 @@
+#include <lsdj/pack.h>
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <random>
+
+#include <lsdj/phrase.h>
+#include <lsdj/sav.h>
+
+using namespace Catch;
+
+TEST_CASE( "Packs", "[pack]" )
+{
+	lsdj_sav_t* sav = nullptr;
+	REQUIRE( lsdj_sav_read_from_file(RESOURCES_FOLDER "sav/all.sav", &sav, nullptr) == LSDJ_SUCCESS );
+
+	const lsdj_project_t* project0 = lsdj_sav_get_project_const(sav, 0);
+	const lsdj_project_t* project1 = lsdj_sav_get_project_const(sav, 1);
+
+	FILE* file = tmpfile();
+	REQUIRE( file != nullptr );
+	lsdj_vio_t vio = lsdj_create_file_vio(file);
+
+	lsdj_pack_t* pack = nullptr;
+	REQUIRE( lsdj_pack_open(&vio, &pack, nullptr) == LSDJ_SUCCESS );
+	REQUIRE( lsdj_pack_get_song_count(pack) == 0 );
+
+	size_t newChunkCount = 0;
+	REQUIRE( lsdj_pack_append_project(pack, project0, &newChunkCount) == LSDJ_SUCCESS );
+	REQUIRE( lsdj_pack_append_project(pack, project1, &newChunkCount) == LSDJ_SUCCESS );
+	REQUIRE( lsdj_pack_get_song_count(pack) == 2 );
+	REQUIRE( lsdj_pack_get_chunk_count(pack) == newChunkCount );
+
+	// Most of a song is empty phrases, chains and such, which are all the same chunk
+	REQUIRE( newChunkCount < LSDJ_PACK_SONG_CHUNK_COUNT );
+
+	SECTION( "Reading songs back" )
+	{
+		lsdj_song_t song;
+		REQUIRE( lsdj_pack_read_song(pack, 0, &song) == LSDJ_SUCCESS );
+		REQUIRE( memcmp(song.bytes, lsdj_project_get_song_const(project0)->bytes, sizeof(song.bytes)) == 0 );
+		REQUIRE( lsdj_pack_read_song(pack, 1, &song) == LSDJ_SUCCESS );
+		REQUIRE( memcmp(song.bytes, lsdj_project_get_song_const(project1)->bytes, sizeof(song.bytes)) == 0 );
+
+		REQUIRE( lsdj_pack_read_song(pack, 2, &song) == LSDJ_NO_PROJECT_AT_INDEX );
+	}
+
+	SECTION( "Reading projects back" )
+	{
+		lsdj_project_t* project = nullptr;
+		REQUIRE( lsdj_pack_read_project(pack, 1, &project, nullptr) == LSDJ_SUCCESS );
+		REQUIRE( strncmp(lsdj_project_get_name(project), lsdj_project_get_name(project1), LSDJ_PROJECT_NAME_LENGTH) == 0 );
+		REQUIRE( lsdj_project_get_version(project) == lsdj_project_get_version(project1) );
+		REQUIRE( memcmp(lsdj_project_get_song_const(project)->bytes, lsdj_project_get_song_const(project1)->bytes, LSDJ_SONG_BYTE_COUNT) == 0 );
+		lsdj_project_free(project);
+	}
+
+	SECTION( "Identical songs are stored once" )
+	{
+		newChunkCount = 0;
+		REQUIRE( lsdj_pack_append_project(pack, project0, &newChunkCount) == LSDJ_SUCCESS );
+		REQUIRE( newChunkCount == 0 );
+
+		// A single changed phrase only adds that phrase
+		lsdj_project_t* project = nullptr;
+		REQUIRE( lsdj_project_copy(project0, &project, nullptr) == LSDJ_SUCCESS );
+		lsdj_phrase_set_note(lsdj_project_get_song(project), 0x30, 0, 0x20);
+		REQUIRE( lsdj_pack_append_project(pack, project, &newChunkCount) == LSDJ_SUCCESS );
+		REQUIRE( newChunkCount == 1 );
+
+		lsdj_song_t song;
+		REQUIRE( lsdj_pack_read_song(pack, 3, &song) == LSDJ_SUCCESS );
+		REQUIRE( memcmp(song.bytes, lsdj_project_get_song_const(project)->bytes, sizeof(song.bytes)) == 0 );
+		lsdj_project_free(project);
+	}
+
+	SECTION( "Chunks cover every byte of a song" )
+	{
+		lsdj_project_t* project = nullptr;
+		REQUIRE( lsdj_project_new(&project, nullptr) == LSDJ_SUCCESS );
+
+		std::mt19937 random(1234);
+		std::uniform_int_distribution<int> bytes(0, 255);
+		for (auto& byte : lsdj_project_get_song(project)->bytes)
+			byte = static_cast<uint8_t>(bytes(random));
+
+		REQUIRE( lsdj_pack_append_project(pack, project, nullptr) == LSDJ_SUCCESS );
+
+		lsdj_song_t song;
+		memset(song.bytes, 0, sizeof(song.bytes));
+		REQUIRE( lsdj_pack_read_song(pack, 2, &song) == LSDJ_SUCCESS );
+		REQUIRE( memcmp(song.bytes, lsdj_project_get_song_const(project)->bytes, sizeof(song.bytes)) == 0 );
+		lsdj_project_free(project);
+	}
+
+	SECTION( "Reopening" )
+	{
+		lsdj_pack_free(pack);
+		REQUIRE( lsdj_pack_open(&vio, &pack, nullptr) == LSDJ_SUCCESS );
+		REQUIRE( lsdj_pack_get_song_count(pack) == 2 );
+		REQUIRE( lsdj_pack_get_chunk_count(pack) == newChunkCount );
+
+		lsdj_song_t song;
+		REQUIRE( lsdj_pack_read_song(pack, 1, &song) == LSDJ_SUCCESS );
+		REQUIRE( memcmp(song.bytes, lsdj_project_get_song_const(project1)->bytes, sizeof(song.bytes)) == 0 );
+	}
+
+	SECTION( "Songs that were cut off are ignored" )
+	{
+		lsdj_pack_free(pack);
+
+		// Half a song record, as if appending crashed
+		const uint8_t partial[] = { 'S', 0x40, 0x02, 0x12, 0x34 };
+		REQUIRE( fseek(file, 0, SEEK_END) == 0 );
+		REQUIRE( fwrite(partial, 1, sizeof(partial), file) == sizeof(partial) );
+
+		REQUIRE( lsdj_pack_open(&vio, &pack, nullptr) == LSDJ_SUCCESS );
+		REQUIRE( lsdj_pack_get_song_count(pack) == 2 );
+
+		// The next append overwrites it
+		REQUIRE( lsdj_pack_append_project(pack, project1, nullptr) == LSDJ_SUCCESS );
+		lsdj_pack_free(pack);
+
+		REQUIRE( lsdj_pack_open(&vio, &pack, nullptr) == LSDJ_SUCCESS );
+		REQUIRE( lsdj_pack_get_song_count(pack) == 3 );
+
+		lsdj_song_t song;
+		REQUIRE( lsdj_pack_read_song(pack, 2, &song) == LSDJ_SUCCESS );
+		REQUIRE( memcmp(song.bytes, lsdj_project_get_song_const(project1)->bytes, sizeof(song.bytes)) == 0 );
+	}
+
+	SECTION( "Chunks that were torn are ignored" )
+	{
+		lsdj_pack_free(pack);
+
+		// A phrase chunk record whose contents never made it to disk, as if appending crashed
+		uint8_t torn[10 + 64] = { 'C', 0, 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0 };
+		REQUIRE( fseek(file, 0, SEEK_END) == 0 );
+		REQUIRE( fwrite(torn, 1, sizeof(torn), file) == sizeof(torn) );
+
+		REQUIRE( lsdj_pack_open(&vio, &pack, nullptr) == LSDJ_SUCCESS );
+		REQUIRE( lsdj_pack_get_chunk_count(pack) == newChunkCount );
+
+		// The next append overwrites it
+		lsdj_project_t* project = nullptr;
+		REQUIRE( lsdj_project_copy(project0, &project, nullptr) == LSDJ_SUCCESS );
+		lsdj_phrase_set_note(lsdj_project_get_song(project), 0x30, 0, 0x20);
+		REQUIRE( lsdj_pack_append_project(pack, project, nullptr) == LSDJ_SUCCESS );
+		lsdj_pack_free(pack);
+
+		REQUIRE( lsdj_pack_open(&vio, &pack, nullptr) == LSDJ_SUCCESS );
+		REQUIRE( lsdj_pack_get_chunk_count(pack) == newChunkCount + 1 );
+
+		lsdj_song_t song;
+		REQUIRE( lsdj_pack_read_song(pack, 2, &song) == LSDJ_SUCCESS );
+		REQUIRE( memcmp(song.bytes, lsdj_project_get_song_const(project)->bytes, sizeof(song.bytes)) == 0 );
+		lsdj_project_free(project);
+	}
+
+	SECTION( "Corrupt chunks are detected when reading" )
+	{
+		// The first byte of the first chunk, which is part of the first song
+		REQUIRE( fseek(file, 8 + 10, SEEK_SET) == 0 );
+		const int byte = fgetc(file);
+		REQUIRE( fseek(file, 8 + 10, SEEK_SET) == 0 );
+		REQUIRE( fputc(byte ^ 0xFF, file) != EOF );
+
+		lsdj_song_t song;
+		memset(song.bytes, 0, sizeof(song.bytes));
+		REQUIRE( lsdj_pack_read_song(pack, 0, &song) == LSDJ_PACK_INVALID );
+
+		// The song is left untouched
+		REQUIRE( std::all_of(std::begin(song.bytes), std::end(song.bytes), [](uint8_t byte){ return byte == 0; }) );
+	}
+
+	SECTION( "Other data isn't a pack" )
+	{
+		lsdj_pack_free(pack);
+		pack = nullptr;
+
+		REQUIRE( fseek(file, 0, SEEK_SET) == 0 );
+		REQUIRE( fputc('X', file) != EOF );
+
+		lsdj_pack_t* other = nullptr;
+		REQUIRE( lsdj_pack_open(&vio, &other, nullptr) == LSDJ_PACK_INVALID );
+	}
+
+	lsdj_pack_free(pack);
+	fclose(file);
+	lsdj_sav_free(sav);
+}
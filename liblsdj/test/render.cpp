@@ -0,0 +1,107 @@
+#include <lsdj/render.h>
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <cstring>
+#include <vector>
+
+#include <lsdj/hash.h>
+#include <lsdj/sav.h>
+
+using namespace Catch;
+
+static std::vector<int16_t> render(const lsdj_song_t* song, unsigned int sampleRate, unsigned int channelMask)
+{
+	lsdj_renderer_t* renderer = nullptr;
+	REQUIRE( lsdj_renderer_new(song, sampleRate, &renderer, nullptr) == LSDJ_SUCCESS );
+	lsdj_renderer_set_channel_mask(renderer, channelMask);
+
+	// Render in odd-sized chunks, so block boundaries don't line up with ticks
+	std::vector<int16_t> samples;
+	std::vector<int16_t> chunk(1000 * LSDJ_RENDER_FRAME_SAMPLE_COUNT);
+	size_t count;
+	while ((count = lsdj_renderer_render(renderer, chunk.data(), 1000)) > 0)
+		samples.insert(samples.end(), chunk.begin(), chunk.begin() + count * LSDJ_RENDER_FRAME_SAMPLE_COUNT);
+
+	lsdj_renderer_free(renderer);
+	return samples;
+}
+
+SCENARIO( "Rendering songs", "[render]" )
+{
+	GIVEN( "A new song" )
+	{
+		lsdj_song_t song;
+		memcpy(song.bytes, LSDJ_SONG_NEW_BYTES, sizeof(song.bytes));
+
+		THEN( "Nothing is rendered" )
+		{
+			REQUIRE( lsdj_render_get_frame_count(&song, 44100) == 0 );
+			REQUIRE( render(&song, 44100, LSDJ_RENDER_ALL_CHANNELS).empty() );
+		}
+	}
+
+	GIVEN( "A song with notes" )
+	{
+		lsdj_sav_t* sav = nullptr;
+		REQUIRE( lsdj_sav_read_from_file(RESOURCES_FOLDER "sav/all.sav", &sav, nullptr) == LSDJ_SUCCESS );
+		const lsdj_song_t* song = lsdj_project_get_song_const(lsdj_sav_get_project_const(sav, 0));
+
+		const unsigned int sampleRate = 22050;
+		const auto samples = render(song, sampleRate, LSDJ_RENDER_ALL_CHANNELS);
+
+		THEN( "The whole song is rendered, and isn't silent" )
+		{
+			REQUIRE( samples.size() == lsdj_render_get_frame_count(song, sampleRate) * LSDJ_RENDER_FRAME_SAMPLE_COUNT );
+			REQUIRE( std::any_of(samples.begin(), samples.end(), [](int16_t sample){ return sample != 0; }) );
+		}
+
+		THEN( "Rendering is deterministic" )
+		{
+			REQUIRE( render(song, sampleRate, LSDJ_RENDER_ALL_CHANNELS) == samples );
+		}
+
+		THEN( "Rendering channels separately adds up to the full mix" )
+		{
+			std::vector<int32_t> sum(samples.size(), 0);
+			for (unsigned int channel = 0; channel < 4; channel++)
+			{
+				const auto channelSamples = render(song, sampleRate, 1u << channel);
+				REQUIRE( channelSamples.size() == samples.size() );
+				for (size_t i = 0; i < samples.size(); i++)
+					sum[i] += channelSamples[i];
+			}
+
+			REQUIRE( std::equal(sum.begin(), sum.end(), samples.begin()) );
+		}
+
+		WHEN( "Writing a WAV file" )
+		{
+			std::vector<uint8_t> memory(44 + samples.size() * sizeof(int16_t));
+			lsdj_memory_access_state_t state;
+			state.begin = state.cur = memory.data();
+			state.size = memory.size();
+			lsdj_vio_t wvio = lsdj_create_memory_vio(&state);
+
+			size_t writeCounter = 0;
+			REQUIRE( lsdj_render_wav(song, sampleRate, LSDJ_RENDER_ALL_CHANNELS, &wvio, &writeCounter, nullptr) == LSDJ_SUCCESS );
+
+			THEN( "It contains a header and the rendered samples" )
+			{
+				REQUIRE( writeCounter == memory.size() );
+				REQUIRE( memcmp(memory.data(), "RIFF", 4) == 0 );
+				REQUIRE( memcmp(memory.data() + 8, "WAVEfmt ", 8) == 0 );
+				REQUIRE( memcmp(memory.data() + 36, "data", 4) == 0 );
+				REQUIRE( memory[44] == (samples[0] & 0xFF) );
+				REQUIRE( memory[45] == ((samples[0] >> 8) & 0xFF) );
+			}
+
+			THEN( "It matches the reference render" )
+			{
+				REQUIRE( lsdj_hash_bytes(memory.data(), memory.size(), 0) == 0x0B7D9F8150BAB3C2 );
+			}
+		}
+
+		lsdj_sav_free(sav);
+	}
+}
@@ -332,6 +332,16 @@ TEST_CASE( ".sav save/load", "[sav]" )
 		lsdj_sav_free(compSav);
 	}
 
+	SECTION( "Reading something that isn't a sav" )
+	{
+		lsdj_sav_t* sav = nullptr;
+		REQUIRE( lsdj_sav_read_from_memory(raw.data(), raw.size(), &sav, nullptr) != LSDJ_SUCCESS );
+		REQUIRE( sav == nullptr );
+
+		// Callers that free on failure shouldn't free twice
+		lsdj_sav_free(sav);
+	}
+
 	SECTION( "Checking sav likelihood" )
 	{
         const auto lsdsng = readFileContents(RESOURCES_FOLDER "lsdsng/happy_birthday.lsdsng");
@@ -0,0 +1,207 @@
+#include <lsdj/synth.h>
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <lsdj/project.h>
+#include <lsdj/sav.h>
+#include <lsdj/song.h>
+
+using namespace Catch;
+
+static int get_level(const uint8_t* wave, size_t sample)
+{
+	return sample % 2 == 0 ? wave[sample / 2] >> 4 : wave[sample / 2] & 0x0F;
+}
+
+SCENARIO( "Generating synth waves", "[synth]" )
+{
+	lsdj_song_t song;
+	memcpy(song.bytes, LSDJ_SONG_NEW_BYTES, sizeof(song.bytes));
+
+	uint8_t waves[LSDJ_SYNTH_WAVE_COUNT][LSDJ_WAVE_BYTE_COUNT];
+
+	GIVEN( "A synth with default parameters" )
+	{
+		lsdj_synth_render_waves(&song, 0, waves);
+
+		THEN( "It matches the default wave LSDJ generates" )
+		{
+			for (uint8_t wave = 0; wave < LSDJ_SYNTH_WAVE_COUNT; ++wave)
+				REQUIRE( memcmp(waves[wave], lsdj_wave_get_bytes_const(&song, wave), LSDJ_WAVE_BYTE_COUNT) == 0 );
+		}
+	}
+
+	GIVEN( "A synth sweeping its volume down to zero" )
+	{
+		lsdj_synth_set_volume_start(&song, 1, 0x20);
+		lsdj_synth_set_volume_end(&song, 1, 0x00);
+		lsdj_synth_render_waves(&song, 1, waves);
+
+		THEN( "The first wave is loud and the last one is silent" )
+		{
+			int lowest = 0xF, highest = 0;
+			for (size_t sample = 0; sample < LSDJ_WAVE_BYTE_COUNT * 2; ++sample)
+			{
+				lowest = std::min(lowest, get_level(waves[0], sample));
+				highest = std::max(highest, get_level(waves[0], sample));
+				
+				const int level = get_level(waves[LSDJ_SYNTH_WAVE_COUNT - 1], sample);
+				REQUIRE( (level == 7 || level == 8) );
+			}
+			
+			REQUIRE( highest - lowest >= 12 );
+		}
+	}
+
+	GIVEN( "An unfiltered square wave" )
+	{
+		lsdj_synth_set_waveform(&song, 2, LSDJ_SYNTH_WAVEFORM_SQUARE);
+		lsdj_synth_set_volume_start(&song, 2, 0x08);
+		lsdj_synth_set_volume_end(&song, 2, 0x08);
+		lsdj_synth_set_filter(&song, 2, LSDJ_SYNTH_FILTER_ALL_PASS);
+		lsdj_synth_render_waves(&song, 2, waves);
+
+		THEN( "The first half is high and the second half low" )
+		{
+			REQUIRE( get_level(waves[0], 8) > 8 );
+			REQUIRE( get_level(waves[0], 24) < 7 );
+		}
+
+		THEN( "Parameters without a sweep produce identical waves" )
+		{
+			for (size_t wave = 1; wave < LSDJ_SYNTH_WAVE_COUNT; ++wave)
+				REQUIRE( memcmp(waves[0], waves[wave], LSDJ_WAVE_BYTE_COUNT) == 0 );
+		}
+	}
+
+	GIVEN( "A clipping synth" )
+	{
+		lsdj_synth_set_volume_start(&song, 3, 0xFF);
+		lsdj_synth_set_volume_end(&song, 3, 0xFF);
+		lsdj_synth_set_limit_start(&song, 3, 0x7);
+		lsdj_synth_set_limit_end(&song, 3, 0x7);
+		lsdj_synth_render_waves(&song, 3, waves);
+
+		THEN( "The wave stays within the limit" )
+		{
+			for (size_t sample = 0; sample < LSDJ_WAVE_BYTE_COUNT * 2; ++sample)
+			{
+				const int level = get_level(waves[0], sample);
+				REQUIRE( level >= 4 );
+				REQUIRE( level <= 11 );
+			}
+		}
+	}
+
+	GIVEN( "A synth whose waves are written to the song" )
+	{
+		lsdj_synth_set_cutoff_end(&song, 4, 0x20);
+		lsdj_synth_render_waves(&song, 4, waves);
+		lsdj_synth_write_waves(&song, 4);
+
+		THEN( "The synth's waves are replaced and flagged as overwritten" )
+		{
+			for (uint8_t wave = 0; wave < LSDJ_SYNTH_WAVE_COUNT; ++wave)
+				REQUIRE( memcmp(lsdj_wave_get_bytes_const(&song, 4 * LSDJ_SYNTH_WAVE_COUNT + wave), waves[wave], LSDJ_WAVE_BYTE_COUNT) == 0 );
+
+			REQUIRE( lsdj_synth_is_wave_overwritten(&song, 4) );
+			REQUIRE_FALSE( lsdj_synth_is_wave_overwritten(&song, 3) );
+		}
+
+		THEN( "The neighbouring synths' waves are left alone" )
+		{
+			REQUIRE( memcmp(lsdj_wave_get_bytes_const(&song, 4 * LSDJ_SYNTH_WAVE_COUNT - 1), LSDJ_SONG_NEW_BYTES + 0x6000, LSDJ_WAVE_BYTE_COUNT) == 0 );
+			REQUIRE( memcmp(lsdj_wave_get_bytes_const(&song, 5 * LSDJ_SYNTH_WAVE_COUNT), LSDJ_SONG_NEW_BYTES + 0x6000, LSDJ_WAVE_BYTE_COUNT) == 0 );
+		}
+	}
+}
+
+//! Compare the generated waves of every synth in a song against the ones LSDJ generated
+/*! Synths with default parameters have to match exactly, the samples of the others are counted */
+static void compare_synths(const lsdj_song_t* song, bool handDrawn, size_t& sampleCount, size_t& exactCount)
+{
+	lsdj_song_t newSong;
+	memcpy(newSong.bytes, LSDJ_SONG_NEW_BYTES, sizeof(newSong.bytes));
+
+	uint8_t defaultWaves[LSDJ_SYNTH_WAVE_COUNT][LSDJ_WAVE_BYTE_COUNT];
+	lsdj_synth_render_waves(&newSong, 0, defaultWaves);
+
+	for (uint8_t synth = 0; synth < LSDJ_SYNTH_COUNT; ++synth)
+	{
+		// Waves that were overwritten didn't come from the synth
+		if (lsdj_synth_is_wave_overwritten(song, synth) || (handDrawn && synth < 2))
+			continue;
+
+		uint8_t waves[LSDJ_SYNTH_WAVE_COUNT][LSDJ_WAVE_BYTE_COUNT];
+		lsdj_synth_render_waves(song, synth, waves);
+
+		const bool isDefault = memcmp(waves, defaultWaves, sizeof(waves)) == 0;
+		const int volumeStart = lsdj_synth_get_volume_start(song, synth);
+		const int volumeEnd = lsdj_synth_get_volume_end(song, synth);
+
+		for (uint8_t wave = 0; wave < LSDJ_SYNTH_WAVE_COUNT; ++wave)
+		{
+			const uint8_t* expected = lsdj_wave_get_bytes_const(song, (uint8_t)(synth * LSDJ_SYNTH_WAVE_COUNT + wave));
+			if (isDefault)
+			{
+				REQUIRE( memcmp(waves[wave], expected, LSDJ_WAVE_BYTE_COUNT) == 0 );
+				continue;
+			}
+
+			// From a volume of 0x30 LSDJ overflows internally, garbling part of the peak
+			if (volumeStart + (volumeEnd - volumeStart) * wave / LSDJ_SYNTH_WAVE_COUNT >= 0x30)
+				continue;
+
+			for (size_t sample = 0; sample < LSDJ_WAVE_BYTE_COUNT * 2; ++sample)
+			{
+				const int difference = std::abs(get_level(waves[wave], sample) - get_level(expected, sample));
+				REQUIRE( difference <= 2 );
+
+				sampleCount++;
+				if (difference == 0)
+					exactCount++;
+			}
+		}
+	}
+}
+
+TEST_CASE( "Generated synth waves match LSDJ", "[synth]" )
+{
+	const char* files[] = {
+		"all.sav", "happy_birthday.sav", "lsdj499.sav", "lsdj620.sav", "lsdj668.sav", "lsdj671.sav",
+		"lsdj690.sav", "lsdj732.sav", "lsdj790.sav", "lsdj798.sav", "lsdj834.sav", "lsdj888.sav"
+	};
+
+	size_t sampleCount = 0;
+	size_t exactCount = 0;
+
+	for (const char* file : files)
+	{
+		lsdj_sav_t* sav = nullptr;
+		REQUIRE( lsdj_sav_read_from_file((std::string(RESOURCES_FOLDER "sav/") + file).c_str(), &sav, nullptr) == LSDJ_SUCCESS );
+
+		// The song saved with every LSDJ version has hand-drawn waves in its first two
+		// synths, but LSDJ never flagged them as overwritten
+		const bool handDrawn = strncmp(file, "lsdj", 4) == 0;
+
+		compare_synths(lsdj_sav_get_working_memory_song_const(sav), handDrawn, sampleCount, exactCount);
+
+		for (uint8_t i = 0; i < LSDJ_SAV_PROJECT_COUNT; ++i)
+		{
+			const lsdj_project_t* project = lsdj_sav_get_project_const(sav, i);
+			if (project)
+				compare_synths(lsdj_project_get_song_const(project), handDrawn, sampleCount, exactCount);
+		}
+
+		lsdj_sav_free(sav);
+	}
+
+	// The model isn't bit-exact for filtered, resonant or phase compressed synths yet,
+	// but at least three quarters of their samples are
+	REQUIRE( sampleCount > 0 );
+	REQUIRE( exactCount * 4 >= sampleCount * 3 );
+}
@@ -0,0 +1,140 @@
+#include <lsdj/timing.h>
+
+#include <catch2/catch.hpp>
+#include <cstring>
+
+#include <lsdj/chain.h>
+#include <lsdj/groove.h>
+#include <lsdj/phrase.h>
+#include <lsdj/sav.h>
+
+using namespace Catch;
+
+SCENARIO( "Song timing", "[timing]" )
+{
+	lsdj_song_t song;
+	memcpy(song.bytes, LSDJ_SONG_NEW_BYTES, sizeof(song.bytes));
+
+	// At 120 BPM, a tick lasts 1/48th of a second
+	REQUIRE( lsdj_song_set_tempo(&song, 120) );
+
+	lsdj_groove_set_step(&song, 0, 0, 6);
+	lsdj_groove_set_step(&song, 0, 1, 6);
+	lsdj_groove_set_step(&song, 0, 2, LSDJ_GROOVE_NO_VALUE);
+
+	// The first channel plays a single phrase of 16 steps, in groove 0
+	lsdj_row_set_chain(&song, 0, LSDJ_CHANNEL_PULSE1, 0);
+	lsdj_chain_set_phrase(&song, 0, 0, 0);
+
+	GIVEN( "A song with one phrase at a steady tempo" )
+	{
+		lsdj_song_timing_t timing;
+		lsdj_song_time(&song, &timing, nullptr);
+
+		THEN( "The phrase takes 96 ticks, or two seconds" )
+		{
+			REQUIRE( timing.tickCount == 96 );
+			REQUIRE( timing.duration == Detail::Approx(2.0) );
+			REQUIRE( timing.loops );
+		}
+	}
+
+	GIVEN( "A second channel with a faster groove, and a tempo change halfway" )
+	{
+		// The second channel plays the same chain twice, switching to a groove of 3 ticks per step
+		lsdj_row_set_chain(&song, 0, LSDJ_CHANNEL_PULSE2, 1);
+		lsdj_row_set_chain(&song, 1, LSDJ_CHANNEL_PULSE2, 1);
+		lsdj_chain_set_phrase(&song, 1, 0, 1);
+		lsdj_phrase_set_command(&song, 1, 0, LSDJ_COMMAND_G);
+		lsdj_phrase_set_command_value(&song, 1, 0, 1);
+		lsdj_groove_set_step(&song, 1, 0, 3);
+		lsdj_groove_set_step(&song, 1, 1, LSDJ_GROOVE_NO_VALUE);
+
+		// The first channel doubles the tempo halfway its phrase
+		lsdj_phrase_set_command(&song, 0, 8, LSDJ_COMMAND_T);
+		lsdj_phrase_set_command_value(&song, 0, 8, 240);
+
+		lsdj_song_timing_t timing;
+		double rowTimes[LSDJ_CHANNEL_COUNT][LSDJ_TIMING_ROW_COUNT];
+		lsdj_song_time(&song, &timing, rowTimes);
+
+		THEN( "The second half plays twice as fast" )
+		{
+			REQUIRE( timing.tickCount == 96 );
+			REQUIRE( timing.duration == Detail::Approx(1.5) );
+		}
+
+		THEN( "Every played row gets its start time" )
+		{
+			REQUIRE( rowTimes[LSDJ_CHANNEL_PULSE1][0] == Detail::Approx(0.0) );
+			REQUIRE( rowTimes[LSDJ_CHANNEL_PULSE1][1] == LSDJ_TIMING_NOT_PLAYED );
+			REQUIRE( rowTimes[LSDJ_CHANNEL_PULSE2][1] == Detail::Approx(1.0) );
+			REQUIRE( rowTimes[LSDJ_CHANNEL_WAVE][0] == LSDJ_TIMING_NOT_PLAYED );
+		}
+
+		THEN( "A timer reports the steps in order of time" )
+		{
+			lsdj_song_timer_t timer;
+			REQUIRE( lsdj_song_timer_start(&song, &timer) );
+
+			lsdj_timed_step_t step;
+			uint32_t previousTick = 0;
+			unsigned int counts[LSDJ_CHANNEL_COUNT] = { 0, 0, 0, 0 };
+			while (lsdj_song_timer_next(&song, &timer, &step))
+			{
+				REQUIRE( step.tick >= previousTick );
+				previousTick = step.tick;
+				counts[step.channel]++;
+
+				if (step.channel == LSDJ_CHANNEL_PULSE2)
+					REQUIRE( step.tickCount == 3 );
+			}
+
+			REQUIRE( counts[LSDJ_CHANNEL_PULSE1] == 16 );
+			REQUIRE( counts[LSDJ_CHANNEL_PULSE2] == 32 );
+			REQUIRE( timer.tick == 96 );
+		}
+	}
+
+	GIVEN( "A song that stops with HFF" )
+	{
+		lsdj_phrase_set_command(&song, 0, 3, LSDJ_COMMAND_H);
+		lsdj_phrase_set_command_value(&song, 0, 3, 0xFF);
+
+		lsdj_song_timing_t timing;
+		lsdj_song_time(&song, &timing, nullptr);
+
+		THEN( "The song ends after that step" )
+		{
+			REQUIRE( timing.tickCount == 24 );
+			REQUIRE( timing.duration == Detail::Approx(0.5) );
+			REQUIRE_FALSE( timing.loops );
+		}
+	}
+}
+
+TEST_CASE( "Timing a batch of songs", "[timing]" )
+{
+	lsdj_sav_t* sav = nullptr;
+	REQUIRE( lsdj_sav_read_from_file(RESOURCES_FOLDER "sav/all.sav", &sav, nullptr) == LSDJ_SUCCESS );
+
+	const lsdj_song_t* songs[] = {
+		lsdj_project_get_song_const(lsdj_sav_get_project_const(sav, 0)),
+		lsdj_project_get_song_const(lsdj_sav_get_project_const(sav, 1))
+	};
+
+	lsdj_song_timing_t timings[2];
+	lsdj_song_time_batch(songs, 2, timings);
+
+	for (int i = 0; i < 2; i++)
+	{
+		lsdj_song_timing_t timing;
+		lsdj_song_time(songs[i], &timing, nullptr);
+
+		REQUIRE( timings[i].tickCount == timing.tickCount );
+		REQUIRE( timings[i].duration == timing.duration );
+		REQUIRE( timings[i].duration > 0.0 );
+	}
+
+	lsdj_sav_free(sav);
+}
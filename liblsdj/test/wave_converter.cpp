@@ -0,0 +1,132 @@
+#include <lsdj/wave_converter.h>
+
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace Catch;
+
+static int get_level(const uint8_t* wave, size_t step)
+{
+	return step % 2 == 0 ? wave[step / 2] >> 4 : wave[step / 2] & 0x0F;
+}
+
+static std::vector<float> make_sine(size_t length, double harmonic, float amplitude, float offset)
+{
+	std::vector<float> cycle(length);
+	for (size_t i = 0; i < length; ++i)
+		cycle[i] = offset + amplitude * static_cast<float>(std::sin(6.283185307179586 * harmonic * static_cast<double>(i) / static_cast<double>(length)));
+
+	return cycle;
+}
+
+SCENARIO( "Converting audio cycles to waves", "[wave_converter]" )
+{
+	lsdj_wave_converter_t* converter = nullptr;
+	REQUIRE( lsdj_wave_converter_new(2048, &converter, nullptr) == LSDJ_SUCCESS );
+
+	uint8_t wave[LSDJ_WAVE_BYTE_COUNT];
+
+	GIVEN( "A sine wave" )
+	{
+		const auto cycle = make_sine(2048, 1, 1.0f, 0.0f);
+		lsdj_wave_converter_convert(converter, cycle.data(), wave);
+
+		THEN( "The wave follows the sine" )
+		{
+			for (size_t step = 0; step < LSDJ_WAVE_STEP_COUNT; ++step)
+			{
+				const double expected = 7.5 + 7.5 * std::sin(6.283185307179586 * static_cast<double>(step) / static_cast<double>(LSDJ_WAVE_STEP_COUNT));
+				REQUIRE( std::abs(get_level(wave, step) - expected) <= 0.5 );
+			}
+		}
+
+		THEN( "A quiet sine with an offset is normalized to the same wave" )
+		{
+			const auto quiet = make_sine(2048, 1, 0.1f, 0.3f);
+
+			uint8_t normalized[LSDJ_WAVE_BYTE_COUNT];
+			lsdj_wave_converter_convert(converter, quiet.data(), normalized);
+
+			// Steps right between two levels may round either way
+			for (size_t step = 0; step < LSDJ_WAVE_STEP_COUNT; ++step)
+				REQUIRE( std::abs(get_level(normalized, step) - get_level(wave, step)) <= 1 );
+		}
+	}
+
+	GIVEN( "Harmonics too high for a wave to hold" )
+	{
+		const auto cycle = make_sine(2048, 40, 1.0f, 0.0f);
+		lsdj_wave_converter_convert(converter, cycle.data(), wave);
+
+		THEN( "They are filtered out instead of aliasing" )
+		{
+			for (size_t step = 0; step < LSDJ_WAVE_STEP_COUNT; ++step)
+				REQUIRE( get_level(wave, step) == 8 );
+		}
+	}
+
+	GIVEN( "A converter that doesn't normalize" )
+	{
+		lsdj_wave_converter_set_normalize(converter, false);
+
+		const auto cycle = make_sine(2048, 1, 0.5f, 0.0f);
+		lsdj_wave_converter_convert(converter, cycle.data(), wave);
+
+		THEN( "The level of the audio is kept" )
+		{
+			REQUIRE( get_level(wave, 8) == 11 );
+			REQUIRE( get_level(wave, 24) == 4 );
+		}
+	}
+
+	GIVEN( "A converter that dithers" )
+	{
+		const auto cycle = make_sine(2048, 3, 1.0f, 0.0f);
+
+		uint8_t plain[LSDJ_WAVE_BYTE_COUNT];
+		lsdj_wave_converter_convert(converter, cycle.data(), plain);
+
+		lsdj_wave_converter_set_dither(converter, true);
+		lsdj_wave_converter_convert(converter, cycle.data(), wave);
+
+		THEN( "Every step is at most one level off" )
+		{
+			for (size_t step = 0; step < LSDJ_WAVE_STEP_COUNT; ++step)
+				REQUIRE( std::abs(get_level(wave, step) - get_level(plain, step)) <= 1 );
+		}
+
+		THEN( "The noise is the same every time" )
+		{
+			lsdj_wave_converter_t* other = nullptr;
+			REQUIRE( lsdj_wave_converter_new(2048, &other, nullptr) == LSDJ_SUCCESS );
+			lsdj_wave_converter_set_dither(other, true);
+
+			uint8_t again[LSDJ_WAVE_BYTE_COUNT];
+			lsdj_wave_converter_convert(other, cycle.data(), again);
+			REQUIRE( memcmp(wave, again, sizeof(wave)) == 0 );
+
+			lsdj_wave_converter_free(other);
+		}
+	}
+
+	lsdj_wave_converter_free(converter);
+
+	GIVEN( "Cycles shorter than a wave" )
+	{
+		REQUIRE( lsdj_wave_converter_new(8, &converter, nullptr) == LSDJ_SUCCESS );
+
+		const float cycle[8] = { 1, 1, 1, 1, -1, -1, -1, -1 };
+		lsdj_wave_converter_convert(converter, cycle, wave);
+
+		THEN( "They are stretched over the entire wave" )
+		{
+			REQUIRE( get_level(wave, 6) > 8 );
+			REQUIRE( get_level(wave, 22) < 7 );
+		}
+
+		lsdj_wave_converter_free(converter);
+	}
+}
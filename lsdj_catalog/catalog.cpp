@@ -0,0 +1,281 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#include "catalog.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include <lsdj/compression.h>
+#include <lsdj/hash.h>
+#include <lsdj/project.h>
+#include <lsdj/song.h>
+
+#include "../common/index_file.hpp"
+#include "../common/song_library.hpp"
+
+namespace lsdj
+{
+    namespace
+    {
+        constexpr IndexMagic MAGIC = { 'L', 'S', 'D', 'J', 'C', 'A', 'T', 0 };
+        constexpr uint32_t FORMAT_VERSION = 1;
+        
+        constexpr size_t HEADER_SIZE = 24;
+        constexpr size_t FILE_RECORD_SIZE = 32;
+        constexpr size_t SONG_RECORD_SIZE = 24;
+        
+        CatalogSong makeSong(const lsdj_song_t* song, uint8_t slot, const char* name, uint8_t version)
+        {
+            CatalogSong entry;
+            entry.slot = slot;
+            if (name)
+                entry.name = std::string(name, strnlen(name, LSDJ_PROJECT_NAME_LENGTH));
+            entry.version = version;
+            entry.formatVersion = lsdj_song_get_format_version(song);
+            entry.tempo = lsdj_song_get_tempo(song);
+            entry.hash = lsdj_song_hash(song);
+            
+            // Songs come from memory that was decompressed just fine, so counting can't fail
+            lsdj_compress_count_blocks(song->bytes, &entry.blockCount);
+            
+            return entry;
+        }
+    }
+    
+    constexpr uint8_t CatalogSong::WORKING_MEMORY;
+    constexpr uint8_t CatalogSong::LSDSNG;
+    
+    bool Catalog::open(const ghc::filesystem::path& path)
+    {
+        close();
+        
+        if (!file.open(path))
+            return false;
+        
+        // Check that everything the header promises is actually there, so lookups don't need to
+        const uint8_t* data = file.data();
+        if (!hasIndexHeader(file, MAGIC, FORMAT_VERSION, HEADER_SIZE))
+        {
+            close();
+            return false;
+        }
+        
+        fileCount = readLittleEndian(data + 12, 4);
+        songCount = readLittleEndian(data + 16, 4);
+        
+        const size_t stringsOffset = HEADER_SIZE + fileCount * FILE_RECORD_SIZE + songCount * SONG_RECORD_SIZE;
+        if (stringsOffset > file.size())
+        {
+            close();
+            return false;
+        }
+        
+        for (size_t i = 0; i < fileCount; ++i)
+        {
+            const uint8_t* record = getFileRecord(i);
+            if (stringsOffset + readLittleEndian(record, 4) + readLittleEndian(record + 4, 4) > file.size() ||
+                readLittleEndian(record + 24, 4) + readLittleEndian(record + 28, 4) > songCount)
+            {
+                close();
+                return false;
+            }
+        }
+        
+        return true;
+    }
+
+    void Catalog::close()
+    {
+        file.close();
+        fileCount = 0;
+        songCount = 0;
+    }
+
+    std::string Catalog::getPath(size_t index) const
+    {
+        const uint8_t* record = getFileRecord(index);
+        const size_t stringsOffset = HEADER_SIZE + fileCount * FILE_RECORD_SIZE + songCount * SONG_RECORD_SIZE;
+        
+        const auto begin = reinterpret_cast<const char*>(file.data() + stringsOffset + readLittleEndian(record, 4));
+        return std::string(begin, readLittleEndian(record + 4, 4));
+    }
+
+    CatalogFile Catalog::getFile(size_t index) const
+    {
+        const uint8_t* record = getFileRecord(index);
+        
+        CatalogFile entry;
+        entry.path = getPath(index);
+        entry.modified = static_cast<int64_t>(readLittleEndian(record + 8, 8));
+        entry.size = readLittleEndian(record + 16, 8);
+        
+        const size_t firstSong = readLittleEndian(record + 24, 4);
+        const size_t count = readLittleEndian(record + 28, 4);
+        for (size_t i = firstSong; i < firstSong + count; ++i)
+        {
+            const uint8_t* song = getSongRecord(i);
+            
+            CatalogSong songEntry;
+            songEntry.name = std::string(reinterpret_cast<const char*>(song), strnlen(reinterpret_cast<const char*>(song), LSDJ_PROJECT_NAME_LENGTH));
+            songEntry.slot = song[8];
+            songEntry.version = song[9];
+            songEntry.formatVersion = song[10];
+            songEntry.tempo = static_cast<unsigned short>(readLittleEndian(song + 12, 2));
+            songEntry.blockCount = static_cast<unsigned int>(readLittleEndian(song + 14, 2));
+            songEntry.hash = readLittleEndian(song + 16, 8);
+            entry.songs.emplace_back(std::move(songEntry));
+        }
+        
+        return entry;
+    }
+
+    size_t Catalog::find(const std::string& path) const
+    {
+        const size_t stringsOffset = HEADER_SIZE + fileCount * FILE_RECORD_SIZE + songCount * SONG_RECORD_SIZE;
+        
+        // Files are sorted by path, so a binary search only touches a handful of pages
+        size_t begin = 0;
+        size_t end = fileCount;
+        while (begin < end)
+        {
+            const size_t middle = begin + (end - begin) / 2;
+            const uint8_t* record = getFileRecord(middle);
+            
+            const size_t length = readLittleEndian(record + 4, 4);
+            int order = memcmp(file.data() + stringsOffset + readLittleEndian(record, 4), path.data(), std::min(length, path.size()));
+            if (order == 0)
+                order = length < path.size() ? -1 : length > path.size() ? 1 : 0;
+            
+            if (order == 0)
+                return middle;
+            else if (order < 0)
+                begin = middle + 1;
+            else
+                end = middle;
+        }
+        
+        return fileCount;
+    }
+
+    bool Catalog::isUpToDate(size_t index, int64_t modified, uint64_t size) const
+    {
+        const uint8_t* record = getFileRecord(index);
+        return static_cast<int64_t>(readLittleEndian(record + 8, 8)) == modified && readLittleEndian(record + 16, 8) == size;
+    }
+
+    bool Catalog::write(const ghc::filesystem::path& path, std::vector<CatalogFile>& files)
+    {
+        std::sort(files.begin(), files.end(), [](const CatalogFile& lhs, const CatalogFile& rhs){ return lhs.path < rhs.path; });
+        
+        size_t songCount = 0;
+        for (const auto& entry : files)
+            songCount += entry.songs.size();
+        
+        std::vector<uint8_t> data(MAGIC.begin(), MAGIC.end());
+        appendLittleEndian(data, FORMAT_VERSION, 4);
+        appendLittleEndian(data, files.size(), 4);
+        appendLittleEndian(data, songCount, 4);
+        appendLittleEndian(data, 0, 4);
+        
+        size_t stringOffset = 0;
+        size_t firstSong = 0;
+        for (const auto& entry : files)
+        {
+            appendLittleEndian(data, stringOffset, 4);
+            appendLittleEndian(data, entry.path.size(), 4);
+            appendLittleEndian(data, static_cast<uint64_t>(entry.modified), 8);
+            appendLittleEndian(data, entry.size, 8);
+            appendLittleEndian(data, firstSong, 4);
+            appendLittleEndian(data, entry.songs.size(), 4);
+            
+            stringOffset += entry.path.size();
+            firstSong += entry.songs.size();
+        }
+        
+        for (const auto& entry : files)
+        {
+            for (const auto& song : entry.songs)
+            {
+                std::array<uint8_t, LSDJ_PROJECT_NAME_LENGTH> name = {};
+                std::copy_n(song.name.begin(), std::min(song.name.size(), name.size()), name.begin());
+                data.insert(data.end(), name.begin(), name.end());
+                
+                data.emplace_back(song.slot);
+                data.emplace_back(song.version);
+                data.emplace_back(song.formatVersion);
+                data.emplace_back(0);
+                appendLittleEndian(data, song.tempo, 2);
+                appendLittleEndian(data, song.blockCount, 2);
+                appendLittleEndian(data, song.hash, 8);
+            }
+        }
+        
+        for (const auto& entry : files)
+            data.insert(data.end(), entry.path.begin(), entry.path.end());
+        
+        return writeIndex(path, data);
+    }
+
+    bool Catalog::scan(const ghc::filesystem::path& path, CatalogFile& file)
+    {
+        file.path = path.string();
+        file.modified = getModificationTime(path);
+        file.size = ghc::filesystem::file_size(path);
+        file.songs.clear();
+        
+        return readSongs(path, [&](const lsdj_song_t* song, uint8_t slot, const char* name, uint8_t version)
+        {
+            file.songs.emplace_back(makeSong(song, slot, name, version));
+        });
+    }
+
+    int64_t Catalog::getModificationTime(const ghc::filesystem::path& path)
+    {
+        return static_cast<int64_t>(ghc::filesystem::last_write_time(path).time_since_epoch().count());
+    }
+
+    const uint8_t* Catalog::getFileRecord(size_t index) const
+    {
+        return file.data() + HEADER_SIZE + index * FILE_RECORD_SIZE;
+    }
+
+    const uint8_t* Catalog::getSongRecord(size_t index) const
+    {
+        return file.data() + HEADER_SIZE + fileCount * FILE_RECORD_SIZE + index * SONG_RECORD_SIZE;
+    }
+}
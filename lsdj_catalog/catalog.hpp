@@ -0,0 +1,135 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#ifndef LSDJ_CATALOG_HPP
+#define LSDJ_CATALOG_HPP
+
+#include <cstdint>
+#include <ghc/filesystem.hpp>
+#include <string>
+#include <vector>
+
+#include "../common/mapped_file.hpp"
+#include "../common/song_library.hpp"
+
+/* A catalog stores what's in a library of .sav's and .lsdsng's, so it can be queried
+   without reading any of them. All numbers are little endian.
+ 
+   - A header: the magic "LSDJCAT" followed by a zero byte, the format version, the amount
+     of files and the amount of songs (all 32-bit), and 4 reserved bytes
+   - A 32-byte record for every file, sorted by path: the offset and length of its path in
+     the string table (32-bit), its modification time and size (64-bit), and the index of
+     its first song and the amount of songs (32-bit)
+   - A 24-byte record for every song: its name (8 bytes), its slot, project version and
+     format version, a reserved byte, its tempo and the amount of blocks it compresses into
+     (16-bit), and the hash of the song (64-bit)
+   - The string table with all paths */
+
+namespace lsdj
+{
+    //! What a catalog knows about a single song
+    struct CatalogSong
+    {
+        //! The slot of a working memory song
+        static constexpr uint8_t WORKING_MEMORY = WORKING_MEMORY_SLOT;
+        
+        //! The slot of the song in an .lsdsng
+        static constexpr uint8_t LSDSNG = LSDSNG_SLOT;
+        
+        //! The project index in a sav, or one of the special slots above
+        uint8_t slot = LSDSNG;
+        
+        std::string name;
+        uint8_t version = 0;
+        uint8_t formatVersion = 0;
+        unsigned short tempo = 0;
+        unsigned int blockCount = 0;
+        uint64_t hash = 0;
+    };
+    
+    //! What a catalog knows about a single file
+    struct CatalogFile
+    {
+        std::string path;
+        
+        // Together with the path, these tell whether the file changed since it was cataloged
+        int64_t modified = 0;
+        uint64_t size = 0;
+        
+        std::vector<CatalogSong> songs;
+    };
+    
+    //! A catalog on disk, mapped into memory so looking something up doesn't read all of it
+    class Catalog
+    {
+    public:
+        //! Map a catalog file
+        /*! @return False if it doesn't exist or isn't a valid catalog */
+        bool open(const ghc::filesystem::path& path);
+        void close();
+        
+        size_t getFileCount() const { return fileCount; }
+        std::string getPath(size_t index) const;
+        CatalogFile getFile(size_t index) const;
+        
+        //! Find a file by its path
+        /*! @return The index of the file, or getFileCount() if it isn't in the catalog */
+        size_t find(const std::string& path) const;
+        
+        //! Whether a file in the catalog still has the given modification time and size
+        bool isUpToDate(size_t index, int64_t modified, uint64_t size) const;
+        
+        //! Write a catalog to disk, sorting the files by path
+        static bool write(const ghc::filesystem::path& path, std::vector<CatalogFile>& files);
+        
+        //! Read the songs in a .sav or .lsdsng, for putting them in a catalog
+        static bool scan(const ghc::filesystem::path& path, CatalogFile& file);
+        
+        //! The modification time of a file as it's stored in the catalog
+        static int64_t getModificationTime(const ghc::filesystem::path& path);
+        
+    private:
+        const uint8_t* getFileRecord(size_t index) const;
+        const uint8_t* getSongRecord(size_t index) const;
+        
+    private:
+        MappedFile file;
+        size_t fileCount = 0;
+        size_t songCount = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,258 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+#include <ghc/filesystem.hpp>
+#include <popl/popl.hpp>
+
+#include <lsdj/version.h>
+
+#include "../common/common.hpp"
+#include "../common/song_library.hpp"
+#include "../common/thread_pool.hpp"
+#include "catalog.hpp"
+
+void printHelp(const popl::OptionParser& options)
+{
+    std::cout << "lsdj-catalog -c library.catalog mymusic.sav|mymusic.lsdsng|folder ...\n"
+              << "lsdj-catalog -c library.catalog [-n name] [-f mymusic.sav]\n\n"
+              << "Version: " << LSDJ_VERSION_STRING << "\n\n"
+              << options << "\n\n";
+
+    std::cout << "LibLSDJ is open source and freely available to anyone.\nIf you'd like to show your appreciation, please consider\n  - buying one of my albums (https://4ntler.bandcamp.com)\n  - donating money through PayPal (https://paypal.me/4ntler).\n";
+}
+
+//! Whether a path is an input itself, or lies somewhere inside of it
+bool isInside(const ghc::filesystem::path& path, const ghc::filesystem::path& input)
+{
+    const auto inputString = input.string();
+    const auto pathString = path.lexically_normal().string();
+    if (pathString.compare(0, inputString.size(), inputString) != 0)
+        return false;
+    
+    return pathString.size() == inputString.size() || inputString.back() == ghc::filesystem::path::preferred_separator || pathString[inputString.size()] == ghc::filesystem::path::preferred_separator;
+}
+
+//! Bring a catalog up to date with the files in the inputs, only reading the ones that changed
+/*! Files cataloged earlier that lie outside of the inputs are kept as they are, so a library
+    can be cataloged one folder at a time. */
+int update(const ghc::filesystem::path& catalogPath, const std::vector<std::string>& inputs, unsigned int jobs, bool verbose)
+{
+    const auto paths = lsdj::collectSongFiles(inputs);
+    
+    std::vector<ghc::filesystem::path> roots;
+    for (const auto& input : inputs)
+        roots.emplace_back(lsdj::absoluteInputPath(input));
+    
+    // A catalog that doesn't exist yet (or can't be read) is simply rebuilt from scratch
+    lsdj::Catalog catalog;
+    catalog.open(catalogPath);
+    
+    std::vector<lsdj::CatalogFile> files(paths.size());
+    std::vector<size_t> changed;
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        const auto path = paths[i].string();
+        const auto index = catalog.find(path);
+        
+        if (index == catalog.getFileCount())
+        {
+            changed.emplace_back(i);
+            continue;
+        }
+        
+        if (catalog.isUpToDate(index, lsdj::Catalog::getModificationTime(paths[i]), ghc::filesystem::file_size(paths[i])))
+            files[i] = catalog.getFile(index);
+        else
+            changed.emplace_back(i);
+    }
+    
+    // Of the files that weren't found, only those inside an input are gone, the rest wasn't looked at
+    std::set<std::string> found;
+    for (const auto& path : paths)
+        found.emplace(path.string());
+    
+    std::vector<lsdj::CatalogFile> carried;
+    size_t removedCount = 0;
+    for (size_t i = 0; i < catalog.getFileCount(); ++i)
+    {
+        const auto path = catalog.getPath(i);
+        if (found.count(path) != 0)
+            continue;
+        
+        if (std::any_of(roots.begin(), roots.end(), [&](const ghc::filesystem::path& root){ return isInside(path, root); }))
+            ++removedCount;
+        else
+            carried.emplace_back(catalog.getFile(i));
+    }
+    
+    // The old catalog is replaced in a moment, which some platforms won't allow while it's mapped
+    catalog.close();
+    
+    // Reading the files that changed is where the time goes, so spread that over the jobs
+    std::vector<char> succeeded(changed.size(), false);
+    lsdj::ThreadPool::forEach(jobs, changed.size(), [&](size_t i)
+    {
+        succeeded[i] = lsdj::Catalog::scan(paths[changed[i]], files[changed[i]]);
+    });
+    
+    // Files that can't be read are left out, so they're tried again next time
+    std::vector<lsdj::CatalogFile> cataloged = std::move(carried);
+    cataloged.reserve(cataloged.size() + files.size());
+    size_t changedIndex = 0;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        const bool wasChanged = changedIndex < changed.size() && changed[changedIndex] == i;
+        if (wasChanged)
+        {
+            if (!succeeded[changedIndex++])
+            {
+                std::cerr << "Could not read '" << paths[i].string() << "'" << std::endl;
+                continue;
+            }
+            
+            if (verbose)
+                std::cout << "Cataloged " << paths[i].string() << std::endl;
+        }
+        
+        cataloged.emplace_back(std::move(files[i]));
+    }
+    
+    if (!lsdj::Catalog::write(catalogPath, cataloged))
+    {
+        std::cerr << "Could not write '" << catalogPath.string() << "'" << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Cataloged " << changed.size() << " file(s), " << (paths.size() - changed.size()) << " unchanged, " << removedCount << " removed" << std::endl;
+    
+    return 0;
+}
+
+//! Print a song as a line of tab-separated values
+void printSong(const std::string& path, const lsdj::CatalogSong& song)
+{
+    std::cout << path << '\t' << lsdj::formatSlot(song.slot)
+              << '\t' << song.name
+              << '\t' << std::uppercase << std::hex << static_cast<unsigned int>(song.version) << std::dec
+              << '\t' << static_cast<unsigned int>(song.formatVersion)
+              << '\t' << song.tempo
+              << '\t' << song.blockCount
+              << '\t' << std::nouppercase << std::hex << std::setfill('0') << std::setw(16) << song.hash << std::dec << std::setfill(' ')
+              << '\n';
+}
+
+//! Print the songs in a catalog, optionally only those with a given name or in a given file
+int query(const ghc::filesystem::path& catalogPath, const std::string& name, const std::string& path)
+{
+    lsdj::Catalog catalog;
+    if (!catalog.open(catalogPath))
+    {
+        std::cerr << "'" << catalogPath.string() << "' is not a catalog" << std::endl;
+        return 1;
+    }
+    
+    // A single file is looked up directly, instead of going through all of them
+    size_t begin = 0;
+    size_t end = catalog.getFileCount();
+    if (!path.empty())
+    {
+        begin = catalog.find(lsdj::absoluteInputPath(path).string());
+        if (begin == catalog.getFileCount())
+        {
+            std::cerr << "'" << path << "' is not in the catalog" << std::endl;
+            return 1;
+        }
+        end = begin + 1;
+    }
+    
+    for (size_t i = begin; i < end; ++i)
+    {
+        const auto file = catalog.getFile(i);
+        for (const auto& song : file.songs)
+        {
+            if (name.empty() || lsdj::compareCaseInsensitive(name, song.name))
+                printSong(file.path, song);
+        }
+    }
+    
+    std::cout << std::flush;
+    
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    popl::OptionParser options("Options");
+    auto help = options.add<popl::Switch>("h", "help", "Show the help screen");
+    auto verbose = options.add<popl::Switch>("v", "verbose", "Verbose output while cataloging");
+    auto catalog = options.add<popl::Value<std::string>>("c", "catalog", "The catalog file to update or query", "library.catalog");
+    auto name = options.add<popl::Value<std::string>>("n", "name", "Only list the songs with a given name");
+    auto file = options.add<popl::Value<std::string>>("f", "file", "Only list the songs in a given file");
+    auto jobs = options.add<popl::Value<unsigned int>>("j", "jobs", "The amount of files to read simultaneously", 1);
+    
+    try
+    {
+        options.parse(argc, argv);
+        
+        const auto inputs = options.non_option_args();
+        const auto catalogPath = ghc::filesystem::absolute(catalog->value());
+        
+        if (help->is_set())
+        {
+            printHelp(options);
+            return 0;
+        } else if (!inputs.empty()) {
+            return update(catalogPath, inputs, jobs->value(), verbose->is_set());
+        } else if (ghc::filesystem::exists(catalogPath)) {
+            return query(catalogPath, name->is_set() ? name->value() : "", file->is_set() ? file->value() : "");
+        } else {
+            printHelp(options);
+            return 0;
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+    }
+
+	return 0;
+}
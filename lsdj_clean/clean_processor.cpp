@@ -1,23 +1,18 @@
 #include "clean_processor.hpp"
 
-#include <assert.h>
+#include <cassert>
+
+#include "../common/song_passes.hpp"
 
 namespace lsdj
 {
-    bool CleanProcessor::processSong(lsdj_song_t& song)
+    bool CleanProcessor::processSong(lsdj_song_t* song)
     {
-        if (processTables)
-            lsdj_song_deduplicate_tables(&song);
-        
-//        if (processInstruments)
-//            lsdj_song_deduplicate_instruments(&song);
-        
-        if (processPhrases)
-            lsdj_song_deduplicate_phrases(&song);
+        assert(song != nullptr);
         
-        if (processChains)
-            lsdj_song_deduplicate_chains(&song);
+        CleanPass pass;
+        pass.deduplicate = deduplicate;
         
-        return true;
+        return pass.apply(song, log());
     }
 }
@@ -8,12 +8,10 @@ namespace lsdj
         public SongProcessor
     {
     public:
-        bool processTables = false;
-        bool processInstruments = false;
-        bool processChains = false;
-        bool processPhrases = false;
+        //! Merge duplicate phrases and chains after cleaning
+        bool deduplicate = false;
         
     private:
-        bool processSong(lsdj_song_t& song) final;
+        bool processSong(lsdj_song_t* song) final;
     };
 }
@@ -41,11 +41,12 @@
 #include <lsdj/version.h>
 
 #include "../common/common.hpp"
+#include "../common/stream.hpp"
 #include "mono_processor.hpp"
 
 void printHelp(const popl::OptionParser& options)
 {
-    std::cout << "lsdj-mono mymusic.sav|mymusic.lsdsng ...\n\n"
+    std::cout << "lsdj-mono mymusic.sav|mymusic.lsdsng|folder|- ...\n\n"
               << "Version: " << LSDJ_VERSION_STRING << "\n\n"
               << options << "\n\n";
 
@@ -60,6 +61,7 @@ int main(int argc, char* argv[])
     auto instrument = options.add<popl::Switch>("i", "instrument", "Only adjust instruments");
     auto table = options.add<popl::Switch>("t", "table", "Only adjust tables");
     auto phrase = options.add<popl::Switch>("p", "phrase", "Only adjust phrases");
+    auto jobs = options.add<popl::Value<unsigned int>>("j", "jobs", "The amount of files to convert simultaneously", 1);
     
     try
     {
@@ -76,6 +78,7 @@ int main(int argc, char* argv[])
             lsdj::MonoProcessor processor;
             
             processor.verbose = verbose->is_set();
+            processor.jobs = jobs->value();
             processor.processInstruments = instrument->is_set();
             processor.processPhrases = phrase->is_set();
             processor.processTables = table->is_set();
@@ -84,7 +87,7 @@ int main(int argc, char* argv[])
             
             for (auto& input : inputs)
             {
-                if (!processor.process(ghc::filesystem::absolute(input)))
+                if (!processor.process(lsdj::absoluteUnlessStandardStream(input)))
                     return 1;
             }
             
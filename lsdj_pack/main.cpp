@@ -0,0 +1,285 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <ghc/filesystem.hpp>
+#include <popl/popl.hpp>
+
+#include <lsdj/pack.h>
+#include <lsdj/sav.h>
+#include <lsdj/version.h>
+
+#include "../common/common.hpp"
+#include "../common/song_library.hpp"
+
+void printHelp(const popl::OptionParser& options)
+{
+    std::cout << "lsdj-pack -p library.pack mymusic.sav|mymusic.lsdsng|folder ...\n"
+              << "lsdj-pack -p library.pack -l\n"
+              << "lsdj-pack -p library.pack -x 3 [-x 5] [-o folder]\n"
+              << "lsdj-pack -p library.pack -a [-o folder]\n\n"
+              << "Version: " << LSDJ_VERSION_STRING << "\n\n"
+              << options << "\n\n";
+
+    std::cout << "LibLSDJ is open source and freely available to anyone.\nIf you'd like to show your appreciation, please consider\n  - buying one of my albums (https://4ntler.bandcamp.com)\n  - donating money through PayPal (https://paypal.me/4ntler).\n";
+}
+
+//! Append every project in a .sav or .lsdsng to a pack
+/*! @return False if the file couldn't be read, or not all of its projects could be appended */
+bool append(lsdj_pack_t* pack, const ghc::filesystem::path& path, size_t& songCount, size_t& newChunkCount, bool verbose)
+{
+    const auto before = newChunkCount;
+    size_t count = 0;
+    lsdj_error_t error = LSDJ_SUCCESS;
+    
+    if (path.extension() == ".sav")
+    {
+        lsdj_sav_t* sav = nullptr;
+        error = lsdj_sav_read_from_file(path.string().c_str(), &sav, nullptr);
+        if (error != LSDJ_SUCCESS)
+        {
+            std::cerr << "Could not read '" << path.string() << "'" << std::endl;
+            return false;
+        }
+        
+        // The working memory song is left out, it's a copy of a project that's being worked on
+        for (uint8_t i = 0; i < LSDJ_SAV_PROJECT_COUNT && error == LSDJ_SUCCESS; ++i)
+        {
+            const lsdj_project_t* project = lsdj_sav_get_project_const(sav, i);
+            if (project == nullptr)
+                continue;
+            
+            error = lsdj_pack_append_project(pack, project, &newChunkCount);
+            if (error == LSDJ_SUCCESS)
+                ++count;
+        }
+        
+        lsdj_sav_free(sav);
+        
+        if (error != LSDJ_SUCCESS)
+            lsdj::handle_error(error);
+    } else {
+        lsdj_project_t* project = nullptr;
+        if (lsdj_project_read_lsdsng_from_file(path.string().c_str(), &project, nullptr) != LSDJ_SUCCESS)
+        {
+            std::cerr << "Could not read '" << path.string() << "'" << std::endl;
+            return false;
+        }
+        
+        error = lsdj_pack_append_project(pack, project, &newChunkCount);
+        if (error == LSDJ_SUCCESS)
+            ++count;
+        else
+            lsdj::handle_error(error);
+        
+        lsdj_project_free(project);
+    }
+    
+    if (verbose)
+        std::cout << "Packed " << path.string() << " (" << count << " song(s), " << (newChunkCount - before) << " new chunk(s))" << std::endl;
+    
+    songCount += count;
+    return error == LSDJ_SUCCESS;
+}
+
+//! Append the songs in the inputs to a pack
+/*! @return 1 if any file couldn't be packed completely, so scripts can tell the pack is incomplete */
+int add(lsdj_pack_t* pack, const std::vector<std::string>& inputs, bool verbose)
+{
+    size_t songCount = 0;
+    size_t newChunkCount = 0;
+    size_t failedCount = 0;
+    for (const auto& path : lsdj::collectSongFiles(inputs))
+    {
+        if (!append(pack, path, songCount, newChunkCount, verbose))
+            ++failedCount;
+    }
+    
+    std::cout << "Packed " << songCount << " song(s) with " << newChunkCount << " new chunk(s), the pack now holds "
+              << lsdj_pack_get_song_count(pack) << " song(s) in " << lsdj_pack_get_chunk_count(pack) << " chunk(s)" << std::endl;
+    
+    if (failedCount > 0)
+    {
+        std::cerr << failedCount << " file(s) could not be packed" << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
+
+//! Print the songs in a pack as tab-separated values: their index, name and version
+int list(const lsdj_pack_t* pack)
+{
+    for (size_t i = 0; i < lsdj_pack_get_song_count(pack); ++i)
+    {
+        const char* name = lsdj_pack_get_name(pack, i);
+        std::cout << i << '\t' << std::string(name, strnlen(name, LSDJ_PROJECT_NAME_LENGTH))
+                  << '\t' << std::uppercase << std::hex << static_cast<unsigned int>(lsdj_pack_get_version(pack, i)) << std::nouppercase << std::dec << '\n';
+    }
+    
+    std::cout << std::flush;
+    
+    return 0;
+}
+
+//! Write songs from a pack to .lsdsng's
+int extract(lsdj_pack_t* pack, const std::vector<size_t>& indices, const ghc::filesystem::path& folder, bool verbose)
+{
+    ghc::filesystem::create_directories(folder);
+    
+    for (const auto index : indices)
+    {
+        lsdj_project_t* project = nullptr;
+        lsdj_error_t error = lsdj_pack_read_project(pack, index, &project, nullptr);
+        if (error != LSDJ_SUCCESS)
+        {
+            std::cerr << "Could not read song " << index << " from the pack" << std::endl;
+            return lsdj::handle_error(error);
+        }
+        
+        // Songs in a library often share names, so the index keeps them apart
+        auto name = lsdj::constructProjectName(project, false);
+        if (name.empty())
+            name = "(EMPTY)";
+        
+        std::stringstream stream;
+        stream << std::setfill('0') << std::setw(4) << index << ' ' << name << ".lsdsng";
+        const auto path = folder / stream.str();
+        
+        error = lsdj_project_write_lsdsng_to_file(project, path.string().c_str(), nullptr);
+        lsdj_project_free(project);
+        
+        if (error != LSDJ_SUCCESS)
+        {
+            std::cerr << "Could not write '" << path.string() << "'" << std::endl;
+            return lsdj::handle_error(error);
+        }
+        
+        if (verbose)
+            std::cout << "Extracted " << path.string() << std::endl;
+    }
+    
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    popl::OptionParser options("Options");
+    auto help = options.add<popl::Switch>("h", "help", "Show the help screen");
+    auto verbose = options.add<popl::Switch>("v", "verbose", "Verbose output");
+    auto packFile = options.add<popl::Value<std::string>>("p", "pack", "The pack to append to or read from", "library.pack");
+    auto listSongs = options.add<popl::Switch>("l", "list", "List the songs in the pack");
+    auto extractSong = options.add<popl::Value<size_t>>("x", "extract", "Extract a song by its index (repeatable)");
+    auto extractAll = options.add<popl::Switch>("a", "all", "Extract all songs");
+    auto output = options.add<popl::Value<std::string>>("o", "output", "The folder to extract songs to", ".");
+    
+    try
+    {
+        options.parse(argc, argv);
+        
+        const auto inputs = options.non_option_args();
+        const auto packPath = ghc::filesystem::absolute(packFile->value());
+        
+        if (help->is_set() || (inputs.empty() && !listSongs->is_set() && !extractSong->is_set() && !extractAll->is_set()))
+        {
+            printHelp(options);
+            return 0;
+        }
+        
+        if (inputs.empty() && !ghc::filesystem::exists(packPath))
+        {
+            std::cerr << "'" << packPath.string() << "' does not exist" << std::endl;
+            return 1;
+        }
+        
+        // Packs are only ever appended to, and a new one starts out empty
+        FILE* file = fopen(packPath.string().c_str(), ghc::filesystem::exists(packPath) ? "r+b" : "w+b");
+        if (file == nullptr)
+        {
+            std::cerr << "Could not open '" << packPath.string() << "'" << std::endl;
+            return 1;
+        }
+        
+        lsdj_vio_t vio = lsdj_create_file_vio(file);
+        lsdj_pack_t* pack = nullptr;
+        const lsdj_error_t error = lsdj_pack_open(&vio, &pack, nullptr);
+        if (error != LSDJ_SUCCESS)
+        {
+            fclose(file);
+            return lsdj::handle_error(error);
+        }
+        
+        int result = 0;
+        if (!inputs.empty())
+        {
+            result = add(pack, inputs, verbose->is_set());
+        } else if (listSongs->is_set()) {
+            result = list(pack);
+        } else {
+            std::vector<size_t> indices;
+            if (extractAll->is_set())
+            {
+                for (size_t i = 0; i < lsdj_pack_get_song_count(pack); ++i)
+                    indices.emplace_back(i);
+            } else {
+                for (size_t i = 0; i < extractSong->count(); ++i)
+                    indices.emplace_back(extractSong->value(i));
+            }
+            
+            result = extract(pack, indices, ghc::filesystem::absolute(output->value()), verbose->is_set());
+        }
+        
+        lsdj_pack_free(pack);
+        if (fclose(file) != 0)
+        {
+            std::cerr << "Could not write '" << packPath.string() << "'" << std::endl;
+            return 1;
+        }
+        
+        return result;
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+    }
+
+	return 0;
+}
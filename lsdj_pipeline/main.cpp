@@ -0,0 +1,176 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <ghc/filesystem.hpp>
+#include <popl/popl.hpp>
+
+#include <lsdj/version.h>
+
+#include "../common/common.hpp"
+#include "../common/stream.hpp"
+#include "../common/wavetable.hpp"
+#include "pipeline_processor.hpp"
+
+void printHelp(const popl::OptionParser& options)
+{
+    std::cout << "lsdj-pipeline [--mono] [--clean] [--wavetable wavetables.snt|wavetables.wav -[s 0-F | i 0-FF]] mymusic.sav|mymusic.lsdsng|folder|- ...\n\n"
+              << "Version: " << LSDJ_VERSION_STRING << "\n\n"
+              << "The passes are run in the order they appear on the command line.\n\n"
+              << options << "\n\n";
+
+    std::cout << "LibLSDJ is open source and freely available to anyone.\nIf you'd like to show your appreciation, please consider\n  - buying one of my albums (https://4ntler.bandcamp.com)\n  - donating money through PayPal (https://paypal.me/4ntler).\n";
+}
+
+//! Find where a pass was first asked for on the command line, so passes can be run in that order
+int findArgument(int argc, char* argv[], const char* name)
+{
+    const auto length = strlen(name);
+    
+    for (int i = 1; i < argc; ++i)
+    {
+        // Also match --wavetable=x.snt
+        if (strncmp(argv[i], name, length) == 0 && (argv[i][length] == '\0' || argv[i][length] == '='))
+            return i;
+    }
+    
+    return argc;
+}
+
+int main(int argc, char* argv[])
+{
+    popl::OptionParser options("Options");
+    auto help = options.add<popl::Switch>("h", "help", "Show the help screen");
+    auto verbose = options.add<popl::Switch>("v", "verbose", "Verbose output during processing");
+    auto jobs = options.add<popl::Value<unsigned int>>("j", "jobs", "The amount of files to process simultaneously", 1);
+    auto mono = options.add<popl::Switch>("", "mono", "Change all panning to play on both the left and the right");
+    auto clean = options.add<popl::Switch>("", "clean", "Reset everything that can't be reached from the song screen");
+    auto deduplicate = options.add<popl::Switch>("d", "deduplicate", "Merge identical phrases and chains when cleaning");
+    auto wavetable = options.add<popl::Value<std::string>>("", "wavetable", "A .snt or .wav wavetable to write into the waves");
+    auto index = options.add<popl::Value<std::string>>("i", "index", "The wavetable index 00-FF where the wavetable data should be written");
+    auto synth = options.add<popl::Value<std::string>>("s", "synth", "The synth number 0-F where the wavetable data should be written");
+    auto cycle = options.add<popl::Value<size_t>>("c", "cycle", "The amount of samples in every single-cycle frame of a .wav", 2048);
+    auto noNormalize = options.add<popl::Switch>("", "no-normalize", "Keep the level of .wav frames, instead of scaling them to the full range");
+    auto dither = options.add<popl::Switch>("", "dither", "Dither .wav frames when reducing them to 4 bits");
+    
+    try
+    {
+        options.parse(argc, argv);
+        
+        const auto inputs = options.non_option_args();
+        
+        if (help->is_set())
+        {
+            printHelp(options);
+            return 0;
+        } else if (!inputs.empty() && (mono->is_set() || clean->is_set() || wavetable->is_set())) {
+            
+            lsdj::PipelineProcessor processor;
+            
+            processor.verbose = verbose->is_set();
+            processor.jobs = jobs->value();
+            
+            std::vector<std::pair<int, std::unique_ptr<lsdj::SongPass>>> passes;
+            
+            if (mono->is_set())
+                passes.emplace_back(findArgument(argc, argv, "--mono"), std::make_unique<lsdj::MonoPass>());
+            
+            if (clean->is_set())
+            {
+                auto pass = std::make_unique<lsdj::CleanPass>();
+                pass->deduplicate = deduplicate->is_set();
+                passes.emplace_back(findArgument(argc, argv, "--clean"), std::move(pass));
+            }
+            
+            if (wavetable->is_set())
+            {
+                if (!synth->is_set() && !index->is_set())
+                {
+                    std::cerr << "--wavetable needs either --synth or --index" << std::endl;
+                    return 1;
+                }
+                
+                lsdj::WavetableSettings settings;
+                settings.cycleLength = cycle->value();
+                settings.normalize = !noNormalize->is_set();
+                settings.dither = dither->is_set();
+                
+                if (settings.cycleLength == 0)
+                {
+                    printHelp(options);
+                    return 1;
+                }
+                
+                // The wavetable is loaded once up front and shared by every song
+                // Stdout may be taken by the songs themselves, so messages go to stderr then
+                const bool streaming = std::find_if(inputs.begin(), inputs.end(), lsdj::isStandardStream) != inputs.end();
+                std::vector<lsdj::WaveFrame> frames;
+                if (!lsdj::loadWavetable(wavetable->value(), settings, frames, verbose->is_set(), streaming ? std::cerr : std::cout))
+                    return 1;
+                
+                const auto wave = synth->is_set() ?
+                                    static_cast<uint8_t>(std::stoul(synth->value(), nullptr, 16) * 16) :
+                                    static_cast<uint8_t>(std::stoul(index->value(), nullptr, 16));
+                
+                passes.emplace_back(findArgument(argc, argv, "--wavetable"), std::make_unique<lsdj::WavetablePass>(std::move(frames), wave));
+            }
+            
+            std::stable_sort(passes.begin(), passes.end(), [](const auto& lhs, const auto& rhs){ return lhs.first < rhs.first; });
+            for (auto& pass : passes)
+                processor.addPass(std::move(pass.second));
+            
+            bool success = true;
+            for (auto& input : inputs)
+            {
+                if (!processor.process(lsdj::absoluteUnlessStandardStream(input)))
+                    success = false;
+            }
+            
+            return success ? 0 : 1;
+        } else {
+            printHelp(options);
+            return 0;
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+    }
+
+	return 0;
+}
@@ -0,0 +1,32 @@
+#include "pipeline_processor.hpp"
+
+#include <cassert>
+#include <iostream>
+
+namespace lsdj
+{
+    void PipelineProcessor::addPass(std::unique_ptr<SongPass> pass)
+    {
+        assert(pass != nullptr);
+        passes.emplace_back(std::move(pass));
+    }
+
+    bool PipelineProcessor::processSong(lsdj_song_t* song, const ghc::filesystem::path& source, const std::string& name)
+    {
+        assert(song != nullptr);
+        
+        for (const auto& pass : passes)
+        {
+            if (verbose)
+                log() << "Applying " << pass->getName() << " to " << name << std::endl;
+            
+            if (!pass->apply(song, log()))
+            {
+                log() << "Could not apply " << pass->getName() << " to " << name << std::endl;
+                return false;
+            }
+        }
+        
+        return true;
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "../common/song_passes.hpp"
+#include "../common/song_processor.hpp"
+
+namespace lsdj
+{
+    //! Runs a chain of passes over every song, loading and writing each file only once
+    class PipelineProcessor :
+        public SongProcessor
+    {
+    public:
+        //! Append a pass, to be run after the ones already added
+        void addPass(std::unique_ptr<SongPass> pass);
+        
+        [[nodiscard]] bool isEmpty() const { return passes.empty(); }
+        
+    private:
+        bool processSong(lsdj_song_t* song, const ghc::filesystem::path& source, const std::string& name) final;
+        
+    private:
+        std::vector<std::unique_ptr<SongPass>> passes;
+    };
+}
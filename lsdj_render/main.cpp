@@ -0,0 +1,121 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include <iostream>
+
+#include <ghc/filesystem.hpp>
+#include <popl/popl.hpp>
+
+#include <lsdj/version.h>
+
+#include "song_renderer.hpp"
+
+void printHelp(const popl::OptionParser& options)
+{
+    std::cout << "lsdj-render mymusic.sav|mymusic.lsdsng ...\n\n"
+              << "Version: " << LSDJ_VERSION_STRING << "\n\n"
+              << options << "\n\n";
+
+    std::cout << "LibLSDJ is open source and freely available to anyone.\nIf you'd like to show your appreciation, please consider\n  - buying one of my albums (https://4ntler.bandcamp.com)\n  - donating money through PayPal (https://paypal.me/4ntler).\n";
+}
+
+//! Convert a list of channel numbers ("134") into a render channel mask
+bool parseChannels(const std::string& channels, unsigned int& mask)
+{
+    mask = 0;
+    for (auto c : channels)
+    {
+        if (c < '1' || c > '4')
+            return false;
+        
+        mask |= 1u << (c - '1');
+    }
+    
+    return mask != 0;
+}
+
+int main(int argc, char* argv[])
+{
+    popl::OptionParser options("Options");
+    auto help = options.add<popl::Switch>("h", "help", "Show the help screen");
+    auto verbose = options.add<popl::Switch>("v", "verbose", "Verbose output during rendering");
+    auto output = options.add<popl::Value<std::string>>("o", "output", "The folder to write the WAV files to");
+    auto rate = options.add<popl::Value<unsigned int>>("r", "rate", "The sample rate to render at", 44100);
+    auto channels = options.add<popl::Value<std::string>>("c", "channels", "The channels to render, e.g. 124 for both pulses and noise", "1234");
+    
+    try
+    {
+        options.parse(argc, argv);
+        
+        const auto inputs = options.non_option_args();
+        
+        if (help->is_set())
+        {
+            printHelp(options);
+            return 0;
+        } else if (!inputs.empty()) {
+            
+            lsdj::SongRenderer renderer;
+            
+            renderer.verbose = verbose->is_set();
+            renderer.sampleRate = rate->value();
+            if (output->is_set())
+                renderer.output = output->value();
+            
+            if (renderer.sampleRate == 0 || !parseChannels(channels->value(), renderer.channelMask))
+            {
+                printHelp(options);
+                return 1;
+            }
+            
+            for (auto& input : inputs)
+            {
+                if (!renderer.render(ghc::filesystem::absolute(input)))
+                    return 1;
+            }
+            
+            return 0;
+        } else {
+            printHelp(options);
+            return 0;
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+    }
+
+	return 0;
+}
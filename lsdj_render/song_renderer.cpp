@@ -0,0 +1,141 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include "song_renderer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <lsdj/sav.h>
+
+#include "../common/common.hpp"
+
+namespace lsdj
+{
+    bool SongRenderer::render(const ghc::filesystem::path& path)
+    {
+        const auto extension = path.extension().string();
+        if (compareCaseInsensitive(extension, ".sav"))
+            return renderSav(path);
+        else if (compareCaseInsensitive(extension, ".lsdsng"))
+            return renderLsdsng(path);
+        
+        std::cerr << "'" << path.filename().string() << "' is not a .sav or .lsdsng file" << std::endl;
+        return false;
+    }
+
+    bool SongRenderer::renderSav(const ghc::filesystem::path& path)
+    {
+        lsdj_sav_t* sav = nullptr;
+        const lsdj_error_t error = lsdj_sav_read_from_file(path.string().c_str(), &sav, nullptr);
+        if (error != LSDJ_SUCCESS)
+        {
+            handle_error(error);
+            lsdj_sav_free(sav);
+            return false;
+        }
+        
+        for (uint8_t i = 0; i < LSDJ_SAV_PROJECT_COUNT; ++i)
+        {
+            const lsdj_project_t* project = lsdj_sav_get_project_const(sav, i);
+            if (project == nullptr)
+                continue;
+            
+            std::ostringstream name;
+            name << path.stem().string() << '_' << std::setfill('0') << std::setw(2) << static_cast<unsigned int>(i) << '_' << constructProjectName(project, true);
+            
+            if (!renderSong(lsdj_project_get_song_const(project), constructDestination(path, name.str())))
+            {
+                lsdj_sav_free(sav);
+                return false;
+            }
+        }
+        
+        lsdj_sav_free(sav);
+        return true;
+    }
+
+    bool SongRenderer::renderLsdsng(const ghc::filesystem::path& path)
+    {
+        lsdj_project_t* project = nullptr;
+        const lsdj_error_t error = lsdj_project_read_lsdsng_from_file(path.string().c_str(), &project, nullptr);
+        if (error != LSDJ_SUCCESS)
+        {
+            handle_error(error);
+            lsdj_project_free(project);
+            return false;
+        }
+        
+        const bool result = renderSong(lsdj_project_get_song_const(project), constructDestination(path, path.stem().string()));
+        
+        lsdj_project_free(project);
+        return result;
+    }
+
+    bool SongRenderer::renderSong(const lsdj_song_t* song, const ghc::filesystem::path& destination)
+    {
+        FILE* file = fopen(destination.string().c_str(), "wb");
+        if (file == nullptr)
+            return handle_error(LSDJ_FILE_OPEN_FAILED) == 0;
+        
+        const auto start = std::chrono::steady_clock::now();
+        
+        lsdj_vio_t wvio = lsdj_create_file_vio(file);
+        const lsdj_error_t error = lsdj_render_wav(song, sampleRate, channelMask, &wvio, nullptr, nullptr);
+        fclose(file);
+        
+        if (error != LSDJ_SUCCESS)
+            return handle_error(error) == 0;
+        
+        if (verbose)
+        {
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            const double seconds = static_cast<double>(lsdj_render_get_frame_count(song, sampleRate)) / sampleRate;
+            
+            std::cout << "Rendered '" << destination.filename().string() << "' (" << std::fixed << std::setprecision(1) << seconds << "s of audio in " << elapsed.count() << "s)" << std::endl;
+        }
+        
+        return true;
+    }
+
+    ghc::filesystem::path SongRenderer::constructDestination(const ghc::filesystem::path& input, const std::string& name) const
+    {
+        auto folder = output.empty() ? input.parent_path() : ghc::filesystem::absolute(output);
+        return folder / (name + ".wav");
+    }
+}
@@ -0,0 +1,71 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#ifndef LSDJ_SONG_RENDERER_HPP
+#define LSDJ_SONG_RENDERER_HPP
+
+#include <string>
+
+#include <ghc/filesystem.hpp>
+
+#include <lsdj/render.h>
+#include <lsdj/song.h>
+
+namespace lsdj
+{
+    //! Renders the songs in sav and lsdsng files to WAV files
+    class SongRenderer
+    {
+    public:
+        bool render(const ghc::filesystem::path& path);
+        
+    public:
+        unsigned int sampleRate = 44100;
+        unsigned int channelMask = LSDJ_RENDER_ALL_CHANNELS;
+        bool verbose = false;
+        
+        //! The folder to write to, or empty to write next to the input files
+        std::string output;
+        
+    private:
+        bool renderSav(const ghc::filesystem::path& path);
+        bool renderLsdsng(const ghc::filesystem::path& path);
+        bool renderSong(const lsdj_song_t* song, const ghc::filesystem::path& destination);
+        
+        ghc::filesystem::path constructDestination(const ghc::filesystem::path& input, const std::string& name) const;
+    };
+}
+
+#endif
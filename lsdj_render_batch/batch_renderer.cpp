@@ -0,0 +1,136 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include "batch_renderer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <vector>
+
+namespace lsdj
+{
+    namespace
+    {
+        //! The amount of audio rendered before it is written to disk
+        constexpr unsigned int CHUNK_SECONDS = 1;
+    }
+
+    bool BatchRenderer::processSong(lsdj_song_t* song, const ghc::filesystem::path& source, const std::string& name)
+    {
+        // Empty songs (such as unused working memory) have nothing to render
+        const size_t frameCount = lsdj_render_get_frame_count(song, sampleRate);
+        if (frameCount == 0)
+            return true;
+        
+        lsdj_renderer_t* renderer = nullptr;
+        const lsdj_error_t error = lsdj_renderer_new(song, sampleRate, &renderer, nullptr);
+        if (error != LSDJ_SUCCESS)
+        {
+            logError(error);
+            return false;
+        }
+        
+        const bool succeeded = renderSong(renderer, frameCount, constructDestination(source, name));
+        lsdj_renderer_free(renderer);
+        
+        return succeeded;
+    }
+
+    bool BatchRenderer::renderSong(lsdj_renderer_t* renderer, size_t frameCount, const ghc::filesystem::path& destination)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        
+        FILE* file = fopen(destination.string().c_str(), "wb");
+        if (file == nullptr)
+        {
+            logError(LSDJ_FILE_OPEN_FAILED);
+            return false;
+        }
+        
+        lsdj_vio_t wvio = lsdj_create_file_vio(file);
+        lsdj_error_t error = lsdj_render_write_wav_header(sampleRate, frameCount, &wvio, nullptr);
+        
+        const size_t chunkFrameCount = sampleRate * CHUNK_SECONDS;
+        const size_t chunkSampleCount = chunkFrameCount * LSDJ_RENDER_FRAME_SAMPLE_COUNT;
+        
+        std::vector<int16_t> frames(chunkSampleCount);
+        std::vector<uint8_t> bytes(chunkSampleCount * sizeof(int16_t));
+        
+        while (error == LSDJ_SUCCESS)
+        {
+            const size_t sampleCount = lsdj_renderer_render(renderer, frames.data(), chunkFrameCount) * LSDJ_RENDER_FRAME_SAMPLE_COUNT;
+            if (sampleCount == 0)
+                break;
+            
+            for (size_t i = 0; i < sampleCount; ++i)
+            {
+                const auto sample = static_cast<uint16_t>(frames[i]);
+                bytes[i * 2 + 0] = static_cast<uint8_t>(sample & 0xFF);
+                bytes[i * 2 + 1] = static_cast<uint8_t>(sample >> 8);
+            }
+            
+            if (!lsdj_vio_write(&wvio, bytes.data(), sampleCount * sizeof(int16_t), nullptr))
+                error = LSDJ_WRITE_FAILED;
+        }
+        
+        fclose(file);
+        
+        if (error != LSDJ_SUCCESS)
+        {
+            logError(error);
+            return false;
+        }
+        
+        ++songCount;
+        renderedFrameCount += frameCount;
+        
+        if (verbose)
+        {
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            const double seconds = static_cast<double>(frameCount) / sampleRate;
+            
+            log() << "Rendered '" << destination.filename().string() << "' (" << std::fixed << std::setprecision(1) << seconds << "s of audio in " << std::setprecision(3) << elapsed.count() << "s, " << std::setprecision(0) << seconds / elapsed.count() << "x realtime)" << std::endl;
+        }
+        
+        return true;
+    }
+
+    ghc::filesystem::path BatchRenderer::constructDestination(const ghc::filesystem::path& source, const std::string& name) const
+    {
+        auto folder = output.empty() ? source.parent_path() : ghc::filesystem::absolute(output);
+        return folder / (name + ".wav");
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#ifndef LSDJ_BATCH_RENDERER_HPP
+#define LSDJ_BATCH_RENDERER_HPP
+
+#include <atomic>
+#include <string>
+
+#include <ghc/filesystem.hpp>
+
+#include <lsdj/render.h>
+#include <lsdj/song.h>
+
+#include "../common/song_processor.hpp"
+
+namespace lsdj
+{
+    //! Renders every song found in sav's, lsdsng's and folders to WAV files
+    /*! Every song is rendered as a full mix by a single renderer. With jobs, several files
+        are rendered at the same time, and their output is still printed in order. */
+    class BatchRenderer : public SongProcessor
+    {
+    public:
+        [[nodiscard]] size_t getSongCount() const { return songCount; }
+        [[nodiscard]] size_t getFrameCount() const { return renderedFrameCount; }
+        
+    public:
+        unsigned int sampleRate = 44100;
+        
+        //! The folder to write to, or empty to write next to the input files
+        std::string output;
+        
+    private:
+        [[nodiscard]] bool shouldWriteSongs() const final { return false; }
+        
+        bool processSong(lsdj_song_t* song, const ghc::filesystem::path& source, const std::string& name) final;
+        
+        bool renderSong(lsdj_renderer_t* renderer, size_t frameCount, const ghc::filesystem::path& destination);
+        
+        ghc::filesystem::path constructDestination(const ghc::filesystem::path& source, const std::string& name) const;
+        
+    private:
+        std::atomic<size_t> songCount{0};
+        std::atomic<size_t> renderedFrameCount{0};
+    };
+}
+
+#endif
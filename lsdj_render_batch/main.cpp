@@ -0,0 +1,124 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#include <ghc/filesystem.hpp>
+#include <popl/popl.hpp>
+
+#include <lsdj/version.h>
+
+#include "batch_renderer.hpp"
+#include "../common/stream.hpp"
+
+void printHelp(const popl::OptionParser& options)
+{
+    std::cout << "lsdj-render-batch mymusic.sav|mymusic.lsdsng|folder|- ...\n\n"
+              << "Version: " << LSDJ_VERSION_STRING << "\n\n"
+              << options << "\n\n";
+
+    std::cout << "LibLSDJ is open source and freely available to anyone.\nIf you'd like to show your appreciation, please consider\n  - buying one of my albums (https://4ntler.bandcamp.com)\n  - donating money through PayPal (https://paypal.me/4ntler).\n";
+}
+
+int main(int argc, char* argv[])
+{
+    popl::OptionParser options("Options");
+    auto help = options.add<popl::Switch>("h", "help", "Show the help screen");
+    auto verbose = options.add<popl::Switch>("v", "verbose", "Verbose output during rendering");
+    auto output = options.add<popl::Value<std::string>>("o", "output", "The folder to write the WAV files to");
+    auto rate = options.add<popl::Value<unsigned int>>("r", "rate", "The sample rate to render at", 44100);
+    auto jobs = options.add<popl::Value<unsigned int>>("j", "jobs", "The amount of files to render simultaneously", 1);
+    
+    try
+    {
+        options.parse(argc, argv);
+        
+        const auto inputs = options.non_option_args();
+        
+        if (help->is_set())
+        {
+            printHelp(options);
+            return 0;
+        } else if (!inputs.empty()) {
+            
+            if (rate->value() == 0)
+            {
+                printHelp(options);
+                return 1;
+            }
+            
+            const auto start = std::chrono::steady_clock::now();
+            
+            lsdj::BatchRenderer renderer;
+            
+            renderer.verbose = verbose->is_set();
+            renderer.jobs = jobs->value();
+            renderer.sampleRate = rate->value();
+            if (output->is_set())
+                renderer.output = output->value();
+            
+            bool success = true;
+            for (auto& input : inputs)
+            {
+                if (!renderer.process(lsdj::absoluteUnlessStandardStream(input)))
+                {
+                    success = false;
+                    break;
+                }
+            }
+            
+            if (renderer.verbose)
+            {
+                const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                const double seconds = static_cast<double>(renderer.getFrameCount()) / renderer.sampleRate;
+                
+                std::cout << "Rendered " << renderer.getSongCount() << " song(s), " << std::fixed << std::setprecision(1) << seconds << "s of audio in " << std::setprecision(3) << elapsed.count() << "s (" << std::setprecision(0) << seconds / elapsed.count() << "x realtime)" << std::endl;
+            }
+            
+            return success ? 0 : 1;
+        } else {
+            printHelp(options);
+            return 0;
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+    }
+
+	return 0;
+}
@@ -0,0 +1,203 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+
+#include <ghc/filesystem.hpp>
+#include <popl/popl.hpp>
+
+#include <lsdj/version.h>
+
+#include "../common/song_library.hpp"
+#include "../common/thread_pool.hpp"
+#include "search_index.hpp"
+
+void printHelp(const popl::OptionParser& options)
+{
+    std::cout << "lsdj-search -i library.search mymusic.sav|mymusic.lsdsng|folder ...\n"
+              << "lsdj-search -i library.search [--name name] [--instrument name] [--word name] [--type kit] [--speech] [--kits] [--synths] [--min-bpm 150] [--max-bpm 200]\n\n"
+              << "Version: " << LSDJ_VERSION_STRING << "\n\n"
+              << options << "\n\n";
+
+    std::cout << "LibLSDJ is open source and freely available to anyone.\nIf you'd like to show your appreciation, please consider\n  - buying one of my albums (https://4ntler.bandcamp.com)\n  - donating money through PayPal (https://paypal.me/4ntler).\n";
+}
+
+//! Build a search index over all songs in the inputs
+int build(const ghc::filesystem::path& indexPath, const std::vector<std::string>& inputs, unsigned int jobs, bool verbose)
+{
+    // Songs are numbered in path order, so building twice gives the same index
+    const auto paths = lsdj::collectSongFiles(inputs);
+    
+    std::vector<std::vector<lsdj::SearchSong>> files(paths.size());
+    std::vector<char> succeeded(paths.size(), false);
+    lsdj::ThreadPool::forEach(jobs, paths.size(), [&](size_t i)
+    {
+        succeeded[i] = lsdj::SearchIndex::scan(paths[i], files[i]);
+    });
+    
+    std::vector<lsdj::SearchSong> songs;
+    size_t fileCount = 0;
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        if (!succeeded[i])
+        {
+            std::cerr << "Could not read '" << paths[i].string() << "'" << std::endl;
+            continue;
+        }
+        
+        if (verbose)
+            std::cout << "Indexed " << paths[i].string() << std::endl;
+        
+        ++fileCount;
+        std::move(files[i].begin(), files[i].end(), std::back_inserter(songs));
+    }
+    
+    if (!lsdj::SearchIndex::write(indexPath, songs))
+    {
+        std::cerr << "Could not write '" << indexPath.string() << "'" << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Indexed " << songs.size() << " song(s) in " << fileCount << " file(s)" << std::endl;
+    
+    return 0;
+}
+
+//! Add a term for every value of an option
+void addTerms(const std::shared_ptr<popl::Value<std::string>>& option, const std::string& prefix, std::vector<std::string>& terms)
+{
+    for (size_t i = 0; i < option->count(); ++i)
+    {
+        const auto value = option->value(i);
+        terms.emplace_back(prefix + lsdj::SearchIndex::normalize(value.data(), value.size()));
+    }
+}
+
+//! Print the songs in an index that have all of the terms and fall within a tempo range
+int query(const ghc::filesystem::path& indexPath, const std::vector<std::string>& terms, unsigned int minimumTempo, unsigned int maximumTempo, bool verbose)
+{
+    const auto start = std::chrono::steady_clock::now();
+    
+    lsdj::SearchIndex index;
+    if (!index.open(indexPath))
+    {
+        std::cerr << "'" << indexPath.string() << "' is not a search index" << std::endl;
+        return 1;
+    }
+    
+    // The tempo sits in the song records, which are only read for the songs the terms let through
+    size_t count = 0;
+    for (const auto song : index.intersect(terms))
+    {
+        const auto tempo = index.getTempo(song);
+        if (tempo < minimumTempo || tempo > maximumTempo)
+            continue;
+        
+        const auto entry = index.getSong(song);
+        std::cout << entry.path << '\t' << lsdj::formatSlot(entry.slot) << '\t' << entry.name << '\t' << entry.tempo << '\n';
+        ++count;
+    }
+    
+    std::cout << std::flush;
+    
+    if (verbose)
+    {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        std::cerr << count << " of " << index.getSongCount() << " song(s) matched in " << (static_cast<double>(elapsed.count()) / 1000.0) << " ms" << std::endl;
+    }
+    
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    popl::OptionParser options("Options");
+    auto help = options.add<popl::Switch>("h", "help", "Show the help screen");
+    auto verbose = options.add<popl::Switch>("v", "verbose", "Verbose output while indexing, timing while searching");
+    auto indexFile = options.add<popl::Value<std::string>>("i", "index", "The search index to build or query", "library.search");
+    auto jobs = options.add<popl::Value<unsigned int>>("j", "jobs", "The amount of files to read simultaneously", 1);
+    auto name = options.add<popl::Value<std::string>>("n", "name", "Only songs with a given name");
+    auto instrument = options.add<popl::Value<std::string>>("", "instrument", "Only songs with an instrument of a given name (repeatable)");
+    auto word = options.add<popl::Value<std::string>>("", "word", "Only songs with a speech word of a given name (repeatable)");
+    auto type = options.add<popl::Value<std::string>>("", "type", "Only songs playing an instrument of a type: pulse, wave, kit or noise (repeatable)");
+    auto speech = options.add<popl::Switch>("", "speech", "Only songs playing speech");
+    auto kits = options.add<popl::Switch>("", "kits", "Only songs playing kit instruments");
+    auto synths = options.add<popl::Switch>("", "synths", "Only songs playing wave instruments through the synth");
+    auto minimumTempo = options.add<popl::Value<unsigned int>>("", "min-bpm", "Only songs with at least this tempo", 0);
+    auto maximumTempo = options.add<popl::Value<unsigned int>>("", "max-bpm", "Only songs with at most this tempo", 0xFFFF);
+    
+    try
+    {
+        options.parse(argc, argv);
+        
+        const auto inputs = options.non_option_args();
+        const auto indexPath = ghc::filesystem::absolute(indexFile->value());
+        
+        if (help->is_set())
+        {
+            printHelp(options);
+            return 0;
+        } else if (!inputs.empty()) {
+            return build(indexPath, inputs, jobs->value(), verbose->is_set());
+        } else if (ghc::filesystem::exists(indexPath)) {
+            std::vector<std::string> terms;
+            addTerms(name, "name:", terms);
+            addTerms(instrument, "instrument:", terms);
+            addTerms(word, "word:", terms);
+            addTerms(type, "type:", terms);
+            if (speech->is_set())
+                terms.emplace_back("has:speech");
+            if (kits->is_set())
+                terms.emplace_back("has:kit");
+            if (synths->is_set())
+                terms.emplace_back("has:synth");
+            
+            return query(indexPath, terms, minimumTempo->value(), maximumTempo->value(), verbose->is_set());
+        } else {
+            printHelp(options);
+            return 0;
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+    }
+
+	return 0;
+}
@@ -0,0 +1,535 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#include "search_index.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <map>
+
+#include <lsdj/index.h>
+#include <lsdj/instrument.h>
+#include <lsdj/phrase.h>
+#include <lsdj/project.h>
+#include <lsdj/song.h>
+#include <lsdj/speech.h>
+
+#include "../common/index_file.hpp"
+#include "../common/song_library.hpp"
+
+namespace lsdj
+{
+    namespace
+    {
+        constexpr IndexMagic MAGIC = { 'L', 'S', 'D', 'J', 'S', 'R', 'C', 0 };
+        constexpr uint32_t FORMAT_VERSION = 1;
+        
+        constexpr size_t HEADER_SIZE = 32;
+        constexpr size_t SONG_RECORD_SIZE = 24;
+        constexpr size_t TERM_RECORD_SIZE = 20;
+        
+        constexpr uint32_t BLOCK_LENGTH = 128;
+        constexpr size_t SKIP_SIZE = 8;
+        
+        // Phrases select the speech synthesizer through the instrument right after the regular ones
+        constexpr uint8_t SPEECH_INSTRUMENT = LSDJ_INSTRUMENT_COUNT;
+        
+        void appendVariable(std::vector<uint8_t>& data, uint32_t value)
+        {
+            while (value >= 0x80)
+            {
+                data.emplace_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            data.emplace_back(static_cast<uint8_t>(value));
+        }
+        
+        //! Encode the postings of a single term, see the format description in search_index.hpp
+        void appendPostings(std::vector<uint8_t>& data, const std::vector<uint32_t>& songs)
+        {
+            const size_t blockCount = (songs.size() + BLOCK_LENGTH - 1) / BLOCK_LENGTH;
+            
+            std::vector<uint8_t> blocks;
+            std::vector<uint8_t> skips;
+            for (size_t block = 0; block < blockCount; ++block)
+            {
+                const size_t begin = block * BLOCK_LENGTH;
+                const size_t end = std::min<size_t>(begin + BLOCK_LENGTH, songs.size());
+                
+                appendLittleEndian(skips, songs[begin], 4);
+                appendLittleEndian(skips, blocks.size(), 4);
+                
+                for (size_t i = begin + 1; i < end; ++i)
+                    appendVariable(blocks, songs[i] - songs[i - 1]);
+            }
+            
+            data.insert(data.end(), skips.begin(), skips.end());
+            data.insert(data.end(), blocks.begin(), blocks.end());
+        }
+        
+        const char* typeName(lsdj_instrument_type_t type)
+        {
+            switch (type)
+            {
+                case LSDJ_INSTRUMENT_TYPE_PULSE: return "pulse";
+                case LSDJ_INSTRUMENT_TYPE_WAVE: return "wave";
+                case LSDJ_INSTRUMENT_TYPE_KIT: return "kit";
+                case LSDJ_INSTRUMENT_TYPE_NOISE: return "noise";
+                default: return "unknown";
+            }
+        }
+        
+        bool usesSpeech(const lsdj_song_t* song, const lsdj_song_index_t* index)
+        {
+            for (uint8_t phrase = 0; phrase < LSDJ_PHRASE_COUNT; ++phrase)
+            {
+                if (!lsdj_song_index_is_phrase_used(index, phrase))
+                    continue;
+                
+                for (uint8_t step = 0; step < LSDJ_PHRASE_LENGTH; ++step)
+                {
+                    if (lsdj_phrase_get_instrument(song, phrase, step) == SPEECH_INSTRUMENT)
+                        return true;
+                }
+            }
+            
+            return false;
+        }
+        
+        bool describe(const lsdj_song_t* song, uint8_t slot, const char* name, SearchSong& entry)
+        {
+            lsdj_song_index_t* index = nullptr;
+            if (lsdj_song_index_new(song, &index, nullptr) != LSDJ_SUCCESS)
+                return false;
+            
+            entry.slot = slot;
+            if (name)
+                entry.name = std::string(name, strnlen(name, LSDJ_PROJECT_NAME_LENGTH));
+            entry.tempo = lsdj_song_get_tempo(song);
+            
+            auto& terms = entry.terms;
+            terms.clear();
+            
+            const auto normalizedName = SearchIndex::normalize(entry.name.data(), entry.name.size());
+            if (!normalizedName.empty())
+                terms.emplace_back("name:" + normalizedName);
+            
+            // Names are searchable as long as the instrument exists, but only instruments
+            // the song actually plays count towards the types and features it uses
+            for (uint8_t instrument = 0; instrument < LSDJ_INSTRUMENT_COUNT; ++instrument)
+            {
+                if (!lsdj_instrument_is_allocated(song, instrument))
+                    continue;
+                
+                const auto instrumentName = SearchIndex::normalize(lsdj_instrument_get_name(song, instrument), LSDJ_INSTRUMENT_NAME_LENGTH);
+                if (!instrumentName.empty())
+                    terms.emplace_back("instrument:" + instrumentName);
+                
+                if (!lsdj_song_index_is_instrument_used(index, instrument))
+                    continue;
+                
+                const auto type = lsdj_instrument_get_type(song, instrument);
+                terms.emplace_back(std::string("type:") + typeName(type));
+                
+                if (type == LSDJ_INSTRUMENT_TYPE_KIT)
+                    terms.emplace_back("has:kit");
+                else if (type == LSDJ_INSTRUMENT_TYPE_WAVE && lsdj_instrument_wave_get_play_mode(song, instrument) != LSDJ_INSTRUMENT_WAVE_PLAY_MANUAL)
+                    terms.emplace_back("has:synth");
+            }
+            
+            if (usesSpeech(song, index))
+                terms.emplace_back("has:speech");
+            
+            // Only words that say something, the rest still carry their default names
+            for (uint8_t word = 0; word < LSDJ_SPEECH_WORD_COUNT; ++word)
+            {
+                if (lsdj_speech_get_word_allophone(song, word, 0) == LSDJ_SPEECH_WORD_NO_ALLOPHONE_VALUE)
+                    continue;
+                
+                const auto wordName = SearchIndex::normalize(lsdj_speech_get_word_name(song, word), LSDJ_SPEECH_WORD_NAME_LENGTH);
+                if (!wordName.empty())
+                    terms.emplace_back("word:" + wordName);
+            }
+            
+            std::sort(terms.begin(), terms.end());
+            terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+            
+            lsdj_song_index_free(index);
+            return true;
+        }
+    }
+    
+    constexpr uint8_t SearchSong::WORKING_MEMORY;
+    constexpr uint8_t SearchSong::LSDSNG;
+    constexpr uint32_t Postings::END;
+    
+    Postings::Postings(const uint8_t* begin, const uint8_t* end, uint32_t count) :
+        skips(begin),
+        blocks(begin + ((count + BLOCK_LENGTH - 1) / BLOCK_LENGTH) * SKIP_SIZE),
+        end(end),
+        count(count),
+        blockCount((count + BLOCK_LENGTH - 1) / BLOCK_LENGTH)
+    {
+        if (blocks > end)
+            this->count = blockCount = 0;
+        
+        if (this->count > 0)
+            enterBlock(0);
+    }
+
+    uint32_t Postings::next()
+    {
+        if (current == END)
+            return END;
+        
+        if (remaining == 0)
+        {
+            if (block + 1 < blockCount)
+                enterBlock(block + 1);
+            else
+                current = END;
+            return current;
+        }
+        
+        uint32_t delta = 0;
+        for (unsigned int shift = 0; ; shift += 7)
+        {
+            // Running off the end of the postings means the index is corrupt, so just stop
+            if (position == end || shift > 28)
+                return current = END;
+            
+            const uint8_t byte = *position++;
+            delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                break;
+        }
+        
+        --remaining;
+        return current += delta;
+    }
+
+    uint32_t Postings::advance(uint32_t target)
+    {
+        if (current == END || current >= target)
+            return current;
+        
+        // Skip every block that starts at or before the target, except the last one
+        if (block + 1 < blockCount && readLittleEndian(skips + (block + 1) * SKIP_SIZE, 4) <= target)
+        {
+            uint32_t low = block + 1;
+            uint32_t high = blockCount;
+            while (high - low > 1)
+            {
+                const uint32_t middle = low + (high - low) / 2;
+                if (readLittleEndian(skips + middle * SKIP_SIZE, 4) <= target)
+                    low = middle;
+                else
+                    high = middle;
+            }
+            
+            enterBlock(low);
+        }
+        
+        while (current < target)
+            next();
+        
+        return current;
+    }
+
+    void Postings::enterBlock(uint32_t index)
+    {
+        block = index;
+        current = static_cast<uint32_t>(readLittleEndian(skips + index * SKIP_SIZE, 4));
+        position = blocks + readLittleEndian(skips + index * SKIP_SIZE + 4, 4);
+        remaining = std::min(BLOCK_LENGTH, count - index * BLOCK_LENGTH) - 1;
+        
+        if (position > end)
+            current = END;
+    }
+
+    bool SearchIndex::open(const ghc::filesystem::path& path)
+    {
+        close();
+        
+        if (!file.open(path))
+            return false;
+        
+        // Check that everything the header promises is actually there, so lookups don't need to
+        const uint8_t* data = file.data();
+        if (!hasIndexHeader(file, MAGIC, FORMAT_VERSION, HEADER_SIZE))
+        {
+            close();
+            return false;
+        }
+        
+        songCount = readLittleEndian(data + 12, 4);
+        termCount = readLittleEndian(data + 16, 4);
+        stringsOffset = readLittleEndian(data + 20, 4);
+        
+        const size_t postingsOffset = HEADER_SIZE + songCount * SONG_RECORD_SIZE + termCount * TERM_RECORD_SIZE;
+        if (postingsOffset > stringsOffset || stringsOffset > file.size())
+        {
+            close();
+            return false;
+        }
+        
+        for (uint32_t i = 0; i < songCount; ++i)
+        {
+            const uint8_t* record = getSongRecord(i);
+            if (stringsOffset + readLittleEndian(record + 8, 4) + readLittleEndian(record + 12, 4) > file.size())
+            {
+                close();
+                return false;
+            }
+        }
+        
+        for (uint32_t i = 0; i < termCount; ++i)
+        {
+            const uint8_t* record = getTermRecord(i);
+            const size_t postings = readLittleEndian(record + 8, 4);
+            if (stringsOffset + readLittleEndian(record, 4) + readLittleEndian(record + 4, 2) > file.size() ||
+                postings < postingsOffset || postings + readLittleEndian(record + 12, 4) > stringsOffset)
+            {
+                close();
+                return false;
+            }
+        }
+        
+        return true;
+    }
+
+    void SearchIndex::close()
+    {
+        file.close();
+        songCount = 0;
+        termCount = 0;
+        stringsOffset = 0;
+    }
+
+    SearchSong SearchIndex::getSong(uint32_t index) const
+    {
+        const uint8_t* record = getSongRecord(index);
+        
+        SearchSong song;
+        song.name = std::string(reinterpret_cast<const char*>(record), strnlen(reinterpret_cast<const char*>(record), LSDJ_PROJECT_NAME_LENGTH));
+        song.path = std::string(reinterpret_cast<const char*>(file.data() + stringsOffset + readLittleEndian(record + 8, 4)), readLittleEndian(record + 12, 4));
+        song.tempo = static_cast<unsigned short>(readLittleEndian(record + 16, 2));
+        song.slot = record[18];
+        
+        return song;
+    }
+
+    unsigned short SearchIndex::getTempo(uint32_t index) const
+    {
+        return static_cast<unsigned short>(readLittleEndian(getSongRecord(index) + 16, 2));
+    }
+
+    Postings SearchIndex::find(const std::string& term) const
+    {
+        // Terms are sorted, so a binary search only touches a handful of pages
+        size_t begin = 0;
+        size_t end = termCount;
+        while (begin < end)
+        {
+            const size_t middle = begin + (end - begin) / 2;
+            const uint8_t* record = getTermRecord(static_cast<uint32_t>(middle));
+            
+            const size_t length = readLittleEndian(record + 4, 2);
+            int order = memcmp(file.data() + stringsOffset + readLittleEndian(record, 4), term.data(), std::min(length, term.size()));
+            if (order == 0)
+                order = length < term.size() ? -1 : length > term.size() ? 1 : 0;
+            
+            if (order == 0)
+            {
+                const uint8_t* postings = file.data() + readLittleEndian(record + 8, 4);
+                return Postings(postings, postings + readLittleEndian(record + 12, 4), static_cast<uint32_t>(readLittleEndian(record + 16, 4)));
+            }
+            else if (order < 0)
+                begin = middle + 1;
+            else
+                end = middle;
+        }
+        
+        return Postings();
+    }
+
+    std::vector<uint32_t> SearchIndex::intersect(const std::vector<std::string>& terms) const
+    {
+        std::vector<uint32_t> songs;
+        
+        if (terms.empty())
+        {
+            songs.resize(songCount);
+            for (uint32_t i = 0; i < songCount; ++i)
+                songs[i] = i;
+            return songs;
+        }
+        
+        std::vector<Postings> lists;
+        for (const auto& term : terms)
+        {
+            lists.emplace_back(find(term));
+            if (lists.back().size() == 0)
+                return songs;
+        }
+        
+        // The shortest postings lead, and the others only jump to the songs it proposes
+        std::sort(lists.begin(), lists.end(), [](const Postings& lhs, const Postings& rhs){ return lhs.size() < rhs.size(); });
+        
+        uint32_t candidate = lists[0].song();
+        while (candidate != Postings::END)
+        {
+            bool matches = true;
+            for (size_t i = 1; i < lists.size(); ++i)
+            {
+                const uint32_t song = lists[i].advance(candidate);
+                if (song != candidate)
+                {
+                    candidate = song == Postings::END ? song : lists[0].advance(song);
+                    matches = false;
+                    break;
+                }
+            }
+            
+            if (matches)
+            {
+                if (candidate < songCount)
+                    songs.emplace_back(candidate);
+                candidate = lists[0].next();
+            }
+        }
+        
+        return songs;
+    }
+
+    bool SearchIndex::write(const ghc::filesystem::path& path, const std::vector<SearchSong>& songs)
+    {
+        std::map<std::string, std::vector<uint32_t>> postings;
+        for (uint32_t i = 0; i < songs.size(); ++i)
+        {
+            for (const auto& term : songs[i].terms)
+                postings[term].emplace_back(i);
+        }
+        
+        std::vector<uint8_t> strings;
+        std::vector<uint8_t> records;
+        for (const auto& song : songs)
+        {
+            std::array<uint8_t, LSDJ_PROJECT_NAME_LENGTH> name = {};
+            std::copy_n(song.name.begin(), std::min(song.name.size(), name.size()), name.begin());
+            records.insert(records.end(), name.begin(), name.end());
+            
+            appendLittleEndian(records, strings.size(), 4);
+            appendLittleEndian(records, song.path.size(), 4);
+            appendLittleEndian(records, song.tempo, 2);
+            records.emplace_back(song.slot);
+            appendLittleEndian(records, 0, 5);
+            
+            strings.insert(strings.end(), song.path.begin(), song.path.end());
+        }
+        
+        const size_t postingsOffset = HEADER_SIZE + songs.size() * SONG_RECORD_SIZE + postings.size() * TERM_RECORD_SIZE;
+        
+        std::vector<uint8_t> encoded;
+        for (const auto& term : postings)
+        {
+            const size_t begin = encoded.size();
+            appendPostings(encoded, term.second);
+            
+            appendLittleEndian(records, strings.size(), 4);
+            appendLittleEndian(records, term.first.size(), 2);
+            appendLittleEndian(records, 0, 2);
+            appendLittleEndian(records, postingsOffset + begin, 4);
+            appendLittleEndian(records, encoded.size() - begin, 4);
+            appendLittleEndian(records, term.second.size(), 4);
+            
+            strings.insert(strings.end(), term.first.begin(), term.first.end());
+        }
+        
+        std::vector<uint8_t> data(MAGIC.begin(), MAGIC.end());
+        appendLittleEndian(data, FORMAT_VERSION, 4);
+        appendLittleEndian(data, songs.size(), 4);
+        appendLittleEndian(data, postings.size(), 4);
+        appendLittleEndian(data, postingsOffset + encoded.size(), 4);
+        appendLittleEndian(data, 0, 8);
+        
+        data.insert(data.end(), records.begin(), records.end());
+        data.insert(data.end(), encoded.begin(), encoded.end());
+        data.insert(data.end(), strings.begin(), strings.end());
+        
+        return writeIndex(path, data);
+    }
+
+    bool SearchIndex::scan(const ghc::filesystem::path& path, std::vector<SearchSong>& songs)
+    {
+        songs.clear();
+        
+        bool described = true;
+        const bool read = readSongs(path, [&](const lsdj_song_t* song, uint8_t slot, const char* name, uint8_t)
+        {
+            SearchSong entry;
+            entry.path = path.string();
+            if (describe(song, slot, name, entry))
+                songs.emplace_back(std::move(entry));
+            else
+                described = false;
+        });
+        
+        return read && described;
+    }
+
+    std::string SearchIndex::normalize(const char* name, size_t length)
+    {
+        std::string result(name, strnlen(name, length));
+        while (!result.empty() && result.back() == ' ')
+            result.pop_back();
+        
+        std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+        return result;
+    }
+
+    const uint8_t* SearchIndex::getSongRecord(uint32_t index) const
+    {
+        return file.data() + HEADER_SIZE + index * SONG_RECORD_SIZE;
+    }
+
+    const uint8_t* SearchIndex::getTermRecord(uint32_t index) const
+    {
+        return file.data() + HEADER_SIZE + songCount * SONG_RECORD_SIZE + index * TERM_RECORD_SIZE;
+    }
+}
@@ -0,0 +1,173 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#ifndef LSDJ_SEARCH_INDEX_HPP
+#define LSDJ_SEARCH_INDEX_HPP
+
+#include <cstdint>
+#include <ghc/filesystem.hpp>
+#include <string>
+#include <vector>
+
+#include "../common/mapped_file.hpp"
+#include "../common/song_library.hpp"
+
+/* A search index maps terms describing songs to the songs they describe, so questions like
+   "which songs use kits and have a tempo over 150?" are answered without reading any of the
+   songs. All numbers are little endian.
+ 
+   - A header: the magic "LSDJSRC" followed by a zero byte, the format version, the amount of
+     songs, the amount of terms and the offset of the string table (all 32-bit), and 8
+     reserved bytes
+   - A 24-byte record for every song: its name (8 bytes), the offset and length of its path
+     in the string table (32-bit), its tempo (16-bit), its slot, and 5 reserved bytes
+   - A 20-byte record for every term, sorted: the offset (32-bit) and length (16-bit) of the
+     term in the string table, 2 reserved bytes, and the offset, size and amount of songs
+     of its postings (32-bit)
+   - The postings of every term: song indices in ascending order, split into blocks of 128.
+     A skip table lists the first song and the byte offset of every block, followed by the
+     blocks themselves, which store the distance to every next song as a variable length
+     integer. Looking for a song only decodes the one block that might contain it.
+   - The string table with all paths and terms
+ 
+   Terms are lower case, and look like "name:mysong", "instrument:kick", "word:hey",
+   "type:pulse|wave|kit|noise" and "has:speech|kit|synth". */
+
+namespace lsdj
+{
+    //! A song in a search index
+    struct SearchSong
+    {
+        //! The slot of a working memory song
+        static constexpr uint8_t WORKING_MEMORY = WORKING_MEMORY_SLOT;
+        
+        //! The slot of the song in an .lsdsng
+        static constexpr uint8_t LSDSNG = LSDSNG_SLOT;
+        
+        std::string path;
+        
+        //! The project index in a sav, or one of the special slots above
+        uint8_t slot = LSDSNG;
+        
+        std::string name;
+        unsigned short tempo = 0;
+        
+        //! The terms describing the song, only used while building an index
+        std::vector<std::string> terms;
+    };
+    
+    //! Walks through the songs of a single term, in ascending order
+    class Postings
+    {
+    public:
+        //! The value of song() once the postings are exhausted
+        static constexpr uint32_t END = 0xFFFFFFFF;
+        
+        Postings() = default;
+        Postings(const uint8_t* begin, const uint8_t* end, uint32_t count);
+        
+        uint32_t size() const { return count; }
+        
+        //! The current song, or END
+        uint32_t song() const { return current; }
+        
+        //! Move to the next song
+        uint32_t next();
+        
+        //! Move to the first song at or past a target
+        /*! Jumps straight to the block that might contain the target through the skip table */
+        uint32_t advance(uint32_t target);
+        
+    private:
+        void enterBlock(uint32_t block);
+        
+    private:
+        const uint8_t* skips = nullptr;
+        const uint8_t* blocks = nullptr;
+        const uint8_t* end = nullptr;
+        const uint8_t* position = nullptr;
+        
+        uint32_t count = 0;
+        uint32_t blockCount = 0;
+        uint32_t block = 0;
+        uint32_t remaining = 0;
+        uint32_t current = END;
+    };
+    
+    //! A search index on disk, mapped into memory so a query only touches the postings it needs
+    class SearchIndex
+    {
+    public:
+        //! Map a search index file
+        /*! @return False if it doesn't exist or isn't a valid search index */
+        bool open(const ghc::filesystem::path& path);
+        void close();
+        
+        size_t getSongCount() const { return songCount; }
+        SearchSong getSong(uint32_t index) const;
+        unsigned short getTempo(uint32_t index) const;
+        
+        //! Find the postings of a term
+        /*! @return The postings, which are empty if no song has the term */
+        Postings find(const std::string& term) const;
+        
+        //! Find the songs that have all of the given terms
+        /*! Walks the postings in lockstep starting from the shortest, so the cost depends on the
+            rarest term instead of the size of the library */
+        std::vector<uint32_t> intersect(const std::vector<std::string>& terms) const;
+        
+        //! Write a search index to disk
+        static bool write(const ghc::filesystem::path& path, const std::vector<SearchSong>& songs);
+        
+        //! Read the songs in a .sav or .lsdsng and describe them for the index
+        static bool scan(const ghc::filesystem::path& path, std::vector<SearchSong>& songs);
+        
+        //! Turn a name into the way it's spelled in a term
+        static std::string normalize(const char* name, size_t length);
+        
+    private:
+        const uint8_t* getSongRecord(uint32_t index) const;
+        const uint8_t* getTermRecord(uint32_t index) const;
+        
+    private:
+        MappedFile file;
+        size_t songCount = 0;
+        size_t termCount = 0;
+        size_t stringsOffset = 0;
+    };
+}
+
+#endif
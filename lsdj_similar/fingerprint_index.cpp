@@ -0,0 +1,345 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#include "fingerprint_index.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <unordered_set>
+
+#include <lsdj/project.h>
+
+#include "../common/index_file.hpp"
+#include "../common/song_library.hpp"
+
+namespace lsdj
+{
+    namespace
+    {
+        constexpr IndexMagic MAGIC = { 'L', 'S', 'D', 'J', 'F', 'P', 'R', 0 };
+        constexpr uint32_t FORMAT_VERSION = 1;
+        
+        constexpr size_t HEADER_SIZE = 32;
+        constexpr size_t SONG_RECORD_SIZE = 24 + LSDJ_FINGERPRINT_LENGTH * 4;
+        constexpr size_t BAND_ENTRY_SIZE = 12;
+        
+        bool isMoreSimilar(const SimilarSong& lhs, const SimilarSong& rhs)
+        {
+            if (lhs.similarity != rhs.similarity)
+                return lhs.similarity > rhs.similarity;
+            else if (lhs.song != rhs.song)
+                return lhs.song < rhs.song;
+            else
+                return lhs.other < rhs.other;
+        }
+    }
+    
+    constexpr uint8_t FingerprintSong::WORKING_MEMORY;
+    constexpr uint8_t FingerprintSong::LSDSNG;
+    
+    bool FingerprintIndex::open(const ghc::filesystem::path& path)
+    {
+        close();
+        
+        if (!file.open(path))
+            return false;
+        
+        // Check that everything the header promises is actually there, so lookups don't need to
+        const uint8_t* data = file.data();
+        if (!hasIndexHeader(file, MAGIC, FORMAT_VERSION, HEADER_SIZE))
+        {
+            close();
+            return false;
+        }
+        
+        songCount = readLittleEndian(data + 12, 4);
+        melodyCount = readLittleEndian(data + 16, 4);
+        stringsOffset = readLittleEndian(data + 20, 4);
+        
+        if (melodyCount > songCount ||
+            HEADER_SIZE + songCount * SONG_RECORD_SIZE + LSDJ_FINGERPRINT_BAND_COUNT * melodyCount * BAND_ENTRY_SIZE != stringsOffset ||
+            stringsOffset > file.size())
+        {
+            close();
+            return false;
+        }
+        
+        for (uint32_t i = 0; i < songCount; ++i)
+        {
+            const uint8_t* record = getSongRecord(i);
+            if (stringsOffset + readLittleEndian(record + 8, 4) + readLittleEndian(record + 12, 4) > file.size())
+            {
+                close();
+                return false;
+            }
+        }
+        
+        for (uint8_t band = 0; band < LSDJ_FINGERPRINT_BAND_COUNT; ++band)
+        {
+            for (size_t i = 0; i < melodyCount; ++i)
+            {
+                if (readLittleEndian(getBandEntry(band, i) + 8, 4) >= songCount)
+                {
+                    close();
+                    return false;
+                }
+            }
+        }
+        
+        return true;
+    }
+
+    void FingerprintIndex::close()
+    {
+        file.close();
+        songCount = 0;
+        melodyCount = 0;
+        stringsOffset = 0;
+    }
+
+    FingerprintSong FingerprintIndex::getSong(uint32_t index) const
+    {
+        const uint8_t* record = getSongRecord(index);
+        
+        FingerprintSong song;
+        song.name = std::string(reinterpret_cast<const char*>(record), strnlen(reinterpret_cast<const char*>(record), LSDJ_PROJECT_NAME_LENGTH));
+        song.path = std::string(reinterpret_cast<const char*>(file.data() + stringsOffset + readLittleEndian(record + 8, 4)), readLittleEndian(record + 12, 4));
+        song.slot = record[16];
+        getFingerprint(index, song.fingerprint);
+        
+        return song;
+    }
+
+    void FingerprintIndex::getFingerprint(uint32_t index, lsdj_fingerprint_t& fingerprint) const
+    {
+        const uint8_t* record = getSongRecord(index);
+        
+        fingerprint.ngramCount = static_cast<uint32_t>(readLittleEndian(record + 20, 4));
+        for (size_t i = 0; i < LSDJ_FINGERPRINT_LENGTH; ++i)
+            fingerprint.minimums[i] = static_cast<uint32_t>(readLittleEndian(record + 24 + i * 4, 4));
+    }
+
+    std::vector<SimilarSong> FingerprintIndex::findSimilar(const lsdj_fingerprint_t& fingerprint, size_t count) const
+    {
+        std::vector<SimilarSong> songs;
+        if (fingerprint.ngramCount == 0)
+            return songs;
+        
+        std::unordered_set<uint32_t> candidates;
+        for (uint8_t band = 0; band < LSDJ_FINGERPRINT_BAND_COUNT; ++band)
+        {
+            const auto bucket = findBucket(band, lsdj_fingerprint_hash_band(&fingerprint, band));
+            for (size_t i = bucket.first; i < bucket.second; ++i)
+                candidates.insert(static_cast<uint32_t>(readLittleEndian(getBandEntry(band, i) + 8, 4)));
+        }
+        
+        lsdj_fingerprint_t candidateFingerprint;
+        for (const auto candidate : candidates)
+        {
+            getFingerprint(candidate, candidateFingerprint);
+            
+            SimilarSong song;
+            song.song = candidate;
+            song.similarity = lsdj_fingerprint_similarity(&fingerprint, &candidateFingerprint);
+            songs.emplace_back(song);
+        }
+        
+        const auto end = songs.begin() + std::min(count, songs.size());
+        std::partial_sort(songs.begin(), end, songs.end(), isMoreSimilar);
+        songs.erase(end, songs.end());
+        
+        return songs;
+    }
+
+    std::vector<SimilarSong> FingerprintIndex::findDuplicates(double threshold) const
+    {
+        // Every pair sharing a bucket is a candidate, but it only needs comparing once
+        std::unordered_set<uint64_t> compared;
+        std::vector<SimilarSong> pairs;
+        
+        lsdj_fingerprint_t lhs;
+        lsdj_fingerprint_t rhs;
+        for (uint8_t band = 0; band < LSDJ_FINGERPRINT_BAND_COUNT; ++band)
+        {
+            size_t begin = 0;
+            while (begin < melodyCount)
+            {
+                const uint64_t hash = readLittleEndian(getBandEntry(band, begin), 8);
+                size_t end = begin + 1;
+                while (end < melodyCount && readLittleEndian(getBandEntry(band, end), 8) == hash)
+                    ++end;
+                
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const auto first = static_cast<uint32_t>(readLittleEndian(getBandEntry(band, i) + 8, 4));
+                    getFingerprint(first, lhs);
+                    
+                    for (size_t j = i + 1; j < end; ++j)
+                    {
+                        const auto second = static_cast<uint32_t>(readLittleEndian(getBandEntry(band, j) + 8, 4));
+                        if (!compared.insert((static_cast<uint64_t>(first) << 32) | second).second)
+                            continue;
+                        
+                        getFingerprint(second, rhs);
+                        
+                        SimilarSong pair;
+                        pair.song = first;
+                        pair.other = second;
+                        pair.similarity = lsdj_fingerprint_similarity(&lhs, &rhs);
+                        if (pair.similarity >= threshold)
+                            pairs.emplace_back(pair);
+                    }
+                }
+                
+                begin = end;
+            }
+        }
+        
+        std::sort(pairs.begin(), pairs.end(), isMoreSimilar);
+        return pairs;
+    }
+
+    bool FingerprintIndex::write(const ghc::filesystem::path& path, const std::vector<FingerprintSong>& songs)
+    {
+        std::vector<uint8_t> data(MAGIC.begin(), MAGIC.end());
+        
+        std::vector<uint32_t> melodies;
+        for (uint32_t i = 0; i < songs.size(); ++i)
+        {
+            if (songs[i].fingerprint.ngramCount > 0)
+                melodies.emplace_back(i);
+        }
+        
+        const size_t stringsOffset = HEADER_SIZE + songs.size() * SONG_RECORD_SIZE + LSDJ_FINGERPRINT_BAND_COUNT * melodies.size() * BAND_ENTRY_SIZE;
+        
+        appendLittleEndian(data, FORMAT_VERSION, 4);
+        appendLittleEndian(data, songs.size(), 4);
+        appendLittleEndian(data, melodies.size(), 4);
+        appendLittleEndian(data, stringsOffset, 4);
+        appendLittleEndian(data, 0, 8);
+        
+        size_t stringOffset = 0;
+        for (const auto& song : songs)
+        {
+            std::array<uint8_t, LSDJ_PROJECT_NAME_LENGTH> name = {};
+            std::copy_n(song.name.begin(), std::min(song.name.size(), name.size()), name.begin());
+            data.insert(data.end(), name.begin(), name.end());
+            
+            appendLittleEndian(data, stringOffset, 4);
+            appendLittleEndian(data, song.path.size(), 4);
+            data.emplace_back(song.slot);
+            appendLittleEndian(data, 0, 3);
+            appendLittleEndian(data, song.fingerprint.ngramCount, 4);
+            for (const auto minimum : song.fingerprint.minimums)
+                appendLittleEndian(data, minimum, 4);
+            
+            stringOffset += song.path.size();
+        }
+        
+        // Songs without a melody would all end up in the same buckets, so they're left out
+        std::vector<std::pair<uint64_t, uint32_t>> entries(melodies.size());
+        for (uint8_t band = 0; band < LSDJ_FINGERPRINT_BAND_COUNT; ++band)
+        {
+            for (size_t i = 0; i < melodies.size(); ++i)
+                entries[i] = { lsdj_fingerprint_hash_band(&songs[melodies[i]].fingerprint, band), melodies[i] };
+            
+            std::sort(entries.begin(), entries.end());
+            for (const auto& entry : entries)
+            {
+                appendLittleEndian(data, entry.first, 8);
+                appendLittleEndian(data, entry.second, 4);
+            }
+        }
+        
+        for (const auto& song : songs)
+            data.insert(data.end(), song.path.begin(), song.path.end());
+        
+        return writeIndex(path, data);
+    }
+
+    bool FingerprintIndex::scan(const ghc::filesystem::path& path, std::vector<FingerprintSong>& songs)
+    {
+        songs.clear();
+        
+        return readSongs(path, [&](const lsdj_song_t* song, uint8_t slot, const char* name, uint8_t)
+        {
+            FingerprintSong entry;
+            entry.path = path.string();
+            entry.slot = slot;
+            if (name)
+                entry.name = std::string(name, strnlen(name, LSDJ_PROJECT_NAME_LENGTH));
+            lsdj_song_fingerprint(song, &entry.fingerprint);
+            songs.emplace_back(std::move(entry));
+        });
+    }
+
+    const uint8_t* FingerprintIndex::getSongRecord(uint32_t index) const
+    {
+        return file.data() + HEADER_SIZE + index * SONG_RECORD_SIZE;
+    }
+
+    const uint8_t* FingerprintIndex::getBandEntry(uint8_t band, size_t index) const
+    {
+        return file.data() + HEADER_SIZE + songCount * SONG_RECORD_SIZE + (band * melodyCount + index) * BAND_ENTRY_SIZE;
+    }
+
+    std::pair<size_t, size_t> FingerprintIndex::findBucket(uint8_t band, uint64_t hash) const
+    {
+        // Find the first entry with the hash, then the first one past it
+        auto lowerBound = [&](uint64_t value)
+        {
+            size_t begin = 0;
+            size_t end = melodyCount;
+            while (begin < end)
+            {
+                const size_t middle = begin + (end - begin) / 2;
+                if (readLittleEndian(getBandEntry(band, middle), 8) < value)
+                    begin = middle + 1;
+                else
+                    end = middle;
+            }
+            return begin;
+        };
+        
+        const size_t begin = lowerBound(hash);
+        size_t end = begin;
+        while (end < melodyCount && readLittleEndian(getBandEntry(band, end), 8) == hash)
+            ++end;
+        
+        return { begin, end };
+    }
+}
@@ -0,0 +1,141 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#ifndef LSDJ_FINGERPRINT_INDEX_HPP
+#define LSDJ_FINGERPRINT_INDEX_HPP
+
+#include <cstdint>
+#include <ghc/filesystem.hpp>
+#include <string>
+#include <vector>
+
+#include <lsdj/fingerprint.h>
+
+#include "../common/mapped_file.hpp"
+#include "../common/song_library.hpp"
+
+/* A fingerprint index stores the melodic fingerprints of a library of songs, together with
+   the buckets of locality sensitive hashing (see lsdj/fingerprint.h), so similar songs are
+   found without comparing against every song. All numbers are little endian.
+ 
+   - A header: the magic "LSDJFPR" followed by a zero byte, the format version, the amount of
+     songs, the amount of songs with a melody, and the offset of the string table (all
+     32-bit), and 8 reserved bytes
+   - A 280-byte record for every song: its name (8 bytes), the offset and length of its path
+     in the string table (32-bit), its slot, 3 reserved bytes, its amount of n-grams and the
+     minimum hashes of its fingerprint (32-bit)
+   - A table for every band, with a 12-byte entry for every song with a melody: the hash of
+     the band (64-bit) and the song (32-bit), sorted by hash. Songs in the same bucket sit
+     next to each other, and a bucket is found with a binary search.
+   - The string table with all paths */
+
+namespace lsdj
+{
+    //! A song in a fingerprint index
+    struct FingerprintSong
+    {
+        //! The slot of a working memory song
+        static constexpr uint8_t WORKING_MEMORY = WORKING_MEMORY_SLOT;
+        
+        //! The slot of the song in an .lsdsng
+        static constexpr uint8_t LSDSNG = LSDSNG_SLOT;
+        
+        std::string path;
+        
+        //! The project index in a sav, or one of the special slots above
+        uint8_t slot = LSDSNG;
+        
+        std::string name;
+        lsdj_fingerprint_t fingerprint;
+    };
+    
+    //! A song found to be similar to another
+    struct SimilarSong
+    {
+        uint32_t song = 0;
+        
+        //! The song it's similar to, if it was found in the index itself
+        uint32_t other = 0;
+        
+        double similarity = 0;
+    };
+    
+    //! A fingerprint index on disk, mapped into memory so a lookup only touches its own buckets
+    class FingerprintIndex
+    {
+    public:
+        //! Map a fingerprint index file
+        /*! @return False if it doesn't exist or isn't a valid fingerprint index */
+        bool open(const ghc::filesystem::path& path);
+        void close();
+        
+        size_t getSongCount() const { return songCount; }
+        FingerprintSong getSong(uint32_t index) const;
+        void getFingerprint(uint32_t index, lsdj_fingerprint_t& fingerprint) const;
+        
+        //! Find the songs most similar to a fingerprint
+        /*! Only songs sharing a bucket with the fingerprint in any band are compared
+            @param fingerprint The fingerprint to look for
+            @param count The maximum amount of songs to return
+            @return The songs, most similar first */
+        std::vector<SimilarSong> findSimilar(const lsdj_fingerprint_t& fingerprint, size_t count) const;
+        
+        //! Find all pairs of songs in the index that are at least as similar as a threshold
+        /*! @return The pairs, most similar first */
+        std::vector<SimilarSong> findDuplicates(double threshold) const;
+        
+        //! Write a fingerprint index to disk
+        static bool write(const ghc::filesystem::path& path, const std::vector<FingerprintSong>& songs);
+        
+        //! Read the songs in a .sav or .lsdsng and fingerprint them
+        static bool scan(const ghc::filesystem::path& path, std::vector<FingerprintSong>& songs);
+        
+    private:
+        const uint8_t* getSongRecord(uint32_t index) const;
+        const uint8_t* getBandEntry(uint8_t band, size_t index) const;
+        
+        //! Find the range of entries in a band table with a given hash
+        std::pair<size_t, size_t> findBucket(uint8_t band, uint64_t hash) const;
+        
+    private:
+        MappedFile file;
+        size_t songCount = 0;
+        size_t melodyCount = 0;
+        size_t stringsOffset = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,201 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+
+#include <ghc/filesystem.hpp>
+#include <popl/popl.hpp>
+
+#include <lsdj/version.h>
+
+#include "../common/song_library.hpp"
+#include "../common/thread_pool.hpp"
+#include "fingerprint_index.hpp"
+
+void printHelp(const popl::OptionParser& options)
+{
+    std::cout << "lsdj-similar -i library.fingerprints mymusic.sav|mymusic.lsdsng|folder ...\n"
+              << "lsdj-similar -i library.fingerprints -q mysong.lsdsng|mymusic.sav [-k 10]\n"
+              << "lsdj-similar -i library.fingerprints -d [-t 0.8]\n\n"
+              << "Version: " << LSDJ_VERSION_STRING << "\n\n"
+              << options << "\n\n";
+
+    std::cout << "LibLSDJ is open source and freely available to anyone.\nIf you'd like to show your appreciation, please consider\n  - buying one of my albums (https://4ntler.bandcamp.com)\n  - donating money through PayPal (https://paypal.me/4ntler).\n";
+}
+
+//! Print a song as tab-separated values: its path, slot and name
+void printSong(const lsdj::FingerprintSong& song)
+{
+    std::cout << song.path << '\t' << lsdj::formatSlot(song.slot) << '\t' << song.name;
+}
+
+//! Fingerprint all songs in the inputs and write them to an index
+int build(const ghc::filesystem::path& indexPath, const std::vector<std::string>& inputs, unsigned int jobs, bool verbose)
+{
+    // Songs are numbered in path order, so building twice gives the same index
+    const auto paths = lsdj::collectSongFiles(inputs);
+    
+    std::vector<std::vector<lsdj::FingerprintSong>> files(paths.size());
+    std::vector<char> succeeded(paths.size(), false);
+    lsdj::ThreadPool::forEach(jobs, paths.size(), [&](size_t i)
+    {
+        succeeded[i] = lsdj::FingerprintIndex::scan(paths[i], files[i]);
+    });
+    
+    std::vector<lsdj::FingerprintSong> songs;
+    size_t fileCount = 0;
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        if (!succeeded[i])
+        {
+            std::cerr << "Could not read '" << paths[i].string() << "'" << std::endl;
+            continue;
+        }
+        
+        if (verbose)
+            std::cout << "Fingerprinted " << paths[i].string() << std::endl;
+        
+        ++fileCount;
+        std::move(files[i].begin(), files[i].end(), std::back_inserter(songs));
+    }
+    
+    if (!lsdj::FingerprintIndex::write(indexPath, songs))
+    {
+        std::cerr << "Could not write '" << indexPath.string() << "'" << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Fingerprinted " << songs.size() << " song(s) in " << fileCount << " file(s)" << std::endl;
+    
+    return 0;
+}
+
+//! Print the songs in the index most similar to each song in a file
+int query(const lsdj::FingerprintIndex& index, const ghc::filesystem::path& path, size_t count)
+{
+    std::vector<lsdj::FingerprintSong> songs;
+    if (!lsdj::FingerprintIndex::scan(ghc::filesystem::absolute(path), songs))
+    {
+        std::cerr << "Could not read '" << path.string() << "'" << std::endl;
+        return 1;
+    }
+    
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto& song : songs)
+    {
+        for (const auto& match : index.findSimilar(song.fingerprint, count))
+        {
+            printSong(song);
+            std::cout << '\t' << match.similarity << '\t';
+            printSong(index.getSong(match.song));
+            std::cout << '\n';
+        }
+    }
+    
+    std::cout << std::flush;
+    
+    return 0;
+}
+
+//! Print all pairs of songs in the index that are at least as similar as a threshold
+int findDuplicates(const lsdj::FingerprintIndex& index, double threshold)
+{
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto& pair : index.findDuplicates(threshold))
+    {
+        printSong(index.getSong(pair.song));
+        std::cout << '\t' << pair.similarity << '\t';
+        printSong(index.getSong(pair.other));
+        std::cout << '\n';
+    }
+    
+    std::cout << std::flush;
+    
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    popl::OptionParser options("Options");
+    auto help = options.add<popl::Switch>("h", "help", "Show the help screen");
+    auto verbose = options.add<popl::Switch>("v", "verbose", "Verbose output while fingerprinting");
+    auto indexFile = options.add<popl::Value<std::string>>("i", "index", "The fingerprint index to build or query", "library.fingerprints");
+    auto jobs = options.add<popl::Value<unsigned int>>("j", "jobs", "The amount of files to read simultaneously", 1);
+    auto queryFile = options.add<popl::Value<std::string>>("q", "query", "Find the songs most similar to those in a .sav or .lsdsng");
+    auto count = options.add<popl::Value<unsigned int>>("k", "count", "The amount of similar songs to list per song", 10);
+    auto duplicates = options.add<popl::Switch>("d", "duplicates", "List all pairs of similar songs in the index");
+    auto threshold = options.add<popl::Value<double>>("t", "threshold", "How similar songs need to be to count as duplicates (0 - 1)", 0.8);
+    
+    try
+    {
+        options.parse(argc, argv);
+        
+        const auto inputs = options.non_option_args();
+        const auto indexPath = ghc::filesystem::absolute(indexFile->value());
+        
+        if (help->is_set())
+        {
+            printHelp(options);
+            return 0;
+        } else if (!inputs.empty()) {
+            return build(indexPath, inputs, jobs->value(), verbose->is_set());
+        } else if (queryFile->is_set() || duplicates->is_set()) {
+            lsdj::FingerprintIndex index;
+            if (!index.open(indexPath))
+            {
+                std::cerr << "'" << indexPath.string() << "' is not a fingerprint index" << std::endl;
+                return 1;
+            }
+            
+            if (queryFile->is_set())
+                return query(index, queryFile->value(), count->value());
+            else
+                return findDuplicates(index, threshold->value());
+        } else {
+            printHelp(options);
+            return 0;
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+    }
+
+	return 0;
+}
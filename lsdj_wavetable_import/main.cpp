@@ -41,11 +41,12 @@
 #include <lsdj/version.h>
 
 #include "../common/common.hpp"
+#include "../common/stream.hpp"
 #include "wavetable_importer.hpp"
 
 void printHelp(const popl::OptionParser& options)
 {
-    std::cout << "lsdj-wavetable-import source.lsdsng wavetables.snt -[s 0-F | i 0-FF]\n\n"
+    std::cout << "lsdj-wavetable-import source.lsdsng|- wavetables.snt|wavetables.wav -[s 0-F | i 0-FF]\n\n"
               << "Version: " << LSDJ_VERSION_STRING << "\n\n"
               << options << "\n";
 
@@ -71,8 +72,11 @@ int main(int argc, char* argv[])
     auto synth = options.add<popl::Value<std::string>>("s", "synth", "The synth number 0-F where the wavetable data should be written");
     auto zero = options.add<popl::Switch>("0", "zero", "Pad the synth with empty wavetables if the .snt file < 256 bytes");
     auto force = options.add<popl::Switch>("f", "force", "Force writing the wavetables, even though non-default data may be in them");
-    auto output = options.add<popl::Value<std::string>>("o", "output", "The output .lsdsng to write to");
+    auto output = options.add<popl::Value<std::string>>("o", "output", "The output .lsdsng to write to, or - to write to stdout");
     auto decimal = options.add<popl::Switch>("d", "decimal", "Is the number for --index or --synth a decimal (instead of hex)?");
+    auto cycle = options.add<popl::Value<size_t>>("c", "cycle", "The amount of samples in every single-cycle frame of a .wav", 2048);
+    auto noNormalize = options.add<popl::Switch>("", "no-normalize", "Keep the level of .wav frames, instead of scaling them to the full range");
+    auto dither = options.add<popl::Switch>("", "dither", "Dither .wav frames when reducing them to 4 bits");
     
     try
     {
@@ -92,13 +96,16 @@ int main(int argc, char* argv[])
             std::string source;
             std::string wavetable;
             
-            if (lsdj_sav_is_likely_valid_file(inputs[0].c_str()) ||
+            // A song read from stdin can't be checked up front, without consuming it
+            if (lsdj::isStandardStream(inputs[0]) ||
+                lsdj_sav_is_likely_valid_file(inputs[0].c_str()) ||
                 lsdj_project_is_likely_valid_lsdsng_file(inputs[0].c_str()))
             {
                 source = inputs[0];
                 wavetable = inputs[1];
             }
-            else if (lsdj_sav_is_likely_valid_file(inputs[1].c_str()) ||
+            else if (lsdj::isStandardStream(inputs[1]) ||
+                     lsdj_sav_is_likely_valid_file(inputs[1].c_str()) ||
                      lsdj_project_is_likely_valid_lsdsng_file(inputs[1].c_str()))
             {
                 source = inputs[1];
@@ -114,6 +121,15 @@ int main(int argc, char* argv[])
             importer.zero = zero->is_set();
             importer.force = force->is_set();
             importer.verbose = verbose->is_set();
+            importer.settings.cycleLength = cycle->value();
+            importer.settings.normalize = !noNormalize->is_set();
+            importer.settings.dither = dither->is_set();
+            
+            if (importer.settings.cycleLength == 0)
+            {
+                printHelp(options);
+                return 1;
+            }
             
             importer.wavetableIndex = synth->is_set() ?
                                         parseSynthIndex(synth->value(), decimal->is_set()) :
@@ -43,12 +43,25 @@
 #include <lsdj/wave.h>
 
 #include "../common/common.hpp"
+#include "../common/stream.hpp"
 #include "wavetable_importer.hpp"
 
 namespace lsdj
 {
     bool WavetableImporter::import(const std::string& input, const std::string& wavetableName)
     {
+        // A song on stdin can't be told apart by its extension, so look at its contents
+        if (isStandardStream(input))
+        {
+            streaming = true;
+            
+            const auto data = readStandardInput();
+            if (isSav(data))
+                return importToSav(input, data, wavetableName);
+            else
+                return importToLsdsng(input, data, wavetableName);
+        }
+        
         const auto path = ghc::filesystem::absolute(input);
         if (!ghc::filesystem::exists(path))
         {
@@ -57,9 +70,9 @@ namespace lsdj
         }
         
         if (path.extension() == ".sav")
-            return importToSav(path, wavetableName);
+            return importToSav(path, {}, wavetableName);
         else if (path.extension() == ".lsdsng")
-            return importToLsdsng(path, wavetableName);
+            return importToLsdsng(path, {}, wavetableName);
         else
         {
             std::cerr << "Unknown file format at '" << path.string() << "'" << std::endl;
@@ -67,11 +80,13 @@ namespace lsdj
         }
     }
     
-    bool WavetableImporter::importToSav(const ghc::filesystem::path& path, const std::string& wavetableName)
+    bool WavetableImporter::importToSav(const ghc::filesystem::path& path, const std::vector<uint8_t>& data, const std::string& wavetableName)
     {
         // Load the sav
         lsdj_sav_t* sav = nullptr;
-        lsdj_error_t error = lsdj_sav_read_from_file(path.string().c_str(), &sav, nullptr);
+        lsdj_error_t error = data.empty() ?
+            lsdj_sav_read_from_file(path.string().c_str(), &sav, nullptr) :
+            lsdj_sav_read_from_memory(data.data(), data.size(), &sav, nullptr);
         if (error != LSDJ_SUCCESS)
         {
             handle_error(error);
@@ -80,7 +95,7 @@ namespace lsdj
         }
         
         if (verbose)
-            std::cout << "Loaded sav " + path.string() << std::endl;
+            console() << "Loaded sav " + path.string() << std::endl;
         
         auto song = lsdj_sav_get_working_memory_song(sav);
         assert(song != nullptr);
@@ -95,8 +110,8 @@ namespace lsdj
         const auto frameCount = result.second;
         
         // Write the sav back to file
-        const auto outputPath = ghc::filesystem::absolute(outputName);
-        error = lsdj_sav_write_to_file(sav, outputPath.string().c_str(), nullptr);
+        const auto outputPath = absoluteUnlessStandardStream(outputName);
+        error = writeSav(sav, outputPath);
         if (error != LSDJ_SUCCESS)
         {
             handle_error(error);
@@ -104,16 +119,18 @@ namespace lsdj
             return false;
         }
         
-        std::cout << "Wrote " << std::dec << frameCount << " frames starting at 0x" << std::hex << (int)wavetableIndex << " to " << outputPath.string() << std::endl;
+        console() << "Wrote " << std::dec << frameCount << " frames starting at 0x" << std::hex << (int)wavetableIndex << " to " << outputPath.string() << std::endl;
         
         return true;
     }
     
-    bool WavetableImporter::importToLsdsng(const ghc::filesystem::path& path, const std::string& wavetableName)
+    bool WavetableImporter::importToLsdsng(const ghc::filesystem::path& path, const std::vector<uint8_t>& data, const std::string& wavetableName)
     {
         // Load the project
         lsdj_project_t* project = nullptr;
-        lsdj_error_t error = lsdj_project_read_lsdsng_from_file(path.string().c_str(), &project, nullptr);
+        lsdj_error_t error = data.empty() ?
+            lsdj_project_read_lsdsng_from_file(path.string().c_str(), &project, nullptr) :
+            lsdj_project_read_lsdsng_from_memory(data.data(), data.size(), &project, nullptr);
         if (error != LSDJ_SUCCESS)
         {
             handle_error(error);
@@ -122,7 +139,7 @@ namespace lsdj
         }
         
         if (verbose)
-            std::cout << "Loaded project " + path.string() << std::endl;
+            console() << "Loaded project " + path.string() << std::endl;
         
         lsdj_song_t* song = lsdj_project_get_song(project);
         assert(song != nullptr);
@@ -137,57 +154,38 @@ namespace lsdj
         const auto frameCount = result.second;
         
         // Write the project back to file
-        const auto outputPath = ghc::filesystem::absolute(outputName);
-        error = lsdj_project_write_lsdsng_to_file(project, outputPath.string().c_str(), nullptr);
+        const auto outputPath = absoluteUnlessStandardStream(outputName);
+        error = writeLsdsng(project, outputPath);
         if (error != LSDJ_SUCCESS)
         {
             lsdj_project_free(project);
             return false;
         }
         
-        std::cout << "Wrote " << std::dec << frameCount << " frames starting at 0x" << std::hex << (int)wavetableIndex << " to " << outputPath.string() << std::endl;
+        console() << "Wrote " << std::dec << frameCount << " frames starting at 0x" << std::hex << (int)wavetableIndex << " to " << outputPath.string() << std::endl;
         
         return true;
     }
     
     std::pair<bool, unsigned int> WavetableImporter::importToSong(lsdj_song_t* song, const std::string& wavetableName)
     {
-        // Find the wavetable file
+        // Load the frames, either straight from a .snt or converted from a .wav
         const auto wavetablePath = ghc::filesystem::absolute(wavetableName);
-        if (!ghc::filesystem::exists(wavetablePath))
-        {
-            std::cerr << wavetablePath.filename().string() << " does not exist" << std::endl;
+        std::vector<WaveFrame> frames;
+        if (!loadWavetable(wavetablePath, settings, frames, verbose, console()))
             return {false, 0};
-        }
         
-        // Make sure the wavetable is the correct size
-        const auto wavetableSize = ghc::filesystem::file_size(wavetablePath);
-        if (wavetableSize % 16 != 0)
-        {
-            std::cerr << "The wavetable file size is not a multiple of 16 bytes" << std::endl;
-            return {false, 0};
-        }
-        
-        // Load the wavetable file
-        std::ifstream wavetableStream(wavetablePath.string(), std::ios_base::binary);
-        if (!wavetableStream.is_open())
-        {
-            std::cerr << "Could not open " << wavetablePath.filename().string() << std::endl;
-            return {false, 0};
-        }
-        
-        // Compute the amount of frames we will write
-        const auto frameCount = wavetableSize / 16;
+        const auto frameCount = frames.size();
         if (verbose)
-            std::cout << "Found " << std::dec << frameCount << " frames in " << wavetablePath.string() << std::endl;
+            console() << "Found " << std::dec << frameCount << " frames in " << wavetablePath.string() << std::endl;
         
         const auto actualFrameCount = std::min<unsigned int>(0x100 - wavetableIndex, frameCount);
         if (frameCount != actualFrameCount)
         {
-            std::cout << "Last " << std::dec << (frameCount - actualFrameCount) << " won't fit in the song" << std::endl;
+            console() << "Last " << std::dec << (frameCount - actualFrameCount) << " won't fit in the song" << std::endl;
             
             if (verbose)
-                std::cout << "Writing only " << std::dec << actualFrameCount << " frames due to space limits" << std::endl;
+                console() << "Writing only " << std::dec << actualFrameCount << " frames due to space limits" << std::endl;
         }
         
         // Check to see if we're overwriting non-default wavetables
@@ -195,8 +193,8 @@ namespace lsdj
         {
             if (verbose)
             {
-                std::cout << "Comparing frames to ensure no overwriting" << std::endl;
-                std::cout << "Going to write into frames 0x" << std::hex << static_cast<int>(wavetableIndex)
+                console() << "Comparing frames to ensure no overwriting" << std::endl;
+                console() << "Going to write into frames 0x" << std::hex << static_cast<int>(wavetableIndex)
                           << " to 0x" << static_cast<int>(wavetableIndex + actualFrameCount) << std::endl;
             }
             
@@ -204,7 +202,14 @@ namespace lsdj
             {
                 if (!lsdj_wave_is_default(song, wavetableIndex + frame))
                 {
-                    std::cout << "Some of the wavetable frames you are trying to overwrite already contain data.\nDo you want to continue? y/n\n> ";
+                    // Stdin holds the song itself, so there's no one to ask
+                    if (streaming)
+                    {
+                        std::cerr << "Some of the wavetable frames you are trying to overwrite already contain data, use --force to overwrite them" << std::endl;
+                        return {false, 0};
+                    }
+                    
+                    console() << "Some of the wavetable frames you are trying to overwrite already contain data.\nDo you want to continue? y/n\n> ";
                     
                     char answer = 'n';
                     std::cin >> answer;
@@ -215,26 +220,25 @@ namespace lsdj
                         break;
                     }
                 } else if (verbose) {
-                    std::cout << "Frame 0x" << std::hex << (wavetableIndex + frame) << " is default" << std::endl;
+                    console() << "Frame 0x" << std::hex << (wavetableIndex + frame) << " is default" << std::endl;
                 }
             }
         }
         
-        // Apply the wavetable
-        for (uint8_t frame = 0; frame < actualFrameCount; frame++)
+        // Apply the wavetable (a full table holds 256 frames, which doesn't fit a byte counter)
+        for (unsigned int frame = 0; frame < actualFrameCount; frame++)
         {
-            std::uint8_t* memory = lsdj_wave_get_bytes(song, wavetableIndex + frame);
-            wavetableStream.read(reinterpret_cast<char*>(memory), LSDJ_WAVE_BYTE_COUNT);
+            lsdj_wave_set_bytes(song, static_cast<uint8_t>(wavetableIndex + frame), frames[frame].data());
             
             if (verbose)
-                std::cout << "Wrote " << std::dec << LSDJ_WAVE_BYTE_COUNT << " bytes to frame 0x" << std::hex << (wavetableIndex + frame) << std::endl;
+                console() << "Wrote " << std::dec << LSDJ_WAVE_BYTE_COUNT << " bytes to frame 0x" << std::hex << (wavetableIndex + frame) << std::endl;
         }
         
         // Write zero wavetables
         if (zero)
         {
             if (verbose)
-                std::cout << "Padding empty frames" << std::endl;
+                console() << "Padding empty frames" << std::endl;
             
             std::array<std::uint8_t, LSDJ_WAVE_BYTE_COUNT> table;
             table.fill(0x88);
@@ -244,10 +248,16 @@ namespace lsdj
                 lsdj_wave_set_silent(song, wavetableIndex + frame);
                 
                 if (verbose)
-                    std::cout << "Wrote silence to frame 0x" << std::hex << (wavetableIndex + frame) << std::endl;
+                    console() << "Wrote silence to frame 0x" << std::hex << (wavetableIndex + frame) << std::endl;
             }
         }
         
         return {true, actualFrameCount};
     }
+    
+    std::ostream& WavetableImporter::console() const
+    {
+        // Stdout is taken by the song itself when writing it there
+        return isStandardStream(outputName) ? std::cerr : std::cout;
+    }
 }
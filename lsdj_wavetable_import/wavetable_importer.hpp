@@ -37,12 +37,15 @@
 #define LSDJ_WAVETABLE_IMPORTER_HPP
 
 #include <ghc/filesystem.hpp>
+#include <ostream>
 #include <string>
 #include <vector>
 
 #include <lsdj/error.h>
 #include <lsdj/song.h>
 
+#include "../common/wavetable.hpp"
+
 namespace lsdj
 {
     class WavetableImporter
@@ -58,10 +61,21 @@ namespace lsdj
         bool force = false;
         bool verbose = false;
         
+        //! How .wav wavetables are converted
+        WavetableSettings settings;
+        
     private:
-        bool importToSav(const ghc::filesystem::path& path, const std::string& wavetableName);
-        bool importToLsdsng(const ghc::filesystem::path& path, const std::string& wavetableName);
+        // Data holds the contents of the song if it was read from stdin, otherwise it's read from path
+        bool importToSav(const ghc::filesystem::path& path, const std::vector<uint8_t>& data, const std::string& wavetableName);
+        bool importToLsdsng(const ghc::filesystem::path& path, const std::vector<uint8_t>& data, const std::string& wavetableName);
         std::pair<bool, unsigned int> importToSong(lsdj_song_t* song, const std::string& wavetableName);
+        
+        // Where messages go, which is stderr when the song is written to stdout
+        std::ostream& console() const;
+        
+    private:
+        // Whether the song came from stdin, so the user can't be asked anything
+        bool streaming = false;
     };
 }
 
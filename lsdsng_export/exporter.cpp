@@ -35,36 +35,200 @@
 
 #include "exporter.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdio>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 
+#include <lsdj/hash.h>
 #include <lsdj/sav.h>
 #include <lsdj/song.h>
 
 #include "../common/common.hpp"
+#include "../common/stream.hpp"
+#include "../common/thread_pool.hpp"
+#include "watcher.hpp"
 
 namespace lsdj
 {
+    namespace
+    {
+        //! Hash everything that ends up in an lsdsng
+        uint64_t hashProject(const lsdj_project_t* project)
+        {
+            const uint8_t version = lsdj_project_get_version(project);
+            const uint64_t hash = lsdj_hash_bytes(lsdj_project_get_name(project), LSDJ_PROJECT_NAME_LENGTH, lsdj_song_hash(lsdj_project_get_song_const(project)));
+            
+            return lsdj_hash_bytes(&version, 1, hash);
+        }
+    }
+    
     int Exporter::export_(const ghc::filesystem::path& path)
     {
-        if (ghc::filesystem::is_directory(path))
-            return exportFolder(path);
-        else
-            return exportSav(path);
+        if (isStandardStream(path))
+            return exportStandardInput();
+        
+        if (!statePath.empty() && !loadState())
+            return 1;
+        
+        const int result = ghc::filesystem::is_directory(path) ? exportFolder(path) : exportSav(path);
+        
+        // Even after a failure, the projects that were written shouldn't be written again next time
+        if (!statePath.empty() && !saveState())
+            return 1;
+        
+        return result;
+    }
+    
+    int Exporter::watch(const ghc::filesystem::path& path)
+    {
+        Watcher watcher(path);
+        if (!watcher.isValid())
+        {
+            std::cerr << "Could not watch '" << path.string() << "'" << std::endl;
+            return 1;
+        }
+        
+        console() << "Watching " << path.string() << " for changes" << std::endl;
+        
+        std::vector<ghc::filesystem::path> changed;
+        while (watcher.wait(changed))
+        {
+            // Savs that changed are exported on their own, so earlier exports have no say in collisions anymore
+            writtenFiles.clear();
+            
+            for (size_t i = 0; i < changed.size(); ++i)
+            {
+                console() << "Changed " << changed[i].filename().string() << std::endl;
+                
+                // A sav that can't be read may still be in the middle of being written, it'll come by again
+                if (!exportSav(changed[i], i, console(), nullptr))
+                    std::cerr << "Failed to export '" << changed[i].string() << "'" << std::endl;
+            }
+            console() << std::flush;
+            
+            if (!statePath.empty() && !saveState())
+                return 1;
+        }
+        
+        std::cerr << "Stopped watching '" << path.string() << "'" << std::endl;
+        return 1;
     }
 
     int Exporter::exportFolder(const ghc::filesystem::path& path)
     {
+        // Directory iteration order differs per platform, sort it to keep the output stable
+        std::vector<ghc::filesystem::path> paths;
         for (auto it = ghc::filesystem::directory_iterator(path); it != ghc::filesystem::directory_iterator(); ++it)
         {
             const auto path = it->path();
             if (isHiddenFile(path.filename().string()) || path.extension() != ".sav")
                 continue;
             
-            std::cout << "Found " << path.filename().string() << std::endl;
-            if (exportSav(path) != 0)
+            paths.emplace_back(path);
+        }
+        std::sort(paths.begin(), paths.end());
+        
+        // Frames written to stdout have to come out in order, so that never uses jobs
+        const auto threadCount = isStandardStream(output) ? 1 : std::min<size_t>(std::max(jobs, 1u), paths.size());
+        if (threadCount <= 1)
+        {
+            for (size_t i = 0; i < paths.size(); ++i)
+            {
+                console() << "Found " << paths[i].filename().string() << std::endl;
+                if (!exportSav(paths[i], i, console(), nullptr))
+                    return 1;
+            }
+            
+            return 0;
+        }
+        
+        // The output of every sav is buffered and printed in order, so jobs don't interleave
+        struct SavLog
+        {
+            std::ostringstream output;
+            bool done = false;
+            bool succeeded = false;
+        };
+        
+        std::vector<SavLog> logs(paths.size());
+        std::mutex logMutex;
+        size_t nextLog = 0;
+        std::atomic<bool> failed{false};
+        
+        // This thread helps out while waiting, so it counts as one of the jobs
+        ThreadPool pool(static_cast<unsigned int>(threadCount - 1));
+        ThreadPool::Group group;
+        
+        for (size_t i = 0; i < paths.size() && !failed; ++i)
+        {
+            // Keep a bounded amount of savs in flight, so a huge folder isn't read into memory all at once
+            pool.waitUntilBelow(group, threadCount * 2);
+            
+            pool.submit(group, [&, i]()
+            {
+                auto& log = logs[i];
+                log.output << "Found " << paths[i].filename().string() << std::endl;
+                const bool succeeded = !failed && exportSav(paths[i], i, log.output, &pool);
+                
+                std::lock_guard<std::mutex> lock(logMutex);
+                log.done = true;
+                log.succeeded = succeeded;
+                if (!succeeded)
+                    failed = true;
+                
+                // Print the logs of the savs that are done, but never before those of earlier savs
+                for (; nextLog < logs.size() && logs[nextLog].done; ++nextLog)
+                {
+                    console() << logs[nextLog].output.str() << std::flush;
+                    if (!logs[nextLog].succeeded)
+                        problems() << "Failed to export '" << paths[nextLog].string() << "'" << std::endl;
+                }
+            });
+        }
+        
+        pool.wait(group);
+        
+        return failed ? 1 : 0;
+    }
+
+    int Exporter::exportStandardInput()
+    {
+        // Stdin holds either a single sav, or a stream of frames written by one of the other tools
+        std::vector<StreamFrame> frames;
+        bool framed = false;
+        if (!readStandardInputFrames("stdin", frames, framed))
+        {
+            std::cerr << "Stdin is not a valid stream of files" << std::endl;
+            return 1;
+        }
+        
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            if (!isSav(frames[i].data))
+            {
+                console() << "Skipping " << frames[i].name << ", not a sav" << std::endl;
+                continue;
+            }
+            
+            lsdj_sav_t* sav = nullptr;
+            const lsdj_error_t error = lsdj_sav_read_from_memory(frames[i].data.data(), frames[i].data.size(), &sav, nullptr);
+            if (error != LSDJ_SUCCESS)
+            {
+                reportError(error);
+                return 1;
+            }
+            
+            if (framed)
+                console() << "Found " << frames[i].name << std::endl;
+            
+            const bool succeeded = exportSav(sav, i, console(), nullptr);
+            lsdj_sav_free(sav);
+            if (!succeeded)
                 return 1;
         }
         
@@ -72,38 +236,52 @@ namespace lsdj
     }
 
     int Exporter::exportSav(const ghc::filesystem::path& path)
+    {
+        return exportSav(path, 0, console(), nullptr) ? 0 : 1;
+    }
+
+    bool Exporter::exportSav(const ghc::filesystem::path& path, size_t index, std::ostream& log, ThreadPool* pool)
     {
         // Load in the save file
         lsdj_sav_t* sav = nullptr;
         lsdj_error_t error = lsdj_sav_read_from_file(path.string().c_str(), &sav, nullptr);
         if (error != LSDJ_SUCCESS)
-            return handle_error(error);
+            return reportError(error);
         assert(sav != nullptr);
         
         if (verbose)
-            std::cout << "Read '" << path.string() << "'" << std::endl;
+            log << "Read '" << path.string() << "'" << std::endl;
         
-        const auto outputFolder = ghc::filesystem::absolute(output);
+        const bool succeeded = exportSav(sav, index, log, pool);
+        lsdj_sav_free(sav);
+        
+        return succeeded;
+    }
+
+    bool Exporter::exportSav(const lsdj_sav_t* sav, size_t index, std::ostream& log, ThreadPool* pool)
+    {
+        // Projects streamed to stdout are named relative to the root of the stream
+        const auto outputFolder = isStandardStream(output) ? ghc::filesystem::path() : ghc::filesystem::absolute(output);
+        
+        // Projects are ordered the way they would be exported without jobs: sav by sav, working memory first
+        const size_t order = index * (LSDJ_SAV_PROJECT_COUNT + 1);
         
         if (shouldExportWorkingMemory())
         {
             lsdj_project_t* project = nullptr;
-            error = lsdj_project_new_from_working_memory_song(sav, &project, nullptr);
+            lsdj_error_t error = lsdj_project_new_from_working_memory_song(sav, &project, nullptr);
             if (error != LSDJ_SUCCESS)
-            {
-                lsdj_sav_free(sav);
-                return handle_error(error);
-            }
+                return reportError(error);
             
-            error = exportProject(project, outputFolder, true);
+            error = exportProject(project, outputFolder, true, order, log);
+            lsdj_project_free(project);
             if (error != LSDJ_SUCCESS)
-            {
-                lsdj_sav_free(sav);
-                return handle_error(error);
-            }
+                return reportError(error);
         }
         
-        // Go through every project
+        // Find every project that should be exported
+        std::vector<const lsdj_project_t*> projects;
+        std::vector<size_t> orders;
         for (int i = 0; i < LSDJ_SAV_PROJECT_COUNT; ++i)
         {
             // Retrieve the project
@@ -126,21 +304,36 @@ namespace lsdj
                     continue;
             }
             
-            // Export the project
-            error = exportProject(project, outputFolder, false);
-            if (error != LSDJ_SUCCESS)
-            {
-                lsdj_sav_free(sav);
-                return handle_error(error);
-            }
+            projects.emplace_back(project);
+            orders.emplace_back(order + 1 + i);
         }
         
-        lsdj_sav_free(sav);
+        // Export the projects, compressing them on the other jobs if there are any
+        std::vector<std::ostringstream> logs(projects.size());
+        std::vector<lsdj_error_t> errors(projects.size(), LSDJ_SUCCESS);
         
-        return 0;
+        if (pool)
+        {
+            ThreadPool::Group group;
+            for (size_t i = 0; i < projects.size(); ++i)
+                pool->submit(group, [&, i]() { errors[i] = exportProject(projects[i], outputFolder, false, orders[i], logs[i]); });
+            pool->wait(group);
+        } else {
+            for (size_t i = 0; i < projects.size(); ++i)
+                errors[i] = exportProject(projects[i], outputFolder, false, orders[i], logs[i]);
+        }
+        
+        for (size_t i = 0; i < projects.size(); ++i)
+        {
+            log << logs[i].str();
+            if (errors[i] != LSDJ_SUCCESS)
+                return reportError(errors[i]);
+        }
+        
+        return true;
     }
     
-    lsdj_error_t Exporter::exportProject(const lsdj_project_t* project, ghc::filesystem::path folder, bool workingMemory)
+    lsdj_error_t Exporter::exportProject(const lsdj_project_t* project, ghc::filesystem::path folder, bool workingMemory, size_t order, std::ostream& log)
     {
         auto name = constructName(project);
         if (name.empty())
@@ -150,7 +343,6 @@ namespace lsdj
         
         if (putInFolder)
             path /= name;
-        ghc::filesystem::create_directories(folder);
         
         std::stringstream stream;
         stream << name << convertVersionToString(lsdj_project_get_version(project), true, false);
@@ -161,20 +353,139 @@ namespace lsdj
         stream << ".lsdsng";
         path /= stream.str();
         
-        ghc::filesystem::create_directories(path.parent_path());
-        lsdj_error_t error = lsdj_project_write_lsdsng_to_file(project, path.string().c_str(), nullptr);
-        if (error != LSDJ_SUCCESS)
-            return error;
+        bool unchanged = false;
+        if (isStandardStream(output))
+        {
+            std::vector<uint8_t> data;
+            lsdj_error_t error = lsdj::writeLsdsng(project, data);
+            if (error != LSDJ_SUCCESS)
+                return error;
+            
+            if (!writeFrame(path.generic_string(), data))
+                return LSDJ_WRITE_FAILED;
+        } else {
+            createDirectories(path.parent_path());
+            lsdj_error_t error = writeLsdsng(project, path, order, unchanged);
+            if (error != LSDJ_SUCCESS)
+                return error;
+        }
         
         // Let the user know if verbose output has been toggled on
         if (verbose)
         {
-            std::cout << "Exported " << ghc::filesystem::relative(path, folder).string() << std::endl;
+            log << (unchanged ? "Unchanged " : "Exported ") << (folder.empty() ? path : ghc::filesystem::relative(path, folder)).string() << std::endl;
         }
         
         return LSDJ_SUCCESS;
     }
     
+    void Exporter::createDirectories(const ghc::filesystem::path& path)
+    {
+        std::lock_guard<std::mutex> lock(directoryMutex);
+        
+        // Checking the disk for every project adds up over thousands of savs
+        if (createdDirectories.insert(path.string()).second)
+            ghc::filesystem::create_directories(path);
+    }
+    
+    lsdj_error_t Exporter::writeLsdsng(const lsdj_project_t* project, const ghc::filesystem::path& path, size_t order, bool& unchanged)
+    {
+        // Every job reuses its own buffer
+        thread_local std::vector<uint8_t> buffer(LSDSNG_MAX_SIZE);
+        
+        const auto string = path.string();
+        const auto hash = hashProject(project);
+        std::lock_guard<std::mutex> fileLock(fileMutexes[std::hash<std::string>()(string) % fileMutexes.size()]);
+        
+        {
+            std::lock_guard<std::mutex> lock(writtenFilesMutex);
+            
+            // A project that comes later has already been written here, and would overwrite this one anyway
+            auto it = writtenFiles.find(string);
+            if (it != writtenFiles.end() && it->second > order)
+                return LSDJ_SUCCESS;
+            
+            writtenFiles[string] = order;
+            
+            // The same project is already on disk, so don't even bother compressing it
+            auto previous = hashes.find(string);
+            unchanged = previous != hashes.end() && previous->second == hash && ghc::filesystem::exists(path);
+            if (unchanged)
+                return LSDJ_SUCCESS;
+        }
+        
+        size_t size = 0;
+        lsdj_error_t error = lsdj_project_write_lsdsng_to_memory(project, buffer.data(), &size);
+        if (error != LSDJ_SUCCESS)
+            return error;
+        
+        FILE* file = fopen(string.c_str(), "wb");
+        if (file == nullptr)
+            return LSDJ_FILE_OPEN_FAILED;
+        
+        const size_t written = fwrite(buffer.data(), 1, size, file);
+        fclose(file);
+        
+        if (written != size)
+            return LSDJ_WRITE_FAILED;
+        
+        std::lock_guard<std::mutex> lock(writtenFilesMutex);
+        hashes[string] = hash;
+        
+        return LSDJ_SUCCESS;
+    }
+    
+    bool Exporter::loadState()
+    {
+        // There's nothing to remember the first time around
+        std::ifstream stream(statePath);
+        if (!stream.is_open())
+            return true;
+        
+        // Every line holds a hash in hex and the lsdsng it was written to
+        std::string line;
+        while (std::getline(stream, line))
+        {
+            const auto space = line.find(' ');
+            if (space == std::string::npos)
+            {
+                problems() << "'" << statePath << "' is not a state file written by lsdsng-export" << std::endl;
+                return false;
+            }
+            
+            hashes[line.substr(space + 1)] = std::stoull(line.substr(0, space), nullptr, 16);
+        }
+        
+        return true;
+    }
+    
+    bool Exporter::saveState()
+    {
+        // Write next to the old state and swap them, so an interrupted write can't lose it
+        const auto temporaryPath = statePath + ".tmp";
+        {
+            std::ofstream stream(temporaryPath, std::ios_base::trunc);
+            for (const auto& entry : hashes)
+                stream << std::hex << std::setfill('0') << std::setw(16) << entry.second << ' ' << entry.first << '\n';
+            
+            if (!stream.flush())
+            {
+                problems() << "Could not write '" << temporaryPath << "'" << std::endl;
+                return false;
+            }
+        }
+        
+        std::error_code error;
+        ghc::filesystem::rename(temporaryPath, statePath, error);
+        if (error)
+        {
+            problems() << "Could not write '" << statePath << "'" << std::endl;
+            return false;
+        }
+        
+        return true;
+    }
+    
     int Exporter::print(const ghc::filesystem::path& path)
     {
         if (ghc::filesystem::is_directory(path))
@@ -191,7 +502,7 @@ namespace lsdj
             if (isHiddenFile(path.filename().string()) || path.extension() != ".sav")
                 continue;
             
-            std::cout << "Found " << path.filename().string() << std::endl;
+            console() << "Found " << path.filename().string() << std::endl;
             if (printSav(path) != 0)
                 return 1;
         }
@@ -203,16 +514,19 @@ namespace lsdj
     {
         // Try and read the sav
         lsdj_sav_t* sav = nullptr;
-        lsdj_error_t error = lsdj_sav_read_from_file(path.string().c_str(), &sav, nullptr);
+        lsdj_error_t error = readSav(path, &sav);
         if (error != LSDJ_SUCCESS)
-            return lsdj::handle_error(error);
+        {
+            reportError(error);
+            return 1;
+        }
         assert(sav != nullptr);
         
         // Header
-        std::cout << "#   Name       ";
+        console() << "#   Name       ";
         if (versionStyle != VersionStyle::NONE)
-            std::cout << "Ver  ";
-        std::cout << "Fmt  BPM" << std::endl;
+            console() << "Ver  ";
+        console() << "Fmt  BPM" << std::endl;
         
         if (shouldExportWorkingMemory())
         {
@@ -272,7 +586,7 @@ namespace lsdj
     
     void Exporter::printWorkingMemorySong(const lsdj_sav_t* sav)
     {
-        std::cout << "WM  ";
+        console() << "WM  ";
         
         // If the working memory song represent one of the projects, display that name
         const auto active = lsdj_sav_get_active_project_index(sav);
@@ -283,9 +597,9 @@ namespace lsdj
             if (project)
             {
                 const auto name = constructName(project);
-                std::cout << name;
+                console() << name;
                 for (auto i = name.length(); i < 11; i += 1)
-                    std::cout << ' ';
+                    console() << ' ';
                 hasActiveProject = true;
             }
         }
@@ -293,7 +607,7 @@ namespace lsdj
         if (!hasActiveProject) {
             // The working memory doesn't represent one of the projects, so it
             // doesn't really have a name
-            std::cout << "           ";
+            console() << "           ";
         }
         
         const lsdj_song_t* song = lsdj_sav_get_working_memory_song_const(sav);
@@ -301,24 +615,24 @@ namespace lsdj
         // Display whether the working memory song is "dirty"/edited, and display that
         // as version number (it doesn't really have a version number otherwise)
         if (versionStyle != VersionStyle::NONE && lsdj_song_has_changed(song))
-            std::cout << "*    ";
+            console() << "*    ";
         else
-            std::cout << "     ";
+            console() << "     ";
         
         // Retrieve the sav format version of the song and display it as well
         const auto versionString = std::to_string(lsdj_song_get_format_version(song));
-        std::cout << versionString;
+        console() << versionString;
         for (auto i = 0; i < 5 - versionString.length(); i++)
-            std::cout << ' ';
+            console() << ' ';
         
         // Display the bpm of the project
         if (song)
         {
             int tempo = lsdj_song_get_tempo(song);
-            std::cout << tempo;
+            console() << tempo;
         }
         
-        std::cout << std::endl;
+        console() << std::endl;
     }
 
     void Exporter::printProject(const lsdj_sav_t* sav, std::uint8_t index)
@@ -331,7 +645,7 @@ namespace lsdj
         // Since we're printing, we should show the user this slot is effectively empty
         if (!project)
         {
-            std::cout << "(EMPTY)" << std::endl;
+            console() << "(EMPTY)" << std::endl;
             return;
         }
         
@@ -346,38 +660,38 @@ namespace lsdj
         }
         
         // Print out the index
-        std::cout << std::to_string(index) << "  ";
+        console() << std::to_string(index) << "  ";
         if (index < 10)
-            std::cout << ' ';
+            console() << ' ';
         
         // Display the name of the project
         const auto name = constructName(project);
-        std::cout << name;
+        console() << name;
         
         for (auto i = 0; i < (11 - name.length()); ++i)
-            std::cout << ' ';
+            console() << ' ';
         
         // Display the version number of the project
         const auto songVersionString = convertVersionToString(lsdj_project_get_version(project), false, true);
-        std::cout << songVersionString;
+        console() << songVersionString;
         for (auto i = songVersionString.size(); i < 5; i += 1)
-            std::cout << ' ';
+            console() << ' ';
         
         // Retrieve the format version of the song to display
         const lsdj_song_t* song = lsdj_project_get_song_const(project);
         const auto formatVersionString = std::to_string(lsdj_song_get_format_version(song));
-        std::cout << formatVersionString;
+        console() << formatVersionString;
         for (auto i = 0; i < 5 - formatVersionString.length(); i++)
-            std::cout << ' ';
+            console() << ' ';
         
         // Display the bpm of the project
         if (song)
         {
             int tempo = lsdj_song_get_tempo(song);
-            std::cout << std::setfill(' ') << std::setw(3) << tempo;
+            console() << std::setfill(' ') << std::setw(3) << tempo;
         }
         
-        std::cout << std::endl;
+        console() << std::endl;
     }
     
     bool Exporter::shouldExportWorkingMemory()
@@ -391,6 +705,26 @@ namespace lsdj
         return std::find(std::begin(indices), std::end(indices), -1) != std::end(indices);
     }
 
+    std::ostream& Exporter::console() const
+    {
+        if (messages)
+            return *messages;
+        
+        // Stdout is taken by the lsdsngs themselves when streaming
+        return isStandardStream(output) ? std::cerr : std::cout;
+    }
+
+    std::ostream& Exporter::problems() const
+    {
+        return messages ? *messages : std::cerr;
+    }
+
+    bool Exporter::reportError(lsdj_error_t error) const
+    {
+        problems() << "ERROR: " << lsdj_error_get_description(error) << std::endl;
+        return false;
+    }
+
     std::string Exporter::constructName(const lsdj_project_t* project)
     {
         return constructProjectName(project, underscore);
@@ -36,7 +36,15 @@
 #ifndef LSDJ_EXPORTER_HPP
 #define LSDJ_EXPORTER_HPP
 
+#include <array>
 #include <ghc/filesystem.hpp>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <lsdj/error.h>
 #include <lsdj/project.h>
@@ -44,6 +52,8 @@
 
 namespace lsdj
 {
+    class ThreadPool;
+    
     class Exporter
     {
     public:
@@ -58,6 +68,9 @@ namespace lsdj
         int export_(const ghc::filesystem::path& path);
         int print(const ghc::filesystem::path& path);
         
+        //! Export the .sav's in a folder (or a single .sav) again whenever they change, until interrupted
+        int watch(const ghc::filesystem::path& path);
+        
     public:
         // The version exporting style
         VersionStyle versionStyle = VersionStyle::HEX;
@@ -67,19 +80,42 @@ namespace lsdj
         bool verbose = false;
         bool skipWorkingMemory = false;
         
+        //! The amount of savs (and projects within them) that may be exported simultaneously
+        unsigned int jobs = 1;
+        
         std::vector<int> indices;
         std::vector<std::string> names;
         std::string output;
         
+        //! A file remembering what every exported lsdsng holds, so unchanged projects aren't written again next time (empty = none)
+        std::string statePath;
+        
+        //! Where messages and printed lists go, instead of stdout (e.g. the response to a client)
+        std::ostream* messages = nullptr;
+        
     private:
         int exportFolder(const ghc::filesystem::path& path);
+        int exportStandardInput();
         int exportSav(const ghc::filesystem::path& path);
+        bool exportSav(const ghc::filesystem::path& path, size_t index, std::ostream& log, ThreadPool* pool);
+        bool exportSav(const lsdj_sav_t* sav, size_t index, std::ostream& log, ThreadPool* pool);
         int printFolder(const ghc::filesystem::path& path);
         int printSav(const ghc::filesystem::path& path);
         bool shouldExportWorkingMemory();
         
-        // Export an actual project
-        lsdj_error_t exportProject(const lsdj_project_t* project, ghc::filesystem::path folder, bool workingMemory);
+        // Export an actual project, order tells which of two projects exported to the same path should win
+        lsdj_error_t exportProject(const lsdj_project_t* project, ghc::filesystem::path folder, bool workingMemory, size_t order, std::ostream& log);
+        
+        // Create a folder and its parents, unless this exporter already did so before
+        void createDirectories(const ghc::filesystem::path& path);
+        
+        // Write an lsdsng to disk in one go, instead of byte by byte through the file system
+        // Unchanged tells whether the file on disk already held the same project, and wasn't written
+        lsdj_error_t writeLsdsng(const lsdj_project_t* project, const ghc::filesystem::path& path, size_t order, bool& unchanged);
+        
+        // Read and write the hashes of the exported projects
+        bool loadState();
+        bool saveState();
         
         // Converts a project version to a string representation using the current VersionStyle
         std::string convertVersionToString(uint8_t version, bool prefixDot, bool prefixWhitespace) const;
@@ -91,6 +127,31 @@ namespace lsdj
         void printProject(const lsdj_sav_t* sav, std::uint8_t index);
         
         std::string constructName(const lsdj_project_t* project);
+        
+        // Where messages go, which is stderr when the lsdsngs are written to stdout
+        std::ostream& console() const;
+        
+        // Where problems go, which is the client's response when serving
+        std::ostream& problems() const;
+        
+        // Report an error where problems go, for functions that return whether they succeeded
+        bool reportError(lsdj_error_t error) const;
+        
+    private:
+        // The folders that have already been created, shared between jobs
+        std::unordered_set<std::string> createdDirectories;
+        std::mutex directoryMutex;
+        
+        // The order of the last project written to every path, so that when jobs export
+        // projects with the same name, the same one ends up on disk as without jobs
+        std::unordered_map<std::string, size_t> writtenFiles;
+        std::mutex writtenFilesMutex;
+        
+        // The hash of the project in every lsdsng on disk, guarded by writtenFilesMutex
+        std::map<std::string, uint64_t> hashes;
+        
+        // Writes to the same path are serialized, writes to others mostly aren't
+        std::array<std::mutex, 64> fileMutexes;
     };
 }
 
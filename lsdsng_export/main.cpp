@@ -36,6 +36,7 @@
 #include <popl/popl.hpp>
 #include <ghc/filesystem.hpp>
 
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -45,17 +46,83 @@
 #include <lsdj/version.h>
 
 #include "../common/common.hpp"
+#include "../common/server.hpp"
+#include "../common/stream.hpp"
 #include "exporter.hpp"
 
 void printHelp(const popl::OptionParser& options)
 {
-    std::cout << "lsdsng-export mymusic.sav|folder\n\n"
+    std::cout << "lsdsng-export mymusic.sav|folder|-\n"
+              << "lsdsng-export --serve\n\n"
               << "Version: " << LSDJ_VERSION_STRING << "\n\n"
               << options << "\n";
 
     std::cout << "LibLSDJ is open source and freely available to anyone.\nIf you'd like to show your appreciation, please consider\n  - buying one of my albums (https://4ntler.bandcamp.com)\n  - donating money through PayPal (https://paypal.me/4ntler).\n";
 }
 
+// Handle export and list jobs from stdin until it closes, with the command line options as defaults
+int serveJobs(const std::function<void(lsdj::Exporter&)>& configure, unsigned int jobs)
+{
+    lsdj::Server server(jobs);
+    
+    server.addCommand("export", "mymusic.sav output-folder [index|wm ...]", [&](const std::vector<std::string>& arguments, std::ostream& output)
+    {
+        if (arguments.size() < 2)
+        {
+            output << "Usage: export mymusic.sav output-folder [index|wm ...]" << std::endl;
+            return false;
+        }
+        
+        const auto path = ghc::filesystem::absolute(arguments[0]);
+        if (!ghc::filesystem::is_regular_file(path))
+        {
+            output << "Path '" << path.string() << "' is not a file" << std::endl;
+            return false;
+        }
+        
+        // Every job gets its own exporter, jobs already run simultaneously
+        lsdj::Exporter exporter;
+        configure(exporter);
+        exporter.jobs = 1;
+        exporter.messages = &output;
+        exporter.output = ghc::filesystem::absolute(arguments[1]).string();
+        
+        if (arguments.size() > 2)
+        {
+            exporter.indices.clear();
+            exporter.names.clear();
+            for (auto it = arguments.begin() + 2; it != arguments.end(); ++it)
+                exporter.indices.emplace_back(*it == "wm" ? -1 : std::stoi(*it));
+        }
+        
+        return exporter.export_(path) == 0;
+    });
+    
+    server.addCommand("list", "mymusic.sav", [&](const std::vector<std::string>& arguments, std::ostream& output)
+    {
+        if (arguments.size() != 1)
+        {
+            output << "Usage: list mymusic.sav" << std::endl;
+            return false;
+        }
+        
+        const auto path = ghc::filesystem::absolute(arguments[0]);
+        if (!ghc::filesystem::is_regular_file(path))
+        {
+            output << "Path '" << path.string() << "' is not a file" << std::endl;
+            return false;
+        }
+        
+        lsdj::Exporter exporter;
+        configure(exporter);
+        exporter.messages = &output;
+        
+        return exporter.print(path) == 0;
+    });
+    
+    return server.serve(std::cin, std::cout);
+}
+
 int main(int argc, char* argv[])
 {
     popl::OptionParser options("Options");
@@ -66,11 +133,15 @@ int main(int argc, char* argv[])
     auto print = options.add<popl::Switch>("p", "print", "Print a list of all songs in the sav, instead of exporting");
     auto decimal = options.add<popl::Switch>("d", "decimal", "Use decimal notation for the version number, instead of hex");
     auto underscore = options.add<popl::Switch>("u", "underscore", "Use an underscore for the special lightning bolt character, instead of x");
-    auto output = options.add<popl::Value<std::string>>("o", "output", "Output folder for the lsdsng's", "");
+    auto output = options.add<popl::Value<std::string>>("o", "output", "Output folder for the lsdsng's, or - to stream them to stdout", "");
     auto index = options.add<popl::Value<int>>("i", "index", "Single out a given project index to export, 0 or more");
     auto name = options.add<popl::Value<std::string>>("n", "name", "Single out a given project by name to export");
     auto wm = options.add<popl::Switch>("w", "working-memory", "Single out the working-memory song to export");
     auto skipWorkingMemory = options.add<popl::Switch>("", "skip-working", "Do not export the song in working-memory when no other projects are given");
+    auto jobs = options.add<popl::Value<unsigned int>>("j", "jobs", "The amount of savs to export simultaneously", 1);
+    auto serve = options.add<popl::Switch>("", "serve", "Keep running, and handle export and list jobs sent through stdin line by line");
+    auto watch = options.add<popl::Switch>("", "watch", "Keep running, and export the savs again whenever they change");
+    auto state = options.add<popl::Value<std::string>>("", "state", "A file remembering what was exported, so unchanged projects aren't written again");
 
     try
     {
@@ -78,37 +149,28 @@ int main(int argc, char* argv[])
         
         const auto inputs = options.non_option_args();
         
-        // Show help if requested
-        if (help->is_set())
+        // Find conflicting arguments
+        if (wm->is_set() && skipWorkingMemory->is_set())
+        {
+            std::cerr << "Incompatible arguments: --working-memory and --skip-working";
+            return 1;
+        }
+        
+        if (watch->is_set() && (print->is_set() || serve->is_set() || (!inputs.empty() && lsdj::isStandardStream(inputs.front())) || lsdj::isStandardStream(output->value())))
+        {
+            std::cerr << "Incompatible arguments: --watch only works on savs and folders on disk" << std::endl;
+            return 1;
+        }
+        
+        // Apply the flags manipulating output "style" and which projects are exported
+        auto configure = [&](lsdj::Exporter& exporter)
         {
-            printHelp(options);
-            return 0;
-        // Do we have an input file?
-        } else if (!inputs.empty()) {
-            // What is the path of the input file, and does it exist on disk?
-            const auto path = ghc::filesystem::absolute(inputs.front());
-            if (!ghc::filesystem::exists(path))
-            {
-                std::cerr << "Path '" << path.string() << "' does not exist" << std::endl;
-                return 1;
-            }
-
-            // Find conflicting arguments
-            if (wm->is_set() && skipWorkingMemory->is_set())
-            {
-                std::cerr << "Incompatible arguments: --working-memory and --skip-working";
-                return 1;
-            }
-            
-            // Create the exporter, that will do the work
-            lsdj::Exporter exporter;
-            
-            // Parse some of the flags manipulating output "style"
             exporter.versionStyle = noversion->is_set() ? lsdj::Exporter::VersionStyle::NONE : decimal->is_set() ? lsdj::Exporter::VersionStyle::DECIMAL : lsdj::Exporter::VersionStyle::HEX;
             exporter.underscore = underscore->is_set();
             exporter.putInFolder = folder->is_set();
             exporter.verbose = verbose->is_set();
             exporter.skipWorkingMemory = skipWorkingMemory->is_set();
+            exporter.jobs = jobs->value();
 
             // Has the user specified one or more specific indices to export?
             if (index->is_set())
@@ -125,13 +187,42 @@ int main(int argc, char* argv[])
             
             if (wm->is_set())
                 exporter.indices.emplace_back(-1); // -1 represents working memory, kind-of a hack, but meh :/
+        };
+        
+        // Show help if requested
+        if (help->is_set())
+        {
+            printHelp(options);
+            return 0;
+        } else if (serve->is_set()) {
+            return serveJobs(configure, jobs->value());
+        // Do we have an input file?
+        } else if (!inputs.empty()) {
+            // What is the path of the input file, and does it exist on disk?
+            const auto path = lsdj::absoluteUnlessStandardStream(inputs.front());
+            if (!lsdj::isStandardStream(path) && !ghc::filesystem::exists(path))
+            {
+                std::cerr << "Path '" << path.string() << "' does not exist" << std::endl;
+                return 1;
+            }
+
+            // Create the exporter, that will do the work
+            lsdj::Exporter exporter;
+            configure(exporter);
 
             // Has the user requested a print, or an actual export?
             if (print->is_set()) {
                 return exporter.print(path);
             } else {
                 exporter.output = output->value();
-                return exporter.export_(path);
+                if (state->is_set())
+                    exporter.statePath = ghc::filesystem::absolute(state->value()).string();
+                
+                const int result = exporter.export_(path);
+                if (!watch->is_set())
+                    return result;
+                
+                return exporter.watch(path);
             }
         } else {
             printHelp(options);
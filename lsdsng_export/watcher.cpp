@@ -0,0 +1,203 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#include "watcher.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <thread>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "../common/common.hpp"
+
+namespace lsdj
+{
+    namespace
+    {
+        //! Emulators write savs in several steps, so changes are only reported once it's been quiet this long
+        constexpr int SETTLE_MILLISECONDS = 250;
+    }
+
+    Watcher::Watcher(const ghc::filesystem::path& path)
+    {
+        if (ghc::filesystem::is_directory(path))
+        {
+            folder = path;
+        } else {
+            folder = path.parent_path();
+            file = path.filename();
+        }
+        
+#ifdef __linux__
+        descriptor = inotify_init1(IN_CLOEXEC);
+        if (descriptor == -1)
+            return;
+        
+        // Savs are either written in place, or written elsewhere and moved over the old one
+        if (inotify_add_watch(descriptor, folder.string().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1)
+        {
+            close(descriptor);
+            descriptor = -1;
+        }
+#else
+        scan(snapshot);
+#endif
+    }
+
+    Watcher::~Watcher()
+    {
+#ifdef __linux__
+        if (descriptor != -1)
+            close(descriptor);
+#endif
+    }
+
+    bool Watcher::isValid() const
+    {
+#ifdef __linux__
+        return descriptor != -1;
+#else
+        return ghc::filesystem::is_directory(folder);
+#endif
+    }
+
+    bool Watcher::isWatched(const ghc::filesystem::path& path) const
+    {
+        if (isHiddenFile(path.filename().string()) || path.extension() != ".sav")
+            return false;
+        
+        return file.empty() || path.filename() == file;
+    }
+
+#ifdef __linux__
+    bool Watcher::wait(std::vector<ghc::filesystem::path>& changed)
+    {
+        std::set<ghc::filesystem::path> paths;
+        alignas(inotify_event) char buffer[4096];
+        
+        // Block until something happens, then keep collecting until things settle down
+        int timeout = -1;
+        while (true)
+        {
+            pollfd request = { descriptor, POLLIN, 0 };
+            const int ready = poll(&request, 1, timeout);
+            if (ready < 0)
+                return false;
+            
+            if (ready == 0)
+            {
+                if (!paths.empty())
+                    break;
+                
+                timeout = -1;
+                continue;
+            }
+            
+            const ssize_t size = read(descriptor, buffer, sizeof(buffer));
+            if (size <= 0)
+                return false;
+            
+            for (ssize_t position = 0; position < size; )
+            {
+                const auto event = reinterpret_cast<const inotify_event*>(buffer + position);
+                position += sizeof(inotify_event) + event->len;
+                
+                if (event->len == 0)
+                    continue;
+                
+                const auto path = folder / event->name;
+                if (isWatched(path))
+                    paths.insert(path);
+            }
+            
+            timeout = SETTLE_MILLISECONDS;
+        }
+        
+        changed.assign(paths.begin(), paths.end());
+        return true;
+    }
+#else
+    bool Watcher::wait(std::vector<ghc::filesystem::path>& changed)
+    {
+        while (true)
+        {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            
+            std::map<ghc::filesystem::path, std::pair<ghc::filesystem::file_time_type, uintmax_t>> current;
+            scan(current);
+            
+            std::vector<ghc::filesystem::path> paths;
+            for (const auto& entry : current)
+            {
+                const auto previous = snapshot.find(entry.first);
+                if (previous == snapshot.end() || previous->second != entry.second)
+                    paths.emplace_back(entry.first);
+            }
+            
+            if (paths.empty())
+                continue;
+            
+            // Wait for the writes to settle down, and pick up the final sizes
+            std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_MILLISECONDS));
+            scan(snapshot);
+            
+            changed = std::move(paths);
+            return true;
+        }
+    }
+
+    void Watcher::scan(std::map<ghc::filesystem::path, std::pair<ghc::filesystem::file_time_type, uintmax_t>>& result) const
+    {
+        result.clear();
+        
+        std::error_code error;
+        for (auto it = ghc::filesystem::directory_iterator(folder, error); it != ghc::filesystem::directory_iterator(); it.increment(error))
+        {
+            const auto path = it->path();
+            if (error || !isWatched(path))
+                continue;
+            
+            result[path] = { ghc::filesystem::last_write_time(path, error), ghc::filesystem::file_size(path, error) };
+        }
+    }
+#endif
+}
@@ -0,0 +1,84 @@
+/*
+ 
+ This file is a part of liblsdj, a C library for managing everything
+ that has to do with LSDJ, software for writing music (chiptune) with
+ your gameboy. For more information, see:
+ 
+ * https://github.com/stijnfrishert/liblsdj
+ * http://www.littlesounddj.com
+ 
+ --------------------------------------------------------------------------------
+ 
+ MIT License
+ 
+ Copyright (c) 2018 - 2020 Stijn Frishert
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ */
+
+
+#ifndef LSDJ_WATCHER_HPP
+#define LSDJ_WATCHER_HPP
+
+#include <ghc/filesystem.hpp>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace lsdj
+{
+    //! Waits for .sav's in a folder (or a single .sav) to be written to
+    /*! Uses inotify on Linux, and checks the modification times every second elsewhere */
+    class Watcher
+    {
+    public:
+        //! Watch a folder of .sav's, or a single .sav
+        explicit Watcher(const ghc::filesystem::path& path);
+        ~Watcher();
+        
+        Watcher(const Watcher&) = delete;
+        Watcher& operator=(const Watcher&) = delete;
+        
+        //! Whether the path can be watched
+        bool isValid() const;
+        
+        //! Block until one or more .sav's have been changed, and are done being written to
+        /*! @return False if watching failed */
+        bool wait(std::vector<ghc::filesystem::path>& changed);
+        
+    private:
+        bool isWatched(const ghc::filesystem::path& path) const;
+        
+    private:
+        ghc::filesystem::path folder;
+        ghc::filesystem::path file; // Empty = every .sav in the folder
+        
+#ifdef __linux__
+        int descriptor = -1;
+#else
+        // The modification time and size of every .sav when last checked
+        std::map<ghc::filesystem::path, std::pair<ghc::filesystem::file_time_type, uintmax_t>> snapshot;
+        
+        void scan(std::map<ghc::filesystem::path, std::pair<ghc::filesystem::file_time_type, uintmax_t>>& result) const;
+#endif
+    };
+}
+
+#endif
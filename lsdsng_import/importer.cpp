@@ -34,174 +34,321 @@
  */
 
 #include <algorithm>
-#include <array>
 #include <cassert>
+#include <cstring>
 #include <iostream>
+#include <iterator>
+#include <sstream>
 
+#include <lsdj/compression.h>
 #include <lsdj/song.h>
-#include <lsdj/project.h>
 
 #include "../common/common.hpp"
+#include "../common/stream.hpp"
+#include "../common/thread_pool.hpp"
 #include "importer.hpp"
 
 namespace lsdj
 {
     // Scan a path, see whether it's either an .lsdsng or a folder containing .lsdsng's
     // Returns the path to the .WM (working memory) file, or {} is there was none
-    void Importer::scanPath(const ghc::filesystem::path& path, std::vector<ghc::filesystem::path>& paths)
+    void Importer::scanPath(const ghc::filesystem::path& path, std::vector<Input>& inputs)
     {
+        if (isStandardStream(path))
+        {
+            scanStandardInput(inputs);
+            return;
+        }
+        
         if (isHiddenFile(path.filename().string()))
             return;
         
         if (ghc::filesystem::is_regular_file(path))
         {
-            const auto stem = path.stem().string();
-            const auto isWm = stem.size() >= 3 && stem.substr(stem.size() - 3) == ".WM";
-            
-            if (!isWm || (!workingMemoryInput.empty() && path == ghc::filesystem::absolute(workingMemoryInput)))
-                paths.emplace_back(path);
-            else {
-                std::cout << "Ignoring " << path.string() << ", because it ends on .WM" << std::endl;
-                std::cout << "If you want to include this as the working memory song, use the -w flag" << std::endl;
-            }
+            if (shouldImport(path))
+                inputs.push_back({ path, {} });
         }
         else if (ghc::filesystem::is_directory(path))
         {
+            // Directory iteration order differs per platform, sort it so songs get the same priority everywhere
+            std::vector<ghc::filesystem::path> children;
             for (auto it = ghc::filesystem::directory_iterator(path); it != ghc::filesystem::directory_iterator(); ++it)
-                scanPath(it->path(), paths);
+                children.emplace_back(it->path());
+            std::sort(children.begin(), children.end());
+            
+            for (const auto& child : children)
+                scanPath(child, inputs);
         } else {
             throw std::runtime_error(path.string() + " is not a file or directory");
         }
     }
     
-    int Importer::import()
+    // Stdin holds either a single .lsdsng or .sav, or a stream of frames written by one of the other tools
+    void Importer::scanStandardInput(std::vector<Input>& inputs)
     {
-        // Create an empty sav to work with
-        lsdj_sav_t* sav = nullptr;
-        lsdj_error_t error = lsdj_sav_new(&sav, nullptr);
-        if (error != LSDJ_SUCCESS)
-            return handle_error(error);
-        assert(sav != nullptr);
+        std::vector<StreamFrame> frames;
+        bool framed = false;
+        if (!readStandardInputFrames("stdin", frames, framed))
+            throw std::runtime_error("Stdin is not a valid stream of files");
         
-        // Find the first available project slot index
-        uint8_t index = 0;
-        for( ; index < LSDJ_SAV_PROJECT_COUNT; ++index)
+        for (auto& frame : frames)
         {
-            if (!lsdj_sav_get_project_const(sav, index))
-                break;
+            if (!isHiddenFile(ghc::filesystem::path(frame.name).filename().string()) && shouldImport(frame.name))
+                inputs.push_back({ frame.name, std::move(frame.data) });
         }
+    }
+    
+    bool Importer::shouldImport(const ghc::filesystem::path& path)
+    {
+        if (path.extension() != ".lsdsng" && path.extension() != ".sav")
+            return false;
+        
+        const auto stem = path.stem().string();
+        const auto isWm = stem.size() >= 3 && stem.substr(stem.size() - 3) == ".WM";
+        
+        if (!isWm || (!workingMemoryInput.empty() && path == ghc::filesystem::absolute(workingMemoryInput)))
+            return true;
+        
+        console() << "Ignoring " << path.string() << ", because it ends on .WM" << std::endl;
+        console() << "If you want to include this as the working memory song, use the -w flag" << std::endl;
+        return false;
+    }
+    
+    int Importer::import()
+    {
+        assert(!outputFile.empty());
         
         // Go through all input files and recursively find all .lsdsngs's (and the working memory file)
-        std::vector<ghc::filesystem::path> paths;
+        std::vector<Input> files;
         for (auto& input : inputs)
-            scanPath(ghc::filesystem::absolute(input), paths);
+            scanPath(absoluteUnlessStandardStream(input), files);
         
-        assert(!outputFile.empty());
+        // Read every song and measure its size, one input per task
+        std::vector<std::vector<Song>> loaded(files.size());
+        std::vector<lsdj_error_t> errors(files.size(), LSDJ_SUCCESS);
+        ThreadPool::forEach(jobs, files.size(), [&](size_t i){ errors[i] = load(files[i], loaded[i]); });
         
-        // Import all lsdsng/sav files
-        for (auto i = 0; i < paths.size(); ++i)
+        bool success = true;
+        std::vector<Song> songs;
+        for (size_t i = 0; i < files.size(); ++i)
         {
-            if (index == LSDJ_SAV_PROJECT_COUNT)
+            if (errors[i] != LSDJ_SUCCESS)
             {
-                std::cerr << "Reached maximum project count, can't write " << paths[i].string() << std::endl;
-                break;
+                problems() << "Could not read " << files[i].path.string() << std::endl;
+                reportError(errors[i]);
+                success = false;
+                continue;
             }
             
-            const lsdj_error_t error = import(paths[i], sav, index);
-            if (error != LSDJ_SUCCESS)
-            {
-                lsdj_sav_free(sav);
-                return handle_error(error);
-            }
+            std::move(loaded[i].begin(), loaded[i].end(), std::back_inserter(songs));
         }
         
-        // Import the working memory song
-        error = importWorkingMemorySong(sav, paths);
-        if (error != LSDJ_SUCCESS)
+        // Decide which songs go where, before compressing anything for real
+        size_t leftOut = 0;
+        const auto savs = plan(songs, leftOut);
+        
+        std::vector<std::ostringstream> logs(savs.size());
+        errors.assign(savs.size(), LSDJ_SUCCESS);
+        
+        // Savs streamed to stdout have to come out in order
+        if (isStandardStream(outputFile))
         {
-            lsdj_sav_free(sav);
-            return handle_error(error);
+            for (size_t i = 0; i < savs.size(); ++i)
+                errors[i] = write(savs[i], songs, constructOutputPath(i), i == 0, logs[i]);
+        } else {
+            ThreadPool::forEach(jobs, savs.size(), [&](size_t i){ errors[i] = write(savs[i], songs, constructOutputPath(i), i == 0, logs[i]); });
         }
         
-        // Write the sav to file
-        error = lsdj_sav_write_to_file(sav, ghc::filesystem::absolute(outputFile).string().c_str(), nullptr);
-        if (error != LSDJ_SUCCESS)
+        for (size_t i = 0; i < savs.size(); ++i)
         {
-            lsdj_sav_free(sav);
-            return handle_error(error);
+            console() << logs[i].str();
+            if (errors[i] != LSDJ_SUCCESS)
+            {
+                reportError(errors[i]);
+                success = false;
+            }
         }
         
-        return 0;
+        if (!success)
+            return 1;
+        
+        // Songs that were left out are only reported, so give scripts a way to notice
+        return leftOut > 0 ? 2 : 0;
     }
 
-    lsdj_error_t Importer::import(const ghc::filesystem::path& path, lsdj_sav_t* sav, uint8_t& index)
+    lsdj_error_t Importer::load(const Input& input, std::vector<Song>& songs)
     {
+        const auto& path = input.path;
         if (path.extension() == ".sav")
-            return importSav(path.string(), sav, index);
-        else if (path.extension() == ".lsdsng")
-            return importSong(path.string(), sav, index);
-    }
-
-    lsdj_error_t Importer::importSav(const std::string& path, lsdj_sav_t* destSav, uint8_t& index)
-    {
-        lsdj_sav_t* sourceSav = nullptr;
-        lsdj_error_t result = lsdj_sav_read_from_file(path.data(), &sourceSav, nullptr);
-        if (result != LSDJ_SUCCESS)
-            return result;
-        
-        for (uint8_t i = 0; i < LSDJ_SAV_PROJECT_COUNT && index < LSDJ_SAV_PROJECT_COUNT; ++i)
         {
-            const lsdj_project_t* project = lsdj_sav_get_project_const(sourceSav, i);
-            if (project)
+            lsdj_sav_t* sav = nullptr;
+            lsdj_error_t error = input.data.empty() ?
+                lsdj_sav_read_from_file(path.string().c_str(), &sav, nullptr) :
+                lsdj_sav_read_from_memory(input.data.data(), input.data.size(), &sav, nullptr);
+            if (error != LSDJ_SUCCESS)
+                return error;
+            
+            for (uint8_t i = 0; i < LSDJ_SAV_PROJECT_COUNT && error == LSDJ_SUCCESS; ++i)
             {
-                result = importProject(project, destSav, index);
-                if (result != LSDJ_SUCCESS)
-                    break;
+                const lsdj_project_t* project = lsdj_sav_get_project_const(sav, i);
+                if (!project)
+                    continue;
+                
+                // The sav is freed once all of its projects have been read, so hold on to copies
+                lsdj_project_t* copy = nullptr;
+                error = lsdj_project_copy(project, &copy, nullptr);
+                if (error == LSDJ_SUCCESS)
+                    error = addSong(std::unique_ptr<lsdj_project_t, ProjectDeleter>(copy), songs);
             }
+            
+            lsdj_sav_free(sav);
+            return error;
+        } else {
+            lsdj_project_t* project = nullptr;
+            const lsdj_error_t error = input.data.empty() ?
+                lsdj_project_read_lsdsng_from_file(path.string().c_str(), &project, nullptr) :
+                lsdj_project_read_lsdsng_from_memory(input.data.data(), input.data.size(), &project, nullptr);
+            if (error != LSDJ_SUCCESS)
+                return error;
+            
+            return addSong(std::unique_ptr<lsdj_project_t, ProjectDeleter>(project), songs);
         }
+    }
+
+    lsdj_error_t Importer::addSong(std::unique_ptr<lsdj_project_t, ProjectDeleter> project, std::vector<Song>& songs)
+    {
+        assert(project != nullptr);
+        
+        Song song;
+        
+        const auto name = lsdj_project_get_name(project.get());
+        song.name = std::string(name, strnlen(name, LSDJ_PROJECT_NAME_LENGTH));
+        
+        const lsdj_error_t error = lsdj_compress_count_blocks(lsdj_project_get_song_const(project.get())->bytes, &song.blockCount);
+        if (error != LSDJ_SUCCESS)
+            return error;
         
-        lsdj_sav_free(sourceSav);
+        song.project = std::move(project);
+        songs.emplace_back(std::move(song));
         
         return LSDJ_SUCCESS;
     }
-    
-    lsdj_error_t Importer::importSong(const std::string& path, lsdj_sav_t* sav, uint8_t& index)
+
+    std::vector<Importer::Sav> Importer::plan(const std::vector<Song>& songs, size_t& leftOut) const
     {
-        lsdj_project_t* project = nullptr;
-        lsdj_error_t error = lsdj_project_read_lsdsng_from_file(path.c_str(), &project, nullptr);
-        if (error == LSDJ_SUCCESS)
+        std::vector<size_t> order(songs.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        
+        // Filling a single sav with the smallest songs first fits the most of them. When splitting,
+        // placing the largest songs first (first-fit decreasing) leaves the fewest savs half-empty.
+        if (pack)
+        {
+            std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs)
+            {
+                return split ? songs[lhs].blockCount > songs[rhs].blockCount : songs[lhs].blockCount < songs[rhs].blockCount;
+            });
+        }
+        
+        // There's always at least one sav, if only for the working memory song
+        std::vector<Sav> savs(1);
+        
+        for (auto index : order)
         {
-            error = importProject(project, sav, index);
-            lsdj_project_free(project);
+            const auto& song = songs[index];
             
-            if (error != LSDJ_SUCCESS)
-                return error;
+            if (song.blockCount > LSDJ_BLOCK_COUNT)
+            {
+                problems() << "Not importing " << song.name << ", it needs " << song.blockCount << " blocks, more than a sav has" << std::endl;
+                ++leftOut;
+                continue;
+            }
+            
+            // Put the song in the first sav that still has room for it
+            auto sav = std::find_if(savs.begin(), savs.end(), [&](const Sav& sav)
+            {
+                return sav.songs.size() < LSDJ_SAV_PROJECT_COUNT && sav.blockCount + song.blockCount <= LSDJ_BLOCK_COUNT;
+            });
+            
+            if (sav == savs.end())
+            {
+                if (!split)
+                {
+                    problems() << "Not enough room left for " << song.name << " (" << song.blockCount << " blocks), use --split to import it into another sav" << std::endl;
+                    ++leftOut;
+                    continue;
+                }
+                
+                sav = savs.emplace(savs.end());
+            }
+            
+            sav->songs.emplace_back(index);
+            sav->blockCount += song.blockCount;
         }
         
-        return LSDJ_SUCCESS;
+        // Within a sav, keep the songs in the order they were given
+        for (auto& sav : savs)
+            std::sort(sav.songs.begin(), sav.songs.end());
+        
+        return savs;
     }
 
-    lsdj_error_t Importer::importProject(const lsdj_project_t* project, lsdj_sav_t* sav, uint8_t& index)
+    lsdj_error_t Importer::write(const Sav& plan, const std::vector<Song>& songs, const ghc::filesystem::path& path, bool includeWorkingMemory, std::ostream& log)
     {
-        assert(project != nullptr);
-        
-        lsdj_error_t error = lsdj_sav_set_project_copy(sav, index, project, nullptr);
+        lsdj_sav_t* sav = nullptr;
+        lsdj_error_t error = lsdj_sav_new(&sav, nullptr);
         if (error != LSDJ_SUCCESS)
             return error;
+        assert(sav != nullptr);
         
-        if (verbose)
+        for (uint8_t slot = 0; slot < plan.songs.size(); ++slot)
         {
-            const auto n = lsdj_project_get_name(project);
-            std::string name(n, strnlen(n, LSDJ_PROJECT_NAME_LENGTH));
-            std::cout << "Imported " << name.data() << " at slot " << std::to_string(index) << std::endl;
+            const auto& song = songs[plan.songs[slot]];
+            
+            error = lsdj_sav_set_project_copy(sav, slot, song.project.get(), nullptr);
+            if (error != LSDJ_SUCCESS)
+            {
+                lsdj_sav_free(sav);
+                return error;
+            }
+            
+            if (verbose)
+                log << "Imported " << song.name << " at slot " << std::to_string(slot) << std::endl;
         }
         
-        index += 1;
+        if (includeWorkingMemory)
+        {
+            error = importWorkingMemorySong(sav);
+            if (error != LSDJ_SUCCESS)
+            {
+                lsdj_sav_free(sav);
+                return error;
+            }
+        }
+        
+        // Write the sav to file, or to stdout. Several savs on stdout are told apart by framing them.
+        if (!isStandardStream(outputFile))
+        {
+            error = lsdj_sav_write_to_file(sav, path.string().c_str(), nullptr);
+        } else if (!split) {
+            error = writeSav(sav, outputFile);
+        } else {
+            std::vector<uint8_t> data;
+            error = writeSav(sav, data);
+            if (error == LSDJ_SUCCESS && !writeFrame(path.filename().string(), data))
+                error = LSDJ_WRITE_FAILED;
+        }
+        lsdj_sav_free(sav);
+        if (error != LSDJ_SUCCESS)
+            return error;
+        
+        if (verbose || split)
+            log << "Wrote " << plan.songs.size() << " song(s) using " << plan.blockCount << "/" << LSDJ_BLOCK_COUNT << " blocks to " << path.filename().string() << std::endl;
         
         return LSDJ_SUCCESS;
     }
     
-    lsdj_error_t Importer::importWorkingMemorySong(lsdj_sav_t* sav, const std::vector<ghc::filesystem::path>& paths)
+    lsdj_error_t Importer::importWorkingMemorySong(lsdj_sav_t* sav)
     {
         if (workingMemoryInput.empty())
             return LSDJ_SUCCESS;
@@ -220,4 +367,32 @@ namespace lsdj
         
         return LSDJ_SUCCESS;
     }
+    
+    ghc::filesystem::path Importer::constructOutputPath(size_t index) const
+    {
+        const auto path = isStandardStream(outputFile) ? ghc::filesystem::path("out.sav") : ghc::filesystem::absolute(outputFile);
+        if (index == 0)
+            return path;
+        
+        // out.sav, out_2.sav, out_3.sav...
+        return path.parent_path() / (path.stem().string() + "_" + std::to_string(index + 1) + path.extension().string());
+    }
+    
+    std::ostream& Importer::console() const
+    {
+        if (messages)
+            return *messages;
+        
+        return isStandardStream(outputFile) ? std::cerr : std::cout;
+    }
+    
+    std::ostream& Importer::problems() const
+    {
+        return messages ? *messages : std::cerr;
+    }
+
+    void Importer::reportError(lsdj_error_t error) const
+    {
+        problems() << "ERROR: " << lsdj_error_get_description(error) << std::endl;
+    }
 }
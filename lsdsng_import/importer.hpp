@@ -37,10 +37,13 @@
 #define LSDJ_IMPORTER_HPP
 
 #include <ghc/filesystem.hpp>
+#include <memory>
+#include <ostream>
 #include <string>
 #include <vector>
 
 #include <lsdj/error.h>
+#include <lsdj/project.h>
 #include <lsdj/sav.h>
 
 namespace lsdj
@@ -48,6 +51,7 @@ namespace lsdj
     class Importer
     {
     public:
+        //! Returns 0 on success, 1 if something couldn't be read or written, and 2 if songs were left out
         int import();
         
     public:
@@ -56,14 +60,72 @@ namespace lsdj
         std::string outputFile;
         bool verbose = false;
         
+        //! Spread the songs over as many savs as needed, instead of leaving out the ones that don't fit
+        bool split = false;
+        
+        //! Reorder the songs to fit as many as possible in every sav, instead of giving earlier inputs priority
+        bool pack = false;
+        
+        //! The amount of songs that may be read and measured simultaneously
+        unsigned int jobs = 1;
+        
+        //! Where messages and problems go, instead of stdout and stderr (e.g. the response to a client)
+        std::ostream* messages = nullptr;
+        
     private:
-        void scanPath(const ghc::filesystem::path& path, std::vector<ghc::filesystem::path>& paths);
+        //! A file to import from, either on disk or read from stdin
+        struct Input
+        {
+            ghc::filesystem::path path;
+            std::vector<uint8_t> data; // Empty = read from path
+        };
+        
+        struct ProjectDeleter
+        {
+            void operator()(lsdj_project_t* project) const { lsdj_project_free(project); }
+        };
+        
+        //! A song to import, along with the amount of blocks it compresses into
+        struct Song
+        {
+            std::unique_ptr<lsdj_project_t, ProjectDeleter> project;
+            std::string name;
+            unsigned int blockCount = 0;
+        };
+        
+        //! The songs that go into a single output sav, by index
+        struct Sav
+        {
+            std::vector<size_t> songs;
+            unsigned int blockCount = 0;
+        };
+        
+    private:
+        void scanPath(const ghc::filesystem::path& path, std::vector<Input>& inputs);
+        void scanStandardInput(std::vector<Input>& inputs);
+        bool shouldImport(const ghc::filesystem::path& path);
+        
+        // Read the songs from an .lsdsng or .sav, and measure how many blocks they need
+        lsdj_error_t load(const Input& input, std::vector<Song>& songs);
+        lsdj_error_t addSong(std::unique_ptr<lsdj_project_t, ProjectDeleter> project, std::vector<Song>& songs);
+        
+        // Divide the songs over one or more savs, counting the songs that don't fit in leftOut
+        std::vector<Sav> plan(const std::vector<Song>& songs, size_t& leftOut) const;
+        
+        lsdj_error_t write(const Sav& plan, const std::vector<Song>& songs, const ghc::filesystem::path& path, bool includeWorkingMemory, std::ostream& log);
+        lsdj_error_t importWorkingMemorySong(lsdj_sav_t* sav);
+        
+        // The output path of the n-th sav, when the songs are split over several
+        ghc::filesystem::path constructOutputPath(size_t index) const;
+        
+        // Where messages go, which is stderr when the sav is written to stdout
+        std::ostream& console() const;
+        
+        // Where problems with songs go
+        std::ostream& problems() const;
         
-        lsdj_error_t import(const ghc::filesystem::path& path, lsdj_sav_t* sav, uint8_t& index);
-        lsdj_error_t importSav(const std::string& path, lsdj_sav_t* sav, uint8_t& index);
-        lsdj_error_t importSong(const std::string& path, lsdj_sav_t* sav, uint8_t& index);
-        lsdj_error_t importProject(const lsdj_project_t* project, lsdj_sav_t* sav, uint8_t& index);
-        lsdj_error_t importWorkingMemorySong(lsdj_sav_t* sav, const std::vector<ghc::filesystem::path>& paths);
+        // Report an error where problems go
+        void reportError(lsdj_error_t error) const;
     };
 }
 
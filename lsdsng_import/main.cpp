@@ -33,19 +33,24 @@
  
  */
 
+#include <algorithm>
 #include <iostream>
 #include <popl/popl.hpp>
 
 #include <lsdj/version.h>
 
 #include "../common/common.hpp"
+#include "../common/server.hpp"
+#include "../common/stream.hpp"
 #include "importer.hpp"
 
 void printHelp(const popl::OptionParser& options)
 {
-    std::cout << "lsdsng-import -o output.sav song1.lsgsng song2.lsdsng songs.sav...\n\n"
+    std::cout << "lsdsng-import -o output.sav|- song1.lsgsng song2.lsdsng songs.sav|-...\n"
+              << "lsdsng-import --serve\n\n"
               << "Version: " << LSDJ_VERSION_STRING << "\n\n"
-              << options << "\n";
+              << options << "\n"
+              << "Exits with 2 when songs had to be left out because they didn't fit\n\n";
 
     std::cout << "LibLSDJ is open source and freely available to anyone.\nIf you'd like to show your appreciation, please consider\n  - buying one of my albums (https://4ntler.bandcamp.com)\n  - donating money through PayPal (https://paypal.me/4ntler).\n";
 }
@@ -56,6 +61,10 @@ std::string generateOutputFilename(const std::vector<std::string>& inputs)
     // we take that folder name as output. In case of multiple folders,
     if (inputs.size() == 1)
     {
+        // Songs that come in through stdin go out through stdout
+        if (lsdj::isStandardStream(inputs.front()))
+            return "-";
+        
         const auto path = ghc::filesystem::absolute(inputs.front());
         return path.stem().filename().string() + ".sav";
     }
@@ -63,13 +72,52 @@ std::string generateOutputFilename(const std::vector<std::string>& inputs)
     return "out.sav";
 }
 
+// Handle import jobs from stdin until it closes, with the command line options as defaults
+int serveJobs(const lsdj::Importer& defaults, unsigned int jobs)
+{
+    lsdj::Server server(jobs);
+    
+    server.addCommand("import", "output.sav song1.lsdsng song2.lsdsng songs.sav|folder ...", [&](const std::vector<std::string>& arguments, std::ostream& output)
+    {
+        if (arguments.size() < 2)
+        {
+            output << "Usage: import output.sav song1.lsdsng song2.lsdsng songs.sav|folder ..." << std::endl;
+            return false;
+        }
+        
+        // Stdin and stdout carry the jobs and their responses
+        if (std::find_if(arguments.begin(), arguments.end(), lsdj::isStandardStream) != arguments.end())
+        {
+            output << "Jobs can't read from stdin or write to stdout" << std::endl;
+            return false;
+        }
+        
+        // Every job gets its own importer, jobs already run simultaneously
+        lsdj::Importer importer;
+        importer.verbose = defaults.verbose;
+        importer.split = defaults.split;
+        importer.pack = defaults.pack;
+        importer.messages = &output;
+        importer.outputFile = arguments[0];
+        importer.inputs.assign(arguments.begin() + 1, arguments.end());
+        
+        return importer.import() == 0;
+    });
+    
+    return server.serve(std::cin, std::cout);
+}
+
 int main(int argc, char* argv[])
 {
     popl::OptionParser options("Options");
     auto help = options.add<popl::Switch>("h", "help", "Show the help screen");
     auto verbose = options.add<popl::Switch>("v", "verbose", "Verbose output during import");
-    auto output = options.add<popl::Value<std::string>>("o", "output", "The output file (.sav)");
+    auto output = options.add<popl::Value<std::string>>("o", "output", "The output file (.sav), or - to write to stdout");
     auto wm = options.add<popl::Value<std::string>>("w", "working-memory", "The song to put in the working memory");
+    auto split = options.add<popl::Switch>("s", "split", "Spread the songs over as many savs as needed, instead of leaving out the ones that don't fit");
+    auto pack = options.add<popl::Switch>("p", "pack", "Reorder the songs to fit as many as possible per sav, instead of giving earlier songs priority");
+    auto jobs = options.add<popl::Value<unsigned int>>("j", "jobs", "The amount of songs to read and measure simultaneously", 1);
+    auto serve = options.add<popl::Switch>("", "serve", "Keep running, and handle import jobs sent through stdin line by line");
     
     try
     {
@@ -81,6 +129,13 @@ int main(int argc, char* argv[])
         {
             printHelp(options);
             return 0;
+        } else if (serve->is_set()) {
+            lsdj::Importer defaults;
+            defaults.verbose = verbose->is_set();
+            defaults.split = split->is_set();
+            defaults.pack = pack->is_set();
+            
+            return serveJobs(defaults, jobs->value());
         } else if (!imports.empty()) {
             lsdj::Importer importer;
             
@@ -89,6 +144,9 @@ int main(int argc, char* argv[])
                 importer.workingMemoryInput = wm->value();
             
             importer.verbose = verbose->is_set();
+            importer.split = split->is_set();
+            importer.pack = pack->is_set();
+            importer.jobs = jobs->value();
             importer.outputFile = output->is_set() ?
                 output->value() :
                 generateOutputFilename(importer.inputs);